@@ -29,9 +29,12 @@
 
 #include <fstream>
 #include <iostream>
+#include <iomanip>
 #include <d3d12.h>
 #include <assert.h>
 #include <filesystem>
+#include <unordered_map>
+#include <algorithm>
 #include <ppl.h>
 #include <dstorage.h>
 
@@ -40,6 +43,7 @@
 
 #include "XeTv2.h"
 #include "XetFileHeader.h"
+#include "XetMigrate.h"
 
 using Microsoft::WRL::ComPtr;
 
@@ -47,6 +51,12 @@ using Microsoft::WRL::ComPtr;
 
 constexpr UINT TILE_ALIGNMENT = 4096;
 
+// part of the <out>.hash parameters. bump when the converter changes its output for the same input and arguments,
+// so outputs of an older converter are rebuilt rather than reported up to date
+// 2: packed mips padded per PadPackedMips()
+// 3: tile store tiles aligned, outputs that use a tile store are XetFileHeader::GetStoreVersion()
+constexpr UINT CONVERTER_REVISION = 3;
+
 //=============================================================================
 // offsets & sizes for each mip of a texture
 //=============================================================================
@@ -79,6 +89,48 @@ bool m_convertFromXet2{ false };
 ComPtr<IDStorageCompressionCodec> m_compressor;
 //DSTORAGE_COMPRESSION m_compressionLevel = DSTORAGE_COMPRESSION_FASTEST;
 DSTORAGE_COMPRESSION m_compressionLevel = DSTORAGE_COMPRESSION_BEST_RATIO;
+
+//=============================================================================
+// sidecar written next to each output file as <out>.hash
+// records what the output was built from, so an unchanged input can be skipped
+// and unchanged tiles of a modified input can reuse previously compressed bytes
+//=============================================================================
+struct XetHashFileHeader
+{
+    static UINT GetMagic() { return 0x48544558; } // "XETH"
+    static UINT GetVersion() { return 1; }
+
+    UINT m_magic{ GetMagic() };
+    UINT m_version{ GetVersion() };
+    UINT64 m_sourceHash{ 0 };     // entire input file
+    UINT64 m_parametersHash{ 0 }; // converter revision, xet version, compression format & level
+    UINT64 m_outputSize{ 0 };     // detects an output that was replaced or truncated
+    UINT32 m_numTiles{ 0 };       // # entries in the following array of (uncompressed) tile hashes
+    UINT32 m_reserved{ 0 };
+};
+
+bool m_forceRebuild{ false };
+bool m_printStats{ false };
+
+// per-tile statistics written to the <out>.stats sidecar
+std::vector<XetStatsFileHeader::TileStats> m_tileStats;
+
+// hash of each uncompressed standard tile, written to the sidecar
+std::vector<UINT64> m_tileHashes;
+
+// tiles from the previous output that can be re-used, found by uncompressed tile hash
+std::unordered_map<UINT64, XetFileHeader::TileData> m_previousTiles;
+std::vector<BYTE> m_previousFile;
+std::atomic<UINT> m_numTilesReused{ 0 };
+
+// optional second, cheaper encoding of every standard tile, appended after the packed mips
+std::wstring m_lowTierFileName;
+std::vector<XetFileHeader::TileData> m_lowTierOffsets;
+std::vector<BYTE> m_lowTierData;
+
+// optional content-addressed tile store shared across outputs (-store)
+std::wstring m_storeFileName;
+std::vector<UINT64> m_storeHashes; // per standard tile. 0 = embedded in the output
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 void Error(std::wstring in_s)
@@ -113,6 +165,118 @@ static DXGI_FORMAT GetFormatFromHeader(const DirectX::DDS_HEADER& in_ddsHeader)
     return format;
 }
 
+//-----------------------------------------------------------------------------
+// fast non-cryptographic 64-bit hash, consumes 8 bytes at a time
+//-----------------------------------------------------------------------------
+UINT64 HashBytes(const BYTE* in_pBytes, size_t in_numBytes, UINT64 in_seed = 0)
+{
+    const UINT64 prime = 0x9E3779B97F4A7C15ull;
+    UINT64 h = in_seed ^ (in_numBytes * prime);
+
+    const size_t numWords = in_numBytes / sizeof(UINT64);
+    for (size_t i = 0; i < numWords; i++)
+    {
+        UINT64 k;
+        memcpy(&k, in_pBytes + (i * sizeof(UINT64)), sizeof(k)); // source may be unaligned
+        k *= prime;
+        k ^= k >> 31;
+        h = (h ^ k) * 0xBF58476D1CE4E5B9ull;
+        h ^= h >> 29;
+    }
+
+    UINT64 tail = 0;
+    memcpy(&tail, in_pBytes + (numWords * sizeof(UINT64)), in_numBytes - (numWords * sizeof(UINT64)));
+    h = (h ^ (tail * prime)) * 0x94D049BB133111EBull;
+    h ^= h >> 32;
+
+    return h;
+}
+
+//-----------------------------------------------------------------------------
+// hash large buffers in parallel chunks, then hash the array of chunk hashes
+//-----------------------------------------------------------------------------
+UINT64 HashBytesParallel(const BYTE* in_pBytes, size_t in_numBytes)
+{
+    const size_t chunkSize = 1024 * 1024;
+    const UINT numChunks = UINT((in_numBytes + chunkSize - 1) / chunkSize);
+
+    std::vector<UINT64> chunkHashes(numChunks);
+    concurrency::parallel_for(UINT(0), numChunks, [&](UINT i)
+        {
+            size_t offset = i * chunkSize;
+            chunkHashes[i] = HashBytes(in_pBytes + offset, std::min(chunkSize, in_numBytes - offset));
+        });
+
+    return HashBytes((BYTE*)chunkHashes.data(), chunkHashes.size() * sizeof(UINT64), in_numBytes);
+}
+
+//-----------------------------------------------------------------------------
+// anything that changes the output for identical input
+//-----------------------------------------------------------------------------
+UINT64 GetParametersHash()
+{
+    UINT32 parameters[] = { CONVERTER_REVISION, XetFileHeader::GetVersion(), m_compressionFormat, (UINT32)m_compressionLevel };
+    UINT64 h = HashBytes((BYTE*)parameters, sizeof(parameters));
+    return HashBytes((BYTE*)m_storeFileName.data(), m_storeFileName.size() * sizeof(wchar_t), h);
+}
+
+//-----------------------------------------------------------------------------
+// returns true if the sidecar exists, is valid, and was built with the current parameters
+//-----------------------------------------------------------------------------
+bool ReadHashFile(const std::wstring& in_outFileName, XetHashFileHeader& out_header, std::vector<UINT64>& out_tileHashes)
+{
+    std::ifstream inFile(in_outFileName + L".hash", std::ios::binary);
+    if (inFile.fail()) { return false; }
+
+    inFile.read((char*)&out_header, sizeof(out_header));
+    if ((!inFile.good()) ||
+        (XetHashFileHeader::GetMagic() != out_header.m_magic) ||
+        (XetHashFileHeader::GetVersion() != out_header.m_version) ||
+        (GetParametersHash() != out_header.m_parametersHash))
+    {
+        return false;
+    }
+
+    out_tileHashes.resize(out_header.m_numTiles);
+    inFile.read((char*)out_tileHashes.data(), out_tileHashes.size() * sizeof(UINT64));
+    return inFile.good();
+}
+
+//-----------------------------------------------------------------------------
+// the input changed, but many tiles may not have.
+// load the previous output so WriteTiles() can copy already-compressed tiles
+//-----------------------------------------------------------------------------
+void LoadPreviousTiles(const std::wstring& in_outFileName, const std::vector<UINT64>& in_tileHashes, UINT64 in_outputSize)
+{
+    if (!std::filesystem::exists(in_outFileName)) { return; }
+    if (std::filesystem::file_size(in_outFileName) != in_outputSize) { return; }
+
+    std::ifstream inFile(in_outFileName, std::ios::binary);
+    m_previousFile.resize(in_outputSize);
+    inFile.read((char*)m_previousFile.data(), m_previousFile.size());
+    if (!inFile.good()) { m_previousFile.clear(); return; }
+
+    const XetFileHeader& header = *(XetFileHeader*)m_previousFile.data();
+    if ((XetFileHeader::GetMagic() != header.m_magic) || (!XetFileHeader::IsSupportedVersion(header.m_version)) ||
+        (header.m_mipInfo.m_numTilesForStandardMips != in_tileHashes.size()))
+    {
+        m_previousFile.clear();
+        return;
+    }
+
+    const XetFileHeader::TileData* pTileData = (XetFileHeader::TileData*)(m_previousFile.data() + sizeof(header) +
+        (header.m_ddsHeader.mipMapCount * sizeof(XetFileHeader::SubresourceInfo)));
+
+    for (UINT i = 0; i < (UINT)in_tileHashes.size(); i++)
+    {
+        // tiles that were moved to a tile store have no bytes in the file
+        if (pTileData[i].m_numBytes && ((pTileData[i].m_offset + pTileData[i].m_numBytes) <= m_previousFile.size()))
+        {
+            m_previousTiles[in_tileHashes[i]] = pTileData[i];
+        }
+    }
+}
+
 //-----------------------------------------------------------------------------
 // return aligned # bytes based on conservative 4KB alignment
 //-----------------------------------------------------------------------------
@@ -261,6 +425,27 @@ UINT ReadTile(BYTE* out_pDst,
     return XetFileHeader::GetTileSize();
 }
 
+//-----------------------------------------------------------------------------
+// convert linear tile index to coordinate
+//-----------------------------------------------------------------------------
+D3D12_TILED_RESOURCE_COORDINATE GetTileCoord(const XetFileHeader& in_header, UINT in_tileIndex)
+{
+    // search for the mip corresponding to this tile index
+    // starts at mip 0, which contains most tiles
+    // FIXME? optimize search?
+    UINT s = 0;
+    while ((s < (in_header.m_mipInfo.m_numStandardMips - 1)) &&
+        (in_tileIndex >= m_subresourceInfo[s + 1].m_standardMipInfo.m_subresourceTileIndex))
+    {
+        s++;
+    }
+    UINT i = in_tileIndex - m_subresourceInfo[s].m_standardMipInfo.m_subresourceTileIndex;
+    UINT y = i / m_subresourceInfo[s].m_standardMipInfo.m_widthTiles;
+    UINT x = i - (y * m_subresourceInfo[s].m_standardMipInfo.m_widthTiles);
+
+    return D3D12_TILED_RESOURCE_COORDINATE{ x, y, 0, s };
+}
+
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 void CompressTile(std::vector<BYTE>& inout_tile)
@@ -281,6 +466,102 @@ void CompressTile(std::vector<BYTE>& inout_tile)
     inout_tile.swap(scratch);
 }
 
+//-----------------------------------------------------------------------------
+// a 64-bit tile hash match is not proof of identical content. decode the previous
+// bytes and compare them to the new uncompressed tile before re-using them
+//-----------------------------------------------------------------------------
+bool PreviousTileMatches(const std::vector<BYTE>& in_tile, const XetFileHeader::TileData& in_previous)
+{
+    const BYTE* pPrevious = &m_previousFile[in_previous.m_offset];
+    if (D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES == in_previous.m_numBytes)
+    {
+        return 0 == memcmp(pPrevious, in_tile.data(), D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES);
+    }
+
+    if (nullptr == m_compressor.Get()) { return false; }
+
+    std::vector<BYTE> decompressed(D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES);
+    size_t decompressedSize = 0;
+    HRESULT hr = m_compressor->DecompressBuffer(pPrevious, in_previous.m_numBytes,
+        decompressed.data(), decompressed.size(), &decompressedSize);
+
+    return SUCCEEDED(hr) && (decompressed.size() == decompressedSize) &&
+        (0 == memcmp(decompressed.data(), in_tile.data(), decompressed.size()));
+}
+
+//-----------------------------------------------------------------------------
+// statistics of the uncompressed tile. m_numBytes is filled in after compression
+//-----------------------------------------------------------------------------
+XetStatsFileHeader::TileStats GetTileStats(const std::vector<BYTE>& in_tile, UINT in_bytesPerBlock)
+{
+    XetStatsFileHeader::TileStats stats{};
+
+    UINT histogram[256]{};
+    for (BYTE b : in_tile) { histogram[b]++; }
+
+    float numBytes = (float)in_tile.size();
+    for (UINT count : histogram)
+    {
+        if (count)
+        {
+            float p = count / numBytes;
+            stats.m_entropy -= p * std::log2(p);
+        }
+    }
+
+    bool uniform = true;
+    for (size_t i = in_bytesPerBlock; uniform && (i < in_tile.size()); i += in_bytesPerBlock)
+    {
+        uniform = (0 == memcmp(&in_tile[0], &in_tile[i], in_bytesPerBlock));
+    }
+    if (uniform) { stats.m_flags |= XetStatsFileHeader::TILE_FLAG_UNIFORM; }
+
+    return stats;
+}
+
+//-----------------------------------------------------------------------------
+// summarize tile statistics per standard mip
+//-----------------------------------------------------------------------------
+std::vector<XetStatsFileHeader::MipStats> GetMipStats(const XetFileHeader& in_header)
+{
+    std::vector<XetStatsFileHeader::MipStats> mipStats(in_header.m_mipInfo.m_numStandardMips);
+    for (UINT s = 0; s < in_header.m_mipInfo.m_numStandardMips; s++)
+    {
+        const auto& info = m_subresourceInfo[s].m_standardMipInfo;
+        UINT numTiles = info.m_widthTiles * info.m_heightTiles;
+
+        auto& m = mipStats[s];
+        m.m_numTiles = numTiles;
+        m.m_minTileBytes = UINT32(-1);
+        for (UINT i = info.m_subresourceTileIndex; i < (info.m_subresourceTileIndex + numTiles); i++)
+        {
+            const auto& t = m_tileStats[i];
+            if (t.m_flags & XetStatsFileHeader::TILE_FLAG_UNIFORM) { m.m_numUniformTiles++; }
+            m.m_numBytes += t.m_numBytes;
+            m.m_averageEntropy += t.m_entropy;
+            m.m_minTileBytes = std::min(m.m_minTileBytes, t.m_numBytes);
+            m.m_maxTileBytes = std::max(m.m_maxTileBytes, t.m_numBytes);
+        }
+        if (numTiles) { m.m_averageEntropy /= numTiles; }
+    }
+    return mipStats;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+void PrintMipStats(const std::vector<XetStatsFileHeader::MipStats>& in_mipStats)
+{
+    std::wcout << "mip tiles uniform    bytes  avg/tile  min/tile  max/tile entropy" << std::endl;
+    for (UINT s = 0; s < (UINT)in_mipStats.size(); s++)
+    {
+        const auto& m = in_mipStats[s];
+        std::wcout << std::setw(3) << s << std::setw(6) << m.m_numTiles << std::setw(8) << m.m_numUniformTiles
+            << std::setw(9) << m.m_numBytes << std::setw(10) << (m.m_numTiles ? m.m_numBytes / m.m_numTiles : 0)
+            << std::setw(10) << m.m_minTileBytes << std::setw(10) << m.m_maxTileBytes
+            << std::setw(8) << std::fixed << std::setprecision(2) << m.m_averageEntropy << std::endl;
+    }
+}
+
 //-----------------------------------------------------------------------------
 // builds offset table and fills tiled texture data
 //-----------------------------------------------------------------------------
@@ -293,6 +574,18 @@ void WriteTiles(const XetFileHeader& in_header, const BYTE* in_pSrc)
     // texture data starts after the header, and after the table of offsets
     std::atomic<uint32_t> offset = 0;
 
+    UINT bytesPerBlock = 16;
+    switch (in_header.m_extensionHeader.dxgiFormat)
+    {
+    case DXGI_FORMAT_BC1_TYPELESS:
+    case DXGI_FORMAT_BC1_UNORM:
+    case DXGI_FORMAT_BC1_UNORM_SRGB:
+        bytesPerBlock = 8;
+        break;
+    default: // BC7
+        break;
+    }
+
     UINT numTiles = (UINT)m_offsets.size() - 1;
     concurrency::parallel_for(UINT(0), numTiles, [&](UINT tileIndex)
         {
@@ -306,28 +599,32 @@ void WriteTiles(const XetFileHeader& in_header, const BYTE* in_pSrc)
             }
             else
             {
-                // convert linear tile index to coordinate
-                // search for the mip corresponding to this tile index
-                // starts at mip 0, which contains most tiles
-                // FIXME? optimize search?
-                UINT s = 0;
-                while ((s < (in_header.m_mipInfo.m_numStandardMips - 1)) &&
-                    (tileIndex >= m_subresourceInfo[s + 1].m_standardMipInfo.m_subresourceTileIndex))
-                {
-                    s++;
-                }
-                UINT i = tileIndex - m_subresourceInfo[s].m_standardMipInfo.m_subresourceTileIndex;
-                UINT y = i / m_subresourceInfo[s].m_standardMipInfo.m_widthTiles;
-                UINT x = i - (y * m_subresourceInfo[s].m_standardMipInfo.m_widthTiles);
-
-                ReadTile(tile.data(), D3D12_TILED_RESOURCE_COORDINATE{ x, y, 0, s }, m_subresourceData[s], in_pSrc);
+                auto coord = GetTileCoord(in_header, tileIndex);
+                ReadTile(tile.data(), coord, m_subresourceData[coord.Subresource], in_pSrc);
             }
 
-            if (m_compressionFormat)
+            m_tileHashes[tileIndex] = HashBytes(tile.data(), tile.size());
+            m_tileStats[tileIndex] = GetTileStats(tile, bytesPerBlock);
+
+            // identical tile in the previous output? take its (possibly compressed) bytes as-is
+            auto previous = m_previousTiles.find(m_tileHashes[tileIndex]);
+            if ((m_previousTiles.end() != previous) && PreviousTileMatches(tile, previous->second))
+            {
+                const BYTE* pPrevious = &m_previousFile[previous->second.m_offset];
+                tile.assign(pPrevious, pPrevious + previous->second.m_numBytes);
+                m_numTilesReused.fetch_add(1, std::memory_order_relaxed);
+            }
+            else if (m_compressionFormat)
             {
                 CompressTile(tile);
             }
 
+            m_tileStats[tileIndex].m_numBytes = (UINT)tile.size();
+            if (tile.size() < D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES)
+            {
+                m_tileStats[tileIndex].m_flags |= XetStatsFileHeader::TILE_FLAG_COMPRESSED;
+            }
+
             UINT uniqueOffset = offset.fetch_add((UINT)tile.size(), std::memory_order_relaxed);
             memcpy(&m_textureData[uniqueOffset], tile.data(), tile.size()); // copy bytes
 
@@ -343,6 +640,209 @@ void WriteTiles(const XetFileHeader& in_header, const BYTE* in_pSrc)
     m_textureData.resize(offset);
 }
 
+//-----------------------------------------------------------------------------
+// read the lower-quality encoding of the input. must match the input's dimensions, format, and mips
+// returns pointer to the beginning of the DDS data within in_fileBytes
+//-----------------------------------------------------------------------------
+const BYTE* ReadLowTierFile(const XetFileHeader& in_header, const std::vector<BYTE>& in_fileBytes)
+{
+    if ((in_fileBytes.size() < (sizeof(UINT32) + sizeof(DirectX::DDS_HEADER))) ||
+        (DirectX::DDS_MAGIC != *(UINT32*)in_fileBytes.data()))
+    {
+        Error(m_lowTierFileName + L" is not a valid DDS file");
+    }
+
+    const BYTE* pBits = in_fileBytes.data() + sizeof(UINT32);
+    DirectX::DDS_HEADER ddsHeader = *(DirectX::DDS_HEADER*)pBits;
+    pBits += ddsHeader.size;
+
+    DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+    if ((ddsHeader.ddspf.flags & DDS_FOURCC) && (MAKEFOURCC('D', 'X', '1', '0') == ddsHeader.ddspf.fourCC))
+    {
+        format = ((DirectX::DDS_HEADER_DXT10*)pBits)->dxgiFormat;
+        pBits += sizeof(DirectX::DDS_HEADER_DXT10);
+    }
+    else
+    {
+        format = GetFormatFromHeader(ddsHeader);
+    }
+
+    if (0 == ddsHeader.mipMapCount) { ddsHeader.mipMapCount = 1; }
+
+    // a reserved resource has a single format, so the tiers can only differ in encoding quality
+    if ((ddsHeader.width != in_header.m_ddsHeader.width) ||
+        (ddsHeader.height != in_header.m_ddsHeader.height) ||
+        (ddsHeader.mipMapCount != in_header.m_ddsHeader.mipMapCount) ||
+        (format != in_header.m_extensionHeader.dxgiFormat))
+    {
+        Error(m_lowTierFileName + L" must have the same dimensions, format, and mip count as the input");
+    }
+
+    return pBits;
+}
+
+//-----------------------------------------------------------------------------
+// builds the low tier offset table and tile data
+// a tile that doesn't get smaller than the full quality tile is not stored (m_numBytes = 0)
+//-----------------------------------------------------------------------------
+void WriteLowTierTiles(const XetFileHeader& in_header, const BYTE* in_pSrc)
+{
+    UINT numTiles = (UINT)m_offsets.size() - 1;
+    m_lowTierOffsets.resize(numTiles);
+    m_lowTierData.resize(numTiles * (size_t)D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES);
+
+    std::atomic<uint32_t> offset = 0;
+    concurrency::parallel_for(UINT(0), numTiles, [&](UINT tileIndex)
+        {
+            std::vector<BYTE> tile(D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES);
+
+            auto coord = GetTileCoord(in_header, tileIndex);
+            ReadTile(tile.data(), coord, m_subresourceData[coord.Subresource], in_pSrc);
+
+            if (m_compressionFormat)
+            {
+                CompressTile(tile);
+            }
+
+            m_lowTierOffsets[tileIndex] = { .m_offset = 0, .m_numBytes = 0 };
+            if (tile.size() < m_offsets[tileIndex].m_numBytes)
+            {
+                UINT uniqueOffset = offset.fetch_add((UINT)tile.size(), std::memory_order_relaxed);
+                memcpy(&m_lowTierData[uniqueOffset], tile.data(), tile.size());
+                m_lowTierOffsets[tileIndex] = { .m_offset = uniqueOffset, .m_numBytes = (UINT)tile.size() };
+            }
+        });
+    m_lowTierData.resize(offset);
+}
+
+//-----------------------------------------------------------------------------
+// move tiles into the shared content-addressed store, or reference them if already there
+// identical tiles across all outputs that use the same store are stored once
+// must be called before WritePackedMips(), as it compacts m_textureData
+//-----------------------------------------------------------------------------
+void AddTilesToStore()
+{
+    std::wstring indexFileName = m_storeFileName + L".index";
+
+    // load the index, if the store exists
+    XetStoreFileHeader storeHeader;
+    storeHeader.m_compressionFormat = m_compressionFormat;
+    std::unordered_map<UINT64, XetStoreFileHeader::StoreEntry> index;
+    if (std::filesystem::exists(m_storeFileName) && std::filesystem::exists(indexFileName))
+    {
+        std::ifstream indexFile(indexFileName, std::ios::binary);
+        indexFile.read((char*)&storeHeader, sizeof(storeHeader));
+        if ((!indexFile.good()) || (XetStoreFileHeader::GetMagic() != storeHeader.m_magic) ||
+            (XetStoreFileHeader::GetVersion() != storeHeader.m_version))
+        {
+            Error(indexFileName + L" is not a valid tile store index");
+        }
+        if (storeHeader.m_compressionFormat != m_compressionFormat)
+        {
+            Error(m_storeFileName + L" was built with a different compression format");
+        }
+
+        std::vector<XetStoreFileHeader::StoreEntry> entries((size_t)storeHeader.m_numTiles);
+        indexFile.read((char*)entries.data(), entries.size() * sizeof(entries[0]));
+        if (!indexFile.good()) { Error(indexFileName + L" is truncated"); }
+        for (const auto& e : entries) { index[e.m_hash] = e; }
+    }
+    else
+    {
+        std::vector<BYTE> header(TILE_ALIGNMENT, 0);
+        memcpy(header.data(), &storeHeader, sizeof(storeHeader));
+
+        std::ofstream newStore(m_storeFileName, std::ios::out | std::ios::binary);
+        newStore.write((char*)header.data(), header.size());
+    }
+
+    std::fstream store(m_storeFileName, std::ios::in | std::ios::out | std::ios::binary);
+    if (store.fail()) { Error(L"Failed to open " + m_storeFileName); }
+    store.seekp(0, std::ios::end);
+    UINT64 storeSize = (UINT64)store.tellp();
+    assert(0 == (storeSize % TILE_ALIGNMENT));
+
+    // tiles are padded so each starts on an alignment boundary, as the reference file streamer
+    // reads with FILE_FLAG_NO_BUFFERING from offsets rounded down to the sector size
+    const std::vector<BYTE> padding(TILE_ALIGNMENT, 0);
+
+    UINT numFound = 0, numAdded = 0;
+    UINT64 numBytesFound = 0, numBytesAdded = 0;
+
+    m_storeHashes.assign(m_tileHashes.size(), 0);
+    std::vector<BYTE> compacted;
+    std::vector<BYTE> existing;
+    for (UINT i = 0; i < (UINT)m_tileHashes.size(); i++)
+    {
+        auto& tileData = m_offsets[i];
+        const BYTE* pTile = &m_textureData[tileData.m_offset];
+        const UINT64 hash = m_tileHashes[i];
+
+        bool stored = false;
+        if (hash)
+        {
+            auto found = index.find(hash);
+            if (index.end() == found)
+            {
+                const UINT paddedSize = GetAlignedSize(tileData.m_numBytes);
+                store.seekp(storeSize);
+                store.write((const char*)pTile, tileData.m_numBytes);
+                store.write((const char*)padding.data(), paddedSize - tileData.m_numBytes);
+                index[hash] = XetStoreFileHeader::StoreEntry{ hash, storeSize, tileData.m_numBytes, 0 };
+                storeSize += paddedSize;
+
+                numAdded++;
+                numBytesAdded += tileData.m_numBytes;
+                stored = true;
+            }
+            // guard against hash collisions: the stored bytes must be identical
+            else if (found->second.m_numBytes == tileData.m_numBytes)
+            {
+                existing.resize(tileData.m_numBytes);
+                store.seekg(found->second.m_offset);
+                store.read((char*)existing.data(), existing.size());
+                stored = store.good() && (0 == memcmp(existing.data(), pTile, tileData.m_numBytes));
+
+                if (stored)
+                {
+                    numFound++;
+                    numBytesFound += tileData.m_numBytes;
+                }
+            }
+        }
+
+        if (stored)
+        {
+            m_storeHashes[i] = hash;
+            tileData = { .m_offset = 0, .m_numBytes = 0 };
+        }
+        else
+        {
+            UINT offset = (UINT)compacted.size();
+            compacted.insert(compacted.end(), pTile, pTile + tileData.m_numBytes);
+            tileData.m_offset = offset;
+        }
+    }
+    m_textureData.swap(compacted);
+    if (!store.good()) { Error(L"Failed writing " + m_storeFileName); }
+    store.close();
+
+    // rewrite the index, sorted by hash so it can be searched
+    std::vector<XetStoreFileHeader::StoreEntry> entries;
+    entries.reserve(index.size());
+    for (const auto& e : index) { entries.push_back(e.second); }
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.m_hash < b.m_hash; });
+
+    storeHeader.m_numTiles = entries.size();
+    std::ofstream indexFile(indexFileName, std::ios::out | std::ios::binary);
+    indexFile.write((char*)&storeHeader, sizeof(storeHeader));
+    indexFile.write((char*)entries.data(), entries.size() * sizeof(entries[0]));
+
+    std::wcout << "store: " << numFound << " tiles (" << numBytesFound << " bytes) already stored, "
+        << numAdded << " tiles (" << numBytesAdded << " bytes) added. store holds "
+        << entries.size() << " tiles, " << storeSize - TILE_ALIGNMENT << " bytes" << std::endl;
+}
+
 //-----------------------------------------------------------------------------
 // pad packed mips according to copyable footprint requirements
 //-----------------------------------------------------------------------------
@@ -367,6 +867,8 @@ void PadPackedMips(const XetFileHeader& in_header, const BYTE* in_psrc, std::vec
 
     for (UINT i = 0; i < numSubresources; i++)
     {
+        // each subresource starts at its footprint offset, which may be past the previous subresource's last row
+        pDst = out_paddedPackedMips.data() + srcLayout[i].Offset;
         for (UINT r = 0; r < numRows[i]; r++)
         {
             memcpy(pDst, in_psrc, rowSizeBytes[i]);
@@ -433,8 +935,30 @@ int main()
     argParser.AddArg(L"-in", inFileName);
     argParser.AddArg(L"-out", outFileName);
     argParser.AddArg(L"-compress", m_compressionFormat, L"compression format");
+    argParser.AddArg(L"-force", m_forceRebuild, L"ignore <out>.hash and rebuild everything");
+    argParser.AddArg(L"-stats", m_printStats, L"print per-mip tile statistics");
+    argParser.AddArg(L"-lowtier", m_lowTierFileName, L"lower-quality encoding of -in (same size, format, and mips) to store as a second tier");
+    argParser.AddArg(L"-store", m_storeFileName, L"content-addressed tile store shared by outputs. created if necessary");
+
+    std::wstring migratePath;
+    std::wstring validatePath;
+    argParser.AddArg(L"-migrate", migratePath, L"v2 XET file or directory to migrate, in parallel, to the current format in the -out directory");
+    argParser.AddArg(L"-validate", validatePath, L"XET file or directory to check for consistency");
     argParser.Parse();
 
+    //--------------------------
+    // bulk modes work on many files, and do not use the single-file state below
+    //--------------------------
+    if (validatePath.size())
+    {
+        return (int)ValidateXetFiles(validatePath);
+    }
+    if (migratePath.size())
+    {
+        if (0 == outFileName.size()) { Error(L"-migrate requires an -out directory"); }
+        return (int)MigrateXetFiles(migratePath, outFileName, m_compressionFormat, (UINT32)m_compressionLevel, m_forceRebuild);
+    }
+
     //--------------------------
     // read dds file
     //--------------------------
@@ -455,6 +979,47 @@ int main()
         Error(L"Failed to map file");
     }
 
+    //--------------------------
+    // skip if the output is up to date
+    //--------------------------
+    std::filesystem::path inFilePath(inFileName);
+    auto fileSize = std::filesystem::file_size(inFilePath);
+
+    XetHashFileHeader hashHeader;
+    hashHeader.m_sourceHash = HashBytesParallel(pInFileBytes, fileSize);
+    hashHeader.m_parametersHash = GetParametersHash();
+
+    // the low tier input is part of the source
+    std::vector<BYTE> lowTierFile;
+    if (m_lowTierFileName.size())
+    {
+        std::ifstream lowTierStream(m_lowTierFileName, std::ios::binary);
+        if (lowTierStream.fail()) { Error(L"Failed to open " + m_lowTierFileName); }
+        lowTierFile.resize(std::filesystem::file_size(m_lowTierFileName));
+        lowTierStream.read((char*)lowTierFile.data(), lowTierFile.size());
+
+        UINT64 hashes[] = { hashHeader.m_sourceHash, HashBytesParallel(lowTierFile.data(), lowTierFile.size()) };
+        hashHeader.m_sourceHash = HashBytes((BYTE*)hashes, sizeof(hashes));
+    }
+    {
+        XetHashFileHeader previousHeader;
+        std::vector<UINT64> previousTileHashes;
+        if ((!m_forceRebuild) && ReadHashFile(outFileName, previousHeader, previousTileHashes))
+        {
+            if ((previousHeader.m_sourceHash == hashHeader.m_sourceHash) &&
+                std::filesystem::exists(outFileName) && std::filesystem::exists(outFileName + L".stats") &&
+                (std::filesystem::file_size(outFileName) == previousHeader.m_outputSize))
+            {
+                std::wcout << outFileName << " up to date" << std::endl;
+                UnmapViewOfFile(pInFileBytes);
+                CloseHandle(inFileMapping);
+                CloseHandle(inFileHandle);
+                return 0;
+            }
+            LoadPreviousTiles(outFileName, previousTileHashes, previousHeader.m_outputSize);
+        }
+    }
+
     XetFileHeader header;
     header.m_compressionFormat = m_compressionFormat;
 
@@ -515,10 +1080,9 @@ int main()
     //--------------------------
     // reserve output space
     //--------------------------
-    std::filesystem::path inFilePath(inFileName);
-    auto fileSize = std::filesystem::file_size(inFilePath);
-
     m_offsets.resize(header.m_mipInfo.m_numTilesForStandardMips + 1);
+    m_tileHashes.resize(header.m_mipInfo.m_numTilesForStandardMips);
+    m_tileStats.resize(header.m_mipInfo.m_numTilesForStandardMips);
     // reserve enough space to hold all tiles, worst case
     m_textureData.resize(m_offsets.size() * (TILE_ALIGNMENT + D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES));
 
@@ -530,6 +1094,19 @@ int main()
         HRESULT hr = DStorageCreateCompressionCodec((DSTORAGE_COMPRESSION_FORMAT)m_compressionFormat, 2, IID_PPV_ARGS(&m_compressor));
     }
     WriteTiles(header, pBits);
+
+    // compares sizes with the full quality tiles, so must precede moving tiles to the store
+    if (lowTierFile.size())
+    {
+        if (m_convertFromXet2) { Error(L"-lowtier requires a DDS input"); }
+        WriteLowTierTiles(header, ReadLowTierFile(header, lowTierFile));
+    }
+
+    if (m_storeFileName.size())
+    {
+        AddTilesToStore();
+    }
+
     header.m_mipInfo.m_numUncompressedBytesForPackedMips = WritePackedMips(header, pInFileBytes, fileSize);
 
     //------------------------------------------
@@ -549,9 +1126,16 @@ int main()
     }
 
     // correct the tile offsets to account for the preceding data
+    // tiles in the tile store have no bytes in this file
     for (auto& o : m_offsets)
     {
-        o.m_offset += (UINT)textureDataOffset;
+        if (o.m_numBytes) { o.m_offset += (UINT)textureDataOffset; }
+    }
+
+    // readers without tile store support must reject this file
+    if (m_storeHashes.size())
+    {
+        header.m_version = XetFileHeader::GetStoreVersion();
     }
 
     std::ofstream outFile(outFileName, std::ios::out | std::ios::binary);
@@ -569,6 +1153,92 @@ int main()
     outFile.write((char*)m_textureData.data(), m_textureData.size());
     outFile.write((char*)m_packedMipData.data(), (UINT)m_packedMipData.size());
 
+    //------------------------------------------
+    // low tier follows the packed mips, so the layout above is unaffected
+    //------------------------------------------
+    if (m_lowTierOffsets.size())
+    {
+        UINT lowTierDataOffset = (UINT)outFile.tellp();
+        UINT64 numFullBytes = 0;
+        UINT numLowTierTiles = 0;
+        for (UINT i = 0; i < (UINT)m_lowTierOffsets.size(); i++)
+        {
+            auto& o = m_lowTierOffsets[i];
+            if (o.m_numBytes)
+            {
+                o.m_offset += lowTierDataOffset;
+                numFullBytes += m_offsets[i].m_numBytes;
+                numLowTierTiles++;
+            }
+        }
+
+        XetTierFooter footer;
+        footer.m_numTiles = (UINT32)m_lowTierOffsets.size();
+        footer.m_tableOffset = lowTierDataOffset + (UINT32)m_lowTierData.size();
+
+        outFile.write((char*)m_lowTierData.data(), m_lowTierData.size());
+        outFile.write((char*)m_lowTierOffsets.data(), m_lowTierOffsets.size() * sizeof(m_lowTierOffsets[0]));
+        outFile.write((char*)&footer, sizeof(footer));
+
+        // heap usage is the same for both tiers: tiles are always 64KB once uploaded
+        std::wcout << "low tier: " << numLowTierTiles << " of " << m_lowTierOffsets.size() << " tiles, "
+            << m_lowTierData.size() << " bytes replace " << numFullBytes << " full quality bytes" << std::endl;
+    }
+
+    //------------------------------------------
+    // tile store reference is last. the store name is relative to the output
+    //------------------------------------------
+    if (m_storeHashes.size())
+    {
+        std::wstring storeName = std::filesystem::relative(std::filesystem::absolute(m_storeFileName),
+            std::filesystem::absolute(outFileName).parent_path()).wstring();
+
+        XetStoreFooter footer;
+        footer.m_numTiles = (UINT32)m_storeHashes.size();
+        footer.m_sectionOffset = (UINT32)outFile.tellp();
+        footer.m_tableOffset = footer.m_sectionOffset;
+        footer.m_storeNameBytes = (UINT32)(storeName.size() * sizeof(wchar_t));
+
+        outFile.write((char*)m_storeHashes.data(), m_storeHashes.size() * sizeof(m_storeHashes[0]));
+        outFile.write((char*)storeName.data(), footer.m_storeNameBytes);
+        outFile.write((char*)&footer, sizeof(footer));
+    }
+
+    //------------------------------------------
+    // tile statistics sidecar, optionally read by XeTexture
+    //------------------------------------------
+    {
+        auto mipStats = GetMipStats(header);
+
+        XetStatsFileHeader statsHeader;
+        statsHeader.m_numTiles = (UINT32)m_tileStats.size();
+        statsHeader.m_numMips = (UINT32)mipStats.size();
+
+        std::ofstream statsFile(outFileName + L".stats", std::ios::out | std::ios::binary);
+        statsFile.write((char*)&statsHeader, sizeof(statsHeader));
+        statsFile.write((char*)m_tileStats.data(), m_tileStats.size() * sizeof(m_tileStats[0]));
+        statsFile.write((char*)mipStats.data(), mipStats.size() * sizeof(mipStats[0]));
+
+        if (m_printStats) { PrintMipStats(mipStats); }
+    }
+
+    //------------------------------------------
+    // write sidecar last, so an interrupted conversion is never considered up to date
+    //------------------------------------------
+    hashHeader.m_outputSize = (UINT64)outFile.tellp();
+    hashHeader.m_numTiles = (UINT32)m_tileHashes.size();
+    outFile.close();
+    {
+        std::ofstream hashFile(outFileName + L".hash", std::ios::out | std::ios::binary);
+        hashFile.write((char*)&hashHeader, sizeof(hashHeader));
+        hashFile.write((char*)m_tileHashes.data(), m_tileHashes.size() * sizeof(UINT64));
+    }
+
+    if (m_numTilesReused)
+    {
+        std::wcout << "re-used " << m_numTilesReused << " of " << m_tileHashes.size() << " tiles" << std::endl;
+    }
+
     UnmapViewOfFile(pInFileBytes);
     CloseHandle(inFileMapping);
     CloseHandle(inFileHandle);
@@ -0,0 +1,717 @@
+//*********************************************************
+//
+// Copyright 2020 Intel Corporation 
+//
+// Permission is hereby granted, free of charge, to any 
+// person obtaining a copy of this software and associated 
+// documentation files(the "Software"), to deal in the Software 
+// without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to 
+// whom the Software is furnished to do so, subject to the 
+// following conditions :
+// The above copyright notice and this permission notice shall 
+// be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+// DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+
+
+// see XetMigrate.h
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <ppl.h>
+#include <d3d12.h>
+#include <dstorage.h>
+#include <wrl/client.h>
+
+#include "XeTv2.h"
+#include "XetFileHeader.h"
+#include "XetMigrate.h"
+
+using Microsoft::WRL::ComPtr;
+
+//-----------------------------------------------------------------------------
+// read-only view of an entire file
+//-----------------------------------------------------------------------------
+class MappedFile
+{
+public:
+    MappedFile(const std::wstring& in_fileName)
+    {
+        m_fileHandle = CreateFile(in_fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (INVALID_HANDLE_VALUE == m_fileHandle) { return; }
+
+        LARGE_INTEGER fileSize{};
+        GetFileSizeEx(m_fileHandle, &fileSize);
+        m_numBytes = (UINT64)fileSize.QuadPart;
+        if (0 == m_numBytes) { return; } // can't map an empty file
+
+        m_fileMapping = CreateFileMapping(m_fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (NULL == m_fileMapping) { return; }
+
+        m_pBytes = (const BYTE*)MapViewOfFile(m_fileMapping, FILE_MAP_READ, 0, 0, 0);
+    }
+    ~MappedFile()
+    {
+        if (m_pBytes) { UnmapViewOfFile(m_pBytes); }
+        if (m_fileMapping) { CloseHandle(m_fileMapping); }
+        if (INVALID_HANDLE_VALUE != m_fileHandle) { CloseHandle(m_fileHandle); }
+    }
+    const BYTE* GetBytes() const { return m_pBytes; } // null on failure
+    UINT64 GetNumBytes() const { return m_numBytes; }
+private:
+    HANDLE m_fileHandle{ INVALID_HANDLE_VALUE };
+    HANDLE m_fileMapping{ NULL };
+    const BYTE* m_pBytes{ nullptr };
+    UINT64 m_numBytes{ 0 };
+};
+
+//-----------------------------------------------------------------------------
+// location of one packed mip within the padded packed mip data
+//-----------------------------------------------------------------------------
+struct PackedMipFootprint
+{
+    UINT64 m_offset;
+    UINT32 m_rowPitch;     // padded
+    UINT32 m_rowSizeBytes; // unpadded
+    UINT32 m_numRows;
+};
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+static UINT64 AlignUp(UINT64 in_value, UINT64 in_alignment)
+{
+    return (in_value + in_alignment - 1) & ~(in_alignment - 1);
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+static UINT GetBytesPerBlock(DXGI_FORMAT in_format)
+{
+    switch (in_format)
+    {
+    case DXGI_FORMAT_BC1_TYPELESS:
+    case DXGI_FORMAT_BC1_UNORM:
+    case DXGI_FORMAT_BC1_UNORM_SRGB:
+        return 8;
+    default: // BC7
+        return 16;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// CPU equivalent of ID3D12Device::GetCopyableFootprints() for the packed mips of a BC texture
+// returns the total # bytes, which is the padded (uncompressed) size of the packed mips
+//-----------------------------------------------------------------------------
+static UINT64 GetPackedMipFootprints(std::vector<PackedMipFootprint>& out_footprints,
+    const DirectX::DDS_HEADER& in_ddsHeader, DXGI_FORMAT in_format, UINT in_firstMip, UINT in_numMips)
+{
+    UINT bytesPerBlock = GetBytesPerBlock(in_format);
+
+    UINT64 totalBytes = 0;
+    out_footprints.resize(in_numMips);
+    for (UINT i = 0; i < in_numMips; i++)
+    {
+        UINT mip = in_firstMip + i;
+        UINT w = std::max<UINT>(1, in_ddsHeader.width >> mip);
+        UINT h = std::max<UINT>(1, in_ddsHeader.height >> mip);
+
+        auto& f = out_footprints[i];
+        f.m_rowSizeBytes = std::max<UINT>(1, (w + 3) / 4) * bytesPerBlock;
+        f.m_numRows = std::max<UINT>(1, (h + 3) / 4);
+        f.m_rowPitch = (UINT32)AlignUp(f.m_rowSizeBytes, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT);
+        f.m_offset = AlignUp(totalBytes, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+        // the last row is not padded
+        totalBytes = f.m_offset + (UINT64(f.m_rowPitch) * (f.m_numRows - 1)) + f.m_rowSizeBytes;
+    }
+    return totalBytes;
+}
+
+//-----------------------------------------------------------------------------
+// place tightly packed mips at their footprints
+//-----------------------------------------------------------------------------
+static void PadPackedMips(std::vector<BYTE>& out_paddedPackedMips,
+    const std::vector<PackedMipFootprint>& in_footprints, UINT64 in_totalBytes, const BYTE* in_pSrc)
+{
+    out_paddedPackedMips.assign((size_t)in_totalBytes, 0);
+    for (const auto& f : in_footprints)
+    {
+        BYTE* pDst = &out_paddedPackedMips[(size_t)f.m_offset];
+        for (UINT r = 0; r < f.m_numRows; r++)
+        {
+            memcpy(pDst, in_pSrc, f.m_rowSizeBytes);
+            pDst += f.m_rowPitch;
+            in_pSrc += f.m_rowSizeBytes;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+static bool Compress(std::vector<BYTE>& out_bytes, IDStorageCompressionCodec* in_pCodec,
+    DSTORAGE_COMPRESSION in_compressionLevel, const BYTE* in_pSrc, UINT32 in_numBytes)
+{
+    size_t bound = in_pCodec->CompressBufferBound(in_numBytes);
+    out_bytes.resize(bound);
+
+    size_t compressedDataSize = 0;
+    HRESULT hr = in_pCodec->CompressBuffer(in_pSrc, in_numBytes, in_compressionLevel,
+        out_bytes.data(), bound, &compressedDataSize);
+
+    out_bytes.resize(compressedDataSize);
+    return SUCCEEDED(hr);
+}
+
+//-----------------------------------------------------------------------------
+// every .xet file below a directory, or the single file
+// the second path of each pair is relative to in_path, to mirror the directory structure
+//-----------------------------------------------------------------------------
+static std::vector<std::pair<std::filesystem::path, std::filesystem::path>> GetXetFiles(const std::wstring& in_path)
+{
+    std::vector<std::pair<std::filesystem::path, std::filesystem::path>> files;
+
+    std::filesystem::path path(in_path);
+    if (std::filesystem::is_directory(path))
+    {
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(path))
+        {
+            if (entry.is_regular_file() && (0 == _wcsicmp(entry.path().extension().c_str(), L".xet")))
+            {
+                files.emplace_back(entry.path(), std::filesystem::relative(entry.path(), path));
+            }
+        }
+    }
+    else if (std::filesystem::exists(path))
+    {
+        files.emplace_back(path, path.filename());
+    }
+    return files;
+}
+
+//-----------------------------------------------------------------------------
+// fast consistency checks on a current-version XET file. reads only the tables and footers
+//-----------------------------------------------------------------------------
+std::wstring ValidateXetFile(const std::wstring& in_fileName)
+{
+    std::ifstream inFile(in_fileName, std::ios::binary);
+    if (inFile.fail()) { return L"failed to open"; }
+
+    inFile.seekg(0, std::ios::end);
+    const UINT64 fileSize = (UINT64)inFile.tellg();
+    inFile.seekg(0, std::ios::beg);
+
+    XetFileHeader header;
+    if (fileSize < sizeof(header)) { return L"too small for a XET header"; }
+    inFile.read((char*)&header, sizeof(header));
+
+    if (XetFileHeader::GetMagic() != header.m_magic) { return L"not a XET file"; }
+    if (!XetFileHeader::IsSupportedVersion(header.m_version))
+    {
+        return L"XET version " + std::to_wstring(header.m_version) + L", expected " + std::to_wstring(XetFileHeader::GetVersion()) +
+            L" or " + std::to_wstring(XetFileHeader::GetStoreVersion());
+    }
+
+    //--------------------------
+    // mip counts & tables
+    //--------------------------
+    const auto& mipInfo = header.m_mipInfo;
+    const UINT numMips = header.m_ddsHeader.mipMapCount;
+    const UINT numTiles = mipInfo.m_numTilesForStandardMips;
+    if ((0 == numMips) || (numMips > D3D12_REQ_MIP_LEVELS) || ((mipInfo.m_numStandardMips + mipInfo.m_numPackedMips) != numMips))
+    {
+        return L"inconsistent mip counts";
+    }
+    if ((0 == mipInfo.m_numPackedMips) != (0 == mipInfo.m_numTilesForPackedMips))
+    {
+        return L"inconsistent packed mip tile count";
+    }
+
+    const UINT64 dataStart = sizeof(header) +
+        (UINT64(numMips) * sizeof(XetFileHeader::SubresourceInfo)) +
+        ((UINT64(numTiles) + 1) * sizeof(XetFileHeader::TileData));
+    if (dataStart > fileSize) { return L"tables exceed the file size"; }
+
+    std::vector<XetFileHeader::SubresourceInfo> subresourceInfo(numMips);
+    inFile.read((char*)subresourceInfo.data(), subresourceInfo.size() * sizeof(subresourceInfo[0]));
+    std::vector<XetFileHeader::TileData> tileData(UINT64(numTiles) + 1);
+    inFile.read((char*)tileData.data(), tileData.size() * sizeof(tileData[0]));
+    if (!inFile.good()) { return L"failed to read tables"; }
+
+    //--------------------------
+    // standard mips: tile dimensions follow from the texture size and the 64KB tile shape
+    // BC1 tiles are 512x256 texels, BC7 tiles are 256x256
+    //--------------------------
+    const DXGI_FORMAT format = header.m_extensionHeader.dxgiFormat;
+    const UINT tileWidth = (8 == GetBytesPerBlock(format)) ? 512 : 256;
+    const UINT tileHeight = 256;
+    UINT tileIndex = 0;
+    for (UINT s = 0; s < mipInfo.m_numStandardMips; s++)
+    {
+        const auto& info = subresourceInfo[s].m_standardMipInfo;
+        UINT w = std::max<UINT>(1, header.m_ddsHeader.width >> s);
+        UINT h = std::max<UINT>(1, header.m_ddsHeader.height >> s);
+        if ((info.m_widthTiles != ((w + tileWidth - 1) / tileWidth)) || (info.m_heightTiles != ((h + tileHeight - 1) / tileHeight)))
+        {
+            return L"mip " + std::to_wstring(s) + L" tile dimensions do not match the texture size";
+        }
+        if (info.m_subresourceTileIndex != tileIndex)
+        {
+            return L"mip " + std::to_wstring(s) + L" has tile index " + std::to_wstring(info.m_subresourceTileIndex) + L", expected " + std::to_wstring(tileIndex);
+        }
+        tileIndex += info.m_widthTiles * info.m_heightTiles;
+    }
+    if (tileIndex != numTiles) { return L"standard mip tiles do not sum to the tile count"; }
+
+    //--------------------------
+    // packed mips: pitches and padded size
+    //--------------------------
+    std::vector<PackedMipFootprint> footprints;
+    UINT64 paddedPackedMipBytes = GetPackedMipFootprints(footprints, header.m_ddsHeader, format, mipInfo.m_numStandardMips, mipInfo.m_numPackedMips);
+    for (UINT i = 0; i < mipInfo.m_numPackedMips; i++)
+    {
+        const auto& info = subresourceInfo[mipInfo.m_numStandardMips + i].m_packedMipInfo;
+        const auto& f = footprints[i];
+        if ((info.m_rowPitch != f.m_rowSizeBytes) || (info.m_slicePitch != (f.m_rowSizeBytes * f.m_numRows)))
+        {
+            return L"mip " + std::to_wstring(mipInfo.m_numStandardMips + i) + L" pitch does not match the texture size";
+        }
+    }
+    if (mipInfo.m_numUncompressedBytesForPackedMips != paddedPackedMipBytes)
+    {
+        return L"packed mips are " + std::to_wstring(mipInfo.m_numUncompressedBytesForPackedMips) +
+            L" bytes padded, expected " + std::to_wstring(paddedPackedMipBytes);
+    }
+
+    //--------------------------
+    // optional trailing sections, newest last. each shortens the range holding the texture data
+    //--------------------------
+    UINT64 dataEnd = fileSize;
+
+    std::vector<UINT64> storeHashes;
+    if (dataEnd >= (dataStart + sizeof(XetStoreFooter)))
+    {
+        XetStoreFooter footer;
+        inFile.seekg(dataEnd - sizeof(footer), std::ios::beg);
+        inFile.read((char*)&footer, sizeof(footer));
+        if (inFile.good() && (XetStoreFooter::GetMagic() == footer.m_magic))
+        {
+            if ((XetStoreFooter::GetVersion() != footer.m_version) || (numTiles != footer.m_numTiles) ||
+                (footer.m_sectionOffset < dataStart) || (footer.m_tableOffset < footer.m_sectionOffset) ||
+                ((UINT64(footer.m_tableOffset) + (UINT64(numTiles) * sizeof(UINT64)) + footer.m_storeNameBytes + sizeof(footer)) != dataEnd))
+            {
+                return L"tile store section is inconsistent";
+            }
+            storeHashes.resize(numTiles);
+            inFile.seekg(footer.m_tableOffset, std::ios::beg);
+            inFile.read((char*)storeHashes.data(), storeHashes.size() * sizeof(storeHashes[0]));
+            dataEnd = footer.m_sectionOffset;
+        }
+        inFile.clear();
+    }
+    if ((XetFileHeader::GetStoreVersion() == header.m_version) != (!storeHashes.empty()))
+    {
+        return L"XET version " + std::to_wstring(header.m_version) + (storeHashes.empty() ? L" without" : L" with") + L" a tile store section";
+    }
+
+    if (dataEnd >= (dataStart + sizeof(XetTierFooter)))
+    {
+        XetTierFooter footer;
+        inFile.seekg(dataEnd - sizeof(footer), std::ios::beg);
+        inFile.read((char*)&footer, sizeof(footer));
+        if (inFile.good() && (XetTierFooter::GetMagic() == footer.m_magic))
+        {
+            if ((XetTierFooter::GetVersion() != footer.m_version) || (numTiles != footer.m_numTiles) || (footer.m_tableOffset < dataStart) ||
+                ((UINT64(footer.m_tableOffset) + (UINT64(numTiles) * sizeof(XetFileHeader::TileData)) + sizeof(footer)) != dataEnd))
+            {
+                return L"low quality tier section is inconsistent";
+            }
+            std::vector<XetFileHeader::TileData> lowTier(numTiles);
+            inFile.seekg(footer.m_tableOffset, std::ios::beg);
+            inFile.read((char*)lowTier.data(), lowTier.size() * sizeof(lowTier[0]));
+            for (UINT i = 0; i < numTiles; i++)
+            {
+                const auto& t = lowTier[i];
+                if (t.m_numBytes && ((t.m_offset < dataStart) || (t.m_numBytes > XetFileHeader::GetTileSize()) ||
+                    ((UINT64(t.m_offset) + t.m_numBytes) > footer.m_tableOffset)))
+                {
+                    return L"low quality tile " + std::to_wstring(i) + L" out of bounds";
+                }
+            }
+            dataEnd = footer.m_tableOffset;
+        }
+        inFile.clear();
+    }
+    if (!inFile.good()) { return L"failed to read trailing sections"; }
+
+    //--------------------------
+    // tiles & packed mips: in bounds, sized, and not overlapping
+    //--------------------------
+    std::vector<XetFileHeader::TileData> ranges;
+    ranges.reserve(tileData.size());
+    for (UINT i = 0; i < numTiles; i++)
+    {
+        const auto& t = tileData[i];
+        if (storeHashes.size() && storeHashes[i])
+        {
+            if (t.m_numBytes) { return L"tile " + std::to_wstring(i) + L" is both embedded and in the tile store"; }
+            continue;
+        }
+        if (0 == t.m_numBytes) { return L"tile " + std::to_wstring(i) + L" is empty"; }
+        if (t.m_numBytes > XetFileHeader::GetTileSize()) { return L"tile " + std::to_wstring(i) + L" is larger than 64KB"; }
+        if ((0 == header.m_compressionFormat) && (XetFileHeader::GetTileSize() != t.m_numBytes))
+        {
+            return L"uncompressed tile " + std::to_wstring(i) + L" is not 64KB";
+        }
+        if ((t.m_offset < dataStart) || ((UINT64(t.m_offset) + t.m_numBytes) > dataEnd))
+        {
+            return L"tile " + std::to_wstring(i) + L" out of bounds";
+        }
+        ranges.push_back(t);
+    }
+
+    if (mipInfo.m_numPackedMips)
+    {
+        const auto& p = tileData[numTiles];
+        if ((0 == p.m_numBytes) || (p.m_offset < dataStart) || ((UINT64(p.m_offset) + p.m_numBytes) > dataEnd))
+        {
+            return L"packed mips out of bounds";
+        }
+        if ((0 == header.m_compressionFormat) && (p.m_numBytes != mipInfo.m_numUncompressedBytesForPackedMips))
+        {
+            return L"uncompressed packed mips are " + std::to_wstring(p.m_numBytes) + L" bytes, expected " + std::to_wstring(mipInfo.m_numUncompressedBytesForPackedMips);
+        }
+        ranges.push_back(p);
+    }
+
+    std::sort(ranges.begin(), ranges.end(), [](const XetFileHeader::TileData& a, const XetFileHeader::TileData& b) { return a.m_offset < b.m_offset; });
+    for (size_t i = 1; i < ranges.size(); i++)
+    {
+        if ((UINT64(ranges[i - 1].m_offset) + ranges[i - 1].m_numBytes) > ranges[i].m_offset)
+        {
+            return L"texture data overlaps at offset " + std::to_wstring(ranges[i].m_offset);
+        }
+    }
+
+    return std::wstring();
+}
+
+//-----------------------------------------------------------------------------
+// v2 tiles are uncompressed and already in tiled layout, so they are copied or only compressed
+// the output is written to a temporary file, validated, then renamed
+//-----------------------------------------------------------------------------
+static std::wstring MigrateXetFile(const std::wstring& in_srcFileName, const std::wstring& in_dstFileName,
+    IDStorageCompressionCodec* in_pCodec, UINT32 in_compressionFormat, DSTORAGE_COMPRESSION in_compressionLevel)
+{
+    MappedFile src(in_srcFileName);
+    if (nullptr == src.GetBytes()) { return L"failed to open"; }
+    const BYTE* pSrcBytes = src.GetBytes();
+    const UINT64 srcSize = src.GetNumBytes();
+
+    if (srcSize < sizeof(XetFileHeaderV2)) { return L"too small for a XET header"; }
+    const XetFileHeaderV2& srcHeader = *(const XetFileHeaderV2*)pSrcBytes;
+    if (XetFileHeaderV2::GetMagic() != srcHeader.m_magic) { return L"not a XET file"; }
+    if (XetFileHeaderV2::GetVersion() != srcHeader.m_version) { return L"not a v2 XET file"; }
+
+    XetFileHeader header;
+    header.m_ddsHeader = srcHeader.m_ddsHeader;
+    header.m_extensionHeader = srcHeader.m_extensionHeader;
+    header.m_compressionFormat = in_compressionFormat;
+    header.m_mipInfo.m_numStandardMips = srcHeader.m_mipInfo.m_numStandardMips;
+    header.m_mipInfo.m_numTilesForStandardMips = srcHeader.m_mipInfo.m_numTilesForStandardMips;
+    header.m_mipInfo.m_numPackedMips = srcHeader.m_mipInfo.m_numPackedMips;
+    header.m_mipInfo.m_numTilesForPackedMips = srcHeader.m_mipInfo.m_numTilesForPackedMips;
+    if (0 == header.m_ddsHeader.mipMapCount) { header.m_ddsHeader.mipMapCount = 1; }
+
+    const auto& mipInfo = header.m_mipInfo;
+    const UINT numMips = header.m_ddsHeader.mipMapCount;
+    const UINT numTiles = mipInfo.m_numTilesForStandardMips;
+    const UINT tileSize = XetFileHeader::GetTileSize();
+
+    // v2 holds at most 16 subresources
+    if ((numMips > _countof(srcHeader.m_subresourceInfo)) || ((mipInfo.m_numStandardMips + mipInfo.m_numPackedMips) != numMips))
+    {
+        return L"inconsistent mip counts";
+    }
+
+    //--------------------------
+    // v2 offset table: every tile is an uncompressed 64KB in the file
+    //--------------------------
+    const UINT64 srcTableEnd = sizeof(XetFileHeaderV2) + (UINT64(numTiles) * sizeof(XetFileHeaderV2::TileData));
+    if (srcTableEnd > srcSize) { return L"tile table exceeds the file size"; }
+    const XetFileHeaderV2::TileData* pSrcTiles = (const XetFileHeaderV2::TileData*)(pSrcBytes + sizeof(XetFileHeaderV2));
+    for (UINT i = 0; i < numTiles; i++)
+    {
+        if (tileSize != pSrcTiles[i].m_numBytes) { return L"tile " + std::to_wstring(i) + L" is not 64KB"; }
+        if ((pSrcTiles[i].m_offset < srcTableEnd) || ((UINT64(pSrcTiles[i].m_offset) + tileSize) > srcSize))
+        {
+            return L"tile " + std::to_wstring(i) + L" out of bounds";
+        }
+    }
+
+    //--------------------------
+    // subresource info. standard mips are unchanged, packed mips are described by their footprints
+    //--------------------------
+    std::vector<XetFileHeader::SubresourceInfo> subresourceInfo(numMips);
+    UINT tileIndex = 0;
+    for (UINT s = 0; s < mipInfo.m_numStandardMips; s++)
+    {
+        const auto& info = srcHeader.m_subresourceInfo[s].m_standardMipInfo;
+        if (info.m_subresourceTileIndex != tileIndex) { return L"mip " + std::to_wstring(s) + L" tile index is inconsistent"; }
+        subresourceInfo[s].m_standardMipInfo = XetFileHeader::StandardMipInfo{
+            info.m_widthTiles, info.m_heightTiles, info.m_depthTiles, info.m_subresourceTileIndex };
+        tileIndex += info.m_widthTiles * info.m_heightTiles;
+    }
+    if (tileIndex != numTiles) { return L"standard mip tiles do not sum to the tile count"; }
+
+    std::vector<PackedMipFootprint> footprints;
+    UINT64 paddedPackedMipBytes = GetPackedMipFootprints(footprints, header.m_ddsHeader,
+        header.m_extensionHeader.dxgiFormat, mipInfo.m_numStandardMips, mipInfo.m_numPackedMips);
+    UINT64 packedMipBytes = 0;
+    for (UINT i = 0; i < mipInfo.m_numPackedMips; i++)
+    {
+        const auto& f = footprints[i];
+        subresourceInfo[mipInfo.m_numStandardMips + i].m_packedMipInfo = XetFileHeader::PackedMipInfo{
+            f.m_rowSizeBytes, f.m_rowSizeBytes * f.m_numRows, f.m_rowPitch, f.m_rowPitch * f.m_numRows };
+        packedMipBytes += f.m_rowSizeBytes * f.m_numRows;
+    }
+    header.m_mipInfo.m_numUncompressedBytesForPackedMips = (UINT32)paddedPackedMipBytes;
+
+    // v2 packed mips are unpadded, from the packed mip file offset to the end of the file
+    const BYTE* pSrcPackedMips = nullptr;
+    if (mipInfo.m_numPackedMips)
+    {
+        UINT64 packedMipOffset = srcHeader.m_subresourceInfo[mipInfo.m_numStandardMips].m_packedMipInfo.m_fileOffset;
+        if ((packedMipOffset < srcTableEnd) || ((srcSize - packedMipOffset) != packedMipBytes))
+        {
+            return L"packed mips are " + std::to_wstring(srcSize - std::min<UINT64>(srcSize, packedMipOffset)) +
+                L" bytes, expected " + std::to_wstring(packedMipBytes);
+        }
+        pSrcPackedMips = pSrcBytes + packedMipOffset;
+    }
+
+    //--------------------------
+    // compress tiles in parallel. uncompressed tiles are written directly from the source
+    //--------------------------
+    std::vector<std::vector<BYTE>> compressedTiles;
+    if (in_pCodec)
+    {
+        compressedTiles.resize(numTiles);
+        std::atomic<bool> failed{ false };
+        concurrency::parallel_for(UINT(0), numTiles, [&](UINT i)
+            {
+                if (!Compress(compressedTiles[i], in_pCodec, in_compressionLevel, pSrcBytes + pSrcTiles[i].m_offset, tileSize))
+                {
+                    failed = true;
+                }
+            });
+        if (failed) { return L"compression failed"; }
+    }
+
+    std::vector<BYTE> packedMips;
+    PadPackedMips(packedMips, footprints, paddedPackedMipBytes, pSrcPackedMips);
+    if (in_pCodec && packedMips.size())
+    {
+        std::vector<BYTE> compressed;
+        if (!Compress(compressed, in_pCodec, in_compressionLevel, packedMips.data(), (UINT32)packedMips.size())) { return L"compression failed"; }
+        packedMips.swap(compressed);
+    }
+
+    //--------------------------
+    // offset table
+    //--------------------------
+    std::vector<XetFileHeader::TileData> tileData(UINT64(numTiles) + 1);
+    UINT64 dataOffset = sizeof(header) +
+        (subresourceInfo.size() * sizeof(subresourceInfo[0])) +
+        (tileData.size() * sizeof(tileData[0]));
+
+    // align only for legacy support for uncompressed file formats, as DdsToXet does
+    std::vector<BYTE> alignedTextureDataGap;
+    if (nullptr == in_pCodec)
+    {
+        alignedTextureDataGap.resize(AlignUp(dataOffset, XetFileHeaderV2::GetAlignment()) - dataOffset, 0);
+        dataOffset += alignedTextureDataGap.size();
+    }
+
+    for (UINT i = 0; i < numTiles; i++)
+    {
+        UINT numBytes = in_pCodec ? (UINT)compressedTiles[i].size() : tileSize;
+        tileData[i] = { (UINT32)dataOffset, numBytes };
+        dataOffset += numBytes;
+    }
+    tileData.back() = { (UINT32)dataOffset, (UINT32)packedMips.size() };
+    if ((dataOffset + packedMips.size()) > UINT32(-1)) { return L"output exceeds the 4GB offset limit"; }
+
+    //--------------------------
+    // write, validate, then replace the destination
+    //--------------------------
+    std::wstring tmpFileName = in_dstFileName + L".tmp";
+    {
+        std::ofstream outFile(tmpFileName, std::ios::out | std::ios::binary);
+        outFile.write((char*)&header, sizeof(header));
+        outFile.write((char*)subresourceInfo.data(), subresourceInfo.size() * sizeof(subresourceInfo[0]));
+        outFile.write((char*)tileData.data(), tileData.size() * sizeof(tileData[0]));
+        outFile.write((char*)alignedTextureDataGap.data(), alignedTextureDataGap.size());
+        for (UINT i = 0; i < numTiles; i++)
+        {
+            if (in_pCodec) { outFile.write((char*)compressedTiles[i].data(), compressedTiles[i].size()); }
+            else { outFile.write((char*)pSrcBytes + pSrcTiles[i].m_offset, tileSize); }
+        }
+        outFile.write((char*)packedMips.data(), packedMips.size());
+        if (!outFile.good()) { return L"failed to write " + tmpFileName; }
+    }
+
+    std::error_code ec;
+    std::wstring error = ValidateXetFile(tmpFileName);
+    if (error.size())
+    {
+        std::filesystem::remove(tmpFileName, ec);
+        return L"output failed validation: " + error;
+    }
+    std::filesystem::rename(tmpFileName, in_dstFileName, ec);
+    if (ec) { return L"failed to replace " + in_dstFileName; }
+
+    return std::wstring();
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+UINT MigrateXetFiles(const std::wstring& in_srcPath, const std::wstring& in_dstDir,
+    UINT32 in_compressionFormat, UINT32 in_compressionLevel, bool in_force)
+{
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    auto files = GetXetFiles(in_srcPath);
+    if (0 == files.size())
+    {
+        std::wcout << "No XET files found in " << in_srcPath << std::endl;
+        return 0;
+    }
+
+    ComPtr<IDStorageCompressionCodec> compressor;
+    if (in_compressionFormat)
+    {
+        HRESULT hr = DStorageCreateCompressionCodec((DSTORAGE_COMPRESSION_FORMAT)in_compressionFormat, 0, IID_PPV_ARGS(&compressor));
+        if (FAILED(hr))
+        {
+            std::wcout << "Error: failed to create compression codec" << std::endl;
+            return (UINT)files.size();
+        }
+    }
+
+    std::atomic<UINT> numMigrated{ 0 };
+    std::atomic<UINT> numCopied{ 0 };
+    std::atomic<UINT> numUpToDate{ 0 };
+    std::atomic<UINT> numFailed{ 0 };
+    std::mutex outputMutex;
+
+    concurrency::parallel_for_each(files.begin(), files.end(), [&](const std::pair<std::filesystem::path, std::filesystem::path>& in_file)
+        {
+            const auto& srcFileName = in_file.first;
+            std::filesystem::path dstFileName = std::filesystem::path(in_dstDir) / in_file.second;
+
+            std::error_code ec;
+            std::filesystem::create_directories(dstFileName.parent_path(), ec);
+
+            std::wstring result;
+            std::wstring error;
+            if (std::filesystem::equivalent(srcFileName, dstFileName, ec))
+            {
+                error = L"destination is the source";
+            }
+            else if ((!in_force) && std::filesystem::exists(dstFileName, ec) &&
+                (std::filesystem::last_write_time(dstFileName, ec) >= std::filesystem::last_write_time(srcFileName, ec)) &&
+                ValidateXetFile(dstFileName).empty())
+            {
+                result = L"up to date";
+                numUpToDate++;
+            }
+            else
+            {
+                XetFileHeader srcHeader{};
+                {
+                    std::ifstream inFile(srcFileName, std::ios::binary);
+                    inFile.read((char*)&srcHeader, sizeof(srcHeader.m_magic) + sizeof(srcHeader.m_version));
+                }
+
+                // already current: validate, then copy as-is
+                if ((XetFileHeader::GetMagic() == srcHeader.m_magic) && XetFileHeader::IsSupportedVersion(srcHeader.m_version))
+                {
+                    error = ValidateXetFile(srcFileName);
+                    if (error.empty())
+                    {
+                        std::filesystem::copy_file(srcFileName, dstFileName, std::filesystem::copy_options::overwrite_existing, ec);
+                        if (ec) { error = L"failed to copy"; }
+                        else { result = L"already current, copied"; numCopied++; }
+                    }
+                }
+                else
+                {
+                    error = MigrateXetFile(srcFileName, dstFileName, compressor.Get(), in_compressionFormat, (DSTORAGE_COMPRESSION)in_compressionLevel);
+                    if (error.empty())
+                    {
+                        result = L"migrated, " + std::to_wstring(std::filesystem::file_size(srcFileName, ec)) + L" -> " +
+                            std::to_wstring(std::filesystem::file_size(dstFileName, ec)) + L" bytes";
+                        numMigrated++;
+                    }
+                }
+            }
+            if (error.size())
+            {
+                result = L"Error: " + error;
+                numFailed++;
+            }
+
+            std::lock_guard<std::mutex> lock(outputMutex);
+            std::wcout << in_file.second.wstring() << ": " << result << std::endl;
+        });
+
+    auto seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+    std::wcout << numMigrated << " migrated, " << numCopied << " copied, " << numUpToDate << " up to date, "
+        << numFailed << " failed in " << seconds << "s" << std::endl;
+
+    return numFailed;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+UINT ValidateXetFiles(const std::wstring& in_path)
+{
+    auto files = GetXetFiles(in_path);
+
+    std::atomic<UINT> numFailed{ 0 };
+    std::mutex outputMutex;
+
+    concurrency::parallel_for_each(files.begin(), files.end(), [&](const std::pair<std::filesystem::path, std::filesystem::path>& in_file)
+        {
+            std::wstring error = ValidateXetFile(in_file.first);
+            if (error.size())
+            {
+                numFailed++;
+                std::lock_guard<std::mutex> lock(outputMutex);
+                std::wcout << in_file.second.wstring() << ": Error: " << error << std::endl;
+            }
+        });
+
+    std::wcout << files.size() << " files validated, " << numFailed << " failed" << std::endl;
+    return numFailed;
+}
@@ -0,0 +1,51 @@
+//*********************************************************
+//
+// Copyright 2020 Intel Corporation 
+//
+// Permission is hereby granted, free of charge, to any 
+// person obtaining a copy of this software and associated 
+// documentation files(the "Software"), to deal in the Software 
+// without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to 
+// whom the Software is furnished to do so, subject to the 
+// following conditions :
+// The above copyright notice and this permission notice shall 
+// be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+// DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+
+
+#pragma once
+
+#include <string>
+
+/*-----------------------------------------------------------------------------
+Bulk migration of XeT v2 files and validation of current XET files
+
+Both operate on a single file or on every .xet file below a directory,
+process files in parallel, and do not create a D3D12 device:
+tiling is taken from the v2 header, and packed mip footprints are computed on the CPU.
+
+v2 tiles are already in tiled layout, so migration copies (or only compresses) them.
+Every migrated file is validated before it replaces the destination.
+-----------------------------------------------------------------------------*/
+
+// returns the number of files that failed
+UINT MigrateXetFiles(const std::wstring& in_srcPath, const std::wstring& in_dstDir,
+    UINT32 in_compressionFormat, UINT32 in_compressionLevel, bool in_force);
+
+// returns the number of files that failed
+UINT ValidateXetFiles(const std::wstring& in_path);
+
+// returns an empty string if the file is consistent, otherwise a description of the first problem found
+std::wstring ValidateXetFile(const std::wstring& in_fileName);
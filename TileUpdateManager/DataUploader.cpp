@@ -31,6 +31,7 @@
 #include "FileStreamerReference.h"
 #include "FileStreamerDS.h"
 #include "StreamingHeap.h"
+#include "EventTracer.h"
 
 //=============================================================================
 // Internal class that uploads texture data into a reserved resource
@@ -177,6 +178,7 @@ void Streaming::DataUploader::StartThreads()
 
     m_submitThread = std::thread([&]
         {
+            TRACE_THREAD_NAME("Submit");
             while (m_threadsRunning)
             {
                 m_submitFlag.Wait();
@@ -187,6 +189,8 @@ void Streaming::DataUploader::StartThreads()
     // launch thread to monitor fences
     m_fenceMonitorThread = std::thread([&]
         {
+            TRACE_THREAD_NAME("FenceMonitor");
+
             // initialize timer on the thread that will use it
             RawCpuTimer fenceMonitorThread;
             m_pFenceThreadTimer = &fenceMonitorThread;
@@ -297,8 +301,7 @@ void Streaming::DataUploader::FreeUpdateList(Streaming::UpdateList& in_updateLis
     in_updateList.m_executionState = UpdateList::State::STATE_FREE;
 
     // return the index to this updatelist to the pool
-    UINT i = UINT(&in_updateList - m_updateLists.data());
-    m_updateListAllocator.Free(i);
+    m_updateListAllocator.Free(GetIndex(in_updateList));
 }
 
 //-----------------------------------------------------------------------------
@@ -311,8 +314,21 @@ void Streaming::DataUploader::SubmitUpdateList(Streaming::UpdateList& in_updateL
     // fenceMonitorThread will wait for the copy fence to become valid before progressing state
     in_updateList.m_executionState = UpdateList::State::STATE_SUBMITTED;
 
+    TRACE_INSTANT("SubmitUpdateList", GetIndex(in_updateList), in_updateList.GetNumStandardUpdates());
+
     if (in_updateList.GetNumStandardUpdates())
     {
+        // the same offsets the file streamers read. nothing is read from files while visualizing
+        if (FileStreamer::VisualizationMode::DATA_VIZ_NONE == m_pFileStreamer->GetVisualizationMode())
+        {
+            for (const auto& coord : in_updateList.m_coords)
+            {
+                in_updateList.m_numFileBytes += in_updateList.m_pStreamingResource->GetFileOffset(coord).numBytes;
+            }
+        }
+        m_requestCounters.m_numTilesQueued.fetch_add(in_updateList.GetNumStandardUpdates(), std::memory_order_relaxed);
+        m_requestCounters.m_numFileBytesQueued.fetch_add(in_updateList.m_numFileBytes, std::memory_order_relaxed);
+
         m_pFileStreamer->StreamTexture(in_updateList);
     }
 
@@ -381,7 +397,9 @@ void Streaming::DataUploader::FenceMonitorThread()
 
             if (m_memoryFence->GetCompletedValue() >= updateList.m_copyFenceValue)
             {
+                TRACE_INSTANT("PackedMipsComplete", GetIndex(updateList), EventTracer::NO_VALUE, updateList.m_copyFenceValue);
                 updateList.m_pStreamingResource->NotifyPackedMips();
+                m_completionCounters.m_numUpdateListsCompleted.fetch_add(1, std::memory_order_relaxed);
                 freeUpdateList = true;
             }
             break;
@@ -392,6 +410,7 @@ void Streaming::DataUploader::FenceMonitorThread()
             // only check copy fence if the fence has been set (avoid race condition)
             if ((updateList.m_copyFenceValid) && (m_pFileStreamer->GetCompleted(updateList)))
             {
+                TRACE_INSTANT("CopyComplete", GetIndex(updateList), updateList.GetNumStandardUpdates(), updateList.m_copyFenceValue);
                 updateList.m_executionState = UpdateList::State::STATE_MAP_PENDING;
             }
             else
@@ -403,12 +422,15 @@ void Streaming::DataUploader::FenceMonitorThread()
         case UpdateList::State::STATE_MAP_PENDING:
             if (updateList.m_mappingFenceValue <= m_mappingFence->GetCompletedValue())
             {
+                TRACE_INSTANT("UpdateListComplete", GetIndex(updateList),
+                    updateList.GetNumStandardUpdates() + updateList.GetNumEvictions(), updateList.m_mappingFenceValue);
+
                 // notify evictions
                 if (updateList.GetNumEvictions())
                 {
                     updateList.m_pStreamingResource->NotifyEvicted(updateList.m_evictCoords);
 
-                    m_numTotalEvictions.fetch_add(updateList.GetNumEvictions(), std::memory_order_relaxed);
+                    m_completionCounters.m_numEvictions.fetch_add(updateList.GetNumEvictions(), std::memory_order_relaxed);
                 }
 
                 // notify regular tiles
@@ -417,12 +439,25 @@ void Streaming::DataUploader::FenceMonitorThread()
                     updateList.m_pStreamingResource->NotifyCopyComplete(updateList.m_coords);
 
                     auto updateLatency = m_pFenceThreadTimer->GetTime() - updateList.m_copyLatencyTimer;
-                    m_totalTileCopyLatency.fetch_add(updateLatency * updateList.GetNumStandardUpdates(), std::memory_order_relaxed);
-
-                    m_numTotalUploads.fetch_add(updateList.GetNumStandardUpdates(), std::memory_order_relaxed);
-
+                    m_completionCounters.m_totalTileCopyLatency.fetch_add(updateLatency * updateList.GetNumStandardUpdates(), std::memory_order_relaxed);
+
+                    // bucket i holds latencies below 2^i microseconds
+                    {
+                        UINT64 microseconds = UINT64(m_pFenceThreadTimer->GetSecondsFromDelta(updateLatency) * 1000000.f);
+                        UINT bucket = 0;
+                        while (microseconds && (bucket < TileUpdateManagerStatistics::NUM_LATENCY_BUCKETS - 1))
+                        {
+                            microseconds >>= 1;
+                            bucket++;
+                        }
+                        m_completionCounters.m_tileLatencyHistogram[bucket].fetch_add(updateList.GetNumStandardUpdates(), std::memory_order_relaxed);
+                    }
+
+                    m_completionCounters.m_numFileBytesRead.fetch_add(updateList.m_numFileBytes, std::memory_order_relaxed);
+                    m_completionCounters.m_numTilesUploaded.fetch_add(updateList.GetNumStandardUpdates(), std::memory_order_relaxed);
                 }
 
+                m_completionCounters.m_numUpdateListsCompleted.fetch_add(1, std::memory_order_relaxed);
                 freeUpdateList = true;
             }
         break;
@@ -468,6 +503,9 @@ void Streaming::DataUploader::SubmitThread()
 
         ASSERT(UpdateList::State::STATE_SUBMITTED == updateList.m_executionState);
 
+        TRACE_SCOPE("UpdateTileMappings");
+        TRACE_SCOPE_ARGS(GetIndex(updateList), updateList.GetNumStandardUpdates() + updateList.GetNumEvictions(), m_mappingFenceValue);
+
         // set to the fence value to be signaled next
         updateList.m_mappingFenceValue = m_mappingFenceValue;
 
@@ -488,6 +526,7 @@ void Streaming::DataUploader::SubmitThread()
                 updateList.m_pStreamingResource->GetTiledResource(),
                 updateList.m_pStreamingResource->GetHeap()->GetHeap(),
                 updateList.m_coords, updateList.m_heapIndices);
+            m_mappingCounters.m_numTilesMapped.fetch_add(updateList.GetNumStandardUpdates(), std::memory_order_relaxed);
 
             updateList.m_executionState = UpdateList::State::STATE_UPLOADING;
         }
@@ -507,3 +546,46 @@ void Streaming::DataUploader::SubmitThread()
         m_mappingFenceValue++;
     }
 }
+
+//-----------------------------------------------------------------------------
+// lock-free: each counter is read once, while the threads keep running
+// completions are read before requests, and in-flight values (requests - completions) are clamped at 0
+//-----------------------------------------------------------------------------
+void Streaming::DataUploader::GetStatistics(TileUpdateManagerStatistics& out_statistics) const
+{
+    const UINT64 numFileBytesRead = m_completionCounters.m_numFileBytesRead.load(std::memory_order_acquire);
+    const UINT64 numTilesUploaded = m_completionCounters.m_numTilesUploaded.load(std::memory_order_acquire);
+
+    out_statistics.m_numTilesUploaded = numTilesUploaded;
+    out_statistics.m_numTilesEvicted = GetTotalNumEvictions();
+    out_statistics.m_compressedBytesRead = numFileBytesRead;
+    out_statistics.m_uncompressedBytesRead = numTilesUploaded * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES;
+    out_statistics.m_numUpdateListsCompleted = m_completionCounters.m_numUpdateListsCompleted;
+    out_statistics.m_totalTileCopyLatency = GetApproximateTileCopyLatency();
+    for (UINT i = 0; i < TileUpdateManagerStatistics::NUM_LATENCY_BUCKETS; i++)
+    {
+        out_statistics.m_tileLatencyHistogram[i] = m_completionCounters.m_tileLatencyHistogram[i].load(std::memory_order_relaxed);
+    }
+
+    out_statistics.m_numTilesMapped = m_mappingCounters.m_numTilesMapped;
+
+    out_statistics.m_numTilesQueued = m_requestCounters.m_numTilesQueued.load(std::memory_order_acquire);
+    out_statistics.m_numTilesInFlight = UINT(std::max(out_statistics.m_numTilesQueued, numTilesUploaded) - numTilesUploaded);
+    const UINT64 numFileBytesQueued = m_requestCounters.m_numFileBytesQueued.load(std::memory_order_acquire);
+    out_statistics.m_stagingBytesInFlight = std::max(numFileBytesQueued, numFileBytesRead) - numFileBytesRead;
+    out_statistics.m_stagingBytesCapacity = UINT64(m_stagingBufferSizeMB) * 1024 * 1024;
+
+    out_statistics.m_numUpdateLists = (UINT)m_updateLists.size();
+    for (const auto& u : m_updateLists)
+    {
+        switch (u.m_executionState.load(std::memory_order_relaxed))
+        {
+        case UpdateList::State::STATE_FREE: out_statistics.m_numUpdateListsFree++; break;
+        case UpdateList::State::STATE_ALLOCATED: out_statistics.m_numUpdateListsAllocated++; break;
+        case UpdateList::State::STATE_SUBMITTED: out_statistics.m_numUpdateListsSubmitted++; break;
+        case UpdateList::State::STATE_UPLOADING: out_statistics.m_numUpdateListsUploading++; break;
+        case UpdateList::State::STATE_MAP_PENDING: out_statistics.m_numUpdateListsMapPending++; break;
+        default: out_statistics.m_numUpdateListsPackedMips++; break; // STATE_PACKED_MAPPING, STATE_PACKED_COPY_PENDING
+        }
+    }
+}
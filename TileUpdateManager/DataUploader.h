@@ -34,6 +34,7 @@
 #include "Timer.h"
 
 #include "SimpleAllocator.h"
+#include "SamplerFeedbackStreaming.h" // for TileUpdateManagerStatistics
 
 //==================================================
 // UploadBuffer keeps an upload buffer per swapchain backbuffer
@@ -66,6 +67,9 @@ namespace Streaming
 
         UINT GetNumUpdateListsAvailable() const { return m_updateListAllocator.GetAvailable(); }
 
+        // # UpdateLists in flight, a measure of the streaming backlog
+        UINT GetNumUpdateListsAllocated() const { return m_updateListAllocator.GetAllocated(); }
+
         // may return null. called by StreamingResource.
         UpdateList* AllocateUpdateList(StreamingResourceDU* in_pStreamingResource);
 
@@ -85,10 +89,13 @@ namespace Streaming
         //----------------------------------
         // statistics and visualization
         //----------------------------------
-        UINT GetTotalNumUploads() const { return m_numTotalUploads; }
-        void AddEvictions(UINT in_numEvictions) { m_numTotalEvictions += in_numEvictions; }
-        UINT GetTotalNumEvictions() const { return m_numTotalEvictions; }
-        float GetApproximateTileCopyLatency() const { return m_pFenceThreadTimer->GetSecondsFromDelta(m_totalTileCopyLatency); } // sum of per-tile latencies so far
+        UINT GetTotalNumUploads() const { return m_completionCounters.m_numTilesUploaded; }
+        void AddEvictions(UINT in_numEvictions) { m_requestCounters.m_numEvictions.fetch_add(in_numEvictions, std::memory_order_relaxed); }
+        UINT GetTotalNumEvictions() const { return m_requestCounters.m_numEvictions + m_completionCounters.m_numEvictions; }
+        float GetApproximateTileCopyLatency() const { return m_pFenceThreadTimer->GetSecondsFromDelta(m_completionCounters.m_totalTileCopyLatency); } // sum of per-tile latencies so far
+
+        // fills the upload, byte, UpdateList, and staging fields
+        void GetStatistics(TileUpdateManagerStatistics& out_statistics) const;
 
         void SetVisualizationMode(UINT in_mode) { m_pFileStreamer->SetVisualizationMode(in_mode); }
         void CaptureTraceFile(bool in_captureTrace) { m_pFileStreamer->CaptureTraceFile(in_captureTrace); }
@@ -110,6 +117,7 @@ namespace Streaming
 
         // only the fence thread (which looks for final completion) frees UpdateLists
         void FreeUpdateList(Streaming::UpdateList& in_updateList);
+        UINT GetIndex(const Streaming::UpdateList& in_updateList) const { return UINT(&in_updateList - m_updateLists.data()); }
 
         // object that performs UpdateTileMappings() requests
         Streaming::MappingUpdater m_mappingUpdater;
@@ -151,10 +159,37 @@ namespace Streaming
 
         //-------------------------------------------
         // statistics
+        // each group has a single writer thread and its own cache line,
+        // so the ProcessFeedback, submit, and fence monitor threads don't write to shared lines
         //-------------------------------------------
-        std::atomic<UINT> m_numTotalEvictions{ 0 };
-        std::atomic<UINT> m_numTotalUploads{ 0 };
-        std::atomic<UINT> m_numTotalUpdateListsProcessed{ 0 };
-        std::atomic<INT64> m_totalTileCopyLatency{ 0 }; // total approximate latency for all copies. divide by m_numTotalUploads then get the time with m_cpuTimer.GetSecondsFromDelta() 
+        static constexpr UINT CACHE_LINE_SIZE = 64;
+
+        // written by the ProcessFeedback thread
+        struct alignas(CACHE_LINE_SIZE) RequestCounters
+        {
+            std::atomic<UINT> m_numEvictions{ 0 };
+            std::atomic<UINT64> m_numTilesQueued{ 0 };
+            std::atomic<UINT64> m_numFileBytesQueued{ 0 };
+        };
+        RequestCounters m_requestCounters;
+
+        // written by the submit thread
+        struct alignas(CACHE_LINE_SIZE) MappingCounters
+        {
+            std::atomic<UINT64> m_numTilesMapped{ 0 };
+        };
+        MappingCounters m_mappingCounters;
+
+        // written by the fence monitor thread
+        struct alignas(CACHE_LINE_SIZE) CompletionCounters
+        {
+            std::atomic<UINT> m_numTilesUploaded{ 0 };
+            std::atomic<UINT> m_numEvictions{ 0 };            // evictions carried by UpdateLists
+            std::atomic<UINT64> m_numFileBytesRead{ 0 };
+            std::atomic<UINT64> m_numUpdateListsCompleted{ 0 };
+            std::atomic<INT64> m_totalTileCopyLatency{ 0 };   // total approximate latency for all copies. divide by m_numTilesUploaded then get the time with m_cpuTimer.GetSecondsFromDelta() 
+            std::atomic<UINT64> m_tileLatencyHistogram[TileUpdateManagerStatistics::NUM_LATENCY_BUCKETS]{};
+        };
+        CompletionCounters m_completionCounters;
     };
 }
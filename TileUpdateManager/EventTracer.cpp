@@ -0,0 +1,198 @@
+//*********************************************************
+//
+// Copyright 2020 Intel Corporation 
+//
+// Permission is hereby granted, free of charge, to any 
+// person obtaining a copy of this software and associated 
+// documentation files(the "Software"), to deal in the Software 
+// without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to 
+// whom the Software is furnished to do so, subject to the 
+// following conditions :
+// The above copyright notice and this permission notice shall 
+// be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+// DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+
+
+#include "pch.h"
+
+#include "EventTracer.h"
+
+#include <iomanip>
+
+thread_local Streaming::EventTracer::ThreadState Streaming::EventTracer::m_threadState;
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+Streaming::EventTracer& Streaming::EventTracer::Get()
+{
+    static EventTracer eventTracer;
+    return eventTracer;
+}
+
+Streaming::EventTracer::EventTracer()
+{
+    LARGE_INTEGER frequency;
+    ::QueryPerformanceFrequency(&frequency);
+    m_microsecondsPerTick = 1000000.0 / double(frequency.QuadPart);
+    m_startTime = GetTime();
+}
+
+//-----------------------------------------------------------------------------
+// a thread that exits returns its ring. the events stay until the ring is reused
+//-----------------------------------------------------------------------------
+Streaming::EventTracer::ThreadState::~ThreadState()
+{
+    if (m_pRing)
+    {
+        Get().ReleaseRing(m_pRing);
+    }
+}
+
+void Streaming::EventTracer::ReleaseRing(Ring* in_pRing)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    in_pRing->m_inUse = false;
+}
+
+//-----------------------------------------------------------------------------
+// the name is applied when the thread's ring is created, so naming a thread costs no memory
+//-----------------------------------------------------------------------------
+void Streaming::EventTracer::SetThreadName(const char* in_pName)
+{
+    m_threadState.m_pName = in_pName;
+    if (m_threadState.m_pRing)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_threadState.m_pRing->m_name = in_pName;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// reuse the ring of a thread that has exited, or add a new one
+//-----------------------------------------------------------------------------
+Streaming::EventTracer::Ring& Streaming::EventTracer::GetRing()
+{
+    if (nullptr == m_threadState.m_pRing)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        Ring* pRing = nullptr;
+        for (auto& r : m_rings)
+        {
+            if (!r->m_inUse)
+            {
+                pRing = r.get();
+                break;
+            }
+        }
+        if (nullptr == pRing)
+        {
+            m_rings.push_back(std::make_unique<Ring>());
+            pRing = m_rings.back().get();
+        }
+
+        pRing->m_inUse = true;
+        pRing->m_writeIndex = 0;
+        pRing->m_threadId = ++m_numThreads;
+        pRing->m_name = m_threadState.m_pName ? m_threadState.m_pName : "Thread " + std::to_string(pRing->m_threadId);
+
+        m_threadState.m_pRing = pRing;
+    }
+    return *m_threadState.m_pRing;
+}
+
+//-----------------------------------------------------------------------------
+// copy the valid events. the writer may continue, and is not blocked:
+// an event at index i is overwritten by the write of index i + RING_SIZE,
+// so anything the writer may have reached while copying is discarded
+//-----------------------------------------------------------------------------
+void Streaming::EventTracer::Ring::Read(std::vector<Event>& out_events) const
+{
+    const UINT64 end = m_writeIndex.load(std::memory_order_acquire);
+    const UINT64 begin = (end > RING_SIZE) ? end - RING_SIZE : 0;
+
+    std::vector<Event> events;
+    events.reserve(size_t(end - begin));
+    for (UINT64 i = begin; i < end; i++)
+    {
+        events.push_back(m_events[i & (RING_SIZE - 1)]);
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const UINT64 written = m_writeIndex.load(std::memory_order_relaxed);
+    const UINT64 validBegin = (written >= RING_SIZE) ? std::max(begin, written - RING_SIZE + 1) : begin;
+
+    if (validBegin < end)
+    {
+        out_events.insert(out_events.end(), events.begin() + size_t(validBegin - begin), events.end());
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Chrome trace event format: complete events ("X") for scopes, thread-scoped instants ("i")
+// times are microseconds since the tracer was created
+//-----------------------------------------------------------------------------
+bool Streaming::EventTracer::WriteChromeTrace(const std::wstring& in_filename)
+{
+    std::ofstream outFile(in_filename, std::ios::trunc);
+    if (!outFile.is_open())
+    {
+        return false;
+    }
+
+    outFile << std::fixed << std::setprecision(3);
+    outFile << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    outFile << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Sampler Feedback Streaming\"}}";
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::vector<Event> events;
+    for (const auto& r : m_rings)
+    {
+        events.clear();
+        r->Read(events);
+
+        outFile << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << r->m_threadId
+            << ",\"args\":{\"name\":\"" << r->m_name << "\"}}";
+
+        for (const auto& e : events)
+        {
+            outFile << ",\n{\"name\":\"" << e.m_pName << "\",\"pid\":1,\"tid\":" << r->m_threadId
+                << ",\"ts\":" << double(e.m_startTime - m_startTime) * m_microsecondsPerTick;
+            if (e.m_duration < 0)
+            {
+                outFile << ",\"ph\":\"i\",\"s\":\"t\"";
+            }
+            else
+            {
+                outFile << ",\"ph\":\"X\",\"dur\":" << double(e.m_duration) * m_microsecondsPerTick;
+            }
+
+            if ((NO_VALUE != e.m_updateListId) || (NO_VALUE != e.m_numTiles) || (NO_FENCE != e.m_fenceValue))
+            {
+                const char* pSeparator = "";
+                outFile << ",\"args\":{";
+                if (NO_VALUE != e.m_updateListId) { outFile << pSeparator << "\"updateList\":" << e.m_updateListId; pSeparator = ","; }
+                if (NO_VALUE != e.m_numTiles) { outFile << pSeparator << "\"tiles\":" << e.m_numTiles; pSeparator = ","; }
+                if (NO_FENCE != e.m_fenceValue) { outFile << pSeparator << "\"fence\":" << e.m_fenceValue; }
+                outFile << "}";
+            }
+            outFile << "}";
+        }
+    }
+
+    outFile << "\n]}\n";
+    return outFile.good();
+}
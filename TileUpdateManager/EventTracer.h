@@ -0,0 +1,202 @@
+//*********************************************************
+//
+// Copyright 2020 Intel Corporation 
+//
+// Permission is hereby granted, free of charge, to any 
+// person obtaining a copy of this software and associated 
+// documentation files(the "Software"), to deal in the Software 
+// without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to 
+// whom the Software is furnished to do so, subject to the 
+// following conditions :
+// The above copyright notice and this permission notice shall 
+// be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+// DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+
+
+/*=============================================================================
+EventTracer
+
+Records what the streaming threads are doing, for viewing as a timeline in
+chrome://tracing or https://ui.perfetto.dev
+
+Each thread writes to its own ring of events without locking. A ring keeps only
+the most recent events, so the tracer can be left enabled as a flight recorder
+and written out on demand, e.g. after a hitch.
+
+An event is a named stage with a start time and duration (or an instant),
+optionally tagged with an UpdateList id, a tile count, and a fence value.
+Names must be string literals: only the pointer is stored.
+
+Recording costs a QueryPerformanceCounter() and a 40 byte copy per event.
+When not enabled it costs a relaxed atomic load. Set EVENT_TRACING to 0 to
+compile all of it out.
+=============================================================================*/
+
+#pragma once
+
+#ifndef EVENT_TRACING
+#define EVENT_TRACING 1
+#endif
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <memory>
+
+namespace Streaming
+{
+    class EventTracer
+    {
+    public:
+        static constexpr UINT32 NO_VALUE = UINT32(-1);
+        static constexpr UINT64 NO_FENCE = UINT64(-1);
+
+        struct Event
+        {
+            INT64 m_startTime{ 0 };            // QueryPerformanceCounter() ticks
+            INT64 m_duration{ -1 };            // ticks. negative for an instant event
+            const char* m_pName{ nullptr };    // string literal
+            UINT64 m_fenceValue{ NO_FENCE };
+            UINT32 m_updateListId{ NO_VALUE };
+            UINT32 m_numTiles{ NO_VALUE };
+        };
+
+        // one tracer per process, shared by all threads and TileUpdateManagers
+        static EventTracer& Get();
+
+        void SetEnabled(bool in_enabled) { m_enabled.store(in_enabled, std::memory_order_relaxed); }
+        bool GetEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+        // label the calling thread in the trace
+        void SetThreadName(const char* in_pName);
+
+        static INT64 GetTime() { LARGE_INTEGER i; ::QueryPerformanceCounter(&i); return i.QuadPart; }
+
+        // append to the calling thread's ring
+        void Record(const Event& in_event)
+        {
+            if (GetEnabled()) { GetRing().Write(in_event); }
+        }
+
+        void RecordInstant(const char* in_pName, UINT32 in_updateListId = NO_VALUE, UINT32 in_numTiles = NO_VALUE, UINT64 in_fenceValue = NO_FENCE)
+        {
+            if (GetEnabled())
+            {
+                GetRing().Write(Event{ GetTime(), -1, in_pName, in_fenceValue, in_updateListId, in_numTiles });
+            }
+        }
+
+        // write the events currently held by all rings as Chrome trace event JSON
+        // threads may keep recording: events overwritten while copying are dropped
+        bool WriteChromeTrace(const std::wstring& in_filename);
+
+        //-------------------------------------------
+        // records the lifetime of the scope. arguments may be set before it ends
+        //-------------------------------------------
+        class Scope
+        {
+        public:
+            Scope(const char* in_pName)
+            {
+                if (Get().GetEnabled())
+                {
+                    m_event.m_pName = in_pName;
+                    m_event.m_startTime = GetTime();
+                }
+            }
+            ~Scope()
+            {
+                if (m_event.m_pName)
+                {
+                    m_event.m_duration = GetTime() - m_event.m_startTime;
+                    Get().Record(m_event);
+                }
+            }
+            void SetArgs(UINT32 in_updateListId, UINT32 in_numTiles, UINT64 in_fenceValue = NO_FENCE)
+            {
+                m_event.m_updateListId = in_updateListId;
+                m_event.m_numTiles = in_numTiles;
+                m_event.m_fenceValue = in_fenceValue;
+            }
+            void Discard() { m_event.m_pName = nullptr; } // nothing worth recording happened
+        private:
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+            Event m_event;
+        };
+    private:
+        EventTracer();
+
+        static constexpr UINT32 RING_SIZE = 16384; // events per thread. power of 2
+
+        // single writer (the owning thread), read only by WriteChromeTrace()
+        class Ring
+        {
+        public:
+            void Write(const Event& in_event)
+            {
+                UINT64 i = m_writeIndex.load(std::memory_order_relaxed);
+                m_events[i & (RING_SIZE - 1)] = in_event;
+                m_writeIndex.store(i + 1, std::memory_order_release);
+            }
+            void Read(std::vector<Event>& out_events) const;
+
+            std::string m_name;
+            UINT32 m_threadId{ 0 };  // tid in the trace
+            bool m_inUse{ false };   // owned by a live thread
+            std::atomic<UINT64> m_writeIndex{ 0 };
+        private:
+            std::vector<Event> m_events{ RING_SIZE };
+        };
+
+        // rings are created on a thread's first event and recycled when the thread exits
+        Ring& GetRing();
+        void ReleaseRing(Ring* in_pRing);
+
+        struct ThreadState
+        {
+            ~ThreadState();
+            Ring* m_pRing{ nullptr };
+            const char* m_pName{ nullptr };
+        };
+        static thread_local ThreadState m_threadState;
+
+        std::atomic<bool> m_enabled{ false };
+        std::mutex m_mutex; // guards m_rings and ring names
+        std::vector<std::unique_ptr<Ring>> m_rings;
+        UINT32 m_numThreads{ 0 };
+        INT64 m_startTime{ 0 };
+        double m_microsecondsPerTick{ 0 };
+    };
+}
+
+//-----------------------------------------------------------------------------
+// instrumentation, compiled out if EVENT_TRACING is 0
+// TRACE_SCOPE_ARGS() and TRACE_SCOPE_DISCARD() apply to the TRACE_SCOPE() of the same block
+//-----------------------------------------------------------------------------
+#if EVENT_TRACING
+#define TRACE_THREAD_NAME(name) Streaming::EventTracer::Get().SetThreadName(name)
+#define TRACE_SCOPE(name) Streaming::EventTracer::Scope traceScope(name)
+#define TRACE_SCOPE_ARGS(...) traceScope.SetArgs(__VA_ARGS__)
+#define TRACE_SCOPE_DISCARD() traceScope.Discard()
+#define TRACE_INSTANT(...) Streaming::EventTracer::Get().RecordInstant(__VA_ARGS__)
+#else
+#define TRACE_THREAD_NAME(name)
+#define TRACE_SCOPE(name)
+#define TRACE_SCOPE_ARGS(...)
+#define TRACE_SCOPE_DISCARD()
+#define TRACE_INSTANT(...)
+#endif
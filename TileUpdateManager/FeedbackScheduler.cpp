@@ -0,0 +1,220 @@
+//*********************************************************
+//
+// Copyright 2020 Intel Corporation 
+//
+// Permission is hereby granted, free of charge, to any 
+// person obtaining a copy of this software and associated 
+// documentation files(the "Software"), to deal in the Software 
+// without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to 
+// whom the Software is furnished to do so, subject to the 
+// following conditions :
+// The above copyright notice and this permission notice shall 
+// be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+// DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+
+
+#include "pch.h"
+
+#include "FeedbackScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+//-----------------------------------------------------------------------------
+// results processed since the last call, each weighted m_changeRateWeight
+//-----------------------------------------------------------------------------
+void Streaming::FeedbackScheduler::Update(Candidate& inout_candidate) const
+{
+    auto& history = *inout_candidate.m_pHistory;
+
+    UINT numProcessed = inout_candidate.m_numProcessed - history.m_numProcessed;
+    if (numProcessed)
+    {
+        UINT numChanged = inout_candidate.m_numChanged - history.m_numChanged;
+        float fraction = std::min(1.f, float(numChanged) / float(numProcessed));
+        float keep = std::pow(1.f - m_params.m_changeRateWeight, float(numProcessed));
+        history.m_changeRate = (history.m_changeRate * keep) + (fraction * (1.f - keep));
+    }
+    history.m_numProcessed = inout_candidate.m_numProcessed;
+    history.m_numChanged = inout_candidate.m_numChanged;
+}
+
+//-----------------------------------------------------------------------------
+// 1 frame if feedback always changes, m_maxInterval if it never does
+//-----------------------------------------------------------------------------
+UINT Streaming::FeedbackScheduler::GetInterval(const History& in_history) const
+{
+    float stability = 1.f - std::min(1.f, std::max(0.f, in_history.m_changeRate));
+    return 1 + UINT(float(m_params.m_maxInterval - 1) * stability + 0.5f);
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+bool Streaming::FeedbackScheduler::IsDue(const Candidate& in_candidate) const
+{
+    const auto& history = *in_candidate.m_pHistory;
+
+    if ((0 == history.m_lastFrame) || ((m_frame - history.m_lastFrame) >= GetInterval(history)))
+    {
+        return true;
+    }
+
+    // e.g. the camera moved toward the object
+    float area = in_candidate.m_screenArea;
+    float previousArea = history.m_screenArea;
+    return std::abs(area - previousArea) > (m_params.m_hintChange * std::max(area, previousArea));
+}
+
+//-----------------------------------------------------------------------------
+// importance * staleness. resources that never had feedback come first
+//-----------------------------------------------------------------------------
+float Streaming::FeedbackScheduler::GetPriority(const Candidate& in_candidate) const
+{
+    const auto& history = *in_candidate.m_pHistory;
+
+    float importance = (in_candidate.m_screenArea > 0) ? in_candidate.m_screenArea : 1.f / (1.f + in_candidate.m_distance);
+
+    float staleness = float((0 == history.m_lastFrame) ? m_frame : m_frame - history.m_lastFrame);
+
+    return (importance + 1e-6f) * staleness / float(GetInterval(history));
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+UINT Streaming::FeedbackScheduler::Schedule(Candidate* inout_pCandidates, UINT in_numCandidates, float in_budgetMs)
+{
+    m_statistics.m_numCandidates = in_numCandidates;
+    m_statistics.m_numScheduled = 0;
+    m_statistics.m_numStable = 0;
+    m_statistics.m_numDeferred = 0;
+    m_statistics.m_estimatedMs = 0;
+
+    m_ranked.clear();
+    for (UINT i = 0; i < in_numCandidates; i++)
+    {
+        auto& c = inout_pCandidates[i];
+        c.m_scheduled = false;
+        Update(c);
+
+        if (IsDue(c))
+        {
+            m_ranked.push_back({ GetPriority(c), i });
+        }
+        else
+        {
+            m_statistics.m_numStable++;
+        }
+    }
+
+    // highest priority first. ties in candidate order
+    std::sort(m_ranked.begin(), m_ranked.end(), [](const auto& a, const auto& b)
+        { return (a.first > b.first) || ((a.first == b.first) && (a.second < b.second)); });
+
+    for (const auto& r : m_ranked)
+    {
+        auto& c = inout_pCandidates[r.second];
+        float cost = EstimateCost(c.m_numTexels);
+
+        bool fits = (cost < 0) ?
+            (m_statistics.m_numScheduled < m_params.m_defaultNumResolves) :
+            (m_statistics.m_estimatedMs + cost <= in_budgetMs);
+
+        // a smaller, lower priority candidate may still fit
+        if (!fits && m_statistics.m_numScheduled)
+        {
+            m_statistics.m_numDeferred++;
+            continue;
+        }
+
+        c.m_scheduled = true;
+        c.m_pHistory->m_lastFrame = m_frame;
+        c.m_pHistory->m_screenArea = c.m_screenArea;
+
+        m_statistics.m_numScheduled++;
+        m_statistics.m_estimatedMs += std::max(0.f, cost);
+    }
+
+    m_statistics.m_totalScheduled += m_statistics.m_numScheduled;
+    m_statistics.m_totalStable += m_statistics.m_numStable;
+    m_statistics.m_totalDeferred += m_statistics.m_numDeferred;
+
+    m_frame++;
+
+    return m_statistics.m_numScheduled;
+}
+
+//-----------------------------------------------------------------------------
+// least squares fit of time = a * resolves + b * texels over all measurements,
+// weighting each older measurement by m_costHistoryWeight
+// if all resources have the same size the two terms cannot be separated: cost per resolve only
+//-----------------------------------------------------------------------------
+void Streaming::FeedbackScheduler::AddMeasurement(float in_timeMs, UINT in_numResolves, UINT64 in_numTexels)
+{
+    if (0 == in_numResolves)
+    {
+        return;
+    }
+
+    const double w = m_params.m_costHistoryWeight;
+    const double r = double(in_numResolves);
+    const double T = double(in_numTexels);
+    const double t = double(in_timeMs);
+
+    m_sumRR = w * m_sumRR + r * r;
+    m_sumRT = w * m_sumRT + r * T;
+    m_sumTT = w * m_sumTT + T * T;
+    m_sumRt = w * m_sumRt + r * t;
+    m_sumTt = w * m_sumTt + T * t;
+
+    double a = m_sumRt / m_sumRR;
+    double b = 0;
+
+    double det = (m_sumRR * m_sumTT) - (m_sumRT * m_sumRT);
+    if (det > 1e-6 * m_sumRR * m_sumTT)
+    {
+        double fitA = ((m_sumRt * m_sumTT) - (m_sumTt * m_sumRT)) / det;
+        double fitB = ((m_sumRR * m_sumTt) - (m_sumRT * m_sumRt)) / det;
+
+        if ((fitA >= 0) && (fitB >= 0))
+        {
+            a = fitA;
+            b = fitB;
+        }
+        else if (fitA < 0) // dominated by size
+        {
+            a = 0;
+            b = m_sumTt / m_sumTT;
+        }
+    }
+
+    m_costPerResolve = a;
+    m_costPerTexel = b;
+    m_haveMeasurement = true;
+
+    m_statistics.m_measuredMs = in_timeMs;
+    m_statistics.m_costPerResolveMs = float(a);
+    m_statistics.m_costPerMegaTexelMs = float(b * 1000000.);
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+float Streaming::FeedbackScheduler::EstimateCost(UINT in_numTexels) const
+{
+    if (!m_haveMeasurement)
+    {
+        return -1.f;
+    }
+    return float(m_costPerResolve + m_costPerTexel * double(in_numTexels));
+}
@@ -0,0 +1,143 @@
+//*********************************************************
+//
+// Copyright 2020 Intel Corporation 
+//
+// Permission is hereby granted, free of charge, to any 
+// person obtaining a copy of this software and associated 
+// documentation files(the "Software"), to deal in the Software 
+// without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to 
+// whom the Software is furnished to do so, subject to the 
+// following conditions :
+// The above copyright notice and this permission notice shall 
+// be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+// DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+
+
+/*=============================================================================
+FeedbackScheduler
+
+Chooses which resources get sampler feedback each frame, within a GPU time budget.
+
+A candidate is due for feedback if:
+    it has never had feedback, or
+    its screen area hint changed substantially since its last feedback, or
+    enough frames have passed. The interval grows from 1 frame for resources whose
+    feedback keeps changing the desired tiles to Params::m_maxInterval frames for
+    resources whose feedback never changes.
+Due candidates are ranked by importance (screen area, or distance if there is no area)
+times staleness (frames since feedback / interval), then taken in order until the
+predicted cost exceeds the budget.
+
+The cost model predicts resolve time as a cost per resolve plus a cost per feedback texel,
+fit to measured frame times by least squares with older frames weighted less.
+
+No D3D objects are used: the per-resource History is stored by the caller.
+=============================================================================*/
+
+#pragma once
+
+#include <vector>
+
+namespace Streaming
+{
+    class FeedbackScheduler
+    {
+    public:
+        struct Params
+        {
+            UINT m_maxInterval{ 16 };          // frames between feedback for a resource whose feedback never changes
+            float m_changeRateWeight{ 0.25f }; // weight of each new feedback result in the running change rate
+            float m_hintChange{ 0.5f };        // relative change of screen area that makes a resource due
+            UINT m_defaultNumResolves{ 10 };   // per frame, until resolve time has been measured
+            float m_costHistoryWeight{ 0.9f }; // weight of previous measurements in the cost model
+        };
+
+        // per-resource state, kept by the owner of the resource
+        struct History
+        {
+            UINT64 m_lastFrame{ 0 };   // frame of the most recent feedback. 0 = never
+            float m_screenArea{ 0 };   // hint at that time
+            float m_changeRate{ 1 };   // running fraction of processed feedback that changed the desired tiles
+            UINT m_numProcessed{ 0 };  // resource counters already included in m_changeRate
+            UINT m_numChanged{ 0 };
+        };
+
+        struct Candidate
+        {
+            History* m_pHistory{ nullptr };
+            UINT m_numTexels{ 0 };     // feedback resolution, for the cost model
+            float m_screenArea{ 0 };   // hint: fraction of the render target covered. 0 = unknown
+            float m_distance{ 0 };     // hint: distance from the camera
+            UINT m_numProcessed{ 0 };  // totals from the resource: feedback results processed,
+            UINT m_numChanged{ 0 };    // and how many of those changed the desired tiles
+            bool m_scheduled{ false }; // output of Schedule()
+        };
+
+        struct Statistics
+        {
+            // most recent Schedule()
+            UINT m_numCandidates{ 0 };
+            UINT m_numScheduled{ 0 };
+            UINT m_numStable{ 0 };     // not due: feedback rarely changes and was sampled recently
+            UINT m_numDeferred{ 0 };   // due, but over budget
+            float m_estimatedMs{ 0 };  // predicted resolve time of the scheduled candidates
+
+            // cost model
+            float m_measuredMs{ 0 };   // most recent measured resolve time
+            float m_costPerResolveMs{ 0 };
+            float m_costPerMegaTexelMs{ 0 };
+
+            // since creation
+            UINT64 m_totalScheduled{ 0 };
+            UINT64 m_totalStable{ 0 };
+            UINT64 m_totalDeferred{ 0 };
+        };
+
+        FeedbackScheduler() {}
+        FeedbackScheduler(const Params& in_params) : m_params(in_params) {}
+
+        // sets m_scheduled on the most important due candidates that fit in in_budgetMs
+        // at least 1 if any are due. advances the frame. returns # scheduled
+        UINT Schedule(Candidate* inout_pCandidates, UINT in_numCandidates, float in_budgetMs);
+
+        // measured GPU time of a frame that resolved in_numResolves resources totaling in_numTexels
+        void AddMeasurement(float in_timeMs, UINT in_numResolves, UINT64 in_numTexels);
+
+        // predicted resolve time. negative until something has been measured
+        float EstimateCost(UINT in_numTexels) const;
+
+        // ranking inputs, for the frame of the next Schedule(). Update() first
+        bool IsDue(const Candidate& in_candidate) const;
+        float GetPriority(const Candidate& in_candidate) const;
+        UINT GetInterval(const History& in_history) const;
+
+        // fold new feedback results from the candidate into the change rate of its history
+        void Update(Candidate& inout_candidate) const;
+
+        const Statistics& GetStatistics() const { return m_statistics; }
+    private:
+        Params m_params;
+        UINT64 m_frame{ 1 };
+        Statistics m_statistics;
+
+        // weighted sums for the least-squares fit time = a * resolves + b * texels
+        double m_sumRR{ 0 }, m_sumRT{ 0 }, m_sumTT{ 0 }, m_sumRt{ 0 }, m_sumTt{ 0 };
+        bool m_haveMeasurement{ false };
+        double m_costPerResolve{ 0 }; // ms
+        double m_costPerTexel{ 0 };   // ms
+
+        std::vector<std::pair<float, UINT>> m_ranked; // priority, candidate index
+    };
+}
@@ -60,6 +60,7 @@ namespace Streaming
             DATA_VIZ_TILE
         };
         void SetVisualizationMode(UINT in_mode) { m_visualizationMode = (VisualizationMode)in_mode; }
+        VisualizationMode GetVisualizationMode() const { return m_visualizationMode; }
 
         bool GetCompleted(const UpdateList& in_updateList) const;
 
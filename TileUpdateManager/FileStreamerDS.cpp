@@ -32,6 +32,7 @@
 #include "XeTexture.h"
 #include "UpdateList.h"
 #include "StreamingHeap.h"
+#include "EventTracer.h"
 
 //=======================================================================================
 //=======================================================================================
@@ -93,13 +94,15 @@ void Streaming::FileStreamerDS::StreamTexture(Streaming::UpdateList& in_updateLi
     if (VisualizationMode::DATA_VIZ_NONE == m_visualizationMode)
     {
         request.Options.SourceType = DSTORAGE_REQUEST_SOURCE_FILE;
-        request.Source.File.Source = GetFileHandle(in_updateList.m_pStreamingResource->GetFileHandle());
+        IDStorageFile* pFile = GetFileHandle(in_updateList.m_pStreamingResource->GetFileHandle());
         request.UncompressedSize = D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES;
 
         UINT numCoords = (UINT)in_updateList.m_coords.size();
         for (UINT i = 0; i < numCoords; i++)
         {
-            auto fileOffset = pTextureFileInfo->GetFileOffset(in_updateList.m_coords[i]);
+            auto fileOffset = in_updateList.m_pStreamingResource->GetFileOffset(in_updateList.m_coords[i]);
+            // tiles shared with other textures are read from the tile store
+            request.Source.File.Source = fileOffset.inStore ? GetFileHandle(in_updateList.m_pStreamingResource->GetStoreFileHandle()) : pFile;
             request.Source.File.Offset = fileOffset.offset;
             request.Source.File.Size = fileOffset.numBytes;
 
@@ -114,7 +117,7 @@ void Streaming::FileStreamerDS::StreamTexture(Streaming::UpdateList& in_updateLi
 
             if (m_captureTrace)
             {
-                std::wstring fileName = std::filesystem::path(in_updateList.m_pStreamingResource->GetFileName()).filename();
+                std::wstring fileName = std::filesystem::path(fileOffset.inStore ? pTextureFileInfo->GetStoreFileName() : in_updateList.m_pStreamingResource->GetFileName()).filename();
                 TraceRequest(pAtlas, coord, fileName,
                     request.Source.File.Offset,
                     (UINT32)request.Source.File.Size,
@@ -153,6 +156,9 @@ void Streaming::FileStreamerDS::StreamTexture(Streaming::UpdateList& in_updateLi
 //-----------------------------------------------------------------------------
 void Streaming::FileStreamerDS::Signal()
 {
+    TRACE_SCOPE("DStorageSubmit");
+    TRACE_SCOPE_ARGS(EventTracer::NO_VALUE, EventTracer::NO_VALUE, m_copyFenceValue);
+
     if (VisualizationMode::DATA_VIZ_NONE == m_visualizationMode)
     {
         m_fileQueue->EnqueueSignal(m_copyFence.Get(), m_copyFenceValue);
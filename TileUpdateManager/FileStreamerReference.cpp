@@ -31,6 +31,7 @@
 #include "XeTexture.h"
 #include "StreamingResourceDU.h"
 #include "StreamingHeap.h"
+#include "EventTracer.h"
 
 static const  D3D12_COMMAND_LIST_TYPE g_commandListType = D3D12_COMMAND_LIST_TYPE_COPY;
 
@@ -77,6 +78,7 @@ Streaming::FileStreamerReference::FileStreamerReference(ID3D12Device* in_pDevice
     m_copyThread = std::thread([&]
         {
             DebugPrint(L"Created Copy Thread\n");
+            TRACE_THREAD_NAME("ReferenceCopy");
             while (m_copyThreadRunning)
             {
                 CopyThread();
@@ -183,12 +185,16 @@ void Streaming::FileStreamerReference::LoadTexture(Streaming::FileStreamerRefere
 
     if (VisualizationMode::DATA_VIZ_NONE == m_visualizationMode)
     {
-        auto pTextureFileInfo = pUpdateList->m_pStreamingResource->GetTextureFileInfo();
         auto pFileHandle = FileStreamerReference::GetFileHandle(pUpdateList->m_pStreamingResource->GetFileHandle());
+        HANDLE storeFileHandle = INVALID_HANDLE_VALUE;
+        if (pUpdateList->m_pStreamingResource->GetStoreFileHandle())
+        {
+            storeFileHandle = FileStreamerReference::GetFileHandle(pUpdateList->m_pStreamingResource->GetStoreFileHandle());
+        }
         for (UINT i = startIndex; i < endIndex; i++)
         {
             // get file offset to tile
-            auto fileOffset = pTextureFileInfo->GetFileOffset(pUpdateList->m_coords[i]);
+            auto fileOffset = pUpdateList->m_pStreamingResource->GetFileOffset(pUpdateList->m_coords[i]);
 
             // convert tile index into byte offset
             UINT byteOffset = D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES * in_copyBatch.m_uploadIndices[i];
@@ -201,15 +207,18 @@ void Streaming::FileStreamerReference::LoadTexture(Streaming::FileStreamerRefere
 
             o.Internal = 0;
             o.InternalHigh = 0;
-            o.OffsetHigh = 0;
-            o.Offset = fileOffset.offset;
 
             // align # bytes read
             UINT alignment = FileStreamerReference::MEDIA_SECTOR_SIZE - 1;
             UINT numBytes = (fileOffset.numBytes + alignment) & ~(alignment);
-            o.Offset &= ~alignment; // rewind the offset to alignment
+            UINT64 offset = fileOffset.offset & ~UINT64(alignment); // rewind the offset to alignment
+
+            // a tile store may exceed 4GB
+            o.Offset = (DWORD)offset;
+            o.OffsetHigh = (DWORD)(offset >> 32);
 
-            ::ReadFile(pFileHandle, pDst, numBytes, nullptr, &o);
+            // tiles shared with other textures are read from the tile store
+            ::ReadFile(fileOffset.inStore ? storeFileHandle : pFileHandle, pDst, numBytes, nullptr, &o);
         }
         ASSERT(in_copyBatch.m_numEvents == endIndex);
     }
@@ -269,6 +278,7 @@ void Streaming::FileStreamerReference::ExecuteCopyCommandList(ID3D12GraphicsComm
 void Streaming::FileStreamerReference::CopyThread()
 {
     bool submitCopyCommands = false;
+    [[maybe_unused]] UINT numTilesCopied = 0;
 
     for (auto& c : m_copyBatches)
     {
@@ -330,6 +340,7 @@ void Streaming::FileStreamerReference::CopyThread()
                         D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES * c.m_uploadIndices[i],
                         D3D12_TILE_COPY_FLAG_LINEAR_BUFFER_TO_SWIZZLED_TILED_RESOURCE | D3D12_TILE_COPY_FLAG_NO_HAZARD);
                 }
+                numTilesCopied += c.m_lastSignaled - c.m_copyEnd;
                 c.m_copyEnd = c.m_lastSignaled;
                 ASSERT(c.m_copyEnd <= c.m_pUpdateList->GetNumStandardUpdates());
             }
@@ -363,6 +374,7 @@ void Streaming::FileStreamerReference::CopyThread()
 
     if (submitCopyCommands)
     {
+        TRACE_INSTANT("ExecuteCopies", EventTracer::NO_VALUE, numTilesCopied, m_copyFenceValue);
         ExecuteCopyCommandList(m_copyCommandList.Get());
         m_copyFenceValue++;
     }
@@ -29,6 +29,8 @@
 #include "InternalResources.h"
 #include "XeTexture.h"
 
+#include <atomic>
+
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 Streaming::InternalResources::InternalResources(
@@ -239,10 +241,10 @@ void Streaming::InternalResources::ReadbackFeedback(ID3D12GraphicsCommandList* o
 //-----------------------------------------------------------------------------
 void Streaming::InternalResources::NameStreamingTexture()
 {
-    static UINT m_streamingResourceID = 0;
+    // resources may be prepared concurrently on worker threads
+    static std::atomic<UINT> m_streamingResourceID{ 0 };
     m_tiledResource->SetName(
-        AutoString("m_streamingTexture", m_streamingResourceID).str().c_str());
-    m_streamingResourceID++;
+        AutoString("m_streamingTexture", m_streamingResourceID.fetch_add(1, std::memory_order_relaxed)).str().c_str());
 }
 
 //-----------------------------------------------------------------------------
@@ -0,0 +1,95 @@
+//*********************************************************
+//
+// Copyright 2020 Intel Corporation 
+//
+// Permission is hereby granted, free of charge, to any 
+// person obtaining a copy of this software and associated 
+// documentation files(the "Software"), to deal in the Software 
+// without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to 
+// whom the Software is furnished to do so, subject to the 
+// following conditions :
+// The above copyright notice and this permission notice shall 
+// be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+// DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+namespace Streaming
+{
+    //==================================================
+    // stride scheduling of stale resources by priority weight
+    // under contention for UpdateLists, a resource with twice the priority gets twice as many UpdateLists
+    // resources of equal priority retain oldest-first order
+    // priority 0 is only served when no weighted resource is waiting
+    //==================================================
+    class PriorityScheduler
+    {
+    public:
+        void Resize(size_t in_size) { m_clients.resize(in_size); }
+
+        // resource became stale: it joins at the current virtual time, no credit for time spent idle
+        void Wake(uint32_t in_index, float in_priority)
+        {
+            auto& c = m_clients[in_index];
+            c.m_stride = GetStride(in_priority);
+            c.m_pass = std::max(c.m_pass, m_current);
+            c.m_sequence = ++m_sequence;
+            m_dirty = true;
+        }
+
+        // resource was given an UpdateList. it goes to the back of resources with the same virtual time
+        void Served(uint32_t in_index)
+        {
+            auto& c = m_clients[in_index];
+            m_current = std::max(m_current, c.m_pass);
+            c.m_pass += c.m_stride;
+            c.m_sequence = ++m_sequence;
+            m_dirty = true;
+        }
+
+        // order stale resources by the virtual time at which their next UpdateList would be complete
+        void Sort(std::vector<uint32_t>& inout_indices)
+        {
+            if (!m_dirty) { return; }
+            m_dirty = false;
+            std::sort(inout_indices.begin(), inout_indices.end(), [&](uint32_t a, uint32_t b)
+                {
+                    const auto& ca = m_clients[a];
+                    const auto& cb = m_clients[b];
+                    const double fa = ca.m_pass + ca.m_stride;
+                    const double fb = cb.m_pass + cb.m_stride;
+                    return (fa != fb) ? (fa < fb) : (ca.m_sequence < cb.m_sequence);
+                });
+        }
+    private:
+        static constexpr double m_idleStride = 1e9;
+        struct Client
+        {
+            double m_pass{ 0 };      // virtual time of the next UpdateList
+            double m_stride{ 1 };    // 1 / priority
+            uint64_t m_sequence{ 0 }; // oldest-first among equals
+        };
+        std::vector<Client> m_clients;
+        double m_current{ 0 };
+        uint64_t m_sequence{ 0 };
+        bool m_dirty{ false };
+
+        static double GetStride(float in_priority) { return (in_priority > 0) ? 1.0 / double(in_priority) : m_idleStride; }
+    };
+}
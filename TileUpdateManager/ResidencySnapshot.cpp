@@ -0,0 +1,152 @@
+//*********************************************************
+//
+// Copyright 2020 Intel Corporation 
+//
+// Permission is hereby granted, free of charge, to any 
+// person obtaining a copy of this software and associated 
+// documentation files(the "Software"), to deal in the Software 
+// without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to 
+// whom the Software is furnished to do so, subject to the 
+// following conditions :
+// The above copyright notice and this permission notice shall 
+// be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+// DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+
+
+//=============================================================================
+// Residency snapshots: TileUpdateManager::WriteResidencySnapshot() and RestoreResidencySnapshot()
+//
+// file layout:
+//     SnapshotHeader
+//     per resource: SnapshotResource, file name (m_fileNameLength wchar_t), resident mip per region (m_width * m_height bytes)
+//=============================================================================
+
+#include "pch.h"
+
+#include "TileUpdateManagerBase.h"
+#include "StreamingResourceBase.h"
+
+#include <map>
+
+namespace
+{
+    struct SnapshotHeader
+    {
+        static constexpr UINT32 MAGIC = 0x52534653; // "SFSR"
+        static constexpr UINT32 VERSION = 1;
+
+        UINT32 m_magic{ MAGIC };
+        UINT32 m_version{ VERSION };
+        UINT32 m_numResources{ 0 };
+    };
+
+    struct SnapshotResource
+    {
+        UINT32 m_fileNameLength{ 0 };
+        UINT32 m_ordinal{ 0 }; // n-th resource created from this file
+        UINT32 m_width{ 0 };
+        UINT32 m_height{ 0 };
+    };
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+bool Streaming::TileUpdateManagerBase::WriteResidencySnapshot(const std::wstring& in_filename)
+{
+    std::ofstream ofs(in_filename, std::ios::out | std::ios::binary);
+    if (!ofs.good()) { return false; }
+
+    SnapshotHeader header;
+    header.m_numResources = (UINT32)m_streamingResources.size();
+    ofs.write((const char*)&header, sizeof(header));
+
+    std::map<std::wstring, UINT32> ordinals;
+    for (auto p : m_streamingResources)
+    {
+        const std::wstring& fileName = p->GetFileName();
+
+        SnapshotResource resource;
+        resource.m_fileNameLength = (UINT32)fileName.size();
+        resource.m_ordinal = ordinals[fileName]++;
+        resource.m_width = p->GetNumTilesWidth();
+        resource.m_height = p->GetNumTilesHeight();
+
+        ofs.write((const char*)&resource, sizeof(resource));
+        ofs.write((const char*)fileName.data(), fileName.size() * sizeof(wchar_t));
+        ofs.write((const char*)p->GetResidentMips(), size_t(resource.m_width) * resource.m_height);
+    }
+
+    return ofs.good();
+}
+
+//-----------------------------------------------------------------------------
+// saved resources without a match (or with different dimensions) are skipped
+//-----------------------------------------------------------------------------
+PrefetchHandle Streaming::TileUpdateManagerBase::RestoreResidencySnapshot(const std::wstring& in_filename, const PrefetchOptions& in_options)
+{
+    std::ifstream ifs(in_filename, std::ios::in | std::ios::binary);
+    if (!ifs.good()) { return 0; }
+
+    SnapshotHeader header;
+    ifs.read((char*)&header, sizeof(header));
+    if ((!ifs.good()) || (SnapshotHeader::MAGIC != header.m_magic) || (SnapshotHeader::VERSION != header.m_version))
+    {
+        return 0;
+    }
+
+    std::map<std::pair<std::wstring, UINT32>, StreamingResourceBase*> resources;
+    {
+        std::map<std::wstring, UINT32> ordinals;
+        for (auto p : m_streamingResources)
+        {
+            const std::wstring& fileName = p->GetFileName();
+            resources[{ fileName, ordinals[fileName]++ }] = p;
+        }
+    }
+
+    std::vector<std::pair<StreamingResourceBase*, std::vector<UINT8>>> restores;
+    for (UINT32 i = 0; i < header.m_numResources; i++)
+    {
+        SnapshotResource resource;
+        ifs.read((char*)&resource, sizeof(resource));
+
+        // not a snapshot this version wrote. 16k x 16k BC7 is 64x64 regions
+        if ((!ifs.good()) || (resource.m_fileNameLength > 32768) || (resource.m_width > 4096) || (resource.m_height > 4096)) { break; }
+
+        std::wstring fileName(resource.m_fileNameLength, L'\0');
+        ifs.read((char*)fileName.data(), fileName.size() * sizeof(wchar_t));
+
+        std::vector<UINT8> mips(size_t(resource.m_width) * resource.m_height);
+        ifs.read((char*)mips.data(), mips.size());
+
+        if (!ifs.good()) { break; } // truncated: restore what was read
+
+        auto r = resources.find({ fileName, resource.m_ordinal });
+        if ((resources.end() != r) &&
+            (r->second->GetNumTilesWidth() == resource.m_width) && (r->second->GetNumTilesHeight() == resource.m_height))
+        {
+            restores.emplace_back(r->second, std::move(mips));
+        }
+    }
+
+    std::shared_ptr<PrefetchBatch> pBatch;
+    const PrefetchHandle handle = CreatePrefetchBatch(in_options, (UINT)restores.size(), pBatch);
+    for (auto& [pResource, mips] : restores)
+    {
+        pResource->AddPrefetch(pBatch, std::move(mips));
+    }
+
+    return handle;
+}
@@ -32,11 +32,14 @@ Usage:
 2. Use TileUpdateManager::CreateStreamingHeap() to create heaps to be used by 1 or more StreamingResources
 3. Use TileUpdateManager::CreateStreamingResource() to create 1 or more StreamingResources
     each StreamingResource resides in a single heap
+    optionally, TileUpdateManager::PrepareStreamingResource() does the file i/o and resource creation
+    on any thread, so only a short registration remains for CreateStreamingResource()
 
 Draw loop:
 1. BeginFrame() with the TileUpdateManager (TUM)
 2. Draw your assets using the streaming textures, min-mip-map, and sampler feedback SRVs
     Optionally call TUM::QueueFeedback() to get sampler feedback for this draw.
+    TUM::ScheduleFeedback() chooses which resources to QueueFeedback() for within a GPU time budget
     SRVs can be created using StreamingResource methods
 3. EndFrame() (with the TUM) returns 2 command lists: beforeDraw and afterDraw
 4. ExecuteCommandLists() with [beforeDraw, yourCommandList, afterDraw] command lists.
@@ -61,6 +64,62 @@ struct StreamingHeap
     virtual UINT GetNumTilesAllocated() const = 0;
 };
 
+//=============================================================================
+// see StreamingResource::GetQuality()
+// how much of what the latest feedback requested is resident. computed once per frame after changes
+//=============================================================================
+struct StreamingQuality
+{
+    UINT m_numTilesWanted{ 0 };         // tiles the latest feedback requires, excluding packed mips. limited by StreamingQoS::m_finestMip,
+                                        // excludes tiles kept only by guaranteed mips, pins, or prefetches
+    UINT m_numTilesWantedResident{ 0 }; // of those, resident and mapped
+    float m_mipDeficit{ 0 };            // mean # mips the min mip map is coarser than requested, weighted by requested texels
+
+    float GetFractionResident() const { return m_numTilesWanted ? float(m_numTilesWantedResident) / float(m_numTilesWanted) : 1.f; }
+};
+
+//=============================================================================
+// see StreamingResource::SetQoS()
+// how a resource competes with others for UpdateLists and heap space, and which mips it may or must keep
+// mips are numbered as in the texture: 0 is the finest. values past the standard mips mean "packed mips only"
+//=============================================================================
+struct StreamingQoS
+{
+    // relative share of UpdateLists (and so heap space) while resources wait for them: 2 gets twice the uploads of 1
+    // 0 = only when no other resource is waiting
+    float m_priority{ 1.f };
+
+    // never load mips finer than this, whatever feedback asks for. e.g. 2 caps a texture at 1/4 resolution
+    // wins over m_guaranteedMip and pinned regions
+    UINT m_finestMip{ 0 };
+
+    // keep this mip and coarser resident, without feedback and after QueueEviction()
+    UINT m_guaranteedMip{ UINT(-1) };
+};
+
+//=============================================================================
+// see TileUpdateManager::Prefetch()
+//=============================================================================
+struct PrefetchOptions
+{
+    // share of UpdateLists, as StreamingQoS::m_priority, while a resource has nothing to load but prefetched tiles
+    // if feedback also wants tiles, the resource uses the greater of this and its own priority
+    float m_priority{ 0.5f };
+
+    // seconds until the prefetched tiles are no longer kept, loaded or not. 0 = until ReleasePrefetch()
+    float m_expirySeconds{ 0 };
+};
+
+using PrefetchHandle = UINT64; // 0 is never a valid handle
+
+enum class PrefetchStatus
+{
+    Invalid,  // unknown or released handle
+    Pending,
+    Complete, // every requested region is resident in the min mip map at the requested mip or finer
+    Expired   // expired (or its resource was destroyed) before completing
+};
+
 //=============================================================================
 // a fine-grained streaming, tiled resource
 // TileUpdateManager is used to create these
@@ -88,8 +147,23 @@ struct StreamingResource
 
     // if a resource isn't visible, evict associated data
     // call any time
+    // tiles kept by StreamingQoS::m_guaranteedMip, PinRegion(), and Prefetch() are not evicted
     virtual void QueueEviction() = 0;
 
+    // priority, mip clamp, and guaranteed mips. call any time, applied by the next ProcessFeedback (within a frame)
+    virtual void SetQoS(const StreamingQoS& in_qos) = 0;
+    virtual StreamingQoS GetQoS() const = 0;
+
+    // keep in_mip and coarser resident over a rectangle of min mip map regions, regardless of feedback or QueueEviction()
+    // a region is one tile of mip 0, so tile (x, y) of mip s covers regions (x << s, y << s, 1 << s, 1 << s)
+    // a later pin replaces an earlier one where they overlap. pin with a mip past the standard mips to unpin
+    // the rectangle is clipped to the resource, so e.g. UINT_MAX for in_width and in_height pins to the edges
+    virtual void PinRegion(UINT in_x, UINT in_y, UINT in_width, UINT in_height, UINT in_mip) = 0;
+
+    // load in_mip and coarser over a rectangle of texture coordinates, before feedback asks for it
+    // same as TileUpdateManager::Prefetch() with a single request
+    virtual PrefetchHandle Prefetch(float in_u0, float in_v0, float in_u1, float in_v1, UINT in_mip, const PrefetchOptions& in_options) = 0;
+
     virtual ID3D12Resource* GetTiledResource() const = 0;
 
     virtual ID3D12Resource* GetMinMipMap() const = 0;
@@ -99,11 +173,160 @@ struct StreamingResource
     //--------------------------------------------
     // number of tiles reserved (not necessarily committed) for this resource
     virtual UINT GetNumTilesVirtual() const = 0;
+    // number of streamed tiles currently resident in the heap (excludes packed mips)
+    virtual UINT GetNumTilesResident() const = 0;
+    // gap between the tiles feedback requested and the tiles resident
+    virtual StreamingQuality GetQuality() const = 0;
 #if RESOLVE_TO_TEXTURE
     virtual ID3D12Resource* GetResolvedFeedback() const = 0;
 #endif
 };
 
+//=============================================================================
+// a file parsed, its packed mips read, and its reserved & feedback resources created,
+// ready to become a StreamingResource. see TileUpdateManager::PrepareStreamingResource()
+//=============================================================================
+struct PreparedStreamingResource
+{
+    // only if not passed to CreateStreamingResource()
+    virtual void Destroy() = 0;
+};
+
+//=============================================================================
+// see TileUpdateManager::Prefetch()
+//=============================================================================
+struct PrefetchRequest
+{
+    StreamingResource* m_pResource{ nullptr };
+
+    // rectangle in texture coordinates: 0,0 to 1,1 is the whole texture
+    float m_u0{ 0 };
+    float m_v0{ 0 };
+    float m_u1{ 1 };
+    float m_v1{ 1 };
+
+    UINT m_mip{ 0 }; // load this mip and coarser
+};
+
+//=============================================================================
+// a resource that could get feedback this frame, see TileUpdateManager::ScheduleFeedback()
+//=============================================================================
+struct FeedbackHint
+{
+    StreamingResource* m_pResource{ nullptr };
+    float m_screenArea{ 0 };   // approximate fraction of the render target covered. 0 if unknown
+    float m_distance{ 0 };     // from the camera, any consistent unit. used if there is no screen area
+    bool m_scheduled{ false }; // output: call QueueFeedback() for this resource
+};
+
+//=============================================================================
+// see TileUpdateManager::GetFeedbackSchedulerStatistics()
+//=============================================================================
+struct FeedbackSchedulerStatistics
+{
+    // most recent ScheduleFeedback()
+    UINT m_numCandidates{ 0 };
+    UINT m_numScheduled{ 0 };
+    UINT m_numStable{ 0 };         // skipped: feedback rarely changes and was sampled recently
+    UINT m_numDeferred{ 0 };       // skipped: over budget
+    float m_estimatedMs{ 0 };      // predicted resolve time of the scheduled resources
+
+    // cost model: resolve time = per resolve + per texel of feedback
+    float m_measuredMs{ 0 };       // most recent measured resolve time
+    float m_costPerResolveMs{ 0 };
+    float m_costPerMegaTexelMs{ 0 };
+
+    // totals
+    UINT64 m_totalScheduled{ 0 };
+    UINT64 m_totalStable{ 0 };
+    UINT64 m_totalDeferred{ 0 };
+};
+
+//=============================================================================
+// see TileUpdateManager::GetStatistics()
+// totals are since the TileUpdateManager was created. "current" values are instantaneous
+// counters are read without locks while streaming continues, so values may be a few operations apart
+//=============================================================================
+struct TileUpdateManagerStatistics
+{
+    // tiles, in pipeline order
+    UINT64 m_numTilesRequested{ 0 };   // became pending loads because feedback wanted them
+    UINT64 m_numTilesCancelled{ 0 };   // pending loads abandoned: no longer wanted by the time they could be queued
+    UINT64 m_numTilesRejected{ 0 };    // pending loads dropped when queued: already loading or resident
+    UINT64 m_numTilesQueued{ 0 };      // placed in UpdateLists for upload, including upgrades from the low quality tier
+    UINT64 m_numTilesMapped{ 0 };      // UpdateTileMappings() issued
+    UINT64 m_numTilesUploaded{ 0 };    // copied and mapped
+    UINT64 m_numTilesEvicted{ 0 };
+    UINT m_numTilesInFlight{ 0 };      // current: queued, not yet uploaded
+    UINT m_numTilesResident{ 0 };      // current: streamed tiles in heaps, excluding packed mips
+
+    // bytes of uploaded tiles
+    UINT64 m_compressedBytesRead{ 0 };   // read from files, as stored. 0 while visualizing
+    UINT64 m_uncompressedBytesRead{ 0 }; // written to heaps, 64KB per tile
+
+    // staging: bytes submitted for reading whose uploads have not completed
+    UINT64 m_stagingBytesInFlight{ 0 };
+    UINT64 m_stagingBytesCapacity{ 0 };  // TileUpdateManagerDesc::m_stagingBufferSizeMB
+
+    // UpdateLists: batches of tiles for one resource
+    UINT m_numUpdateLists{ 0 };            // TileUpdateManagerDesc::m_maxNumCopyBatches
+    UINT m_numUpdateListsFree{ 0 };        // current, by state:
+    UINT m_numUpdateListsAllocated{ 0 };   //   being filled by the ProcessFeedback thread
+    UINT m_numUpdateListsSubmitted{ 0 };   //   waiting for the submit thread to map tiles
+    UINT m_numUpdateListsUploading{ 0 };   //   file reads and copies in progress
+    UINT m_numUpdateListsMapPending{ 0 };  //   copies done, waiting for the mapping fence
+    UINT m_numUpdateListsPackedMips{ 0 };  //   mapping or loading packed mips
+    UINT64 m_numUpdateListsCompleted{ 0 };
+    UINT64 m_numSubmits{ 0 };              // file streamer signals. with DirectStorage, IDStorageQueue::Submit() calls
+
+    // low quality tier (DdsToXet -lowtier)
+    UINT64 m_numLowTierUploads{ 0 };
+    UINT64 m_numUpgrades{ 0 };
+    UINT64 m_lowTierBytesSaved{ 0 };
+    UINT64 m_upgradeBytes{ 0 };
+
+    // seconds
+    float m_totalTileCopyLatency{ 0 };        // summed over uploaded tiles. divide by m_numTilesUploaded
+    float m_totalCpuProcessFeedbackTime{ 0 };
+
+    // # tiles uploaded with latency (queued to mapped) in [2^(i-1), 2^i) microseconds. bucket 0 is < 1us, the last bucket has no upper bound
+    // subtract an earlier snapshot to get percentiles over an interval
+    static constexpr UINT NUM_LATENCY_BUCKETS = 26;
+    UINT64 m_tileLatencyHistogram[NUM_LATENCY_BUCKETS]{};
+
+    // upper bound in microseconds of the bucket holding the nearest-rank percentile (e.g. 0.99) of a histogram
+    // returns 0 if the histogram is empty
+    static UINT64 GetLatencyPercentileUs(const UINT64* in_pHistogram, double in_percentile)
+    {
+        UINT64 numTiles = 0;
+        for (UINT i = 0; i < NUM_LATENCY_BUCKETS; i++) { numTiles += in_pHistogram[i]; }
+        if (0 == numTiles) { return 0; }
+
+        // rank = ceil(percentile * numTiles), at least 1
+        const double exactRank = in_percentile * double(numTiles);
+        UINT64 rank = UINT64(exactRank);
+        if ((double(rank) < exactRank) || (0 == rank)) { rank++; }
+
+        UINT64 count = 0;
+        UINT bucket = 0;
+        for (; bucket < NUM_LATENCY_BUCKETS - 1; bucket++)
+        {
+            count += in_pHistogram[bucket];
+            if (count >= rank) { break; }
+        }
+        return UINT64(1) << bucket;
+    }
+
+    // quality, current: StreamingResource::GetQuality() summed over all resources
+    StreamingQuality m_quality;
+
+    // convergence: time from TileUpdateManager::NotifyCameraCut() until every wanted tile was resident
+    UINT64 m_numCameraCuts{ 0 };
+    UINT64 m_numCameraCutsConverged{ 0 };   // cuts that reached full quality before the next cut
+    float m_timeToFullQuality{ 0 };         // seconds, of the most recent converged cut
+    float m_totalTimeToFullQuality{ 0 };    // seconds, summed over converged cuts
+};
+
 //=============================================================================
 // describe TileUpdateManager (default values are recommended)
 //=============================================================================
@@ -143,6 +366,10 @@ struct TileUpdateManagerDesc
 
     // true: use Microsoft DirectStorage. false: use internal file streaming system
     bool m_useDirectStorage{ true };
+
+    // for files with a low quality tier (DdsToXet -lowtier): while at least this many batches are in flight,
+    // load the cheaper encoding of tiles. they are upgraded to full quality once the backlog drains. 0 disables.
+    UINT m_lowTierThreshold{ 0 };
 };
 
 //=============================================================================
@@ -165,6 +392,13 @@ struct TileUpdateManager
     //--------------------------------------------
     virtual StreamingResource* CreateStreamingResource(const std::wstring& in_filename, StreamingHeap* in_pHeap) = 0;
 
+    //--------------------------------------------
+    // Split creation: PrepareStreamingResource() may be called from any thread, concurrently.
+    // CreateStreamingResource() takes ownership of the prepared resource and completes creation
+    //--------------------------------------------
+    virtual PreparedStreamingResource* PrepareStreamingResource(const std::wstring& in_filename) = 0;
+    virtual StreamingResource* CreateStreamingResource(PreparedStreamingResource* in_pPrepared, StreamingHeap* in_pHeap) = 0;
+
     //--------------------------------------------
     // Call BeginFrame() first,
     // once for all TileUpdateManagers that share heap/upload buffers
@@ -180,6 +414,40 @@ struct TileUpdateManager
     // descriptor required to create Clear() and Resolve() commands
     virtual void QueueFeedback(StreamingResource* in_pResource, D3D12_GPU_DESCRIPTOR_HANDLE in_gpuDescriptor) = 0;
 
+    // choose which resources to QueueFeedback() for this frame, so resolves fit in in_gpuBudgetMs
+    // call once per frame with the candidates (e.g. visible objects). sets m_scheduled on the chosen hints
+    // ranks by the screen area (or distance) hint and frames since the last feedback.
+    // resources whose feedback rarely changes the tiles they need are sampled less often
+    // the per-resolve cost is learned from the measured GPU time. returns # scheduled
+    virtual UINT ScheduleFeedback(FeedbackHint* inout_pHints, UINT in_numHints, float in_gpuBudgetMs) = 0;
+
+    // alternative to QueueFeedback(): min mip feedback computed by the application, e.g. on the CPU
+    // in_pMinMips has the layout of resolved feedback: GetMinMipMapWidth() x GetMinMipMapHeight() bytes, 0xff = not sampled
+    // the data is copied. it is processed like resolved feedback, once the current frame has completed on the GPU
+    virtual void QueueCpuFeedback(StreamingResource* in_pResource, const BYTE* in_pMinMips) = 0;
+
+    //--------------------------------------------
+    // prefetch: load regions of resources before feedback asks for them
+    // e.g. warm a teleport destination, or the next shot of a cutscene, before the camera cuts to it
+    // one handle covers the batch, which may span resources. applied by the ProcessFeedback thread within a frame
+    // the tiles are kept, even after QueueEviction(), until ReleasePrefetch() or PrefetchOptions::m_expirySeconds
+    // poll GetPrefetchStatus(), then release every handle, including completed and expired ones
+    //--------------------------------------------
+    virtual PrefetchHandle Prefetch(const PrefetchRequest* in_pRequests, UINT in_numRequests, const PrefetchOptions& in_options) = 0;
+    virtual PrefetchStatus GetPrefetchStatus(PrefetchHandle in_handle) const = 0;
+    virtual void ReleasePrefetch(PrefetchHandle in_handle) = 0;
+
+    //--------------------------------------------
+    // residency snapshots: start a launch, level reload, or benchmark iteration with the tiles of a previous one
+    // WriteResidencySnapshot() saves the resident mip of every region of every StreamingResource, keyed by file name
+    //     (the n-th resource created from a file matches the n-th saved from that file)
+    // RestoreResidencySnapshot() loads the saved tiles of matching resources as a prefetch, each resource's tiles coarsest mip first, each mip in file order
+    //     call after the resources have been created. release the handle when complete to let feedback take over
+    // both return false/0 if the file could not be written/read
+    //--------------------------------------------
+    virtual bool WriteResidencySnapshot(const std::wstring& in_filename) = 0;
+    virtual PrefetchHandle RestoreResidencySnapshot(const std::wstring& in_filename, const PrefetchOptions& in_options) = 0;
+
     //--------------------------------------------
     // Call EndFrame() last, paired with each BeginFrame() and after all draw commands
     // returns two command lists:
@@ -224,4 +492,26 @@ struct TileUpdateManager
     virtual UINT GetTotalNumEvictions() const = 0; // number of tiles evicted so far
     virtual float GetTotalTileCopyLatency() const = 0; // very approximate average latency of tile upload from request to completion
     virtual UINT GetTotalNumSubmits() const = 0;   // number of fence signals for uploads. when using DS, equals number of calls to IDStorageQueue::Submit()
+    virtual UINT GetTotalNumLowTierUploads() const = 0;   // tiles loaded from the low quality tier due to backlog
+    virtual UINT GetTotalNumUpgrades() const = 0;         // low quality tiles later re-loaded at full quality
+    virtual UINT64 GetTotalLowTierBytesSaved() const = 0; // file bytes not read by loading low quality tiles. heap usage is the same for both tiers
+    virtual UINT64 GetTotalUpgradeBytes() const = 0;      // file bytes read to upgrade tiles to full quality
+    virtual FeedbackSchedulerStatistics GetFeedbackSchedulerStatistics() const = 0;
+
+    // call when the view changes abruptly, e.g. the camera jumps. the next frame is the start of the cut
+    // GetStatistics() reports how long it took until all tiles requested by feedback were resident
+    virtual void NotifyCameraCut() = 0;
+
+    // all of the above, and per-stage counts, in one lock-free snapshot. call from the thread that creates StreamingResources
+    // bandwidth should be computed from bytes read, tiles are compressed differently
+    virtual TileUpdateManagerStatistics GetStatistics() const = 0;
+
+    //--------------------------------------------
+    // event tracing: internal threads record stages, UpdateList ids, tile counts, and fence values
+    // each thread keeps only its most recent events, so tracing can stay enabled as a flight recorder
+    // WriteEventTrace() writes Chrome trace event JSON (chrome://tracing, ui.perfetto.dev). call any time
+    // returns false if the file could not be written, or if the library was built with EVENT_TRACING 0
+    //--------------------------------------------
+    virtual void SetEventTracing(bool in_enable) = 0;
+    virtual bool WriteEventTrace(const std::wstring& in_filename) = 0;
 };
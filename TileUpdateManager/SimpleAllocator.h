@@ -26,10 +26,12 @@
 
 #pragma once
 
-#include <d3d12.h>
 #include <vector>
+#include <atomic>
+#include <cstring>
+#include <algorithm>
 
-#include "Streaming.h"
+#include "DebugHelper.h"
 
 namespace Streaming
 {
@@ -142,3 +144,113 @@ namespace Streaming
         RingBuffer m_ringBuffer;
     };
 }
+
+//-----------------------------------------------------------------------------
+// allocates simply by increasing/decreasing an index into an array of available indices
+//-----------------------------------------------------------------------------
+inline Streaming::SimpleAllocator::SimpleAllocator(UINT in_maxNumElements) :
+    m_index(0), m_heap(in_maxNumElements)
+{
+    for (auto& i : m_heap)
+    {
+        i = m_index;
+        m_index++;
+    }
+}
+
+inline Streaming::SimpleAllocator::~SimpleAllocator()
+{
+#ifdef _DEBUG
+    ASSERT(m_index == (UINT)m_heap.size());
+    // verify all indices accounted for and unique
+    std::sort(m_heap.begin(), m_heap.end());
+    for (UINT i = 0; i < (UINT)m_heap.size(); i++)
+    {
+        ASSERT(i == m_heap[i]);
+    }
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// like above, but expects caller to have checked availability first and provided a safe destination
+//-----------------------------------------------------------------------------
+inline void Streaming::SimpleAllocator::Allocate(UINT* out_pIndices, UINT in_numIndices)
+{
+    ASSERT(m_index >= in_numIndices);
+    m_index -= in_numIndices;
+    memcpy(out_pIndices, &m_heap[m_index], in_numIndices * sizeof(UINT));
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+inline void Streaming::SimpleAllocator::Free(const UINT* in_pIndices, UINT in_numIndices)
+{
+    ASSERT(in_numIndices);
+    ASSERT((m_index + in_numIndices) <= (UINT)m_heap.size());
+    memcpy(&m_heap[m_index], in_pIndices, sizeof(UINT) * in_numIndices);
+    m_index += in_numIndices;
+}
+
+//-----------------------------------------------------------------------------
+// uses a lockless ringbuffer so allocate can be on a different thread than free
+//-----------------------------------------------------------------------------
+inline Streaming::AllocatorMT::AllocatorMT(UINT in_numElements) :
+    m_ringBuffer(in_numElements), m_indices(in_numElements)
+{
+    for (UINT i = 0; i < in_numElements; i++)
+    {
+        m_indices[i] = i;
+    }
+}
+
+inline Streaming::AllocatorMT::~AllocatorMT()
+{
+#ifdef _DEBUG
+    ASSERT(0 == GetAllocated());
+    // verify all indices accounted for and unique
+    std::sort(m_indices.begin(), m_indices.end());
+    for (UINT i = 0; i < (UINT)m_indices.size(); i++)
+    {
+        ASSERT(i == m_indices[i]);
+    }
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// multi-threaded allocator (single allocator, single releaser)
+//-----------------------------------------------------------------------------
+inline void Streaming::AllocatorMT::Allocate(UINT* out_pIndices, UINT in_numIndices)
+{
+    ASSERT(m_ringBuffer.GetAvailableToWrite() >= in_numIndices);
+    UINT baseIndex = m_ringBuffer.GetWriteIndex();
+    memcpy(out_pIndices, &m_indices[baseIndex], in_numIndices * sizeof(UINT));
+    m_ringBuffer.Allocate(in_numIndices);
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+inline void Streaming::AllocatorMT::Free(const UINT* in_pIndices, UINT in_numIndices)
+{
+    UINT baseIndex = m_ringBuffer.GetReadIndex();
+    memcpy(&m_indices[baseIndex], in_pIndices, in_numIndices * sizeof(UINT));
+    m_ringBuffer.Free(in_numIndices);
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+inline UINT Streaming::AllocatorMT::Allocate()
+{
+    UINT baseIndex = m_ringBuffer.GetWriteIndex();
+    UINT i = m_indices[baseIndex];
+    m_ringBuffer.Allocate();
+    return i;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+inline void Streaming::AllocatorMT::Free(UINT i)
+{
+    UINT baseIndex = m_ringBuffer.GetReadIndex();
+    m_indices[baseIndex] = i;
+    m_ringBuffer.Free();
+}
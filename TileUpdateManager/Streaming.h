@@ -29,10 +29,9 @@
 #include <d3d12.h>
 #include <wrl.h>
 #include <vector>
-#include <synchapi.h>
-#pragma comment(lib, "Synchronization.lib")
 
 #include "DebugHelper.h"
+#include "SynchronizationFlag.h"
 
 namespace Streaming
 {
@@ -102,29 +101,6 @@ namespace Streaming
         static std::align_val_t constexpr m_alignment{ ALIGNMENT };
     };
 
-    //==================================================
-    // a single thread may wait on this flag, which may be set by any number of threads
-    //==================================================
-    class SynchronizationFlag
-    {
-    public:
-        void Set()
-        { 
-            m_flag = true;
-            WakeByAddressSingle(&m_flag);
-        }
-
-        void Wait()
-        {
-            // note: msdn recommends verifying that the value really changed, but we're not.
-            bool undesiredValue = false;
-            WaitOnAddress(&m_flag, &undesiredValue, sizeof(bool), INFINITE);
-            m_flag = false;
-        };
-    private:
-        bool m_flag{ false };
-    };
-
     inline void SetThreadPriority(std::thread& in_thread, int in_priority)
     {
         if (in_priority) // 0 = default (do nothing). -1 = efficiency. otherwise, performance.
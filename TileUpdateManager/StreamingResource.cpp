@@ -112,3 +112,94 @@ UINT Streaming::StreamingResourceBase::GetNumTilesVirtual() const
 {
     return m_resources->GetNumTilesVirtual();
 }
+
+//-----------------------------------------------------------------------------
+// values are published separately, and may be from consecutive updates
+//-----------------------------------------------------------------------------
+StreamingQuality Streaming::StreamingResourceBase::GetQuality() const
+{
+    StreamingQuality quality;
+    quality.m_numTilesWanted = m_numTilesWanted;
+    quality.m_numTilesWantedResident = m_numTilesWantedResident;
+    quality.m_mipDeficit = m_mipDeficit;
+    return quality;
+}
+
+//-----------------------------------------------------------------------------
+// applied by the ProcessFeedback thread, on the next feedback or eviction of this resource
+//-----------------------------------------------------------------------------
+void Streaming::StreamingResourceBase::SetQoS(const StreamingQoS& in_qos)
+{
+    std::lock_guard<std::mutex> lock(m_qosMutex);
+    m_qos = in_qos;
+    m_qosChanged = true;
+}
+
+StreamingQoS Streaming::StreamingResourceBase::GetQoS() const
+{
+    std::lock_guard<std::mutex> lock(m_qosMutex);
+    return m_qos;
+}
+
+//-----------------------------------------------------------------------------
+// region is in mip 0 tiles (the dimensions of the min mip map)
+//-----------------------------------------------------------------------------
+void Streaming::StreamingResourceBase::PinRegion(UINT in_x, UINT in_y, UINT in_width, UINT in_height, UINT in_mip)
+{
+    std::lock_guard<std::mutex> lock(m_qosMutex);
+    m_pinRequests.push_back({ in_x, in_y, in_width, in_height, (UINT8)std::min(in_mip, 255u) });
+    m_qosChanged = true;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+PrefetchHandle Streaming::StreamingResourceBase::Prefetch(float in_u0, float in_v0, float in_u1, float in_v1, UINT in_mip, const PrefetchOptions& in_options)
+{
+    PrefetchRequest request;
+    request.m_pResource = this;
+    request.m_u0 = in_u0;
+    request.m_v0 = in_v0;
+    request.m_u1 = in_u1;
+    request.m_v1 = in_v1;
+    request.m_mip = in_mip;
+    return m_pTileUpdateManager->Prefetch(&request, 1, in_options);
+}
+
+//-----------------------------------------------------------------------------
+// covers every region the rectangle touches, at least 1
+//-----------------------------------------------------------------------------
+void Streaming::StreamingResourceBase::AddPrefetch(std::shared_ptr<PrefetchBatch> in_pBatch, const PrefetchRequest& in_request)
+{
+    auto toRegions = [](float in_a, float in_b, UINT in_numRegions, UINT& out_start, UINT& out_size)
+    {
+        const float lo = std::clamp(std::min(in_a, in_b), 0.f, 1.f) * float(in_numRegions);
+        const float hi = std::clamp(std::max(in_a, in_b), 0.f, 1.f) * float(in_numRegions);
+        out_start = std::min(UINT(lo), in_numRegions - 1);
+        out_size = std::max(UINT(std::ceil(hi)), out_start + 1) - out_start;
+    };
+
+    Prefetch prefetch{ std::move(in_pBatch) };
+    toRegions(in_request.m_u0, in_request.m_u1, GetNumTilesWidth(), prefetch.m_x, prefetch.m_width);
+    toRegions(in_request.m_v0, in_request.m_v1, GetNumTilesHeight(), prefetch.m_y, prefetch.m_height);
+    prefetch.m_mip = (UINT8)std::min(in_request.m_mip, (UINT)m_maxMip);
+    prefetch.m_complete = false;
+
+    std::lock_guard<std::mutex> lock(m_qosMutex);
+    m_prefetchRequests.push_back(std::move(prefetch));
+    m_qosChanged = true;
+}
+
+void Streaming::StreamingResourceBase::AddPrefetch(std::shared_ptr<PrefetchBatch> in_pBatch, std::vector<UINT8> in_mips)
+{
+    ASSERT(in_mips.size() == m_tileReferences.size());
+    for (auto& m : in_mips)
+    {
+        m = std::min(m, m_maxMip);
+    }
+
+    Prefetch prefetch{ std::move(in_pBatch), 0, 0, GetNumTilesWidth(), GetNumTilesHeight(), m_maxMip, false, std::move(in_mips) };
+
+    std::lock_guard<std::mutex> lock(m_qosMutex);
+    m_prefetchRequests.push_back(std::move(prefetch));
+    m_qosChanged = true;
+}
@@ -37,16 +37,37 @@
 /*-----------------------------------------------------------------------------
 * Rules regarding order of operations:
 *
-* 1. A tile cannot be evicted (DecTileRef tries to set refcount = 0) if resident = 0 because a copy is pending
-* 2. A tile cannot be loaded (AddTileRef tries to set refcount = 1) if resident = 1 because an eviction is pending
+* 1. A tile cannot be evicted (SetMinMip tries to set refcount = 0) if resident = 0 because a copy is pending
+* 2. A tile cannot be loaded (SetMinMip tries to set refcount = 1) if resident = 1 because an eviction is pending
 //---------------------------------------------------------------------------*/
 
+//-----------------------------------------------------------------------------
+// parse the file, read the packed mips, and create the reserved and feedback resources
+// does not touch TileUpdateManager state, so may run on any thread
+//-----------------------------------------------------------------------------
+Streaming::StreamingResourceFile::StreamingResourceFile(const std::wstring& in_filename,
+    ID3D12Device8* in_pDevice, UINT in_numSwapBuffers) :
+    m_filename(in_filename)
+    , m_textureFileInfo(in_filename)
+{
+    m_resources = std::make_unique<Streaming::InternalResources>(in_pDevice, m_textureFileInfo, in_numSwapBuffers);
+
+    UINT numBytes = 0;
+    UINT offset = m_textureFileInfo.GetPackedMipFileOffset(&numBytes, &m_packedMipsUncompressedSize);
+    m_packedMips.resize(numBytes);
+    std::ifstream inFile(m_filename.c_str(), std::ios::binary);
+    inFile.seekg(offset);
+    inFile.read((char*)m_packedMips.data(), numBytes);
+    inFile.close();
+}
+
 //=============================================================================
 // data structure to manage reserved resource
 //=============================================================================
 Streaming::StreamingResourceBase::StreamingResourceBase(
+    // parsed file and internal resources
+    std::unique_ptr<StreamingResourceFile> in_pFile,
     // method that will fill a tile-worth of bits, for streaming
-    const std::wstring& in_filename,
     Streaming::FileHandle* in_pFileHandle,
     // share upload buffers with other InternalResources
     Streaming::TileUpdateManagerSR* in_pTileUpdateManager,
@@ -59,10 +80,14 @@ Streaming::StreamingResourceBase::StreamingResourceBase(
     , m_pendingEvictions(in_pTileUpdateManager->GetNumSwapBuffers() + 1)
     , m_pHeap(in_pHeap)
     , m_pFileHandle(in_pFileHandle)
-    , m_filename(in_filename)
-    , m_textureFileInfo(in_filename)
+    , m_pFile(std::move(in_pFile))
+    , m_filename(m_pFile->m_filename)
+    , m_textureFileInfo(m_pFile->m_textureFileInfo)
 {
-    m_resources = std::make_unique<Streaming::InternalResources>(in_pTileUpdateManager->GetDevice(), m_textureFileInfo, (UINT)m_queuedFeedback.size());
+    m_resources = std::move(m_pFile->m_resources);
+    m_packedMipsUncompressedSize = m_pFile->m_packedMipsUncompressedSize;
+    m_packedMips.swap(m_pFile->m_packedMips);
+
     m_tileMappingState.Init(m_resources->GetPackedMipInfo().NumStandardMips, m_resources->GetTiling());
 
     // no packed mips. odd, but possible. no need to check/update this variable again.
@@ -83,11 +108,19 @@ Streaming::StreamingResourceBase::StreamingResourceBase(
     m_tileReferences.resize(m_tileReferencesWidth * m_tileReferencesHeight, m_maxMip);
     m_minMipMap.resize(m_tileReferences.size(), m_maxMip);
 
+    // no feedback yet, nothing pinned or guaranteed
+    m_feedbackMips.resize(m_tileReferences.size(), m_maxMip);
+    m_pinnedMips.resize(m_tileReferences.size(), m_maxMip);
+    m_floorMips.resize(m_tileReferences.size(), m_maxMip);
+
+    // tiles shared with other textures are read from a separate file
+    if (m_textureFileInfo.GetStoreFileName().size())
+    {
+        m_pStoreFileHandle.reset(in_pTileUpdateManager->OpenFile(m_textureFileInfo.GetStoreFileName()));
+    }
+
     // make sure my heap has an atlas corresponding to my format
     m_pHeap->AllocateAtlas(in_pTileUpdateManager->GetMappingQueue(), m_textureFileInfo.GetFormat());
-
-    // Load packed mips. packed mips are not streamed or evicted.
-    LoadPackedMips();
 }
 
 //-----------------------------------------------------------------------------
@@ -113,6 +146,11 @@ Streaming::StreamingResourceBase::~StreamingResourceBase()
 
     m_pendingEvictions.Clear();
     m_pendingTileLoads.clear();
+    m_pendingUpgrades.clear();
+
+    // prefetches that can no longer complete
+    for (auto& p : m_prefetchRequests) { p.m_pBatch->m_expired = true; }
+    for (auto& p : m_prefetches) { if (!p.m_complete) { p.m_pBatch->m_expired = true; } }
 
     // tell TileUpdateManager to stop tracking
     m_pTileUpdateManager->Remove(this);
@@ -132,106 +170,113 @@ void Streaming::StreamingResourceBase::SetResidencyMapOffsetBase(UINT in_residen
 }
 
 //-----------------------------------------------------------------------------
-// Upload or Evict tiles to match the incoming requested minimum mip
-// if fails to adjust tile reference, then sets out_needRetry = true. Unchanged otherwise.
+// compare what feedback requested with what is resident:
+// wanted: what the latest feedback asks for, limited by m_finestMip. not refcounts, which also keep
+//     guaranteed, pinned, and prefetched tiles that the current view may not need
+// tiles: a tile is wanted if some region it covers requests its mip or finer
+// regions: the min mip map is what the shader samples. a region that wants mip m but has mip r > m is (r - m) mips short
+//     weighted by the texels it requested, so a region that wants mip 0 counts 4x a region that wants mip 1
+// the min mip map is written by the residency thread, and may lag refcounts by a frame: that reads as a deficit, never a false convergence
 //-----------------------------------------------------------------------------
-void Streaming::StreamingResourceBase::SetMinMip(UINT8 in_current, UINT in_x, UINT in_y, UINT in_s)
+const Streaming::StreamingResourceBase::QualitySums& Streaming::StreamingResourceBase::UpdateQuality()
 {
-    // what mip level is currently referenced at this tile?
-    UINT8 s = in_current;
+    if (!m_qualityChanged.exchange(false)) { return m_qualitySums; }
 
-    // addref mips we want
-    // AddRef()s are ordered from bottom mip to top (all dependencies will be loaded first)
-    while (s > in_s)
-    {
-        s -= 1; // already have "this" tile. e.g. have s == 1, desired in_s == 0, start with 0.
-        AddTileRef(in_x >> s, in_y >> s, s);
-    }
+    // 16k x 16k has 15 mips. the weight of the finest request in the largest texture still fits comfortably
+    constexpr UINT MAX_MIPS = 16;
+
+    const UINT width = GetNumTilesWidth();
+    const UINT height = GetNumTilesHeight();
 
-    // decref mips we don't need
-    // DecRef()s are ordered from top mip to bottom (evict lower resolution tiles after all higher resolution ones)
-    while (s < in_s)
+    // starts as the request per region. after visiting mip s, reduced to the finest request over each tile of mip s + 1
+    m_qualityMips.resize(m_feedbackMips.size());
+    for (size_t i = 0; i < m_feedbackMips.size(); i++)
     {
-        DecTileRef(in_x >> s, in_y >> s, s);
-        s++;
+        m_qualityMips[i] = std::max(m_finestMip, m_feedbackMips[i]);
     }
-}
 
-//-----------------------------------------------------------------------------
-// add to refcount for a tile
-// if first time, add tile to list of pending loads
-//-----------------------------------------------------------------------------
-void Streaming::StreamingResourceBase::AddTileRef(UINT in_x, UINT in_y, UINT in_s)
-{
-    auto& refCount = m_tileMappingState.GetRefCount(in_x, in_y, in_s);
-
-    // if refcount is 0xffff... then adding to it will wrap around. shouldn't happen.
-    ASSERT(~refCount);
+    QualitySums sums;
 
-    // need to allocate?
-    if (0 == refCount)
+    UINT layerWidth = width;
+    UINT layerHeight = height;
+    for (UINT s = 0; s < m_maxMip; s++)
     {
-        m_pendingTileLoads.push_back(D3D12_TILED_RESOURCE_COORDINATE{ in_x, in_y, 0, in_s });
+        const UINT numTilesWidth = std::min(layerWidth, m_tileMappingState.GetWidth(s));
+        const UINT numTilesHeight = std::min(layerHeight, m_tileMappingState.GetHeight(s));
+        for (UINT y = 0; y < numTilesHeight; y++)
+        {
+            for (UINT x = 0; x < numTilesWidth; x++)
+            {
+                if (m_qualityMips[y * width + x] <= s)
+                {
+                    sums.m_numTilesWanted++;
+                    if (TileMappingState::IsResident(m_tileMappingState.GetResidency(x, y, s)))
+                    {
+                        sums.m_numTilesWantedResident++;
+                    }
+                }
+            }
+        }
+
+        // tile (x, y) of mip s + 1 covers tiles (2x, 2y) to (2x + 1, 2y + 1) of mip s
+        // in place: each write is to an element that has already been read
+        const UINT nextWidth = (layerWidth + 1) / 2;
+        const UINT nextHeight = (layerHeight + 1) / 2;
+        for (UINT y = 0; y < nextHeight; y++)
+        {
+            const UINT8* pRow0 = &m_qualityMips[(2 * y) * width];
+            const UINT8* pRow1 = ((2 * y + 1) < layerHeight) ? pRow0 + width : pRow0;
+            for (UINT x = 0; x < nextWidth; x++)
+            {
+                const UINT x1 = std::min(2 * x + 1, layerWidth - 1);
+                m_qualityMips[y * width + x] = std::min(
+                    std::min(pRow0[2 * x], pRow0[x1]),
+                    std::min(pRow1[2 * x], pRow1[x1]));
+            }
+        }
+        layerWidth = nextWidth;
+        layerHeight = nextHeight;
     }
-    refCount++;
-}
 
-//-----------------------------------------------------------------------------
-// reduce ref count
-// if 0, add tile to list of pending evictions
-//-----------------------------------------------------------------------------
-void Streaming::StreamingResourceBase::DecTileRef(UINT in_x, UINT in_y, UINT in_s)
-{
-    auto& refCount = m_tileMappingState.GetRefCount(in_x, in_y, in_s);
+    for (size_t i = 0; i < m_feedbackMips.size(); i++)
+    {
+        const UINT8 requested = std::max(m_finestMip, m_feedbackMips[i]);
+        if (requested >= m_maxMip) { continue; } // packed mips are always resident
 
-    ASSERT(0 != refCount);
+        const UINT64 weight = UINT64(1) << (2 * (MAX_MIPS - requested));
+        sums.m_texelWeight += weight;
 
-    // last refrence? try to evict
-    if (1 == refCount)
-    {
-        // queue up a decmapping request that will release the heap index after mapping and clear the resident flag
-        m_pendingEvictions.Append(D3D12_TILED_RESOURCE_COORDINATE{ in_x, in_y, 0, in_s });
+        const UINT8 resident = m_minMipMap[i];
+        if (resident > requested)
+        {
+            sums.m_mipDeficit += weight * (resident - requested);
+        }
     }
-    refCount--;
+
+    m_qualitySums = sums;
+    m_numTilesWanted = sums.m_numTilesWanted;
+    m_numTilesWantedResident = sums.m_numTilesWantedResident;
+    m_mipDeficit = sums.m_texelWeight ? float(double(sums.m_mipDeficit) / double(sums.m_texelWeight)) : 0.f;
+
+    return m_qualitySums;
 }
 
 //-----------------------------------------------------------------------------
-// initialize data structure afther creating the reserved resource and querying its tiling properties
+// Upload or Evict tiles to match the incoming requested minimum mip
+// tiles referenced for the first time become pending loads, tiles no longer referenced become pending evictions
 //-----------------------------------------------------------------------------
-void Streaming::StreamingResourceBase::TileMappingState::Init(UINT in_numMips, const D3D12_SUBRESOURCE_TILING* in_pTiling)
+void Streaming::StreamingResourceBase::SetMinMip(UINT8 in_current, UINT in_x, UINT in_y, UINT in_s)
 {
-    ASSERT(in_numMips);
-    m_refcounts.resize(in_numMips);
-    m_heapIndices.resize(in_numMips);
-    m_resident.resize(in_numMips);
-
-    for (UINT mip = 0; mip < in_numMips; mip++)
-    {
-        UINT width = in_pTiling[mip].WidthInTiles;
-        UINT height = in_pTiling[mip].HeightInTiles;
-        m_refcounts[mip].resize(height);
-        m_heapIndices[mip].resize(height);
-        m_resident[mip].resize(height);
-
-        for (auto& row : m_refcounts[mip])
-        {
-            row.assign(width, 0);
-        }
-        for (auto& row : m_heapIndices[mip])
-        {
-            row.assign(width, TileMappingState::InvalidIndex);
-        }
-        for (auto& row : m_resident[mip])
-        {
-            row.assign(width, 0);
-        }
-    }
+    m_tileMappingState.SetMinMip(in_current, in_x, in_y, in_s,
+        [&](UINT x, UINT y, UINT s) { m_pendingTileLoads.push_back(D3D12_TILED_RESOURCE_COORDINATE{ x, y, 0, s }); },
+        // queue up a decmapping request that will release the heap index after mapping and clear the resident flag
+        [&](UINT x, UINT y, UINT s) { m_pendingEvictions.Append(D3D12_TILED_RESOURCE_COORDINATE{ x, y, 0, s }); });
 }
 
 //-----------------------------------------------------------------------------
 // remove all allocations from the (shared) heap
 //-----------------------------------------------------------------------------
-void Streaming::StreamingResourceBase::TileMappingState::FreeHeapAllocations(Streaming::Heap* in_pHeap)
+void Streaming::TileMappingState::FreeHeapAllocations(Streaming::Heap* in_pHeap)
 {
     for (auto& layer : m_heapIndices)
     {
@@ -249,48 +294,6 @@ void Streaming::StreamingResourceBase::TileMappingState::FreeHeapAllocations(Str
     }
 }
 
-//-----------------------------------------------------------------------------
-// search bottom layer. if refcount of any is positive, there is something resident.
-//-----------------------------------------------------------------------------
-bool Streaming::StreamingResourceBase::TileMappingState::GetAnyRefCount()
-{
-    auto& lastMip = m_refcounts.back();
-    for (const auto& y : lastMip)
-    {
-        for (const auto& x : y)
-        {
-            if (x)
-            {
-                return true;
-            }
-        }
-    }
-    return false;
-}
-
-//-----------------------------------------------------------------------------
-// optimization for UpdateMinMipMap:
-// return true if all bottom layer standard tiles are resident
-// FIXME? currently just checks the lowest tracked mip.
-//-----------------------------------------------------------------------------
-UINT8 Streaming::StreamingResourceBase::TileMappingState::GetMinResidentMip()
-{
-    UINT8 minResidentMip = (UINT8)m_resident.size();
-
-    auto& lastMip = m_resident.back();
-    for (const auto& y : lastMip)
-    {
-        for (const auto& x : y)
-        {
-            if (TileMappingState::Residency::Resident != x)
-            {
-                return minResidentMip;
-            }
-        }
-    }
-    return minResidentMip - 1;
-}
-
 //-----------------------------------------------------------------------------
 // if the residency changes, must also notify TUM
 //-----------------------------------------------------------------------------
@@ -317,13 +320,18 @@ void Streaming::StreamingResourceBase::ProcessFeedback(UINT64 in_frameFenceCompl
     const UINT width = GetNumTilesWidth();
     const UINT height = GetNumTilesHeight();
 
+    // new QoS applies to the latest feedback, even if there is no new feedback
+    const bool qosChanged = UpdateQoS();
+
+    bool evict = false;
     if (m_setZeroRefCounts)
     {
         m_setZeroRefCounts = false;
 
         // has this resource already been zeroed? don't clear again, early exit
         // this is set to false if "changed" due to feedback below
-        if (m_refCountsZero)
+        // unless QoS changed which tiles are kept
+        if (m_refCountsZero && !qosChanged)
         {
             return;
         }
@@ -334,7 +342,26 @@ void Streaming::StreamingResourceBase::ProcessFeedback(UINT64 in_frameFenceCompl
         {
             f.m_feedbackQueued = false;
         }
+        memset(m_feedbackMips.data(), m_maxMip, m_feedbackMips.size());
+        m_qualityChanged = true;
+        evict = true;
+    }
 
+    // guaranteed and pinned tiles stay resident: evict as if feedback wanted nothing
+    if (evict && m_haveFloor)
+    {
+        const UINT numPendingLoads = (UINT)m_pendingTileLoads.size();
+        changed = ApplyFeedbackMips();
+        if (changed)
+        {
+            const UINT numRequested = (UINT)m_pendingTileLoads.size() - numPendingLoads;
+            const UINT numAbandoned = AbandonPendingLoads();
+            m_pTileUpdateManager->AddPendingLoadStatistics(numRequested, numAbandoned, 0);
+            m_pendingEvictions.Rescue(m_tileMappingState);
+        }
+    }
+    else if (evict)
+    {
         // since we're evicting everything, don't need to loop over the reference count structure
         // just set it all to max mip, then schedule eviction any tiles that have refcounts
 
@@ -368,18 +395,20 @@ void Streaming::StreamingResourceBase::ProcessFeedback(UINT64 in_frameFenceCompl
         }
 
         // abandon all pending loads - all refcounts are 0
+        m_pTileUpdateManager->AddPendingLoadStatistics(0, (UINT)m_pendingTileLoads.size(), 0);
         m_pendingTileLoads.clear();
+        AbandonPendingUpgrades();
     }
     else
     {
         UINT feedbackIndex = 0;
+        bool feedbackFound = false;
 
         //------------------------------------------------------------------
         // determine if there is feedback to process
         // if there is more than one feedback ready to process (unlikely), only use the most recent one
         //------------------------------------------------------------------
         {
-            bool feedbackFound = false;
             UINT64 latestFeedbackFenceValue = 0;
             for (UINT i = 0; i < (UINT)m_queuedFeedback.size(); i++)
             {
@@ -399,8 +428,8 @@ void Streaming::StreamingResourceBase::ProcessFeedback(UINT64 in_frameFenceCompl
                 }
             }
 
-            // no new feedback?
-            if (!feedbackFound)
+            // no new feedback? re-apply the previous feedback if QoS changed
+            if ((!feedbackFound) && (!qosChanged))
             {
                 return;
             }
@@ -409,60 +438,260 @@ void Streaming::StreamingResourceBase::ProcessFeedback(UINT64 in_frameFenceCompl
         //------------------------------------------------------------------
         // update the refcount of each tile based on feedback
         //------------------------------------------------------------------
+        const UINT numPendingLoads = (UINT)m_pendingTileLoads.size();
+        if (feedbackFound)
         {
-            // mapped host feedback buffer
-            UINT8* pResolvedData = (UINT8*)m_resources->MapResolvedReadback(feedbackIndex);
+            // mapped host feedback buffer, or feedback provided by the application
+            const bool cpuFeedback = m_queuedFeedback[feedbackIndex].m_cpuFeedback;
+            const UINT8* pResolvedData = cpuFeedback ? m_queuedFeedback[feedbackIndex].m_cpuMinMips.data() :
+                (UINT8*)m_resources->MapResolvedReadback(feedbackIndex);
 
-            TileReference* pTileRow = m_tileReferences.data();
+            TileReference* pFeedbackRow = m_feedbackMips.data();
             for (UINT y = 0; y < height; y++)
             {
                 for (UINT x = 0; x < width; x++)
                 {
                     // clamp to the maximum we are tracking (not tracking packed mips)
-                    UINT8 desired = std::min(pResolvedData[x], m_maxMip);
-                    UINT8 initialValue = pTileRow[x];
-                    if (desired != initialValue) { changed = true; }
-                    SetMinMip(initialValue, x, y, desired);
-                    pTileRow[x] = desired;
+                    pFeedbackRow[x] = std::min(pResolvedData[x], m_maxMip);
                 } // end loop over x
-                pTileRow += width;
+                pFeedbackRow += width;
 
 #if RESOLVE_TO_TEXTURE
-                pResolvedData += (width + 0x0ff) & ~0x0ff;
+                pResolvedData += cpuFeedback ? width : (width + 0x0ff) & ~0x0ff;
 #else
                 pResolvedData += width;
 #endif
 
             } // end loop over y
-            m_resources->UnmapResolvedReadback(feedbackIndex);
+            if (!cpuFeedback)
+            {
+                m_resources->UnmapResolvedReadback(feedbackIndex);
+            }
+
+            // quality is measured against feedback, which may change without changing refcounts (e.g. within a pinned region)
+            m_qualityChanged = true;
         }
+        changed = ApplyFeedbackMips();
 
         // if there was a change, then it's no longer "zeroed"
-        if (changed)
+        // a QoS change alone does not: after QueueEviction() the feedback is still empty
+        if (changed && feedbackFound)
         {
             m_refCountsZero = false;
+            m_numFeedbackChanged++;
         }
+        if (feedbackFound) { m_numFeedbackProcessed++; }
 
-        // abandon pending loads that are no longer relevant
-        AbandonPendingLoads();
+        // new pending loads, and pending loads that are no longer relevant
+        const UINT numRequested = (UINT)m_pendingTileLoads.size() - numPendingLoads;
+        const UINT numAbandoned = AbandonPendingLoads();
+        if (numRequested || numAbandoned)
+        {
+            m_pTileUpdateManager->AddPendingLoadStatistics(numRequested, numAbandoned, 0);
+        }
 
         // clear pending evictions that are no longer relevant
         m_pendingEvictions.Rescue(m_tileMappingState);
     }
 
+    // tiles of a restored snapshot: read each mip in file order
+    // coarser mips first, as SetMinMip() queues them: the min mip map can't improve until they are resident,
+    // and finer tiles loaded first could fill the heap under a prefetch floor that never releases them
+    if (m_sortPendingLoads)
+    {
+        m_sortPendingLoads = false;
+        std::sort(m_pendingTileLoads.begin(), m_pendingTileLoads.end(),
+            [&](const D3D12_TILED_RESOURCE_COORDINATE& a, const D3D12_TILED_RESOURCE_COORDINATE& b)
+            {
+                if (a.Subresource != b.Subresource) { return a.Subresource > b.Subresource; }
+                const auto fa = m_textureFileInfo.GetFileOffset(a);
+                const auto fb = m_textureFileInfo.GetFileOffset(b);
+                return (fa.inStore != fb.inStore) ? fb.inStore : (fa.offset < fb.offset);
+            });
+    }
+
     // update min mip map to adjust to new references
     // required so the eviction timeout is relative to the current expected mapping
     if (changed)
     {
+        // refcounts are current now. the min mip map catches up on the residency thread
+        m_qualityChanged = true;
         SetResidencyChanged();
     }
 }
 
+//-----------------------------------------------------------------------------
+// copy the application's QoS requests and prefetches, and rebuild the per-region floor
+// returns true if something changed, so the latest feedback must be re-applied
+//-----------------------------------------------------------------------------
+bool Streaming::StreamingResourceBase::UpdateQoS()
+{
+    const UINT width = GetNumTilesWidth();
+    const UINT height = GetNumTilesHeight();
+
+    bool changed = false;
+    if (m_qosChanged.exchange(false))
+    {
+        changed = true;
+
+        std::lock_guard<std::mutex> lock(m_qosMutex);
+        m_qosPriority = m_qos.m_priority;
+        m_finestMip = (UINT8)std::min(m_qos.m_finestMip, (UINT)m_maxMip);
+        m_guaranteedMip = (UINT8)std::min(m_qos.m_guaranteedMip, (UINT)m_maxMip);
+
+        for (const auto& pin : m_pinRequests)
+        {
+            if ((pin.m_x >= width) || (pin.m_y >= height)) { continue; }
+            // clamp the size, not the sum: e.g. a width of UINT_MAX means "to the edge"
+            const UINT right = pin.m_x + std::min(pin.m_width, width - pin.m_x);
+            const UINT bottom = pin.m_y + std::min(pin.m_height, height - pin.m_y);
+            for (UINT y = pin.m_y; y < bottom; y++)
+            {
+                memset(&m_pinnedMips[y * width + pin.m_x], pin.m_mip, right - pin.m_x);
+            }
+        }
+        m_pinRequests.clear();
+
+        for (auto& p : m_prefetchRequests)
+        {
+            if (p.m_mips.size()) { m_sortPendingLoads = true; }
+            m_prefetches.push_back(std::move(p));
+        }
+        m_prefetchRequests.clear();
+    }
+
+    // released or expired prefetches no longer keep tiles. others complete when resident
+    bool prefetchPending = false;
+    float prefetchPriority = 0;
+    for (UINT i = 0; i < (UINT)m_prefetches.size();)
+    {
+        auto& p = m_prefetches[i];
+        if (p.m_pBatch->m_released || p.m_pBatch->m_expired)
+        {
+            p = std::move(m_prefetches.back());
+            m_prefetches.pop_back();
+            changed = true;
+            continue;
+        }
+        if (!p.m_complete)
+        {
+            if (GetPrefetchResident(p))
+            {
+                p.m_complete = true;
+                p.m_pBatch->m_numPending.fetch_sub(1, std::memory_order_release);
+            }
+            else
+            {
+                prefetchPending = true;
+                prefetchPriority = std::max(prefetchPriority, p.m_pBatch->m_priority);
+            }
+        }
+        i++;
+    }
+
+    // prefetched tiles have their own priority, unless feedback also wants tiles
+    m_schedulingPriority = m_qosPriority;
+    if (prefetchPending)
+    {
+        m_schedulingPriority = m_refCountsZero ? prefetchPriority : std::max(m_qosPriority, prefetchPriority);
+    }
+
+    if (!changed) { return false; }
+
+    for (size_t i = 0; i < m_floorMips.size(); i++)
+    {
+        m_floorMips[i] = std::min(m_pinnedMips[i], m_guaranteedMip);
+    }
+    for (const auto& p : m_prefetches)
+    {
+        if (p.m_mips.size())
+        {
+            for (size_t i = 0; i < m_floorMips.size(); i++)
+            {
+                m_floorMips[i] = std::min(m_floorMips[i], p.m_mips[i]);
+            }
+            continue;
+        }
+        for (UINT y = p.m_y; y < p.m_y + p.m_height; y++)
+        {
+            TileReference* pFloor = &m_floorMips[y * width];
+            for (UINT x = p.m_x; x < p.m_x + p.m_width; x++)
+            {
+                pFloor[x] = std::min(pFloor[x], p.m_mip);
+            }
+        }
+    }
+
+    m_haveFloor = false;
+    for (auto f : m_floorMips)
+    {
+        if (f < m_maxMip) { m_haveFloor = true; break; }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// the min mip map, not the tile state, decides: that is what the GPU samples
+// mips finer than m_finestMip are never loaded, so a prefetch is complete once the clamped mip is resident
+//-----------------------------------------------------------------------------
+bool Streaming::StreamingResourceBase::GetPrefetchResident(const Prefetch& in_prefetch) const
+{
+    if (!GetPackedMipsResident()) { return false; }
+
+    if (in_prefetch.m_mips.size())
+    {
+        for (size_t i = 0; i < in_prefetch.m_mips.size(); i++)
+        {
+            if (m_minMipMap[i] > std::max(in_prefetch.m_mips[i], m_finestMip)) { return false; }
+        }
+        return true;
+    }
+
+    const UINT8 mip = std::max(in_prefetch.m_mip, m_finestMip);
+    const UINT width = GetNumTilesWidth();
+    for (UINT y = in_prefetch.m_y; y < in_prefetch.m_y + in_prefetch.m_height; y++)
+    {
+        const UINT8* pResident = &m_minMipMap[y * width];
+        for (UINT x = in_prefetch.m_x; x < in_prefetch.m_x + in_prefetch.m_width; x++)
+        {
+            if (pResident[x] > mip) { return false; }
+        }
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// each region wants what feedback asked for, at least its floor (pinned/guaranteed), and at most the finest allowed
+//-----------------------------------------------------------------------------
+bool Streaming::StreamingResourceBase::ApplyFeedbackMips()
+{
+    bool changed = false;
+    const UINT width = GetNumTilesWidth();
+    const UINT height = GetNumTilesHeight();
+
+    UINT i = 0;
+    for (UINT y = 0; y < height; y++)
+    {
+        for (UINT x = 0; x < width; x++, i++)
+        {
+            const UINT8 desired = std::max(m_finestMip, std::min(m_feedbackMips[i], m_floorMips[i]));
+            const UINT8 initialValue = m_tileReferences[i];
+            if (desired != initialValue) { changed = true; }
+            SetMinMip(initialValue, x, y, desired);
+            m_tileReferences[i] = desired;
+        }
+    }
+    return changed;
+}
+
 //-----------------------------------------------------------------------------
 // drop pending loads that are no longer relevant
+// returns # dropped
 //-----------------------------------------------------------------------------
-void Streaming::StreamingResourceBase::AbandonPendingLoads()
+UINT Streaming::StreamingResourceBase::AbandonPendingLoads()
 {
+    const UINT numInitial = (UINT)m_pendingTileLoads.size();
     UINT numPending = (UINT)m_pendingTileLoads.size();
     for (UINT i = 0; i < numPending;)
     {
@@ -481,6 +710,16 @@ void Streaming::StreamingResourceBase::AbandonPendingLoads()
         }
     }
     m_pendingTileLoads.resize(numPending);
+    return numInitial - numPending;
+}
+
+//-----------------------------------------------------------------------------
+// upgrades to full quality are only worth doing when there is no backlog
+//-----------------------------------------------------------------------------
+bool Streaming::StreamingResourceBase::IsStale()
+{
+    return (m_pendingTileLoads.size() || m_pendingEvictions.GetReadyToEvict().size() ||
+        (m_pendingUpgrades.size() && !m_pTileUpdateManager->GetUseLowTier()));
 }
 
 //-----------------------------------------------------------------------------
@@ -492,27 +731,37 @@ UINT Streaming::StreamingResourceBase::QueueTiles()
 {
     UINT uploadsRequested = 0;
 
+    UpdateList scratchUL;
+
     // pushes as many tiles as it can into a single UpdateList
     if (m_pendingTileLoads.size() && m_pHeap->GetAllocator().GetAvailable())
     {
-        UpdateList scratchUL;
+        // under backlog, load the cheaper encoding of tiles that have one
+        scratchUL.m_lowTier = m_textureFileInfo.GetHasLowTier() && m_pTileUpdateManager->GetUseLowTier();
 
         // queue as many new tiles as possible
         QueuePendingTileLoads(&scratchUL);
-        uploadsRequested = (UINT)scratchUL.m_coords.size(); // number of uploads in UpdateList
+    }
+    // replacing low quality tiles doesn't need heap space, but should not add to a backlog
+    else if (m_pendingUpgrades.size() && !m_pTileUpdateManager->GetUseLowTier())
+    {
+        QueuePendingTileUpgrades(&scratchUL);
+    }
 
-        // only allocate an UpdateList if we have updates
-        if (scratchUL.m_coords.size())
-        {
-            // calling function checked for availability, so UL allocation must succeed
-            UpdateList* pUpdateList = m_pTileUpdateManager->AllocateUpdateList(this);
-            ASSERT(pUpdateList);
+    uploadsRequested = (UINT)scratchUL.m_coords.size(); // number of uploads in UpdateList
 
-            pUpdateList->m_coords.swap(scratchUL.m_coords);
-            pUpdateList->m_heapIndices.swap(scratchUL.m_heapIndices);
+    // only allocate an UpdateList if we have updates
+    if (scratchUL.m_coords.size())
+    {
+        // calling function checked for availability, so UL allocation must succeed
+        UpdateList* pUpdateList = m_pTileUpdateManager->AllocateUpdateList(this);
+        ASSERT(pUpdateList);
 
-            m_pTileUpdateManager->SubmitUpdateList(*pUpdateList);
-        }
+        pUpdateList->m_coords.swap(scratchUL.m_coords);
+        pUpdateList->m_heapIndices.swap(scratchUL.m_heapIndices);
+        pUpdateList->m_lowTier = scratchUL.m_lowTier;
+
+        m_pTileUpdateManager->SubmitUpdateList(*pUpdateList);
     }
 
     return uploadsRequested;
@@ -535,6 +784,7 @@ The logic table for evictions:
         0     |  invalid   |    1     | drop (tile already has pending eviction)
         0     |   valid    |    0     | delay (tile has pending load, wait for it to complete)
         0     |   valid    |    1     | evict (tile is resident, so can be evicted)
+        0     |   valid    | upgrade  | delay (tile has pending upgrade copy into its heap index)
 
 The logic table for loads:
 
@@ -544,6 +794,7 @@ The logic table for loads:
         n     |  invalid   |    1     | delay (tile has pending eviction, wait for it to complete)
         n     |   valid    |    0     | drop (tile already has pending load)
         n     |   valid    |    1     | drop (tile already resident)
+        n     |   valid    | upgrade  | drop (tile already resident, full quality copy pending)
 
 Residency is set by the notification functions called by DataUploader (a separate thread)
 Allocating and freeing heap indices is handled respectively by the load and eviction routines below
@@ -586,6 +837,8 @@ UINT Streaming::StreamingResourceBase::QueuePendingTileEvictions()
             // to put it back: set residency to evicting and add tiles to updatelist for eviction
 
             m_tileMappingState.SetResidency(coord, TileMappingState::Residency::NotResident);
+            m_tileMappingState.SetLowTier(coord, false);
+            m_numTilesResident--;
             UINT& heapIndex = m_tileMappingState.GetHeapIndex(coord);
             m_pHeap->GetAllocator().Free(heapIndex);
             heapIndex = TileMappingState::InvalidIndex;
@@ -593,8 +846,9 @@ UINT Streaming::StreamingResourceBase::QueuePendingTileEvictions()
             numEvictions++;
         }
         // valid index but not resident means there is a pending load, do not evict
+        // an upgrade is also copying into the heap index
         // try again later
-        else if (TileMappingState::Residency::Loading == residency)
+        else if ((TileMappingState::Residency::Loading == residency) || (TileMappingState::Residency::Upgrading == residency))
         {
             pendingEvictions[numDelayed] = coord;
             numDelayed++;
@@ -629,6 +883,8 @@ void Streaming::StreamingResourceBase::QueuePendingTileLoads(Streaming::UpdateLi
 
     UINT skippedIndex = 0;
     UINT numConsumed = 0;
+    UINT numLowTier = 0;
+    UINT64 numBytesSaved = 0;
     for (auto& coord : m_pendingTileLoads)
     {
         numConsumed++;
@@ -650,6 +906,18 @@ void Streaming::StreamingResourceBase::QueuePendingTileLoads(Streaming::UpdateLi
             m_tileMappingState.SetResidency(coord, TileMappingState::Residency::Loading);
             m_tileMappingState.GetHeapIndex(coord) = heapIndex;
 
+            // remember low quality tiles so they can be upgraded later
+            bool lowTier = false;
+            XeTexture::FileOffset lowTierOffset;
+            if (out_pUpdateList->m_lowTier && m_textureFileInfo.GetLowTierFileOffset(coord, lowTierOffset))
+            {
+                lowTier = true;
+                numLowTier++;
+                numBytesSaved += m_textureFileInfo.GetFileOffset(coord).numBytes - lowTierOffset.numBytes;
+                m_pendingUpgrades.push_back(coord);
+            }
+            m_tileMappingState.SetLowTier(coord, lowTier);
+
             out_pUpdateList->m_coords.push_back(coord);
             out_pUpdateList->m_heapIndices.push_back(heapIndex);
 
@@ -677,6 +945,59 @@ void Streaming::StreamingResourceBase::QueuePendingTileLoads(Streaming::UpdateLi
     {
         m_pendingTileLoads.erase(m_pendingTileLoads.begin() + skippedIndex, m_pendingTileLoads.begin() + numConsumed);
     }
+
+    if (numLowTier)
+    {
+        m_pTileUpdateManager->AddLowTierUploads(numLowTier, numBytesSaved);
+    }
+
+    // consumed tiles that were neither queued nor skipped were already loading or resident
+    const UINT numRejected = numConsumed - (UINT)out_pUpdateList->m_coords.size() - skippedIndex;
+    if (numRejected)
+    {
+        m_pTileUpdateManager->AddPendingLoadStatistics(0, 0, numRejected);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// re-load low quality tiles at full quality into the heap indices they already occupy
+// the low quality data remains mapped (and sampled) until the copy completes
+//-----------------------------------------------------------------------------
+void Streaming::StreamingResourceBase::QueuePendingTileUpgrades(Streaming::UpdateList* out_pUpdateList)
+{
+    ASSERT(out_pUpdateList);
+
+    UINT64 numBytes = 0;
+    UINT numPending = 0;
+    for (const auto& coord : m_pendingUpgrades)
+    {
+        // drop tiles that were evicted (and possibly re-loaded) since their low quality load
+        // a tile with a pending eviction may still be upgraded: eviction waits for the copy
+        if (!m_tileMappingState.GetLowTier(coord)) { continue; }
+
+        auto residency = m_tileMappingState.GetResidency(coord);
+        if (TileMappingState::Residency::Resident == residency)
+        {
+            m_tileMappingState.SetResidency(coord, TileMappingState::Residency::Upgrading);
+            m_tileMappingState.SetLowTier(coord, false);
+
+            out_pUpdateList->m_coords.push_back(coord);
+            out_pUpdateList->m_heapIndices.push_back(m_tileMappingState.GetHeapIndex(coord));
+            numBytes += m_textureFileInfo.GetFileOffset(coord).numBytes;
+        }
+        // the low quality load is still in flight. try again later
+        else if (TileMappingState::Residency::Loading == residency)
+        {
+            m_pendingUpgrades[numPending] = coord;
+            numPending++;
+        }
+    }
+    m_pendingUpgrades.resize(numPending);
+
+    if (out_pUpdateList->m_coords.size())
+    {
+        m_pTileUpdateManager->AddUpgrades((UINT)out_pUpdateList->m_coords.size(), numBytes);
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -699,64 +1020,11 @@ void Streaming::StreamingResourceBase::UpdateMinMipMap()
     auto& outBuffer = m_pTileUpdateManager->GetResidencyMap();
     UINT8* pResidencyMap = m_residencyMapOffsetBase + (UINT8*)outBuffer.GetData();
 
-    if (m_tileMappingState.GetAnyRefCount())
-    {
-        const UINT width = GetNumTilesWidth();
-        const UINT height = GetNumTilesHeight();
+    m_tileMappingState.UpdateMinMipMap(m_minMipMap.data(), GetNumTilesWidth(), GetNumTilesHeight());
 
-#if 0
-        // FIXME? if the optimization below introduces artifacts, this might work:
-        const UINT8 minResidentMip = (UINT8)m_tileMappingState.GetNumSubresources();
-#else
-        // a simple optimization that's especially effective for large textures
-        // and harmless for smaller ones:
-        // find the minimum fully-resident mip
-        const UINT8 minResidentMip = m_tileMappingState.GetMinResidentMip();
-#endif
-        // Search bottom up for best mip
-        // tiles that have refcounts may still have pending copies, so we have to check residency (can't just memcpy m_tileReferences)
-        // note that tiles can load out of order, but the min mip map cannot have holes, so exit if any lower-res tile is absent
-        // for 16kx16k textures, that's 7-1 iterations maximum (maximum for bc7: 64*64*(7-1)=24576, bc1: 32*64*(6-1)=10240)
-        // in practice don't expect to hit the maximum, as the entire texture would have to be loaded
-        // FIXME? could probably optimize e.g. by vectorizing
-        UINT tileIndex = 0;
-        for (UINT y = 0; y < height; y++)
-        {
-            for (UINT x = 0; x < width; x++)
-            {
-                // mips >= maxmip are pre-loaded packed mips and not tracked
-                // leverage results from previous frame. in the static case, this should # iterations down to exactly # regions
-                UINT8 s = std::max(minResidentMip, m_minMipMap[tileIndex]);
-                UINT8 minMip = s;
-
-                // note: it's ok for a region of the min mip map to include a higher-resolution region than feedback required
-                // the min mip map will be updated on evictions, which will affect "this" region and the referencing region for the tile
-                while (s > 0)
-                {
-                    s--;
-                    if ((TileMappingState::Residency::Resident == m_tileMappingState.GetResidency(x >> s, y >> s, s)) &&
-                        // do not include a tile that may be evicted (resident with 0 refcount is candidate for eviction)
-                        (0 != m_tileMappingState.GetRefCount(x >> s, y >> s, s)))
-                    {
-                        minMip = s;
-                    }
-                    else
-                    {
-                        break;
-                    }
-                }
-                m_minMipMap[tileIndex] = minMip;
-                tileIndex++;
-            } // end y
-        } // end x
-    }
-    // if we know that only packed mips are resident, then write a basic residency map
-    // if refcount is 0, then tile state is either not resident or eviction pending
-    else
-    {
-        memset(m_minMipMap.data(), m_maxMip, m_minMipMap.size());
-    }
     memcpy(pResidencyMap, m_minMipMap.data(), m_minMipMap.size());
+
+    m_qualityChanged = true;
 }
 
 //=============================================================================
@@ -827,18 +1095,6 @@ void Streaming::StreamingResourceBase::EvictionDelay::Rescue(const Streaming::St
     }
 }
 
-//-----------------------------------------------------------------------------
-//-----------------------------------------------------------------------------
-void Streaming::StreamingResourceBase::LoadPackedMips()
-{
-    UINT numBytes = 0;
-    UINT offset = m_textureFileInfo.GetPackedMipFileOffset(&numBytes, &m_packedMipsUncompressedSize);
-    m_packedMips.resize(numBytes);
-    std::ifstream inFile(m_filename.c_str(), std::ios::binary);
-    inFile.seekg(offset);
-    inFile.read((char*)m_packedMips.data(), numBytes);
-    inFile.close();
-}
 
 //-----------------------------------------------------------------------------
 // called when creating/changing FileStreamer
@@ -846,6 +1102,10 @@ void Streaming::StreamingResourceBase::LoadPackedMips()
 void Streaming::StreamingResourceBase::SetFileHandle(const DataUploader* in_pDataUploader)
 {
     m_pFileHandle.reset(in_pDataUploader->OpenFile(m_filename));
+    if (m_textureFileInfo.GetStoreFileName().size())
+    {
+        m_pStoreFileHandle.reset(in_pDataUploader->OpenFile(m_textureFileInfo.GetStoreFileName()));
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -917,11 +1177,27 @@ void Streaming::StreamingResourceBase::ResolveFeedback(ID3D12GraphicsCommandList
     // remember that feedback was queued, and which frame it was queued in.
     auto& f = m_queuedFeedback[m_readbackIndex];
     f.m_renderFenceForFeedback = m_pTileUpdateManager->GetFrameFenceValue();
+    f.m_cpuFeedback = false;
     f.m_feedbackQueued = true;
 
     m_resources->ResolveFeedback(out_pCmdList, m_readbackIndex);
 }
 
+//-----------------------------------------------------------------------------
+// feedback from the application takes the same path as resolved feedback,
+// including waiting for the frame fence, so latency matches the GPU path
+//-----------------------------------------------------------------------------
+void Streaming::StreamingResourceBase::QueueCpuFeedback(const BYTE* in_pMinMips)
+{
+    m_readbackIndex = (m_readbackIndex + 1) % m_queuedFeedback.size();
+
+    auto& f = m_queuedFeedback[m_readbackIndex];
+    f.m_cpuMinMips.assign(in_pMinMips, in_pMinMips + (GetNumTilesWidth() * GetNumTilesHeight()));
+    f.m_renderFenceForFeedback = m_pTileUpdateManager->GetFrameFenceValue();
+    f.m_cpuFeedback = true;
+    f.m_feedbackQueued = true;
+}
+
 #if RESOLVE_TO_TEXTURE
 //-----------------------------------------------------------------------------
 // call after resolving to read back to CPU
@@ -933,6 +1209,17 @@ void Streaming::StreamingResourceBase::ReadbackFeedback(ID3D12GraphicsCommandLis
 }
 #endif
 
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+void Streaming::StreamingResourceBase::AbandonPendingUpgrades()
+{
+    for (const auto& coord : m_pendingUpgrades)
+    {
+        m_tileMappingState.SetLowTier(coord, false);
+    }
+    m_pendingUpgrades.clear();
+}
+
 //-----------------------------------------------------------------------------
 // eject all tiles and remove mappings into heap
 //-----------------------------------------------------------------------------
@@ -944,11 +1231,17 @@ void Streaming::StreamingResourceBase::ClearAllocations()
 
     m_tileMappingState.FreeHeapAllocations(m_pHeap);
     m_tileMappingState.Init(m_resources->GetPackedMipInfo().NumStandardMips, m_resources->GetTiling());
+    m_numTilesResident = 0;
     m_tileReferences.assign(m_tileReferences.size(), m_maxMip);
     m_minMipMap.assign(m_minMipMap.size(), m_maxMip);
 
+    m_pTileUpdateManager->AddPendingLoadStatistics(0, (UINT)m_pendingTileLoads.size(), 0);
     m_pendingEvictions.Clear();
     m_pendingTileLoads.clear();
+    AbandonPendingUpgrades();
+
+    // reload guaranteed, pinned, and prefetched tiles on the next ProcessFeedback()
+    m_qosChanged = true;
 
     // want to upload a residency of all maxMip
     // NOTE: UpdateMinMipMap() will see there are no tiles resident,
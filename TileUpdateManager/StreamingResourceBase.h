@@ -34,10 +34,13 @@ Base class for StreamingResource
 #include <vector>
 #include <d3d12.h>
 #include <string>
+#include <mutex>
 
 #include "SamplerFeedbackStreaming.h"
 #include "InternalResources.h"
 #include "XeTexture.h"
+#include "FeedbackScheduler.h"
+#include "TileMappingState.h"
 
 namespace Streaming
 {
@@ -46,6 +49,39 @@ namespace Streaming
     class Heap;
     class FileHandle;
 
+    //=============================================================================
+    // prefetch requests that share a handle, see TileUpdateManager::Prefetch()
+    // held by the TUM until released, and by each resource until it drops its request
+    //=============================================================================
+    struct PrefetchBatch
+    {
+        float m_priority{ 0.5f };
+        float m_expirySeconds{ 0 };
+        INT64 m_startTime{ 0 };
+        std::atomic<UINT> m_numPending{ 0 }; // requests not yet resident
+        std::atomic<bool> m_expired{ false };
+        std::atomic<bool> m_released{ false };
+    };
+
+    //=============================================================================
+    // the parts of a StreamingResource that do not depend on TileUpdateManager state
+    // can be created on any thread. see TileUpdateManager::PrepareStreamingResource()
+    //=============================================================================
+    class StreamingResourceFile : public ::PreparedStreamingResource
+    {
+    public:
+        StreamingResourceFile(const std::wstring& in_filename, ID3D12Device8* in_pDevice, UINT in_numSwapBuffers);
+        virtual void Destroy() override { delete this; }
+
+        const std::wstring m_filename;
+        const Streaming::XeTexture m_textureFileInfo;
+        std::unique_ptr<Streaming::InternalResources> m_resources;
+
+        // packed mips are not streamed or evicted, they are read here
+        UINT m_packedMipsUncompressedSize{ 0 };
+        std::vector<BYTE> m_packedMips;
+    };
+
     //=============================================================================
     // unpacked mips are dynamically loaded/evicted, preserving a min-mip-map
     // packed mips are not evicted from the heap (as little as 1 tile for a 16k x 16k texture)
@@ -64,15 +100,22 @@ namespace Streaming
         virtual UINT GetMinMipMapOffset() const override;
         virtual bool GetPackedMipsResident() const override;
         virtual void QueueEviction() override;
+        virtual void SetQoS(const StreamingQoS& in_qos) override;
+        virtual StreamingQoS GetQoS() const override;
+        virtual void PinRegion(UINT in_x, UINT in_y, UINT in_width, UINT in_height, UINT in_mip) override;
+        virtual PrefetchHandle Prefetch(float in_u0, float in_v0, float in_u1, float in_v1, UINT in_mip, const PrefetchOptions& in_options) override;
         virtual ID3D12Resource* GetMinMipMap() const override;
         virtual UINT GetNumTilesVirtual() const override;
+        virtual UINT GetNumTilesResident() const override { return m_numTilesResident; }
+        virtual StreamingQuality GetQuality() const override;
         //-----------------------------------------------------------------
         // end external APIs
         //-----------------------------------------------------------------
 
         StreamingResourceBase(
+            // parsed file and internal resources
+            std::unique_ptr<StreamingResourceFile> in_pFile,
             // method that will fill a tile-worth of bits, for streaming
-            const std::wstring& in_filename,
             Streaming::FileHandle* in_pFileHandle,
             // share heap and upload buffers with other InternalResources
             Streaming::TileUpdateManagerSR* in_pTileUpdateManager,
@@ -109,6 +152,9 @@ namespace Streaming
         // call after drawing to get feedback
         void ResolveFeedback(ID3D12GraphicsCommandList1* out_pCmdList);
 
+        // instead of ClearFeedback()/ResolveFeedback(): copy feedback provided by the application
+        void QueueCpuFeedback(const BYTE* in_pMinMips);
+
 #if RESOLVE_TO_TEXTURE
         // call after resolving to read back to CPU
         void ReadbackFeedback(ID3D12GraphicsCommandList* out_pCmdList);
@@ -139,13 +185,22 @@ namespace Streaming
         // returns # tiles evicted
         UINT QueuePendingTileEvictions();
 
-        bool IsStale()
-        {
-            return (m_pendingTileLoads.size() || m_pendingEvictions.GetReadyToEvict().size());
-        }
+        // upgrades count as work only when there is no backlog
+        bool IsStale();
 
         bool InitPackedMips();
 
+        // sums over tiles and min mip map regions, for this resource and for TUM totals
+        struct QualitySums
+        {
+            UINT m_numTilesWanted{ 0 };
+            UINT m_numTilesWantedResident{ 0 };
+            UINT64 m_mipDeficit{ 0 };   // sum of weight * (resident mip - requested mip)
+            UINT64 m_texelWeight{ 0 };  // sum of weight. a region requesting mip m weighs 4^(MAX_MIPS - m)
+        };
+        // recompute after feedback or residency changes. call once per frame
+        const QualitySums& UpdateQuality();
+
         //-------------------------------------
         // end called by TUM::ProcessFeedbackThread
         //-------------------------------------
@@ -157,13 +212,33 @@ namespace Streaming
         UINT GetNumTilesWidth() const { return m_tileReferencesWidth; }
         UINT GetNumTilesHeight() const { return m_tileReferencesHeight; }
 
+        // for TUM::ProcessFeedbackThread(), which orders resources waiting for UpdateLists by priority
+        // StreamingQoS::m_priority, or the prefetch priority if only prefetched tiles are wanted
+        float GetPriority() const { return m_schedulingPriority; }
+
+        // for TUM::Prefetch(). the uv rectangle becomes a rectangle of regions, applied on the next ProcessFeedback()
+        void AddPrefetch(std::shared_ptr<PrefetchBatch> in_pBatch, const PrefetchRequest& in_request);
+        // for TUM::RestoreResidencySnapshot(): a mip per region (GetNumTilesWidth() x GetNumTilesHeight())
+        void AddPrefetch(std::shared_ptr<PrefetchBatch> in_pBatch, std::vector<UINT8> in_mips);
+
+        // for TUM::WriteResidencySnapshot(). the min mip map may be mid-update, which is ok for a snapshot
+        const std::wstring& GetFileName() const { return m_filename; }
+        const UINT8* GetResidentMips() const { return m_minMipMap.data(); }
+
+        // for TUM::ScheduleFeedback()
+        FeedbackScheduler::History& GetFeedbackHistory() { return m_feedbackHistory; }
+        UINT GetNumFeedbackProcessed() const { return m_numFeedbackProcessed; }
+        UINT GetNumFeedbackChanged() const { return m_numFeedbackChanged; }
+
     protected:
+        std::unique_ptr<StreamingResourceFile> m_pFile; // owns m_textureFileInfo
         const std::wstring m_filename;
 
         // object that streams data from a file
-        const Streaming::XeTexture m_textureFileInfo;
+        const Streaming::XeTexture& m_textureFileInfo;
         std::unique_ptr<Streaming::InternalResources> m_resources;
         std::unique_ptr<Streaming::FileHandle> m_pFileHandle;
+        std::unique_ptr<Streaming::FileHandle> m_pStoreFileHandle; // tile store shared with other textures, if any
         Streaming::Heap* m_pHeap{ nullptr };
 
         // packed mip status
@@ -185,69 +260,7 @@ namespace Streaming
 
         Streaming::TileUpdateManagerSR* m_pTileUpdateManager;
 
-        //==================================================
-        // TileMappingState keeps reference counts and heap indices for resources in a min-mip-map
-        //==================================================
-        class TileMappingState
-        {
-        public:
-            void Init(UINT in_numMips, const D3D12_SUBRESOURCE_TILING* in_pTiling);
-
-            UINT GetNumSubresources() const { return (UINT)m_refcounts.size(); }
-
-
-            // 4 states are encoded by the residency state and ref count:
-            // residency | refcount | tile state
-            // ----------+----------+------------------
-            //      0    |    0     | not resident (data not resident & not mapped)
-            //      0    |    n     | copy pending (data not resident & not mapped)
-            //      1    |    0     | eviction pending (data resident & mapped)
-            //      1    |    n     | resident (data resident & mapped)
-
-            // residency is set to Resident or NotResident by the notify thread
-            // residency is read by process feedback thread, and set to transient states Evicting or Loading
-            enum Residency
-            {
-                NotResident = 0b00,
-                Resident    = 0b01,
-                Evicting    = 0b10,
-                Loading     = 0b11,
-            };
-
-            void SetResidency(UINT x, UINT y, UINT s, Residency in_residency) { m_resident[s][y][x] = (BYTE)in_residency; }
-            BYTE GetResidency(UINT x, UINT y, UINT s) const { return m_resident[s][y][x]; }
-            UINT32& GetRefCount(UINT x, UINT y, UINT s) { return m_refcounts[s][y][x]; }
-
-            void SetResidency(const D3D12_TILED_RESOURCE_COORDINATE& in_coord, Residency in_residency) { SetResidency(in_coord.X, in_coord.Y, in_coord.Subresource, in_residency); }
-            BYTE GetResidency(const D3D12_TILED_RESOURCE_COORDINATE& in_coord) { return GetResidency(in_coord.X, in_coord.Y, in_coord.Subresource); }
-            UINT32 GetRefCount(const D3D12_TILED_RESOURCE_COORDINATE& in_coord) const { return m_refcounts[in_coord.Subresource][in_coord.Y][in_coord.X]; }
-
-            UINT32& GetHeapIndex(const D3D12_TILED_RESOURCE_COORDINATE& in_coord) { return m_heapIndices[in_coord.Subresource][in_coord.Y][in_coord.X]; }
-
-            // checks refcount of bottom-most non-packed tile(s). If none are in use, we know nothing is resident.
-            // used in UpdateMinMipMap()
-            bool GetAnyRefCount();
-
-            // return true if all bottom layer standard tiles are resident
-            // Can accelerate UpdateMinMipMap()
-            UINT8 GetMinResidentMip();
-
-            // remove all mappings from a heap. useful when removing an object from a scene
-            void FreeHeapAllocations(Streaming::Heap* in_pHeap);
-
-            UINT GetWidth(UINT in_s) const { return (UINT)m_resident[in_s][0].size(); }
-            UINT GetHeight(UINT in_s) const { return (UINT)m_resident[in_s].size(); }
-
-            static const UINT InvalidIndex{ UINT(-1) };
-        private:
-            template<typename T> using TileRow = std::vector<T>;
-            template<typename T> using TileY = std::vector<TileRow<T>>;
-            template<typename T> using TileLayer = std::vector<TileY<T>>;
-
-            TileLayer<BYTE> m_resident;
-            TileLayer<UINT32> m_refcounts;
-            TileLayer<UINT32> m_heapIndices;
-        };
+        using TileMappingState = Streaming::TileMappingState;
         TileMappingState m_tileMappingState;
 
         void SetResidencyChanged();
@@ -260,6 +273,46 @@ namespace Streaming
         // used by QueueEviction()
         std::atomic<bool> m_setZeroRefCounts{ false };
 
+        // incremented by the notify thread when a load completes, decremented on eviction
+        std::atomic<UINT> m_numTilesResident{ 0 };
+
+        // written by the ProcessFeedback thread: feedback results processed, and how many changed the desired tiles
+        std::atomic<UINT> m_numFeedbackProcessed{ 0 };
+        std::atomic<UINT> m_numFeedbackChanged{ 0 };
+
+        // owned by the render thread, see TUM::ScheduleFeedback()
+        FeedbackScheduler::History m_feedbackHistory;
+
+        // set when refcounts or the min mip map change. cleared by UpdateQuality()
+        std::atomic<bool> m_qualityChanged{ false };
+        QualitySums m_qualitySums; // owned by the ProcessFeedback thread
+        std::vector<UINT8> m_qualityMips; // UpdateQuality() scratch, per region
+
+        // published by UpdateQuality() for GetQuality()
+        std::atomic<UINT> m_numTilesWanted{ 0 };
+        std::atomic<UINT> m_numTilesWantedResident{ 0 };
+        std::atomic<float> m_mipDeficit{ 0 };
+
+        // QoS requested by the application. m_qosMutex guards m_qos, m_pinRequests, and m_prefetchRequests
+        struct PinRequest
+        {
+            UINT m_x, m_y, m_width, m_height;
+            UINT8 m_mip;
+        };
+        struct Prefetch
+        {
+            std::shared_ptr<PrefetchBatch> m_pBatch;
+            UINT m_x, m_y, m_width, m_height;
+            UINT8 m_mip;
+            bool m_complete;
+            std::vector<UINT8> m_mips; // if not empty, a mip per region of the whole resource instead of the rectangle
+        };
+        mutable std::mutex m_qosMutex;
+        StreamingQoS m_qos;
+        std::vector<PinRequest> m_pinRequests;
+        std::vector<Prefetch> m_prefetchRequests;
+        std::atomic<bool> m_qosChanged{ false };
+
     private:
         // do not immediately decmap:
         // need to withhold until in-flight command buffers have completed
@@ -284,6 +337,9 @@ namespace Streaming
 
         std::vector<D3D12_TILED_RESOURCE_COORDINATE> m_pendingTileLoads;
 
+        // tiles loaded from the low quality tier, to be re-loaded at full quality when there is no backlog
+        std::vector<D3D12_TILED_RESOURCE_COORDINATE> m_pendingUpgrades;
+
         //--------------------------------------------------------
         // for public interface
         //--------------------------------------------------------
@@ -295,6 +351,27 @@ namespace Streaming
         UINT m_tileReferencesWidth;  // function of resource tiling
         UINT m_tileReferencesHeight; // function of resource tiling
 
+        // QoS as applied by the ProcessFeedback thread. m_tileReferences = max(finest, min(feedback, floor))
+        std::vector<TileReference> m_feedbackMips; // latest feedback, clamped to the standard mips. m_maxMip after QueueEviction()
+        std::vector<TileReference> m_pinnedMips;   // per region, m_maxMip if not pinned
+        std::vector<TileReference> m_floorMips;    // per region, min of pinned and guaranteed mip: kept regardless of feedback
+        UINT8 m_finestMip{ 0 };
+        UINT8 m_guaranteedMip{ 0xff };
+        bool m_haveFloor{ false };                 // some region keeps tiles after QueueEviction()
+        float m_qosPriority{ 1.f };
+        float m_schedulingPriority{ 1.f };
+        std::vector<Prefetch> m_prefetches;        // until released or expired
+        bool m_sortPendingLoads{ false };          // a snapshot was restored: read its tiles coarsest mip first, each mip in file order
+
+        // copy the application's QoS requests, track prefetches. returns true if the floor or clamp changed
+        bool UpdateQoS();
+
+        // is every region of the prefetch resident at its mip?
+        bool GetPrefetchResident(const Prefetch& in_prefetch) const;
+
+        // set refcounts from m_feedbackMips, limited by QoS. returns true if any region changed
+        bool ApplyFeedbackMips();
+
         UINT8 m_maxMip;
         std::vector<BYTE, Streaming::AlignedAllocator<BYTE>> m_minMipMap; // local version of min mip map, rectified in UpdateMinMipMap()
 
@@ -302,7 +379,7 @@ namespace Streaming
         std::atomic<bool> m_tileResidencyChanged{ false };
 
         // drop pending loads that are no longer relevant
-        void AbandonPendingLoads();
+        UINT AbandonPendingLoads();
 
         // index to next min-mip feedback resolve target
         UINT m_readbackIndex;
@@ -313,21 +390,20 @@ namespace Streaming
         {
             UINT64 m_renderFenceForFeedback{ UINT_MAX };
             std::atomic<bool> m_feedbackQueued{ false }; // written by render thread, read by UpdateFeedback() thread
+            bool m_cpuFeedback{ false };    // m_cpuMinMips holds the feedback, rather than the readback buffer
+            std::vector<BYTE> m_cpuMinMips; // width x height, unpadded
         };
         std::vector<QueuedFeedback> m_queuedFeedback;
 
         // update internal mapping and refcounts for each tile
         void SetMinMip(UINT8 in_current, UINT in_x, UINT in_y, UINT in_s);
 
-        // AddRef, which requires allocation, might fail
-        void AddTileRef(UINT in_x, UINT in_y, UINT in_s);
-
-        // DecRef may decline
-        void DecTileRef(UINT in_x, UINT in_y, UINT in_s);
-
         void QueuePendingTileLoads(Streaming::UpdateList* out_pUpdateList); // returns # tiles queued
 
-        void LoadPackedMips();
+        void QueuePendingTileUpgrades(Streaming::UpdateList* out_pUpdateList);
+
+        // discard pending upgrades. tiles still flagged low tier would otherwise never be upgraded
+        void AbandonPendingUpgrades();
 
         // used by QueueEviction()
         bool m_refCountsZero{ true };
@@ -69,7 +69,13 @@ void Streaming::StreamingResourceDU::NotifyCopyComplete(const std::vector<D3D12_
 {
     for (const auto& t : in_coords)
     {
-        ASSERT(TileMappingState::Residency::Loading == m_tileMappingState.GetResidency(t));
+        ASSERT((TileMappingState::Residency::Loading == m_tileMappingState.GetResidency(t)) ||
+            (TileMappingState::Residency::Upgrading == m_tileMappingState.GetResidency(t)));
+        // an upgraded tile was already resident
+        if (TileMappingState::Residency::Loading == m_tileMappingState.GetResidency(t))
+        {
+            m_numTilesResident++;
+        }
         m_tileMappingState.SetResidency(t, TileMappingState::Residency::Resident);
     }
 
@@ -86,6 +92,7 @@ void Streaming::StreamingResourceDU::NotifyEvicted(const std::vector<D3D12_TILED
     {
         ASSERT(TileMappingState::Residency::Evicting == m_tileMappingState.GetResidency(t));
         m_tileMappingState.SetResidency(t, TileMappingState::Residency::NotResident);
+        m_numTilesResident--;
     }
 
     SetResidencyChanged();
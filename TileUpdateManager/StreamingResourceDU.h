@@ -38,6 +38,17 @@ namespace Streaming
     {
     public:
         const XeTexture* GetTextureFileInfo() const { return &m_textureFileInfo; }
+
+        // where to read a tile: the low quality tier if QueuePendingTileLoads() chose it for this tile, else full quality
+        XeTexture::FileOffset GetFileOffset(const D3D12_TILED_RESOURCE_COORDINATE& in_coord) const
+        {
+            auto fileOffset = m_textureFileInfo.GetFileOffset(in_coord);
+            if (m_tileMappingState.GetLowTier(in_coord))
+            {
+                m_textureFileInfo.GetLowTierFileOffset(in_coord, fileOffset);
+            }
+            return fileOffset;
+        }
         Streaming::Heap* GetHeap() const { return m_pHeap; }
 
         // just for packed mips
@@ -50,6 +61,7 @@ namespace Streaming
         ID3D12Resource* GetTiledResource() const { return m_resources->GetTiledResource(); }
 
         const FileHandle* GetFileHandle() const { return m_pFileHandle.get(); }
+        const FileHandle* GetStoreFileHandle() const { return m_pStoreFileHandle.get(); } // null if no tile store
         const std::wstring& GetFileName() const { return m_filename; }
 
         std::vector<BYTE>& GetPaddedPackedMips(UINT& out_uncompressedSize) { out_uncompressedSize = m_packedMipsUncompressedSize; return m_packedMips; }
@@ -0,0 +1,53 @@
+//*********************************************************
+//
+// Copyright 2020 Intel Corporation 
+//
+// Permission is hereby granted, free of charge, to any 
+// person obtaining a copy of this software and associated 
+// documentation files(the "Software"), to deal in the Software 
+// without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to 
+// whom the Software is furnished to do so, subject to the 
+// following conditions :
+// The above copyright notice and this permission notice shall 
+// be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+// DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#pragma once
+
+#include <atomic>
+
+namespace Streaming
+{
+    //==================================================
+    // a single thread may wait on this flag, which may be set by any number of threads
+    // std::atomic wait/notify is WaitOnAddress on Windows and a futex on Linux
+    //==================================================
+    class SynchronizationFlag
+    {
+    public:
+        void Set()
+        {
+            m_flag.store(true, std::memory_order_release);
+            m_flag.notify_one();
+        }
+
+        void Wait()
+        {
+            m_flag.wait(false, std::memory_order_acquire);
+            m_flag.store(false, std::memory_order_relaxed);
+        };
+    private:
+        std::atomic<bool> m_flag{ false };
+    };
+}
@@ -0,0 +1,311 @@
+//*********************************************************
+//
+// Copyright 2020 Intel Corporation 
+//
+// Permission is hereby granted, free of charge, to any 
+// person obtaining a copy of this software and associated 
+// documentation files(the "Software"), to deal in the Software 
+// without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to 
+// whom the Software is furnished to do so, subject to the 
+// following conditions :
+// The above copyright notice and this permission notice shall 
+// be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+// DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+
+/*=============================================================================
+Per-tile state of a StreamingResource: reference counts, residency, heap indices
+Header-only and free of D3D12 calls so the hot loops can be benchmarked on any platform
+(see microbench). Expects UINT/BYTE, ASSERT, and the D3D12 tiling structs from the includer
+=============================================================================*/
+
+#pragma once
+
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+namespace Streaming
+{
+    class Heap;
+
+    //==================================================
+    // TileMappingState keeps reference counts and heap indices for resources in a min-mip-map
+    //==================================================
+    class TileMappingState
+    {
+    public:
+        void Init(UINT in_numMips, const D3D12_SUBRESOURCE_TILING* in_pTiling);
+
+        UINT GetNumSubresources() const { return (UINT)m_refcounts.size(); }
+
+
+        // 4 states are encoded by the residency state and ref count:
+        // residency | refcount | tile state
+        // ----------+----------+------------------
+        //      0    |    0     | not resident (data not resident & not mapped)
+        //      0    |    n     | copy pending (data not resident & not mapped)
+        //      1    |    0     | eviction pending (data resident & mapped)
+        //      1    |    n     | resident (data resident & mapped)
+
+        // residency is set to Resident or NotResident by the notify thread
+        // residency is read by process feedback thread, and set to transient states Evicting, Loading, or Upgrading
+        // Upgrading: a low quality tile is resident & mapped while its full quality replacement is copied to the same heap index
+        enum Residency
+        {
+            NotResident = 0b000,
+            Resident    = 0b001,
+            Evicting    = 0b010,
+            Loading     = 0b011,
+            Upgrading   = 0b100,
+        };
+
+        void SetResidency(UINT x, UINT y, UINT s, Residency in_residency) { m_resident[s][y][x] = (BYTE)in_residency; }
+        BYTE GetResidency(UINT x, UINT y, UINT s) const { return m_resident[s][y][x]; }
+        UINT32& GetRefCount(UINT x, UINT y, UINT s) { return m_refcounts[s][y][x]; }
+
+        void SetResidency(const D3D12_TILED_RESOURCE_COORDINATE& in_coord, Residency in_residency) { SetResidency(in_coord.X, in_coord.Y, in_coord.Subresource, in_residency); }
+        BYTE GetResidency(const D3D12_TILED_RESOURCE_COORDINATE& in_coord) { return GetResidency(in_coord.X, in_coord.Y, in_coord.Subresource); }
+        UINT32 GetRefCount(const D3D12_TILED_RESOURCE_COORDINATE& in_coord) const { return m_refcounts[in_coord.Subresource][in_coord.Y][in_coord.X]; }
+
+        UINT32& GetHeapIndex(const D3D12_TILED_RESOURCE_COORDINATE& in_coord) { return m_heapIndices[in_coord.Subresource][in_coord.Y][in_coord.X]; }
+
+        // resident data came from the low quality tier
+        void SetLowTier(const D3D12_TILED_RESOURCE_COORDINATE& in_coord, bool in_lowTier) { m_lowTier[in_coord.Subresource][in_coord.Y][in_coord.X] = in_lowTier; }
+        bool GetLowTier(const D3D12_TILED_RESOURCE_COORDINATE& in_coord) const { return m_lowTier[in_coord.Subresource][in_coord.Y][in_coord.X]; }
+
+        // data is resident & mapped, and may be sampled
+        static bool IsResident(BYTE in_residency) { return (Resident == in_residency) || (Upgrading == in_residency); }
+
+        // checks refcount of bottom-most non-packed tile(s). If none are in use, we know nothing is resident.
+        // used in UpdateMinMipMap()
+        bool GetAnyRefCount();
+
+        // return true if all bottom layer standard tiles are resident
+        // Can accelerate UpdateMinMipMap()
+        UINT8 GetMinResidentMip();
+
+        // change the mip referenced by the region at (x,y) from in_current to in_s
+        // in_load(x, y, s) is called for tiles gaining their first reference, in_evict(x, y, s) for tiles losing their last
+        template<typename Load, typename Evict> void SetMinMip(UINT8 in_current, UINT in_x, UINT in_y, UINT in_s, Load&& in_load, Evict&& in_evict);
+
+        // write the finest resident mip of each region, in_width x in_height regions
+        // inout_pMinMipMap holds the previous result, which seeds the search
+        void UpdateMinMipMap(BYTE* inout_pMinMipMap, UINT in_width, UINT in_height);
+
+        // remove all mappings from a heap. useful when removing an object from a scene
+        void FreeHeapAllocations(Streaming::Heap* in_pHeap);
+
+        UINT GetWidth(UINT in_s) const { return (UINT)m_resident[in_s][0].size(); }
+        UINT GetHeight(UINT in_s) const { return (UINT)m_resident[in_s].size(); }
+
+        static const UINT InvalidIndex{ UINT(-1) };
+    private:
+        template<typename T> using TileRow = std::vector<T>;
+        template<typename T> using TileY = std::vector<TileRow<T>>;
+        template<typename T> using TileLayer = std::vector<TileY<T>>;
+
+        TileLayer<BYTE> m_resident;
+        TileLayer<UINT32> m_refcounts;
+        TileLayer<UINT32> m_heapIndices;
+        TileLayer<BYTE> m_lowTier;
+    };
+}
+
+//-----------------------------------------------------------------------------
+// initialize data structure afther creating the reserved resource and querying its tiling properties
+//-----------------------------------------------------------------------------
+inline void Streaming::TileMappingState::Init(UINT in_numMips, const D3D12_SUBRESOURCE_TILING* in_pTiling)
+{
+    ASSERT(in_numMips);
+    m_refcounts.resize(in_numMips);
+    m_heapIndices.resize(in_numMips);
+    m_resident.resize(in_numMips);
+    m_lowTier.resize(in_numMips);
+
+    for (UINT mip = 0; mip < in_numMips; mip++)
+    {
+        UINT width = in_pTiling[mip].WidthInTiles;
+        UINT height = in_pTiling[mip].HeightInTiles;
+        m_refcounts[mip].resize(height);
+        m_heapIndices[mip].resize(height);
+        m_resident[mip].resize(height);
+        m_lowTier[mip].resize(height);
+
+        for (auto& row : m_refcounts[mip])
+        {
+            row.assign(width, 0);
+        }
+        for (auto& row : m_heapIndices[mip])
+        {
+            row.assign(width, TileMappingState::InvalidIndex);
+        }
+        for (auto& row : m_resident[mip])
+        {
+            row.assign(width, 0);
+        }
+        for (auto& row : m_lowTier[mip])
+        {
+            row.assign(width, 0);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// search bottom layer. if refcount of any is positive, there is something resident.
+//-----------------------------------------------------------------------------
+inline bool Streaming::TileMappingState::GetAnyRefCount()
+{
+    auto& lastMip = m_refcounts.back();
+    for (const auto& y : lastMip)
+    {
+        for (const auto& x : y)
+        {
+            if (x)
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+// optimization for UpdateMinMipMap:
+// return true if all bottom layer standard tiles are resident
+// FIXME? currently just checks the lowest tracked mip.
+//-----------------------------------------------------------------------------
+inline UINT8 Streaming::TileMappingState::GetMinResidentMip()
+{
+    UINT8 minResidentMip = (UINT8)m_resident.size();
+
+    auto& lastMip = m_resident.back();
+    for (const auto& y : lastMip)
+    {
+        for (const auto& x : y)
+        {
+            if (!TileMappingState::IsResident(x))
+            {
+                return minResidentMip;
+            }
+        }
+    }
+    return minResidentMip - 1;
+}
+
+//-----------------------------------------------------------------------------
+// add or remove references to match the incoming requested minimum mip
+//-----------------------------------------------------------------------------
+template<typename Load, typename Evict>
+inline void Streaming::TileMappingState::SetMinMip(UINT8 in_current, UINT in_x, UINT in_y, UINT in_s, Load&& in_load, Evict&& in_evict)
+{
+    // what mip level is currently referenced at this tile?
+    UINT8 s = in_current;
+
+    // addref mips we want
+    // AddRef()s are ordered from bottom mip to top (all dependencies will be loaded first)
+    while (s > in_s)
+    {
+        s -= 1; // already have "this" tile. e.g. have s == 1, desired in_s == 0, start with 0.
+        auto& refCount = GetRefCount(in_x >> s, in_y >> s, s);
+
+        // if refcount is 0xffff... then adding to it will wrap around. shouldn't happen.
+        ASSERT(~refCount);
+
+        // need to allocate?
+        if (0 == refCount)
+        {
+            in_load(in_x >> s, in_y >> s, UINT(s));
+        }
+        refCount++;
+    }
+
+    // decref mips we don't need
+    // DecRef()s are ordered from top mip to bottom (evict lower resolution tiles after all higher resolution ones)
+    while (s < in_s)
+    {
+        auto& refCount = GetRefCount(in_x >> s, in_y >> s, s);
+
+        ASSERT(0 != refCount);
+
+        // last refrence? try to evict
+        if (1 == refCount)
+        {
+            in_evict(in_x >> s, in_y >> s, UINT(s));
+        }
+        refCount--;
+        s++;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// traverses residency status to find the finest mip each region can sample
+//-----------------------------------------------------------------------------
+inline void Streaming::TileMappingState::UpdateMinMipMap(BYTE* inout_pMinMipMap, UINT in_width, UINT in_height)
+{
+    if (GetAnyRefCount())
+    {
+#if 0
+        // FIXME? if the optimization below introduces artifacts, this might work:
+        const UINT8 minResidentMip = (UINT8)GetNumSubresources();
+#else
+        // a simple optimization that's especially effective for large textures
+        // and harmless for smaller ones:
+        // find the minimum fully-resident mip
+        const UINT8 minResidentMip = GetMinResidentMip();
+#endif
+        // Search bottom up for best mip
+        // tiles that have refcounts may still have pending copies, so we have to check residency (can't just memcpy m_tileReferences)
+        // note that tiles can load out of order, but the min mip map cannot have holes, so exit if any lower-res tile is absent
+        // for 16kx16k textures, that's 7-1 iterations maximum (maximum for bc7: 64*64*(7-1)=24576, bc1: 32*64*(6-1)=10240)
+        // in practice don't expect to hit the maximum, as the entire texture would have to be loaded
+        // FIXME? could probably optimize e.g. by vectorizing
+        UINT tileIndex = 0;
+        for (UINT y = 0; y < in_height; y++)
+        {
+            for (UINT x = 0; x < in_width; x++)
+            {
+                // mips >= maxmip are pre-loaded packed mips and not tracked
+                // leverage results from previous frame. in the static case, this should # iterations down to exactly # regions
+                UINT8 s = std::max(minResidentMip, inout_pMinMipMap[tileIndex]);
+                UINT8 minMip = s;
+
+                // note: it's ok for a region of the min mip map to include a higher-resolution region than feedback required
+                // the min mip map will be updated on evictions, which will affect "this" region and the referencing region for the tile
+                while (s > 0)
+                {
+                    s--;
+                    if (TileMappingState::IsResident(GetResidency(x >> s, y >> s, s)) &&
+                        // do not include a tile that may be evicted (resident with 0 refcount is candidate for eviction)
+                        (0 != GetRefCount(x >> s, y >> s, s)))
+                    {
+                        minMip = s;
+                    }
+                    else
+                    {
+                        break;
+                    }
+                }
+                inout_pMinMipMap[tileIndex] = minMip;
+                tileIndex++;
+            } // end y
+        } // end x
+    }
+    // if we know that only packed mips are resident, then write a basic residency map
+    // if refcount is 0, then tile state is either not resident or eviction pending
+    else
+    {
+        memset(inout_pMinMipMap, GetNumSubresources(), size_t(in_width) * in_height);
+    }
+}
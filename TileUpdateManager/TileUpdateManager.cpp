@@ -35,6 +35,7 @@
 #include "StreamingResourceBase.h"
 #include "DataUploader.h"
 #include "StreamingHeap.h"
+#include "EventTracer.h"
 
 //--------------------------------------------
 // instantiate streaming library
@@ -65,12 +66,29 @@ StreamingHeap* Streaming::TileUpdateManagerBase::CreateStreamingHeap(UINT in_max
 // Create StreamingResources using a common TileUpdateManager
 //--------------------------------------------
 StreamingResource* Streaming::TileUpdateManagerBase::CreateStreamingResource(const std::wstring& in_filename, StreamingHeap* in_pHeap)
+{
+    return CreateStreamingResource(PrepareStreamingResource(in_filename), in_pHeap);
+}
+
+//-----------------------------------------------------------------------------
+// only uses the device, which is free-threaded. does not touch TUM state
+//-----------------------------------------------------------------------------
+PreparedStreamingResource* Streaming::TileUpdateManagerBase::PrepareStreamingResource(const std::wstring& in_filename)
+{
+    return new Streaming::StreamingResourceFile(in_filename, m_device.Get(), m_numSwapBuffers);
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+StreamingResource* Streaming::TileUpdateManagerBase::CreateStreamingResource(PreparedStreamingResource* in_pPrepared, StreamingHeap* in_pHeap)
 {
     // if threads are running, stop them. they have state that depends on knowing the # of StreamingResources
     Finish();
 
-    Streaming::FileHandle* pFileHandle = m_dataUploader.OpenFile(in_filename);
-    auto pRsrc = new Streaming::StreamingResourceBase(in_filename, pFileHandle, (Streaming::TileUpdateManagerSR*)this, (Streaming::Heap*)in_pHeap);
+    std::unique_ptr<Streaming::StreamingResourceFile> pPrepared((Streaming::StreamingResourceFile*)in_pPrepared);
+
+    Streaming::FileHandle* pFileHandle = m_dataUploader.OpenFile(pPrepared->m_filename);
+    auto pRsrc = new Streaming::StreamingResourceBase(std::move(pPrepared), pFileHandle, (Streaming::TileUpdateManagerSR*)this, (Streaming::Heap*)in_pHeap);
     m_streamingResources.push_back(pRsrc);
     m_numStreamingResourcesChanged = true;
 
@@ -130,6 +148,131 @@ void Streaming::TileUpdateManagerBase::QueueFeedback(StreamingResource* in_pReso
 #endif
 }
 
+//-----------------------------------------------------------------------------
+// the ranking and cost model are in FeedbackScheduler. resources supply their
+// feedback history and how often processed feedback changed their desired tiles
+//-----------------------------------------------------------------------------
+UINT Streaming::TileUpdateManagerBase::ScheduleFeedback(FeedbackHint* inout_pHints, UINT in_numHints, float in_gpuBudgetMs)
+{
+    m_feedbackCandidates.resize(in_numHints);
+    for (UINT i = 0; i < in_numHints; i++)
+    {
+        auto pResource = (Streaming::StreamingResourceBase*)inout_pHints[i].m_pResource;
+        auto& c = m_feedbackCandidates[i];
+        c.m_pHistory = &pResource->GetFeedbackHistory();
+        c.m_numTexels = pResource->GetMinMipMapWidth() * pResource->GetMinMipMapHeight();
+        c.m_screenArea = inout_pHints[i].m_screenArea;
+        c.m_distance = inout_pHints[i].m_distance;
+        c.m_numProcessed = pResource->GetNumFeedbackProcessed();
+        c.m_numChanged = pResource->GetNumFeedbackChanged();
+    }
+
+    UINT numScheduled = m_feedbackScheduler.Schedule(m_feedbackCandidates.data(), in_numHints, in_gpuBudgetMs);
+
+    for (UINT i = 0; i < in_numHints; i++)
+    {
+        inout_pHints[i].m_scheduled = m_feedbackCandidates[i].m_scheduled;
+    }
+    return numScheduled;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+FeedbackSchedulerStatistics Streaming::TileUpdateManagerBase::GetFeedbackSchedulerStatistics() const
+{
+    const auto& s = m_feedbackScheduler.GetStatistics();
+
+    FeedbackSchedulerStatistics statistics;
+    statistics.m_numCandidates = s.m_numCandidates;
+    statistics.m_numScheduled = s.m_numScheduled;
+    statistics.m_numStable = s.m_numStable;
+    statistics.m_numDeferred = s.m_numDeferred;
+    statistics.m_estimatedMs = s.m_estimatedMs;
+    statistics.m_measuredMs = s.m_measuredMs;
+    statistics.m_costPerResolveMs = s.m_costPerResolveMs;
+    statistics.m_costPerMegaTexelMs = s.m_costPerMegaTexelMs;
+    statistics.m_totalScheduled = s.m_totalScheduled;
+    statistics.m_totalStable = s.m_totalStable;
+    statistics.m_totalDeferred = s.m_totalDeferred;
+    return statistics;
+}
+
+//-----------------------------------------------------------------------------
+// feedback from the application replaces the clear/resolve/readback sequence
+//-----------------------------------------------------------------------------
+void Streaming::TileUpdateManagerBase::QueueCpuFeedback(StreamingResource* in_pResource, const BYTE* in_pMinMips)
+{
+    ((Streaming::StreamingResourceBase*)in_pResource)->QueueCpuFeedback(in_pMinMips);
+}
+
+//-----------------------------------------------------------------------------
+// the batch completes when every request is resident. requests without a resource are ignored
+//-----------------------------------------------------------------------------
+PrefetchHandle Streaming::TileUpdateManagerBase::Prefetch(const PrefetchRequest* in_pRequests, UINT in_numRequests, const PrefetchOptions& in_options)
+{
+    UINT numRequests = 0;
+    for (UINT i = 0; i < in_numRequests; i++)
+    {
+        if (in_pRequests[i].m_pResource) { numRequests++; }
+    }
+
+    std::shared_ptr<PrefetchBatch> pBatch;
+    const PrefetchHandle handle = CreatePrefetchBatch(in_options, numRequests, pBatch);
+
+    for (UINT i = 0; i < in_numRequests; i++)
+    {
+        if (in_pRequests[i].m_pResource)
+        {
+            ((Streaming::StreamingResourceBase*)in_pRequests[i].m_pResource)->AddPrefetch(pBatch, in_pRequests[i]);
+        }
+    }
+
+    return handle;
+}
+
+//-----------------------------------------------------------------------------
+// the pending count is set before any request is added, so a batch can't complete early
+//-----------------------------------------------------------------------------
+PrefetchHandle Streaming::TileUpdateManagerBase::CreatePrefetchBatch(const PrefetchOptions& in_options, UINT in_numRequests, std::shared_ptr<PrefetchBatch>& out_pBatch)
+{
+    out_pBatch = std::make_shared<PrefetchBatch>();
+    out_pBatch->m_priority = std::max(0.f, in_options.m_priority);
+    out_pBatch->m_expirySeconds = in_options.m_expirySeconds;
+    out_pBatch->m_startTime = m_cpuTimer.GetTime();
+    out_pBatch->m_numPending = in_numRequests;
+
+    std::lock_guard<std::mutex> lock(m_prefetchMutex);
+    const PrefetchHandle handle = m_nextPrefetchHandle++;
+    m_prefetchBatches[handle] = out_pBatch;
+    return handle;
+}
+
+PrefetchStatus Streaming::TileUpdateManagerBase::GetPrefetchStatus(PrefetchHandle in_handle) const
+{
+    std::lock_guard<std::mutex> lock(m_prefetchMutex);
+    auto i = m_prefetchBatches.find(in_handle);
+    if (m_prefetchBatches.end() == i) { return PrefetchStatus::Invalid; }
+
+    const auto& batch = *i->second;
+    if (0 == batch.m_numPending.load(std::memory_order_acquire)) { return PrefetchStatus::Complete; }
+    if (batch.m_expired) { return PrefetchStatus::Expired; }
+    return PrefetchStatus::Pending;
+}
+
+//-----------------------------------------------------------------------------
+// resources drop the request on the next ProcessFeedback(), after which the tiles follow feedback again
+//-----------------------------------------------------------------------------
+void Streaming::TileUpdateManagerBase::ReleasePrefetch(PrefetchHandle in_handle)
+{
+    std::lock_guard<std::mutex> lock(m_prefetchMutex);
+    auto i = m_prefetchBatches.find(in_handle);
+    if (m_prefetchBatches.end() != i)
+    {
+        i->second->m_released = true;
+        m_prefetchBatches.erase(i);
+    }
+}
+
 //-----------------------------------------------------------------------------
 // returns (approximate) cpu time for processing feedback in the previous frame
 // since processing happens asynchronously, this time should be averaged
@@ -167,6 +310,73 @@ void Streaming::TileUpdateManagerBase::CaptureTraceFile(bool in_captureTrace)
     m_dataUploader.CaptureTraceFile(in_captureTrace);
 }
 
+//-----------------------------------------------------------------------------
+// per-resource residency is summed on the calling thread
+//-----------------------------------------------------------------------------
+TileUpdateManagerStatistics Streaming::TileUpdateManagerBase::GetStatistics() const
+{
+    TileUpdateManagerStatistics statistics;
+
+    m_dataUploader.GetStatistics(statistics);
+
+    statistics.m_numTilesRequested = m_loadCounters.m_numTilesRequested;
+    statistics.m_numTilesCancelled = m_loadCounters.m_numTilesCancelled;
+    statistics.m_numTilesRejected = m_loadCounters.m_numTilesRejected;
+    for (auto p : m_streamingResources)
+    {
+        statistics.m_numTilesResident += p->GetNumTilesResident();
+    }
+
+    statistics.m_numSubmits = m_numTotalSubmits;
+    statistics.m_numLowTierUploads = m_numTotalLowTierUploads;
+    statistics.m_numUpgrades = m_numTotalUpgrades;
+    statistics.m_lowTierBytesSaved = m_totalLowTierBytesSaved;
+    statistics.m_upgradeBytes = m_totalUpgradeBytes;
+    statistics.m_totalCpuProcessFeedbackTime = m_cpuTimer.GetSecondsFromDelta(m_processFeedbackTime);
+
+    statistics.m_quality.m_numTilesWanted = m_qualityCounters.m_numTilesWanted;
+    statistics.m_quality.m_numTilesWantedResident = m_qualityCounters.m_numTilesWantedResident;
+    statistics.m_quality.m_mipDeficit = m_qualityCounters.m_mipDeficit;
+    statistics.m_numCameraCuts = m_numCameraCuts;
+    statistics.m_numCameraCutsConverged = m_qualityCounters.m_numCameraCutsConverged;
+    statistics.m_timeToFullQuality = m_cpuTimer.GetSecondsFromDelta(m_qualityCounters.m_timeToFullQuality);
+    statistics.m_totalTimeToFullQuality = m_cpuTimer.GetSecondsFromDelta(m_qualityCounters.m_totalTimeToFullQuality);
+
+    return statistics;
+}
+
+//-----------------------------------------------------------------------------
+// feedback from the next frame onward reflects the new view
+// if called between BeginFrame() and EndFrame(), the current frame is the first after the cut
+// BeginFrame() signals the frame fence with the value of the previous frame, so the cut frame's
+//     feedback can be read once the fence reaches m_frameFenceValue + 1 either way
+//-----------------------------------------------------------------------------
+void Streaming::TileUpdateManagerBase::NotifyCameraCut()
+{
+    m_cameraCutTime.store(m_cpuTimer.GetTime(), std::memory_order_relaxed);
+    m_cameraCutFenceValue.store(m_frameFenceValue + 1, std::memory_order_relaxed);
+    m_numCameraCuts.fetch_add(1, std::memory_order_release);
+}
+
+//-----------------------------------------------------------------------------
+// the tracer is shared by all TileUpdateManagers in the process
+//-----------------------------------------------------------------------------
+void Streaming::TileUpdateManagerBase::SetEventTracing([[maybe_unused]] bool in_enable)
+{
+#if EVENT_TRACING
+    EventTracer::Get().SetEnabled(in_enable);
+#endif
+}
+
+bool Streaming::TileUpdateManagerBase::WriteEventTrace([[maybe_unused]] const std::wstring& in_filename)
+{
+#if EVENT_TRACING
+    return EventTracer::Get().WriteChromeTrace(in_filename);
+#else
+    return false;
+#endif
+}
+
 //-----------------------------------------------------------------------------
 // Call this method once for each TileUpdateManager that shares heap/upload buffers
 // expected to be called once per frame, before anything is drawn.
@@ -177,6 +387,9 @@ void Streaming::TileUpdateManagerBase::BeginFrame(ID3D12DescriptorHeap* in_pDesc
     ASSERT(!GetWithinFrame());
     m_withinFrame = true;
 
+    TRACE_SCOPE("BeginFrame");
+    TRACE_SCOPE_ARGS(EventTracer::NO_VALUE, EventTracer::NO_VALUE, m_frameFenceValue);
+
     StartThreads();
 
     m_processFeedbackFlag.Set();
@@ -222,6 +435,9 @@ TileUpdateManager::CommandLists Streaming::TileUpdateManagerBase::EndFrame()
     ASSERT(GetWithinFrame());
     // NOTE: we are "within frame" until the end of EndFrame()
 
+    TRACE_SCOPE("EndFrame");
+    TRACE_SCOPE_ARGS(EventTracer::NO_VALUE, EventTracer::NO_VALUE, m_frameFenceValue);
+
     // transition packed mips if necessary
     // FIXME? if any 1 needs a transition, go ahead and check all of them. not worth optimizing.
     // NOTE: the debug layer will complain about CopyTextureRegion() if the resource state is not state_copy_dest (or common)
@@ -312,9 +528,30 @@ TileUpdateManager::CommandLists Streaming::TileUpdateManagerBase::EndFrame()
             }
 #endif
             m_gpuTimerResolve.EndTimer(pCommandList, m_renderFrameIndex);
-            m_feedbackReadbacks.clear();
 
+            // reads back the time of the previous frame that used this index, then the cost model learns from it
             m_gpuTimerResolve.ResolveTimer(pCommandList, m_renderFrameIndex);
+
+            auto& cost = m_feedbackCosts[m_renderFrameIndex];
+            if (cost.m_numResolves)
+            {
+                float timeMs = 1000.f * m_gpuTimerResolve.GetTimes()[m_renderFrameIndex].first;
+                m_feedbackScheduler.AddMeasurement(timeMs, cost.m_numResolves, cost.m_numTexels);
+            }
+
+            cost.m_numResolves = (UINT)m_feedbackReadbacks.size();
+            cost.m_numTexels = 0;
+            for (auto& t : m_feedbackReadbacks)
+            {
+                cost.m_numTexels += t.m_pStreamingResource->GetMinMipMapWidth() * t.m_pStreamingResource->GetMinMipMapHeight();
+            }
+
+            m_feedbackReadbacks.clear();
+        }
+        else
+        {
+            // the timer for this index was not written
+            m_feedbackCosts[m_renderFrameIndex] = FeedbackCost();
         }
 
         pCommandList->Close();
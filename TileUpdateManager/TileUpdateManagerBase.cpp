@@ -31,6 +31,8 @@
 #include "XeTexture.h"
 #include "StreamingHeap.h"
 #include "BitVector.h"
+#include "PriorityScheduler.h"
+#include "EventTracer.h"
 
 // 710 is the agility sdk preview with gpu upload heaps
 extern "C" { __declspec(dllexport) extern const UINT D3D12SDKVersion = 711; }
@@ -42,6 +44,7 @@ extern "C" { __declspec(dllexport) extern const char* D3D12SDKPath = ".\\D3D12\\
 Streaming::TileUpdateManagerBase::TileUpdateManagerBase(const TileUpdateManagerDesc& in_desc, ID3D12Device8* in_pDevice) :// required for constructor
 m_numSwapBuffers(in_desc.m_swapChainBufferCount)
 , m_gpuTimerResolve(in_pDevice, in_desc.m_swapChainBufferCount, D3D12GpuTimer::TimerType::Direct)
+, m_feedbackCosts(in_desc.m_swapChainBufferCount)
 , m_renderFrameIndex(0)
 , m_directCommandQueue(in_desc.m_pDirectCommandQueue)
 , m_device(in_pDevice)
@@ -49,11 +52,15 @@ m_numSwapBuffers(in_desc.m_swapChainBufferCount)
 , m_maxTileMappingUpdatesPerApiCall(in_desc.m_maxTileMappingUpdatesPerApiCall)
 , m_addAliasingBarriers(in_desc.m_addAliasingBarriers)  
 , m_minNumUploadRequests(in_desc.m_minNumUploadRequests)
+, m_lowTierThreshold(in_desc.m_lowTierThreshold)
 , m_threadPriority((int)in_desc.m_threadPriority)
 , m_dataUploader(in_pDevice, in_desc.m_maxNumCopyBatches, in_desc.m_stagingBufferSizeMB, in_desc.m_maxTileMappingUpdatesPerApiCall, (int)in_desc.m_threadPriority)
 {
     ASSERT(D3D12_COMMAND_LIST_TYPE_DIRECT == m_directCommandQueue->GetDesc().Type);
 
+    // assume the creating thread is the one that will call BeginFrame()/EndFrame()
+    TRACE_THREAD_NAME("Application");
+
     ThrowIfFailed(in_pDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_frameFence)));
     m_frameFence->SetName(L"Streaming::TileUpdateManagerBase::m_frameFence");
 
@@ -106,16 +113,19 @@ void Streaming::TileUpdateManagerBase::StartThreads()
     // process sampler feedback buffers, generate upload and eviction commands
     m_processFeedbackThread = std::thread([&]
         {
+            TRACE_THREAD_NAME("ProcessFeedback");
             ProcessFeedbackThread();
         });
 
     // modify residency maps as a result of gpu completion events
     m_updateResidencyThread = std::thread([&]
         {
+            TRACE_THREAD_NAME("UpdateResidency");
             while (m_threadsRunning)
             {
                 m_residencyChangedFlag.Wait();
 
+                TRACE_SCOPE("UpdateMinMipMaps");
                 for (auto p : m_streamingResources)
                 {
                     p->UpdateMinMipMap();
@@ -145,6 +155,10 @@ void Streaming::TileUpdateManagerBase::ProcessFeedbackThread()
     // flags to prevent duplicates in the staleResources array
     BitVector<UINT32> pending(m_streamingResources.size(), 0);
 
+    // under contention for UpdateLists, serve stale resources in proportion to their priority
+    PriorityScheduler scheduler;
+    scheduler.Resize(m_streamingResources.size());
+
     UINT uploadsRequested = 0; // remember if any work was queued so we can signal afterwards
     UINT64 previousFrameFenceValue = m_frameFenceValue;
     while (m_threadsRunning)
@@ -181,7 +195,11 @@ void Streaming::TileUpdateManagerBase::ProcessFeedbackThread()
                 // flush any pending uploads from previous frame
                 if (uploadsRequested) { flushPendingUploadRequests = true; }
 
+                TRACE_SCOPE("ProcessFeedback");
+                TRACE_SCOPE_ARGS(EventTracer::NO_VALUE, EventTracer::NO_VALUE, frameFenceValue);
+
                 auto startTime = m_cpuTimer.GetTime();
+                ExpirePrefetches();
                 for (UINT i = 0; i < m_streamingResources.size(); i++)
                 {
                     m_streamingResources[i]->ProcessFeedback(frameFenceValue);
@@ -189,15 +207,24 @@ void Streaming::TileUpdateManagerBase::ProcessFeedbackThread()
                     {
                         staleResources.push_back(i);
                         pending[i] = 1;
+                        scheduler.Wake(i, m_streamingResources[i]->GetPriority());
                     }
                 }
                 // add the amount of time we just spent processing feedback for a single frame
                 m_processFeedbackTime += UINT64(m_cpuTimer.GetTime() - startTime);
+
+                UpdateQuality(frameFenceValue);
             }
         }
 
         // push uploads and evictions for stale resources
+        if (staleResources.size())
         {
+            TRACE_SCOPE("QueueTiles");
+            [[maybe_unused]] const UINT previousUploadsRequested = uploadsRequested;
+
+            scheduler.Sort(staleResources);
+
             UINT numEvictions = 0;
             UINT newStaleSize = 0; // track number of stale resources, then resize the array to the updated number
             for (auto resourceIndex : staleResources)
@@ -211,7 +238,9 @@ void Streaming::TileUpdateManagerBase::ProcessFeedbackThread()
                     && (m_frameFence->GetCompletedValue() == previousFrameFenceValue)
                     && m_threadsRunning) // don't add work while exiting
                 {
-                    uploadsRequested += m_streamingResources[resourceIndex]->QueueTiles();
+                    const UINT numUploads = m_streamingResources[resourceIndex]->QueueTiles();
+                    if (numUploads) { scheduler.Served(resourceIndex); }
+                    uploadsRequested += numUploads;
                 }
 
                 // tiles that are "loading" can't be evicted. as soon as they arrive, they can be.
@@ -220,7 +249,7 @@ void Streaming::TileUpdateManagerBase::ProcessFeedbackThread()
 
                 if (m_streamingResources[resourceIndex]->IsStale()) // still have work to do?
                 {
-                    // keep stale resource in compacted array while retaining oldest-first ordering
+                    // keep stale resource in compacted array while retaining scheduled ordering
                     staleResources[newStaleSize] = resourceIndex;
                     newStaleSize++;
                 }
@@ -231,6 +260,10 @@ void Streaming::TileUpdateManagerBase::ProcessFeedbackThread()
             }
             staleResources.resize(newStaleSize); // compact array
             if (numEvictions) { m_dataUploader.AddEvictions(numEvictions); }
+
+            // while waiting for UpdateLists this loop spins. only record passes that did something
+            if ((uploadsRequested == previousUploadsRequested) && (0 == numEvictions)) { TRACE_SCOPE_DISCARD(); }
+            TRACE_SCOPE_ARGS(EventTracer::NO_VALUE, uploadsRequested - previousUploadsRequested);
         }
 
         // if there are uploads, maybe signal depending on heuristic to minimize # signals
@@ -243,6 +276,7 @@ void Streaming::TileUpdateManagerBase::ProcessFeedbackThread()
                 // this minimum heuristic prevents "storms" of submits with too few tiles to sustain good throughput
                 ((0 == m_dataUploader.GetNumUpdateListsAvailable()) && (uploadsRequested > m_minNumUploadRequests)))
             {
+                TRACE_INSTANT("SignalFileStreamer", EventTracer::NO_VALUE, uploadsRequested);
                 SignalFileStreamer();
                 uploadsRequested = 0;
             }
@@ -260,6 +294,69 @@ void Streaming::TileUpdateManagerBase::ProcessFeedbackThread()
     if (uploadsRequested) { SignalFileStreamer(); }
 }
 
+//-----------------------------------------------------------------------------
+// expired prefetches are dropped by their resources in ProcessFeedback()
+//-----------------------------------------------------------------------------
+void Streaming::TileUpdateManagerBase::ExpirePrefetches()
+{
+    const INT64 time = m_cpuTimer.GetTime();
+
+    std::lock_guard<std::mutex> lock(m_prefetchMutex);
+    for (auto& b : m_prefetchBatches)
+    {
+        auto& batch = *b.second;
+        if ((batch.m_expirySeconds > 0) && (!batch.m_expired) &&
+            (m_cpuTimer.GetSecondsFromDelta(time - batch.m_startTime) >= batch.m_expirySeconds))
+        {
+            batch.m_expired = true;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// called by the ProcessFeedback thread once per frame, after ProcessFeedback()
+// a camera cut converges when feedback from a frame after the cut has been processed
+// and everything that feedback requested is resident in the min mip map
+//-----------------------------------------------------------------------------
+void Streaming::TileUpdateManagerBase::UpdateQuality(UINT64 in_frameFenceValue)
+{
+    UINT numTilesWanted = 0;
+    UINT numTilesWantedResident = 0;
+    UINT64 mipDeficit = 0;
+    UINT64 texelWeight = 0;
+    for (auto p : m_streamingResources)
+    {
+        const auto& sums = p->UpdateQuality();
+        numTilesWanted += sums.m_numTilesWanted;
+        numTilesWantedResident += sums.m_numTilesWantedResident;
+        mipDeficit += sums.m_mipDeficit;
+        texelWeight += sums.m_texelWeight;
+    }
+    m_qualityCounters.m_numTilesWanted.store(numTilesWanted, std::memory_order_relaxed);
+    m_qualityCounters.m_numTilesWantedResident.store(numTilesWantedResident, std::memory_order_relaxed);
+    m_qualityCounters.m_mipDeficit.store(texelWeight ? float(double(mipDeficit) / double(texelWeight)) : 0.f, std::memory_order_relaxed);
+
+    // a new cut replaces one that has not converged yet
+    const UINT64 numCameraCuts = m_numCameraCuts.load(std::memory_order_acquire);
+    if (numCameraCuts != m_numCameraCutsSeen)
+    {
+        m_numCameraCutsSeen = numCameraCuts;
+        m_awaitingFullQuality = true;
+    }
+
+    if (m_awaitingFullQuality
+        && (in_frameFenceValue >= m_cameraCutFenceValue.load(std::memory_order_relaxed))
+        && (numTilesWanted == numTilesWantedResident) && (0 == mipDeficit))
+    {
+        m_awaitingFullQuality = false;
+
+        const INT64 elapsed = m_cpuTimer.GetTime() - m_cameraCutTime.load(std::memory_order_relaxed);
+        m_qualityCounters.m_timeToFullQuality.store(elapsed, std::memory_order_relaxed);
+        m_qualityCounters.m_totalTimeToFullQuality.fetch_add(elapsed, std::memory_order_relaxed);
+        m_qualityCounters.m_numCameraCutsConverged.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
 //-----------------------------------------------------------------------------
 // flushes all internal queues
 // submits all outstanding command lists
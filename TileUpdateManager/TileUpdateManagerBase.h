@@ -47,12 +47,15 @@ Draw loop:
 #include <vector>
 #include <memory>
 #include <thread>
+#include <map>
+#include <mutex>
 
 #include "SamplerFeedbackStreaming.h"
 #include "D3D12GpuTimer.h"
 #include "Timer.h"
 #include "Streaming.h" // for ComPtr
 #include "DataUploader.h"
+#include "FeedbackScheduler.h"
 
 //=============================================================================
 // manager for tiled resources
@@ -63,6 +66,7 @@ Draw loop:
 namespace Streaming
 {
     class StreamingResourceBase;
+    struct PrefetchBatch;
     class DataUploader;
     class Heap;
     struct UpdateList;
@@ -76,8 +80,17 @@ namespace Streaming
         virtual void Destroy() override;
         virtual StreamingHeap* CreateStreamingHeap(UINT in_maxNumTilesHeap) override;
         virtual StreamingResource* CreateStreamingResource(const std::wstring& in_filename, StreamingHeap* in_pHeap) override;
+        virtual PreparedStreamingResource* PrepareStreamingResource(const std::wstring& in_filename) override;
+        virtual StreamingResource* CreateStreamingResource(PreparedStreamingResource* in_pPrepared, StreamingHeap* in_pHeap) override;
         virtual void BeginFrame(ID3D12DescriptorHeap* in_pDescriptorHeap, D3D12_CPU_DESCRIPTOR_HANDLE in_minmipmapDescriptorHandle) override;
         virtual void QueueFeedback(StreamingResource* in_pResource, D3D12_GPU_DESCRIPTOR_HANDLE in_gpuDescriptor) override;
+        virtual UINT ScheduleFeedback(FeedbackHint* inout_pHints, UINT in_numHints, float in_gpuBudgetMs) override;
+        virtual void QueueCpuFeedback(StreamingResource* in_pResource, const BYTE* in_pMinMips) override;
+        virtual PrefetchHandle Prefetch(const PrefetchRequest* in_pRequests, UINT in_numRequests, const PrefetchOptions& in_options) override;
+        virtual PrefetchStatus GetPrefetchStatus(PrefetchHandle in_handle) const override;
+        virtual void ReleasePrefetch(PrefetchHandle in_handle) override;
+        virtual bool WriteResidencySnapshot(const std::wstring& in_filename) override;
+        virtual PrefetchHandle RestoreResidencySnapshot(const std::wstring& in_filename, const PrefetchOptions& in_options) override;
         virtual CommandLists EndFrame() override;
         virtual void UseDirectStorage(bool in_useDS) override;
         virtual bool GetWithinFrame() const  override { return m_withinFrame; }
@@ -89,6 +102,15 @@ namespace Streaming
         virtual UINT GetTotalNumEvictions() const override;
         virtual float GetTotalTileCopyLatency() const override;
         virtual UINT GetTotalNumSubmits() const override;
+        virtual UINT GetTotalNumLowTierUploads() const override { return m_numTotalLowTierUploads; }
+        virtual UINT GetTotalNumUpgrades() const override { return m_numTotalUpgrades; }
+        virtual UINT64 GetTotalLowTierBytesSaved() const override { return m_totalLowTierBytesSaved; }
+        virtual UINT64 GetTotalUpgradeBytes() const override { return m_totalUpgradeBytes; }
+        virtual FeedbackSchedulerStatistics GetFeedbackSchedulerStatistics() const override;
+        virtual void NotifyCameraCut() override;
+        virtual TileUpdateManagerStatistics GetStatistics() const override;
+        virtual void SetEventTracing(bool in_enable) override;
+        virtual bool WriteEventTrace(const std::wstring& in_filename) override;
         //-----------------------------------------------------------------
         // end external APIs
         //-----------------------------------------------------------------
@@ -126,6 +148,36 @@ namespace Streaming
 
         std::atomic<bool> m_packedMipTransition{ false }; // flag that we need to transition a resource due to packed mips
 
+        // # in-flight UpdateLists at which StreamingResources load low quality tiles. 0 disables
+        const UINT m_lowTierThreshold{ 0 };
+
+        // low quality tier statistics, written by the ProcessFeedback thread
+        std::atomic<UINT> m_numTotalLowTierUploads{ 0 };
+        std::atomic<UINT> m_numTotalUpgrades{ 0 };
+        std::atomic<UINT64> m_totalLowTierBytesSaved{ 0 };
+        std::atomic<UINT64> m_totalUpgradeBytes{ 0 };
+
+        // pending load statistics, written by the ProcessFeedback thread. own cache line, see DataUploader
+        struct alignas(64) LoadCounters
+        {
+            std::atomic<UINT64> m_numTilesRequested{ 0 };
+            std::atomic<UINT64> m_numTilesCancelled{ 0 };
+            std::atomic<UINT64> m_numTilesRejected{ 0 };
+        };
+        LoadCounters m_loadCounters;
+
+        // quality and convergence, written by the ProcessFeedback thread. see UpdateQuality()
+        struct alignas(64) QualityCounters
+        {
+            std::atomic<UINT> m_numTilesWanted{ 0 };
+            std::atomic<UINT> m_numTilesWantedResident{ 0 };
+            std::atomic<float> m_mipDeficit{ 0 };
+            std::atomic<UINT64> m_numCameraCutsConverged{ 0 };
+            std::atomic<INT64> m_timeToFullQuality{ 0 };       // cpu timer ticks, most recent converged cut
+            std::atomic<INT64> m_totalTimeToFullQuality{ 0 };  // cpu timer ticks, all converged cuts
+        };
+        QualityCounters m_qualityCounters;
+
     private:
         // direct queue is used to monitor progress of render frames so we know when feedback buffers are ready to be used
         ComPtr<ID3D12CommandQueue> m_directCommandQueue;
@@ -150,9 +202,32 @@ namespace Streaming
 
         std::atomic<bool> m_havePackedMipsToLoad{ false };
 
+        // written by the application thread in NotifyCameraCut(). the count is published last
+        std::atomic<INT64> m_cameraCutTime{ 0 };
+        std::atomic<UINT64> m_cameraCutFenceValue{ 0 };
+        std::atomic<UINT64> m_numCameraCuts{ 0 };
+
+        // owned by the ProcessFeedback thread
+        UINT64 m_numCameraCutsSeen{ 0 };
+        bool m_awaitingFullQuality{ false };
+
+        // prefetch handles until released. resources hold the batches until they drop their requests
+        mutable std::mutex m_prefetchMutex;
+        std::map<PrefetchHandle, std::shared_ptr<PrefetchBatch>> m_prefetchBatches;
+        PrefetchHandle m_nextPrefetchHandle{ 1 };
+
+        // returns the handle of a new batch, to which in_numRequests requests will be added
+        PrefetchHandle CreatePrefetchBatch(const PrefetchOptions& in_options, UINT in_numRequests, std::shared_ptr<PrefetchBatch>& out_pBatch);
+
         void StartThreads();
         void ProcessFeedbackThread();
 
+        // sum quality over all resources, detect when a camera cut has converged
+        void UpdateQuality(UINT64 in_frameFenceValue);
+
+        // flag prefetches past their expiry time. called by the ProcessFeedback thread once per frame
+        void ExpirePrefetches();
+
         //---------------------------------------------------------------------------
         // TUM creates 2 command lists to be executed Before & After application draw
         // these clear & resolve feedback buffers, coalescing all their barriers
@@ -175,6 +250,16 @@ namespace Streaming
 
         D3D12GpuTimer m_gpuTimerResolve; // time for feedback resolve
 
+        // chooses resources for feedback. learns resolve cost from m_gpuTimerResolve
+        FeedbackScheduler m_feedbackScheduler;
+        std::vector<FeedbackScheduler::Candidate> m_feedbackCandidates;
+        struct FeedbackCost
+        {
+            UINT m_numResolves{ 0 };
+            UINT64 m_numTexels{ 0 };
+        };
+        std::vector<FeedbackCost> m_feedbackCosts; // per frame index, resolves timed by m_gpuTimerResolve
+
         RawCpuTimer m_cpuTimer;
         std::atomic<INT64> m_processFeedbackTime{ 0 }; // sum of cpu timer times since start
         INT64 m_previousFeedbackTime{ 0 }; // m_processFeedbackTime at time of last query
@@ -96,6 +96,34 @@ namespace Streaming
             return m_dataUploader.GetMappingQueue();
         }
 
+        FileHandle* OpenFile(const std::wstring& in_path) const { return m_dataUploader.OpenFile(in_path); }
+
         void SetResidencyChanged() { m_residencyChangedFlag.Set(); }
+
+        // under backlog, prefer the low quality tier of files that have one
+        bool GetUseLowTier() const
+        {
+            return m_lowTierThreshold && (m_dataUploader.GetNumUpdateListsAllocated() >= m_lowTierThreshold);
+        }
+
+        void AddLowTierUploads(UINT in_numTiles, UINT64 in_numBytesSaved)
+        {
+            m_numTotalLowTierUploads.fetch_add(in_numTiles, std::memory_order_relaxed);
+            m_totalLowTierBytesSaved.fetch_add(in_numBytesSaved, std::memory_order_relaxed);
+        }
+
+        void AddUpgrades(UINT in_numTiles, UINT64 in_numBytes)
+        {
+            m_numTotalUpgrades.fetch_add(in_numTiles, std::memory_order_relaxed);
+            m_totalUpgradeBytes.fetch_add(in_numBytes, std::memory_order_relaxed);
+        }
+
+        // new pending loads, pending loads no longer wanted, and pending loads found already loading or resident
+        void AddPendingLoadStatistics(UINT in_numRequested, UINT in_numCancelled, UINT in_numRejected)
+        {
+            m_loadCounters.m_numTilesRequested.fetch_add(in_numRequested, std::memory_order_relaxed);
+            m_loadCounters.m_numTilesCancelled.fetch_add(in_numCancelled, std::memory_order_relaxed);
+            m_loadCounters.m_numTilesRejected.fetch_add(in_numRejected, std::memory_order_relaxed);
+        }
     };
 }
@@ -38,6 +38,8 @@ void Streaming::UpdateList::Reset(Streaming::StreamingResourceDU* in_pStreamingR
     m_copyFenceValid = false;
     m_coords.clear();         // indicates standard tile map & upload
     m_heapIndices.clear();    // because AddUpdate() does a push_back()
+    m_lowTier = false;        // full quality unless StreamingResource decides otherwise
+    m_numFileBytes = 0;       // computed on submit
     m_evictCoords.clear();    // indicates tiles to un-map
     m_copyLatencyTimer = 0;   // clear latency timer
 }
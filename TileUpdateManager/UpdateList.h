@@ -72,6 +72,8 @@ namespace Streaming
         // tile loads:
         std::vector<D3D12_TILED_RESOURCE_COORDINATE> m_coords; // tile coordinates
         std::vector<UINT> m_heapIndices;                       // indices into shared heap (for mapping)
+        bool m_lowTier{ false };                               // queue from the cheaper encoding where a tile has one. per tile: TileMappingState::GetLowTier()
+        UINT64 m_numFileBytes{ 0 };                            // bytes read from files for m_coords, as stored (compressed)
 
         // tile evictions:
         std::vector<D3D12_TILED_RESOURCE_COORDINATE> m_evictCoords;
@@ -30,12 +30,54 @@
 #include "DDS.h"
 #include "XeTexture.h"
 
+#include <mutex>
+#include <map>
+
 static void Error(std::wstring in_s)
 {
     MessageBox(0, in_s.c_str(), L"Error", MB_OK);
     exit(-1);
 }
 
+//-----------------------------------------------------------------------------
+// a store index is loaded once, then shared while any texture references it
+//-----------------------------------------------------------------------------
+static std::shared_ptr<const std::vector<XetStoreFileHeader::StoreEntry>> GetStoreIndex(const std::wstring& in_storeFileName, UINT32 in_compressionFormat)
+{
+    using StoreIndex = std::vector<XetStoreFileHeader::StoreEntry>;
+
+    static std::mutex mutex;
+    static std::map<std::wstring, std::weak_ptr<const StoreIndex>> cache;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto pIndex = cache[in_storeFileName].lock();
+    if (nullptr == pIndex)
+    {
+        std::wstring indexFileName = in_storeFileName + L".index";
+        std::ifstream inFile(indexFileName.c_str(), std::ios::binary);
+        if (inFile.fail()) { Error(indexFileName + L" File doesn't exist (?)"); }
+
+        XetStoreFileHeader header;
+        inFile.read((char*)&header, sizeof(header));
+        if ((!inFile.good()) || (header.m_magic != XetStoreFileHeader::GetMagic()) || (header.m_version != XetStoreFileHeader::GetVersion()))
+        {
+            Error(indexFileName + L" Not a valid tile store index");
+        }
+
+        auto pNewIndex = std::make_shared<StoreIndex>((size_t)header.m_numTiles);
+        inFile.read((char*)pNewIndex->data(), pNewIndex->size() * sizeof(XetStoreFileHeader::StoreEntry));
+        if (!inFile.good()) { Error(indexFileName + L" Unexpected Error reading tile store index"); }
+
+        // store tiles are decompressed using the format of the texture that references them
+        if (header.m_compressionFormat != in_compressionFormat) { Error(in_storeFileName + L" Tile store compression format differs from texture"); }
+
+        pIndex = pNewIndex;
+        cache[in_storeFileName] = pIndex;
+    }
+    return pIndex;
+}
+
 /*-----------------------------------------------------------------------------
 DDS format:
 UINT32 magic number
@@ -51,7 +93,7 @@ Streaming::XeTexture::XeTexture(const std::wstring& in_fileName)
     if (!inFile.good()) { Error(in_fileName + L" Unexpected Error reading header"); }
 
     if (m_fileHeader.m_magic != XetFileHeader::GetMagic()) { Error(in_fileName + L" Not a valid XET file"); }
-    if (m_fileHeader.m_version != XetFileHeader::GetVersion()) { Error(in_fileName + L" Incorrect XET version"); }
+    if (!XetFileHeader::IsSupportedVersion(m_fileHeader.m_version)) { Error(in_fileName + L" Incorrect XET version"); }
 
     m_subresourceInfo.resize(m_fileHeader.m_ddsHeader.mipMapCount);
     inFile.read((char*)m_subresourceInfo.data(), m_subresourceInfo.size() * sizeof(m_subresourceInfo[0]));
@@ -60,6 +102,124 @@ Streaming::XeTexture::XeTexture(const std::wstring& in_fileName)
     m_tileOffsets.resize(m_fileHeader.m_mipInfo.m_numTilesForStandardMips + 1); // plus 1 for the packed mips offset & size
     inFile.read((char*)m_tileOffsets.data(), m_tileOffsets.size() * sizeof(m_tileOffsets[0]));
     if (!inFile.good()) { Error(in_fileName + L" Unexpected Error reading packed mip info"); }
+
+    std::streamoff fileEnd = LoadStore(inFile, in_fileName);
+    if ((XetFileHeader::GetStoreVersion() == m_fileHeader.m_version) != (!m_storeFileName.empty()))
+    {
+        Error(in_fileName + L" XET version does not match tile store reference");
+    }
+    LoadLowTier(inFile, fileEnd);
+    LoadStats(in_fileName);
+}
+
+//-----------------------------------------------------------------------------
+// the tile store reference is optional. it is found via a footer at the end of the file
+// resolves tile hashes to offsets in the store
+// returns the end of the data that precedes the store section
+//-----------------------------------------------------------------------------
+std::streamoff Streaming::XeTexture::LoadStore(std::ifstream& in_file, const std::wstring& in_fileName)
+{
+    in_file.seekg(0, std::ios::end);
+    std::streamoff fileSize = in_file.tellg();
+    if (fileSize < (std::streamoff)sizeof(XetStoreFooter)) { return fileSize; }
+
+    XetStoreFooter footer;
+    in_file.seekg(fileSize - sizeof(footer));
+    in_file.read((char*)&footer, sizeof(footer));
+    if ((!in_file.good()) ||
+        (footer.m_magic != XetStoreFooter::GetMagic()) ||
+        (footer.m_version != XetStoreFooter::GetVersion()))
+    {
+        in_file.clear();
+        return fileSize;
+    }
+
+    if (footer.m_numTiles != m_fileHeader.m_mipInfo.m_numTilesForStandardMips) { Error(in_fileName + L" Tile store table does not match texture"); }
+
+    std::vector<UINT64> hashes(footer.m_numTiles);
+    std::wstring storeName(footer.m_storeNameBytes / sizeof(wchar_t), L'\0');
+    in_file.seekg(footer.m_tableOffset);
+    in_file.read((char*)hashes.data(), hashes.size() * sizeof(hashes[0]));
+    in_file.read((char*)storeName.data(), footer.m_storeNameBytes);
+    if (!in_file.good()) { Error(in_fileName + L" Unexpected Error reading tile store table"); }
+
+    // store name is relative to this file
+    m_storeFileName = (std::filesystem::path(in_fileName).parent_path() / storeName).wstring();
+    m_pStoreIndex = GetStoreIndex(m_storeFileName, m_fileHeader.m_compressionFormat);
+
+    m_storeOffsets.resize(hashes.size());
+    for (UINT i = 0; i < (UINT)hashes.size(); i++)
+    {
+        if (0 == hashes[i]) { continue; } // tile is in this file
+
+        auto e = std::lower_bound(m_pStoreIndex->begin(), m_pStoreIndex->end(), hashes[i],
+            [](const XetStoreFileHeader::StoreEntry& a, UINT64 b) { return a.m_hash < b; });
+        if ((m_pStoreIndex->end() == e) || (e->m_hash != hashes[i])) { Error(in_fileName + L" Tile missing from tile store " + m_storeFileName); }
+
+        m_storeOffsets[i].offset = e->m_offset;
+        m_storeOffsets[i].numBytes = e->m_numBytes;
+        m_storeOffsets[i].inStore = true;
+    }
+
+    return footer.m_sectionOffset;
+}
+
+//-----------------------------------------------------------------------------
+// the low tier is optional. it is found via a footer at the end of the file
+//-----------------------------------------------------------------------------
+void Streaming::XeTexture::LoadLowTier(std::ifstream& in_file, std::streamoff in_fileEnd)
+{
+    if (in_fileEnd < (std::streamoff)sizeof(XetTierFooter)) { return; }
+
+    XetTierFooter footer;
+    in_file.seekg(in_fileEnd - sizeof(footer));
+    in_file.read((char*)&footer, sizeof(footer));
+    if ((!in_file.good()) ||
+        (footer.m_magic != XetTierFooter::GetMagic()) ||
+        (footer.m_version != XetTierFooter::GetVersion()) ||
+        (footer.m_numTiles != m_fileHeader.m_mipInfo.m_numTilesForStandardMips))
+    {
+        return;
+    }
+
+    m_lowTierOffsets.resize(footer.m_numTiles);
+    in_file.seekg(footer.m_tableOffset);
+    in_file.read((char*)m_lowTierOffsets.data(), m_lowTierOffsets.size() * sizeof(m_lowTierOffsets[0]));
+    if (!in_file.good())
+    {
+        m_lowTierOffsets.clear();
+    }
+}
+
+//-----------------------------------------------------------------------------
+// statistics are optional. a missing or mismatched sidecar is ignored
+//-----------------------------------------------------------------------------
+void Streaming::XeTexture::LoadStats(const std::wstring& in_fileName)
+{
+    std::ifstream inFile((in_fileName + L".stats").c_str(), std::ios::binary);
+    if (inFile.fail()) { return; }
+
+    XetStatsFileHeader header;
+    inFile.read((char*)&header, sizeof(header));
+    if ((!inFile.good()) ||
+        (header.m_magic != XetStatsFileHeader::GetMagic()) ||
+        (header.m_version != XetStatsFileHeader::GetVersion()) ||
+        (header.m_numTiles != m_fileHeader.m_mipInfo.m_numTilesForStandardMips) ||
+        (header.m_numMips != m_fileHeader.m_mipInfo.m_numStandardMips))
+    {
+        return;
+    }
+
+    m_tileStats.resize(header.m_numTiles);
+    inFile.read((char*)m_tileStats.data(), m_tileStats.size() * sizeof(m_tileStats[0]));
+    m_mipStats.resize(header.m_numMips);
+    inFile.read((char*)m_mipStats.data(), m_mipStats.size() * sizeof(m_mipStats[0]));
+
+    if (!inFile.good())
+    {
+        m_tileStats.clear();
+        m_mipStats.clear();
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -88,8 +248,43 @@ Streaming::XeTexture::FileOffset Streaming::XeTexture::GetFileOffset(const D3D12
 {
     // use index to look up file offset and number of bytes
     UINT index = GetLinearIndex(in_coord);
+    if (m_storeOffsets.size() && m_storeOffsets[index].inStore)
+    {
+        return m_storeOffsets[index];
+    }
+
     FileOffset fileOffset;
     fileOffset.numBytes = m_tileOffsets[index].m_numBytes;
     fileOffset.offset = m_tileOffsets[index].m_offset;
     return fileOffset;
 }
+
+//-----------------------------------------------------------------------------
+// returns false, and leaves out_fileOffset unchanged, if there is no cheaper encoding for this tile
+//-----------------------------------------------------------------------------
+bool Streaming::XeTexture::GetLowTierFileOffset(const D3D12_TILED_RESOURCE_COORDINATE& in_coord, FileOffset& out_fileOffset) const
+{
+    if (m_lowTierOffsets.empty()) { return false; }
+
+    const auto& tileData = m_lowTierOffsets[GetLinearIndex(in_coord)];
+    if (0 == tileData.m_numBytes) { return false; }
+
+    out_fileOffset.offset = tileData.m_offset;
+    out_fileOffset.numBytes = tileData.m_numBytes;
+    out_fileOffset.inStore = false;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+const XetStatsFileHeader::TileStats* Streaming::XeTexture::GetTileStats(const D3D12_TILED_RESOURCE_COORDINATE& in_coord) const
+{
+    if (m_tileStats.empty()) { return nullptr; }
+    return &m_tileStats[GetLinearIndex(in_coord)];
+}
+
+const XetStatsFileHeader::MipStats* Streaming::XeTexture::GetMipStats(UINT in_mip) const
+{
+    if (in_mip >= m_mipStats.size()) { return nullptr; }
+    return &m_mipStats[in_mip];
+}
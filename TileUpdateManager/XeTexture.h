@@ -33,6 +33,8 @@ Holds the file handle
 
 #include <d3d12.h>
 #include <vector>
+#include <fstream>
+#include <memory>
 #include "Timer.h"
 
 #include "XetFileHeader.h"
@@ -49,11 +51,24 @@ namespace Streaming
         UINT32 GetCompressionFormat() const { return m_fileHeader.m_compressionFormat; }
 
         // return value is # bytes. out_offset is byte offset into file
-        struct FileOffset { UINT offset{ 0 }; UINT numBytes{ 0 }; };
+        // inStore: the offset is into the tile store (GetStoreFileName()), not this file
+        struct FileOffset { UINT64 offset{ 0 }; UINT numBytes{ 0 }; bool inStore{ false }; };
         FileOffset GetFileOffset(const D3D12_TILED_RESOURCE_COORDINATE& in_coord) const;
 
+        // content-addressed tile store shared with other textures (DdsToXet -store). empty if none
+        const std::wstring& GetStoreFileName() const { return m_storeFileName; }
+
         UINT GetPackedMipFileOffset(UINT* out_pNumBytesTotal, UINT* out_pNumBytesUncompressed) const;
 
+        // optional cheaper encoding written by DdsToXet -lowtier
+        // returns false if the tile has no low tier encoding (load the full quality tile)
+        bool GetHasLowTier() const { return m_lowTierOffsets.size(); }
+        bool GetLowTierFileOffset(const D3D12_TILED_RESOURCE_COORDINATE& in_coord, FileOffset& out_fileOffset) const;
+
+        // optional statistics from the <file>.stats sidecar written by DdsToXet. return nullptr if not available
+        const XetStatsFileHeader::TileStats* GetTileStats(const D3D12_TILED_RESOURCE_COORDINATE& in_coord) const;
+        const XetStatsFileHeader::MipStats* GetMipStats(UINT in_mip) const;
+
         XeTexture(const std::wstring& in_filename);
     protected:
         XeTexture(const XeTexture&) = delete;
@@ -68,6 +83,19 @@ namespace Streaming
 
         std::vector<XetFileHeader::SubresourceInfo> m_subresourceInfo;
         std::vector<XetFileHeader::TileData> m_tileOffsets;
+        std::vector<XetFileHeader::TileData> m_lowTierOffsets; // empty if no low tier
+        void LoadLowTier(std::ifstream& in_file, std::streamoff in_fileEnd);
+
+        // tile store. the index is shared by all textures referencing the same store
+        using StoreIndex = std::vector<XetStoreFileHeader::StoreEntry>;
+        std::shared_ptr<const StoreIndex> m_pStoreIndex;
+        std::wstring m_storeFileName;
+        std::vector<FileOffset> m_storeOffsets; // numBytes = 0 for tiles embedded in this file
+        std::streamoff LoadStore(std::ifstream& in_file, const std::wstring& in_fileName); // returns end of preceding data
+
+        std::vector<XetStatsFileHeader::TileStats> m_tileStats; // empty if no sidecar
+        std::vector<XetStatsFileHeader::MipStats> m_mipStats;
+        void LoadStats(const std::wstring& in_fileName);
 
         UINT GetLinearIndex(const D3D12_TILED_RESOURCE_COORDINATE& in_coord) const;
     };
@@ -44,6 +44,11 @@ struct XetFileHeader
     static UINT GetTileSize() { return 65536; } // uncompressed size
     static UINT GetVersion() { return 3; }
 
+    // files with tiles in a tile store (see XetStoreFooter) have TileData entries of { 0, 0 }
+    // they carry a different version so readers without tile store support reject them instead of streaming empty tiles
+    static UINT GetStoreVersion() { return 4; }
+    static bool IsSupportedVersion(UINT in_version) { return (GetVersion() == in_version) || (GetStoreVersion() == in_version); }
+
     UINT m_magic{ GetMagic() };
     UINT m_version{ GetVersion() };
     DirectX::DDS_HEADER m_ddsHeader;
@@ -105,3 +110,116 @@ struct XetFileHeader
     // 2nd: array TileData[m_numTilesForStandardMips + 1]
     // 3rd: packed mip data can be found at TileData[m_numTilesForStandardMips].m_offset TileData[m_numTilesForStandardMips].m_numBytes
 };
+
+/*-----------------------------------------------------------------------------
+Optional low-quality tier, appended after the packed mips by DdsToXet -lowtier
+The layout above is unchanged, so readers that ignore the tier still work.
+
+- Tier tile data. tiles are not aligned
+- Array TileData[m_numTiles], same order as XetFileHeader::TileData[] (standard tiles only)
+    m_numBytes = 0 means the tile has no cheaper encoding, load the full quality tile instead
+- XetTierFooter, the last bytes of the file
+
+-----------------------------------------------------------------------------*/
+struct XetTierFooter
+{
+    static UINT GetMagic() { return 0x54544558; } // "XETT"
+    static UINT GetVersion() { return 1; }
+
+    UINT32 m_numTiles{ 0 };    // must equal XetFileHeader::MipInfo::m_numTilesForStandardMips
+    UINT32 m_tableOffset{ 0 }; // file offset of the tier TileData[] array
+    UINT m_version{ GetVersion() };
+    UINT m_magic{ GetMagic() };
+};
+
+/*-----------------------------------------------------------------------------
+Optional reference to a content-addressed tile store, written by DdsToXet -store
+Tiles found in the store are not embedded. Their XetFileHeader::TileData entries are { 0, 0 }
+Present if and only if XetFileHeader::m_version is XetFileHeader::GetStoreVersion()
+This section follows everything else, including an optional low quality tier.
+
+- Array UINT64 hashes[m_numTiles], same order as XetFileHeader::TileData[] (standard tiles only)
+    hash of the uncompressed tile. 0 means the tile is embedded in this file
+- Store file name, m_storeNameBytes of UTF-16, relative to the directory of this file
+- XetStoreFooter, the last bytes of the file
+
+Store file (e.g. corpus.xets): XetStoreFileHeader padded to 4KB, then tile data, append-only
+    every tile starts on a 4KB boundary so it can be read with unbuffered file i/o
+Store index (e.g. corpus.xets.index): XetStoreFileHeader then StoreEntry[m_numTiles] sorted by hash
+
+-----------------------------------------------------------------------------*/
+struct XetStoreFooter
+{
+    static UINT GetMagic() { return 0x52544558; } // "XETR"
+    static UINT GetVersion() { return 1; }
+
+    UINT32 m_numTiles{ 0 };       // must equal XetFileHeader::MipInfo::m_numTilesForStandardMips
+    UINT32 m_tableOffset{ 0 };    // file offset of the hash array, followed by the store name
+    UINT32 m_storeNameBytes{ 0 };
+    UINT32 m_sectionOffset{ 0 };  // start of this section. preceding data (e.g. a low quality tier) ends here
+    UINT m_version{ GetVersion() };
+    UINT m_magic{ GetMagic() };
+};
+
+struct XetStoreFileHeader
+{
+    static UINT GetMagic() { return 0x44544558; } // "XETD"
+    static UINT GetVersion() { return 2; }
+
+    UINT m_magic{ GetMagic() };
+    UINT m_version{ GetVersion() };
+    UINT32 m_compressionFormat{ 0 }; // all tiles in a store share a compression format
+    UINT32 m_reserved{ 0 };
+    UINT64 m_numTiles{ 0 };          // # StoreEntry in the index
+
+    struct StoreEntry
+    {
+        UINT64 m_hash;     // of the uncompressed tile
+        UINT64 m_offset;   // into the store file
+        UINT32 m_numBytes;
+        UINT32 m_reserved;
+    };
+};
+
+/*-----------------------------------------------------------------------------
+Optional statistics sidecar written by DdsToXet as <file>.stats
+
+- Header
+- Array of per-tile statistics, same order as XetFileHeader::TileData[] (standard tiles only)
+- Array of per-mip summaries, one for each standard mip
+
+-----------------------------------------------------------------------------*/
+struct XetStatsFileHeader
+{
+    static UINT GetMagic() { return 0x53544558; } // "XETS"
+    static UINT GetVersion() { return 1; }
+
+    UINT m_magic{ GetMagic() };
+    UINT m_version{ GetVersion() };
+    UINT32 m_numTiles{ 0 }; // # TileStats entries
+    UINT32 m_numMips{ 0 };  // # MipStats entries
+
+    enum TileFlags : UINT32
+    {
+        TILE_FLAG_UNIFORM = 1,    // every BC block in the tile is identical
+        TILE_FLAG_COMPRESSED = 2  // stored compressed (compression reduced the size)
+    };
+
+    struct TileStats
+    {
+        UINT32 m_numBytes; // # bytes in the file
+        float m_entropy;   // of the uncompressed bytes, bits per byte [0..8]
+        UINT32 m_flags;    // TileFlags
+    };
+
+    struct MipStats
+    {
+        UINT32 m_numTiles;
+        UINT32 m_numUniformTiles;
+        UINT64 m_numBytes;     // total # bytes in the file
+        float m_averageEntropy;
+        UINT32 m_minTileBytes;
+        UINT32 m_maxTileBytes;
+        UINT32 m_reserved;
+    };
+};
@@ -0,0 +1,761 @@
+//*********************************************************
+//
+// Copyright 2020 Intel Corporation 
+//
+// Permission is hereby granted, free of charge, to any 
+// person obtaining a copy of this software and associated 
+// documentation files(the "Software"), to deal in the Software 
+// without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to 
+// whom the Software is furnished to do so, subject to the 
+// following conditions :
+// The above copyright notice and this permission notice shall 
+// be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+// DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+
+
+// runs benchmark scenarios several times, and compares the results to a stored baseline for this machine
+// fails (non-zero exit code) with a readable report if a metric got significantly worse than its threshold
+//
+// Windows: build benchmarkHarness.vcxproj, run from the directory containing expanse.exe
+// Linux, from the repository root:
+//     g++ -std=c++20 -O2 -Iinclude benchmarkHarness/benchmarkHarness.cpp -o benchmarkHarness
+//
+// benchmarkHarness [-scenarios file] [-baselines dir] [-machineClass name] [-runs n] [-filter substring]
+//                  [-outDir dir] [-report file] [-update]
+//
+// the scenario file (see config/benchmarks.json) lists commands to run. in a command, {out} is replaced by
+// a per-run path prefix. the command writes a json file (e.g. expanse -timingFileFrames, microbench -json)
+// metrics are paths into that file, e.g. "summary.bandwidth_MBps" or "benchmarks.RingBuffer/WriteRead.ns_per_op"
+// (arrays are searched by "name"), or measured by the harness: process.wall_s, process.cpu_s, process.peak_memory_MB
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <intrin.h>
+#else
+#include <unistd.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+#endif
+
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+
+#include "ConfigurationParser.h"
+
+//-----------------------------------------------------------------------------
+// process-level measurements of one run
+//-----------------------------------------------------------------------------
+struct ProcessResult
+{
+    bool m_started{ false };
+    bool m_timedOut{ false };
+    int m_exitCode{ -1 };
+    double m_wallSeconds{ 0 };
+    double m_cpuSeconds{ 0 };     // user + kernel, including child processes
+    double m_peakMemoryMB{ 0 };   // Windows: peak committed memory of any process in the tree. Linux: peak resident set
+};
+
+#ifdef _WIN32
+//-----------------------------------------------------------------------------
+// cmd.exe runs the command so batch files work. a job object accounts for cmd.exe and everything it starts
+//-----------------------------------------------------------------------------
+ProcessResult RunProcess(const std::string& in_command, double in_timeoutSeconds)
+{
+    ProcessResult result;
+
+    HANDLE job = CreateJobObject(nullptr, nullptr);
+    if (nullptr == job) { return result; }
+
+    // if the harness is killed, so are the benchmarks
+    JOBOBJECT_EXTENDED_LIMIT_INFORMATION limits{};
+    limits.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+    SetInformationJobObject(job, JobObjectExtendedLimitInformation, &limits, sizeof(limits));
+
+    std::string commandLine = "cmd.exe /c " + in_command;
+    STARTUPINFOA startupInfo{ sizeof(startupInfo) };
+    PROCESS_INFORMATION processInfo{};
+
+    const auto start = std::chrono::steady_clock::now();
+    if (!CreateProcessA(nullptr, commandLine.data(), nullptr, nullptr, FALSE, CREATE_SUSPENDED,
+        nullptr, nullptr, &startupInfo, &processInfo))
+    {
+        CloseHandle(job);
+        return result;
+    }
+    result.m_started = true;
+    AssignProcessToJobObject(job, processInfo.hProcess);
+    ResumeThread(processInfo.hThread);
+
+    DWORD timeoutMs = (in_timeoutSeconds > 0) ? DWORD(in_timeoutSeconds * 1000) : INFINITE;
+    if (WAIT_TIMEOUT == WaitForSingleObject(processInfo.hProcess, timeoutMs))
+    {
+        result.m_timedOut = true;
+        TerminateJobObject(job, uint32_t(-1));
+        WaitForSingleObject(processInfo.hProcess, INFINITE);
+    }
+    result.m_wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    DWORD exitCode = 0;
+    GetExitCodeProcess(processInfo.hProcess, &exitCode);
+    result.m_exitCode = int(exitCode);
+
+    // 100ns units
+    JOBOBJECT_BASIC_ACCOUNTING_INFORMATION accounting{};
+    if (QueryInformationJobObject(job, JobObjectBasicAccountingInformation, &accounting, sizeof(accounting), nullptr))
+    {
+        result.m_cpuSeconds = double(accounting.TotalUserTime.QuadPart + accounting.TotalKernelTime.QuadPart) / 1e7;
+    }
+    if (QueryInformationJobObject(job, JobObjectExtendedLimitInformation, &limits, sizeof(limits), nullptr))
+    {
+        result.m_peakMemoryMB = double(limits.PeakProcessMemoryUsed) / (1024. * 1024.);
+    }
+
+    CloseHandle(processInfo.hThread);
+    CloseHandle(processInfo.hProcess);
+    CloseHandle(job);
+    return result;
+}
+#else
+//-----------------------------------------------------------------------------
+// sh runs the command in its own process group, so a timeout can kill everything it started
+//-----------------------------------------------------------------------------
+ProcessResult RunProcess(const std::string& in_command, double in_timeoutSeconds)
+{
+    ProcessResult result;
+
+    const auto start = std::chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid < 0) { return result; }
+    if (0 == pid)
+    {
+        setpgid(0, 0);
+        execl("/bin/sh", "sh", "-c", in_command.c_str(), (char*)nullptr);
+        _exit(127);
+    }
+    result.m_started = true;
+
+    int status = 0;
+    rusage usage{};
+    while (true)
+    {
+        pid_t done = wait4(pid, &status, WNOHANG, &usage);
+        if (done == pid) { break; }
+        if (done < 0) { return result; }
+
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if ((in_timeoutSeconds > 0) && (elapsed > in_timeoutSeconds) && !result.m_timedOut)
+        {
+            result.m_timedOut = true;
+            kill(-pid, SIGKILL);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    result.m_wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.m_exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+
+    // wait4() reports sh plus the children it waited for
+    result.m_cpuSeconds = double(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)
+        + double(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+    result.m_peakMemoryMB = double(usage.ru_maxrss) / 1024.; // KB
+
+    return result;
+}
+#endif
+
+//-----------------------------------------------------------------------------
+// baselines are per machine class: cpu model + # logical cores, unless -machineClass names one
+// e.g. to distinguish GPUs, which matter to expanse but are not detected here
+//-----------------------------------------------------------------------------
+std::string GetMachineClass()
+{
+    std::string brand;
+#if defined(_M_X64) || defined(_M_IX86)
+    int regs[4]{};
+    __cpuid(regs, 0x80000000);
+    if (uint32_t(regs[0]) >= 0x80000004)
+    {
+        char name[49]{};
+        for (int i = 0; i < 3; i++)
+        {
+            __cpuid(regs, 0x80000002 + i);
+            std::memcpy(name + i * 16, regs, 16);
+        }
+        brand = name;
+    }
+#elif defined(__x86_64__) || defined(__i386__)
+    unsigned int regs[4]{};
+    if (__get_cpuid(0x80000000, &regs[0], &regs[1], &regs[2], &regs[3]) && (regs[0] >= 0x80000004))
+    {
+        char name[49]{};
+        for (unsigned int i = 0; i < 3; i++)
+        {
+            __get_cpuid(0x80000002 + i, &regs[0], &regs[1], &regs[2], &regs[3]);
+            std::memcpy(name + i * 16, regs, 16);
+        }
+        brand = name;
+    }
+#endif
+    if (brand.empty()) { brand = "unknown-cpu"; }
+    brand += "-" + std::to_string(std::thread::hardware_concurrency()) + "t";
+
+    // usable as a file name: collapse everything else to single dashes
+    std::string machineClass;
+    for (char c : brand)
+    {
+        if (std::isalnum((unsigned char)c)) { machineClass.push_back((char)std::tolower((unsigned char)c)); }
+        else if (machineClass.size() && ('-' != machineClass.back())) { machineClass.push_back('-'); }
+    }
+    while (machineClass.size() && ('-' == machineClass.back())) { machineClass.pop_back(); }
+    return machineClass;
+}
+
+//-----------------------------------------------------------------------------
+// two-sided critical value of Student's t distribution
+//-----------------------------------------------------------------------------
+double GetCriticalT(double in_confidence, double in_degreesOfFreedom)
+{
+    static const double t90[] = { 6.314, 2.920, 2.353, 2.132, 2.015, 1.943, 1.895, 1.860, 1.833, 1.812,
+        1.796, 1.782, 1.771, 1.761, 1.753, 1.746, 1.740, 1.734, 1.729, 1.725,
+        1.721, 1.717, 1.714, 1.711, 1.708, 1.706, 1.703, 1.701, 1.699, 1.697 };
+    static const double t95[] = { 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042 };
+    static const double t99[] = { 63.657, 9.925, 5.841, 4.604, 4.032, 3.707, 3.499, 3.355, 3.250, 3.169,
+        3.106, 3.055, 3.012, 2.977, 2.947, 2.921, 2.898, 2.878, 2.861, 2.845,
+        2.831, 2.819, 2.807, 2.797, 2.787, 2.779, 2.771, 2.763, 2.756, 2.750 };
+    const double* pTable = t95;
+    double z = 1.960;
+    if (in_confidence < 0.925) { pTable = t90; z = 1.645; }
+    else if (in_confidence > 0.975) { pTable = t99; z = 2.576; }
+
+    // non-integer degrees of freedom (Welch) round down, which is conservative
+    uint32_t df = uint32_t(std::max(1.0, std::floor(in_degreesOfFreedom)));
+    if (df <= 30) { return pTable[df - 1]; }
+
+    // beyond the table, the first correction to the normal approximation
+    return z + (z * z * z + z) / (4.0 * df);
+}
+
+//-----------------------------------------------------------------------------
+// mean and spread of one metric over the runs of a scenario
+//-----------------------------------------------------------------------------
+struct Sample
+{
+    double m_mean{ 0 };
+    double m_stddev{ 0 };  // sample standard deviation, 0 with fewer than 2 runs
+    uint32_t m_numRuns{ 0 };
+
+    Sample() {}
+    Sample(const std::vector<double>& in_values)
+    {
+        m_numRuns = (uint32_t)in_values.size();
+        if (0 == m_numRuns) { return; }
+        for (double v : in_values) { m_mean += v; }
+        m_mean /= m_numRuns;
+        if (m_numRuns > 1)
+        {
+            double sumSquares = 0;
+            for (double v : in_values) { sumSquares += (v - m_mean) * (v - m_mean); }
+            m_stddev = std::sqrt(sumSquares / (m_numRuns - 1));
+        }
+    }
+
+    // half-width of the confidence interval of the mean
+    double GetInterval(double in_confidence) const
+    {
+        if (m_numRuns < 2) { return 0; }
+        return GetCriticalT(in_confidence, m_numRuns - 1) * m_stddev / std::sqrt(double(m_numRuns));
+    }
+
+    double GetVarianceOfMean() const { return m_numRuns ? m_stddev * m_stddev / m_numRuns : 0; }
+};
+
+//-----------------------------------------------------------------------------
+// Welch's t-test: are the means different, without assuming equal variances?
+// with a single run on either side there is no estimate of the noise, so only the threshold applies
+//-----------------------------------------------------------------------------
+bool IsSignificant(const Sample& in_a, const Sample& in_b, double in_confidence)
+{
+    if ((in_a.m_numRuns < 2) || (in_b.m_numRuns < 2)) { return true; }
+
+    const double va = in_a.GetVarianceOfMean();
+    const double vb = in_b.GetVarianceOfMean();
+    const double variance = va + vb;
+    if (variance <= 0) { return in_a.m_mean != in_b.m_mean; }
+
+    const double t = std::abs(in_a.m_mean - in_b.m_mean) / std::sqrt(variance);
+    const double df = (variance * variance) /
+        ((va * va) / (in_a.m_numRuns - 1) + (vb * vb) / (in_b.m_numRuns - 1));
+    return t > GetCriticalT(in_confidence, df);
+}
+
+//=============================================================================
+// what to run, and how to judge it
+//=============================================================================
+struct MetricDesc
+{
+    std::string m_name;
+    bool m_higherIsBetter{ false };
+    double m_thresholdPercent{ 10 }; // worse than the baseline by more than this is a regression
+};
+
+struct Scenario
+{
+    std::string m_name;
+    std::string m_command;
+    std::string m_results;          // json file written by the command, may contain {out}
+    uint32_t m_numRuns{ 5 };
+    uint32_t m_numWarmupRuns{ 0 };      // run first and discarded, e.g. to fill the file cache
+    double m_timeoutSeconds{ 600 };
+    std::vector<MetricDesc> m_metrics;
+};
+
+//-----------------------------------------------------------------------------
+// replace every {out} with the per-run path prefix
+//-----------------------------------------------------------------------------
+std::string ExpandOut(std::string in_string, const std::string& in_out)
+{
+    const std::string token = "{out}";
+    for (size_t pos = in_string.find(token); std::string::npos != pos; pos = in_string.find(token, pos + in_out.size()))
+    {
+        in_string.replace(pos, token.size(), in_out);
+    }
+    return in_string;
+}
+
+//-----------------------------------------------------------------------------
+// "a.b.c": named values, or array elements whose "name" matches
+// returns false if the path does not lead to a value
+//-----------------------------------------------------------------------------
+bool FindValue(const ConfigurationParser::KVP& in_root, const std::string& in_path, double& out_value)
+{
+    const ConfigurationParser::KVP* pNode = &in_root;
+
+    std::stringstream path(in_path);
+    std::string element;
+    while (std::getline(path, element, '.'))
+    {
+        const ConfigurationParser::KVP* pNext = nullptr;
+        if (pNode->isMember(element))
+        {
+            pNext = &(*pNode)[element];
+        }
+        else
+        {
+            for (const auto& v : *pNode)
+            {
+                if (v.isMember("name") && (element == v["name"].asString()))
+                {
+                    pNext = &v;
+                    break;
+                }
+            }
+        }
+        if (nullptr == pNext) { return false; }
+        pNode = pNext;
+    }
+
+    if (pNode->size() || pNode->asString().empty()) { return false; }
+    try
+    {
+        out_value = std::stod(pNode->asString());
+    }
+    catch (...)
+    {
+        return false;
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// measured by the harness rather than read from the results file
+//-----------------------------------------------------------------------------
+bool FindProcessValue(const ProcessResult& in_process, const std::string& in_name, double& out_value)
+{
+    if ("process.wall_s" == in_name) { out_value = in_process.m_wallSeconds; }
+    else if ("process.cpu_s" == in_name) { out_value = in_process.m_cpuSeconds; }
+    else if ("process.peak_memory_MB" == in_name) { out_value = in_process.m_peakMemoryMB; }
+    else { return false; }
+    return true;
+}
+
+//=============================================================================
+// baseline file: for each scenario, each metric's mean, stddev, and # runs
+//=============================================================================
+using Baseline = std::map<std::string, std::map<std::string, Sample>>;
+
+bool ReadBaseline(const std::filesystem::path& in_path, Baseline& out_baseline)
+{
+    if (!std::filesystem::exists(in_path)) { return false; }
+
+    ConfigurationParser parser;
+    if (!parser.Read(in_path.wstring())) { return false; }
+
+    for (const auto& scenario : parser.GetRoot()["scenarios"])
+    {
+        auto& metrics = out_baseline[scenario["name"].asString()];
+        for (const auto& metric : scenario["metrics"])
+        {
+            Sample& s = metrics[metric["name"].asString()];
+            s.m_mean = metric["mean"].asDouble();
+            s.m_stddev = metric["stddev"].asDouble();
+            s.m_numRuns = metric["runs"].asUInt();
+        }
+    }
+    return true;
+}
+
+void WriteBaseline(const std::filesystem::path& in_path, const std::string& in_machineClass, const Baseline& in_baseline)
+{
+    ConfigurationParser parser;
+    auto& root = parser.GetRoot();
+    root["machineClass"] = in_machineClass;
+
+    int scenarioIndex = 0;
+    for (const auto& [scenarioName, metrics] : in_baseline)
+    {
+        auto& scenario = root["scenarios"][scenarioIndex++];
+        scenario["name"] = scenarioName;
+        int metricIndex = 0;
+        for (const auto& [metricName, sample] : metrics)
+        {
+            auto& metric = scenario["metrics"][metricIndex++];
+            metric["name"] = metricName;
+            metric["mean"] = sample.m_mean;
+            metric["stddev"] = sample.m_stddev;
+            metric["runs"] = sample.m_numRuns;
+        }
+    }
+
+    if (in_path.has_parent_path())
+    {
+        std::filesystem::create_directories(in_path.parent_path());
+    }
+    parser.Write(in_path.wstring());
+}
+
+//-----------------------------------------------------------------------------
+// read the scenario file. returns false if there are no scenarios
+//-----------------------------------------------------------------------------
+bool ReadScenarios(const std::string& in_fileName, std::vector<Scenario>& out_scenarios, double& out_confidence, int in_numRuns)
+{
+    ConfigurationParser parser;
+    if (!parser.Read(std::filesystem::path(in_fileName).wstring())) { return false; }
+    const auto& root = parser.GetRoot();
+
+    out_confidence = root.get("confidence", 0.95).asDouble();
+    const uint32_t defaultRuns = root.get("runs", 5).asUInt();
+
+#ifdef _WIN32
+    const std::string platform = "windows";
+#else
+    const std::string platform = "linux";
+#endif
+
+    for (const auto& s : root["scenarios"])
+    {
+        // e.g. a command line that only exists on one platform
+        const std::string scenarioPlatform = s.get("platform", "").asString();
+        if (scenarioPlatform.size() && (platform != scenarioPlatform)) { continue; }
+
+        Scenario scenario;
+        scenario.m_name = s["name"].asString();
+        scenario.m_command = s["command"].asString();
+        scenario.m_results = s.get("results", "").asString();
+        scenario.m_numRuns = std::max(1u, (in_numRuns > 0) ? uint32_t(in_numRuns) : s.get("runs", defaultRuns).asUInt());
+        scenario.m_numWarmupRuns = s.get("warmup", 0).asUInt();
+        scenario.m_timeoutSeconds = s.get("timeout_s", 600).asDouble();
+
+        for (const auto& m : s["metrics"])
+        {
+            MetricDesc metric;
+            metric.m_name = m["name"].asString();
+            metric.m_higherIsBetter = ("higher" == m.get("better", "lower").asString());
+            metric.m_thresholdPercent = m.get("threshold", 10).asDouble();
+            scenario.m_metrics.push_back(metric);
+        }
+        out_scenarios.push_back(scenario);
+    }
+    return out_scenarios.size() > 0;
+}
+
+//=============================================================================
+//=============================================================================
+int main(int argc, char** argv)
+{
+    std::string scenarioFileName = "benchmarks.json";
+    std::string baselineDir = "baselines";
+    std::string outDir = "benchmarkResults";
+    std::string machineClass;
+    std::string filter;
+    std::string reportFileName;
+    int numRuns = 0;
+    bool update = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        const bool haveValue = (i + 1) < argc;
+        if (("-scenarios" == arg) && haveValue) { scenarioFileName = argv[++i]; }
+        else if (("-baselines" == arg) && haveValue) { baselineDir = argv[++i]; }
+        else if (("-machineClass" == arg) && haveValue) { machineClass = argv[++i]; }
+        else if (("-runs" == arg) && haveValue) { numRuns = std::atoi(argv[++i]); }
+        else if (("-filter" == arg) && haveValue) { filter = argv[++i]; }
+        else if (("-outDir" == arg) && haveValue) { outDir = argv[++i]; }
+        else if (("-report" == arg) && haveValue) { reportFileName = argv[++i]; }
+        else if ("-update" == arg) { update = true; }
+        else
+        {
+            std::cerr << "usage: benchmarkHarness [-scenarios file] [-baselines dir] [-machineClass name] [-runs n] "
+                "[-filter substring] [-outDir dir] [-report file] [-update]" << std::endl;
+            return -1;
+        }
+    }
+
+    std::vector<Scenario> scenarios;
+    double confidence = 0.95;
+    if (!ReadScenarios(scenarioFileName, scenarios, confidence, numRuns))
+    {
+        std::cerr << "No scenarios for this platform in " << scenarioFileName << std::endl;
+        return -1;
+    }
+
+    if (machineClass.empty()) { machineClass = GetMachineClass(); }
+    const std::filesystem::path baselinePath = std::filesystem::path(baselineDir) / (machineClass + ".json");
+    Baseline baseline;
+    const bool haveBaseline = ReadBaseline(baselinePath, baseline);
+
+    std::cout << "machine class: " << machineClass << "\nbaseline: " << baselinePath.string()
+        << (haveBaseline ? "" : " (not found)") << std::endl;
+
+    // the report is printed at the end, so it isn't interleaved with output from the benchmarks
+    std::stringstream report;
+    report << std::fixed;
+    std::vector<std::string> failures;
+    uint32_t numImproved = 0;
+
+    const int confidencePercent = int(std::lround(confidence * 100));
+
+    for (const auto& scenario : scenarios)
+    {
+        if (filter.size() && (std::string::npos == scenario.m_name.find(filter))) { continue; }
+
+        std::map<std::string, std::vector<double>> values;
+        uint32_t numFailedRuns = 0;
+
+        for (uint32_t run = 0; run < scenario.m_numWarmupRuns + scenario.m_numRuns; run++)
+        {
+            const bool warmup = run < scenario.m_numWarmupRuns;
+
+            // a fresh directory, e.g. because expanse picks the first unused timing file name
+            const std::filesystem::path runDir = std::filesystem::path(outDir) / scenario.m_name /
+                (warmup ? "warmup" : ("run" + std::to_string(run - scenario.m_numWarmupRuns + 1)));
+            std::error_code error;
+            std::filesystem::remove_all(runDir, error);
+            std::filesystem::create_directories(runDir, error);
+            const std::string out = (runDir / "result").make_preferred().string();
+
+            std::cout << scenario.m_name << (warmup ? " warmup" : " run " + std::to_string(run - scenario.m_numWarmupRuns + 1))
+                << "/" << scenario.m_numRuns << ": " << std::flush;
+
+            // the benchmark's own output goes to a log, so progress and the report stay readable
+            const std::string logFileName = (runDir / "output.txt").make_preferred().string();
+            const std::string command = ExpandOut(scenario.m_command, out) + " > \"" + logFileName + "\" 2>&1";
+            const ProcessResult process = RunProcess(command, scenario.m_timeoutSeconds);
+
+            std::string problem;
+            if (!process.m_started) { problem = "failed to start"; }
+            else if (process.m_timedOut) { problem = "timed out after " + std::to_string(int(scenario.m_timeoutSeconds)) + "s, see " + logFileName; }
+            else if (0 != process.m_exitCode) { problem = "exit code " + std::to_string(process.m_exitCode) + ", see " + logFileName; }
+
+            ConfigurationParser results;
+            const std::string resultsFileName = ExpandOut(scenario.m_results, out);
+            if (problem.empty() && resultsFileName.size() &&
+                !(std::filesystem::exists(resultsFileName) && results.Read(std::filesystem::path(resultsFileName).wstring())))
+            {
+                problem = "no results file " + resultsFileName;
+            }
+
+            if (problem.empty())
+            {
+                for (const auto& metric : scenario.m_metrics)
+                {
+                    double value = 0;
+                    if (FindProcessValue(process, metric.m_name, value) || FindValue(results.GetRoot(), metric.m_name, value))
+                    {
+                        if (!warmup) { values[metric.m_name].push_back(value); }
+                    }
+                    else
+                    {
+                        problem = "no value for " + metric.m_name + " in " + resultsFileName;
+                        break;
+                    }
+                }
+            }
+
+            std::cout << std::fixed << std::setprecision(1) << process.m_wallSeconds << "s"
+                << (problem.size() ? ", " + problem : "") << std::endl;
+            if (problem.size())
+            {
+                if (!warmup) { numFailedRuns++; }
+                failures.push_back(scenario.m_name + ": " + problem);
+            }
+        }
+
+        report << "\n" << scenario.m_name << ": " << scenario.m_numRuns - numFailedRuns << " of " << scenario.m_numRuns
+            << " runs succeeded\n";
+        report << std::left << std::setw(52) << "  metric" << std::right
+            << std::setw(26) << ("mean +/- " + std::to_string(confidencePercent) + "%")
+            << std::setw(26) << "baseline" << std::setw(10) << "change" << "  status\n";
+
+        for (const auto& metric : scenario.m_metrics)
+        {
+            const Sample current(values[metric.m_name]);
+            if (0 == current.m_numRuns) { continue; }
+
+            auto formatSample = [&](const Sample& in_sample)
+            {
+                std::stringstream s;
+                s << std::setprecision(in_sample.m_mean < 10 ? 4 : 1) << std::fixed << in_sample.m_mean
+                    << " +/- " << in_sample.GetInterval(confidence);
+                return s.str();
+            };
+
+            report << "  " << std::left << std::setw(50) << metric.m_name << std::right
+                << std::setw(26) << formatSample(current);
+
+            const auto scenarioBaseline = baseline.find(scenario.m_name);
+            const Sample* pBaseline = nullptr;
+            if (scenarioBaseline != baseline.end())
+            {
+                const auto b = scenarioBaseline->second.find(metric.m_name);
+                if (b != scenarioBaseline->second.end()) { pBaseline = &b->second; }
+            }
+            if ((nullptr == pBaseline) || (0 == pBaseline->m_numRuns))
+            {
+                report << std::setw(26) << "-" << std::setw(10) << "-" << "  no baseline\n";
+                continue;
+            }
+
+            // positive is worse
+            double changePercent = 0;
+            if (0 != pBaseline->m_mean)
+            {
+                changePercent = 100.0 * (current.m_mean - pBaseline->m_mean) / std::abs(pBaseline->m_mean);
+            }
+            else if (current.m_mean != 0)
+            {
+                changePercent = (current.m_mean > 0) ? 100.0 : -100.0;
+            }
+            const double worsePercent = metric.m_higherIsBetter ? -changePercent : changePercent;
+            const bool significant = IsSignificant(current, *pBaseline, confidence);
+
+            std::string status = "ok";
+            if (significant && (worsePercent > metric.m_thresholdPercent))
+            {
+                std::stringstream s;
+                s << std::setprecision(1) << std::fixed << "REGRESSED (" << worsePercent << "% worse, threshold "
+                    << metric.m_thresholdPercent << "%)";
+                status = s.str();
+
+                std::stringstream failure;
+                failure << std::setprecision(4) << std::defaultfloat << scenario.m_name << ": " << metric.m_name
+                    << " " << pBaseline->m_mean << " -> " << current.m_mean << " ("
+                    << (metric.m_higherIsBetter ? "higher" : "lower") << " is better), "
+                    << std::setprecision(1) << std::fixed << worsePercent << "% worse than baseline, threshold "
+                    << metric.m_thresholdPercent << "%";
+                failures.push_back(failure.str());
+            }
+            else if (significant && (-worsePercent > metric.m_thresholdPercent))
+            {
+                status = "improved";
+                numImproved++;
+            }
+            else if (!significant && (std::abs(worsePercent) > metric.m_thresholdPercent))
+            {
+                status = "ok (within noise)";
+            }
+
+            std::stringstream change;
+            change << std::setprecision(1) << std::fixed << std::showpos << changePercent << "%";
+            report << std::setw(26) << formatSample(*pBaseline) << std::setw(10) << change.str() << "  " << status << "\n";
+        }
+
+        // replace this scenario's baseline. other scenarios, e.g. ones not selected by -filter, are kept
+        if (update && (0 == numFailedRuns))
+        {
+            auto& metrics = baseline[scenario.m_name];
+            metrics.clear();
+            for (const auto& metric : scenario.m_metrics)
+            {
+                metrics[metric.m_name] = Sample(values[metric.m_name]);
+            }
+        }
+    }
+
+    report << "\n";
+    if (failures.size())
+    {
+        report << failures.size() << " problem(s):\n";
+        for (const auto& f : failures) { report << "  " << f << "\n"; }
+    }
+    else
+    {
+        report << "no regressions";
+        if (!haveBaseline) { report << " (no baseline: run with -update to create " << baselinePath.string() << ")"; }
+        report << "\n";
+    }
+    if (numImproved)
+    {
+        report << numImproved << " metric(s) improved beyond their threshold: consider -update\n";
+    }
+
+    if (update)
+    {
+        WriteBaseline(baselinePath, machineClass, baseline);
+        report << "baseline written to " << baselinePath.string() << "\n";
+    }
+
+    std::cout << report.str();
+    if (reportFileName.size())
+    {
+        std::ofstream ofs(reportFileName);
+        ofs << "machine class: " << machineClass << "\nbaseline: " << baselinePath.string() << "\n" << report.str();
+    }
+
+    // # of regressions and failed runs
+    return int(std::min(failures.size(), size_t(255)));
+}
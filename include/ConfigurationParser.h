@@ -91,6 +91,7 @@ Known issues:
 #include <algorithm>
 #include <iomanip>
 #include <iostream> // for cerr
+#include <filesystem> // for portable wide file names
 
 //=============================================================================
 //=============================================================================
@@ -176,6 +177,11 @@ public:
     //-------------------------------------------------------------------------
     bool Read(const std::wstring& in_filePath);
 
+    //-------------------------------------------------------------------------
+    // parse the contents of a file already in memory
+    //-------------------------------------------------------------------------
+    void Parse(std::string& in_text);
+
     //-------------------------------------------------------------------------
     // write file
     //-------------------------------------------------------------------------
@@ -317,6 +323,9 @@ private:
     //-------------------------------------------------------------------------
     uint32_t ReadArray(KVP& out_value, const Tokens& in_tokens, uint32_t in_tokenIndex)
     {
+        // empty array: []
+        if ((in_tokenIndex < in_tokens.size()) && (']' == in_tokens[in_tokenIndex][0])) { return in_tokenIndex + 1; }
+
         while (1)
         {
             if (in_tokenIndex + 3 >= in_tokens.size()) ParseError(in_tokens, in_tokenIndex);
@@ -352,6 +361,9 @@ private:
     //-------------------------------------------------------------------------
     uint32_t ReadBlock(KVP& out_value, const Tokens& in_tokens, uint32_t in_tokenIndex)
     {
+        // empty block: {}
+        if ((in_tokenIndex < in_tokens.size()) && ('}' == in_tokens[in_tokenIndex][0])) { return in_tokenIndex + 1; }
+
         while (1)
         {
             if (in_tokenIndex + 3 >= in_tokens.size()) ParseError(in_tokens, in_tokenIndex);
@@ -386,21 +398,28 @@ private:
 //-------------------------------------------------------------------------
 inline bool ConfigurationParser::Read(const std::wstring& in_filePath)
 {
-    std::ifstream ifs(in_filePath, std::ios::in | std::ifstream::binary);
+    std::ifstream ifs(std::filesystem::path(in_filePath), std::ios::in | std::ifstream::binary);
     bool success = ifs.good();
     if (success)
     {
         std::string stream((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+        Parse(stream);
+    }
 
-        Tokens tokens;
-        Tokenize(tokens, stream);
+    return success;
+}
 
-        if ("{" != tokens[0]) ParseError(tokens, 0);
+//-------------------------------------------------------------------------
+// parse text
+//-------------------------------------------------------------------------
+inline void ConfigurationParser::Parse(std::string& in_text)
+{
+    Tokens tokens;
+    Tokenize(tokens, in_text);
 
-        ReadBlock(m_value, tokens, 1);
-    }
+    if ("{" != tokens[0]) ParseError(tokens, 0);
 
-    return success;
+    ReadBlock(m_value, tokens, 1);
 }
 
 //-------------------------------------------------------------------------
@@ -408,7 +427,7 @@ inline bool ConfigurationParser::Read(const std::wstring& in_filePath)
 //-------------------------------------------------------------------------
 inline void ConfigurationParser::Write(const std::wstring& in_filePath) const
 {
-    std::ofstream ofs(in_filePath, std::ios::out);
+    std::ofstream ofs(std::filesystem::path(in_filePath), std::ios::out);
     bool success = !ofs.bad();
     if (success)
     {
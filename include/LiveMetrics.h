@@ -0,0 +1,110 @@
+//*********************************************************
+//
+// Copyright 2020 Intel Corporation 
+//
+// Permission is hereby granted, free of charge, to any 
+// person obtaining a copy of this software and associated 
+// documentation files(the "Software"), to deal in the Software 
+// without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to 
+// whom the Software is furnished to do so, subject to the 
+// following conditions :
+// The above copyright notice and this permission notice shall 
+// be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+// DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+
+
+#pragma once
+
+#include <atomic>
+
+//=============================================================================
+// Live metrics: a ring of streaming statistics samples in named shared memory
+// written by expanse (-liveMetrics name), read by metricsReader (-name name)
+//
+// layout (x64, little-endian, fields naturally aligned):
+//   Header, then Header::m_numSamples Samples, each Header::m_sampleSize bytes, starting at Header::m_headerSize
+//
+// the single writer fills sample n at index (n % m_numSamples), then sets Header::m_numWritten to n + 1
+// each Sample::m_sequence is odd while the sample is being written and 2 * (n + 1) once it holds sample n
+// a reader copies a sample, then re-reads m_sequence; the copy is valid if both reads equal 2 * (n + 1)
+// the writer never waits for readers. a reader more than m_numSamples behind has lost samples
+//
+// new fields are only appended to Sample. readers must use m_headerSize and m_sampleSize as strides,
+// and reject a different m_version (which changes only if existing fields move or change meaning)
+//=============================================================================
+namespace LiveMetrics
+{
+    constexpr UINT32 MAGIC = 0x4D534653; // "SFSM"
+    constexpr UINT32 VERSION = 1;
+    constexpr UINT32 NUM_SAMPLES = 256;
+
+    // kernel object names are per-session with this prefix
+    constexpr const wchar_t* NAME_PREFIX = L"Local\\";
+
+    struct Header
+    {
+        UINT32 m_magic;
+        UINT32 m_version;
+        UINT32 m_headerSize;             // offset of the first sample
+        UINT32 m_sampleSize;             // stride between samples
+        UINT32 m_numSamples;             // ring size
+        UINT32 m_processId;              // of the writer
+        UINT32 m_intervalMs;             // target time between samples
+        UINT32 m_numHeapTiles;           // capacity of all streaming heaps, 64KB tiles
+        UINT64 m_stagingBytesCapacity;
+        std::atomic<UINT64> m_numWritten; // samples written so far. the latest is m_numWritten - 1
+    };
+
+    // totals are since the writer started. "interval" values cover the time since the previous sample
+    struct Sample
+    {
+        std::atomic<UINT64> m_sequence;
+
+        UINT64 m_timeUs;                 // microseconds since the writer started
+        UINT64 m_frameNumber;
+
+        // totals
+        UINT64 m_numTilesRequested;
+        UINT64 m_numTilesUploaded;
+        UINT64 m_numTilesEvicted;
+        UINT64 m_compressedBytesRead;
+        UINT64 m_uncompressedBytesRead;
+
+        // backlog, current
+        UINT64 m_numTilesInFlight;       // queued, not yet uploaded
+        UINT64 m_numUpdateListsBusy;     // not free
+        UINT64 m_numUpdateLists;
+        UINT64 m_stagingBytesInFlight;
+
+        // heap pressure, current
+        UINT64 m_numHeapTilesCommitted;  // compare to Header::m_numHeapTiles
+        UINT64 m_numTilesResident;
+
+        // interval
+        double m_bandwidthMBps;          // compressed bytes read per second
+        double m_uploadsPerSecond;
+        double m_tileLatencyP50Ms;       // upper bound of the power-of-2 histogram bucket
+        double m_tileLatencyP90Ms;
+        double m_tileLatencyP99Ms;
+        double m_frameTimeP50Ms;
+        double m_frameTimeP99Ms;
+        double m_frameTimeMaxMs;
+    };
+
+    static_assert(std::atomic<UINT64>::is_always_lock_free, "shared memory requires lock-free atomics");
+    static_assert(0 == (sizeof(Header) % 8) && (0 == sizeof(Sample) % 8), "samples must stay 8-byte aligned");
+
+    constexpr size_t GetMappingSize() { return sizeof(Header) + NUM_SAMPLES * sizeof(Sample); }
+}
@@ -0,0 +1,275 @@
+//*********************************************************
+//
+// Copyright 2020 Intel Corporation 
+//
+// Permission is hereby granted, free of charge, to any 
+// person obtaining a copy of this software and associated 
+// documentation files(the "Software"), to deal in the Software 
+// without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to 
+// whom the Software is furnished to do so, subject to the 
+// following conditions :
+// The above copyright notice and this permission notice shall 
+// be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+// DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+
+
+// prints the live streaming metrics published by expanse, e.g.:
+//     expanse.exe -liveMetrics sfs
+//     metricsReader.exe -name sfs
+// -csv or -json write one line per sample to stdout, which can be redirected or piped to a collector
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <cstring>
+
+#include "DebugHelper.h"
+#include "ArgParser.h"
+#include "LiveMetrics.h"
+
+#define ErrorMessage(...) { std::wcerr << AutoString(__VA_ARGS__).str() << std::endl; exit(-1); }
+
+//-----------------------------------------------------------------------------
+// read-only view of the writer's ring
+//-----------------------------------------------------------------------------
+class MetricsReader
+{
+public:
+    MetricsReader(const std::wstring& in_name)
+    {
+        const std::wstring name = LiveMetrics::NAME_PREFIX + in_name;
+        m_mapping = OpenFileMapping(FILE_MAP_READ, FALSE, name.c_str());
+        if (nullptr == m_mapping)
+        {
+            ErrorMessage("Shared memory \"", in_name, "\" not found. Is expanse running with -liveMetrics ", in_name, "?");
+        }
+        m_pView = (const BYTE*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+        if (nullptr == m_pView)
+        {
+            ErrorMessage("Failed to map shared memory \"", in_name, "\"");
+        }
+
+        const auto& header = GetHeader();
+        if (LiveMetrics::MAGIC != header.m_magic)
+        {
+            ErrorMessage("\"", in_name, "\" is not a live metrics segment, or the writer has not finished initializing");
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (LiveMetrics::VERSION != header.m_version)
+        {
+            ErrorMessage("Unsupported live metrics version ", header.m_version, ", expected ", LiveMetrics::VERSION);
+        }
+        if ((header.m_sampleSize < sizeof(LiveMetrics::Sample)) || (0 == header.m_numSamples))
+        {
+            ErrorMessage("Invalid live metrics layout");
+        }
+    }
+
+    ~MetricsReader()
+    {
+        if (m_pView) { UnmapViewOfFile(m_pView); }
+        if (m_mapping) { CloseHandle(m_mapping); }
+    }
+
+    const LiveMetrics::Header& GetHeader() const { return *(const LiveMetrics::Header*)m_pView; }
+    UINT64 GetNumWritten() const { return GetHeader().m_numWritten.load(std::memory_order_acquire); }
+
+    // copy sample n. fails if it was overwritten (the reader fell behind) or is being written
+    bool Read(UINT64 in_sampleIndex, LiveMetrics::Sample& out_sample) const
+    {
+        const auto& header = GetHeader();
+        const auto* pSample = (const LiveMetrics::Sample*)(m_pView + header.m_headerSize +
+            (in_sampleIndex % header.m_numSamples) * header.m_sampleSize);
+
+        const UINT64 expected = 2 * (in_sampleIndex + 1);
+        if (expected != pSample->m_sequence.load(std::memory_order_acquire)) { return false; }
+
+        // the sequence is an atomic, copy around it
+        const size_t offset = sizeof(pSample->m_sequence);
+        std::memcpy((BYTE*)&out_sample + offset, (const BYTE*)pSample + offset, sizeof(LiveMetrics::Sample) - offset);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return expected == pSample->m_sequence.load(std::memory_order_relaxed);
+    }
+private:
+    HANDLE m_mapping{ nullptr };
+    const BYTE* m_pView{ nullptr };
+};
+
+//-----------------------------------------------------------------------------
+// one line per sample
+//-----------------------------------------------------------------------------
+enum class Format
+{
+    TEXT,
+    CSV,
+    JSON
+};
+
+void WriteCsvHeader()
+{
+    std::cout << "sample,time_s,frame,tiles_requested,tiles_uploaded,tiles_evicted,compressed_bytes,uncompressed_bytes,"
+        "tiles_in_flight,updatelists_busy,updatelists,staging_bytes,staging_capacity,heap_tiles_committed,heap_tiles,tiles_resident,"
+        "bandwidth_MBps,uploads_per_s,latency_p50_ms,latency_p90_ms,latency_p99_ms,frame_p50_ms,frame_p99_ms,frame_max_ms" << std::endl;
+}
+
+void WriteSample(Format in_format, UINT64 in_index, const LiveMetrics::Header& in_header, const LiveMetrics::Sample& s)
+{
+    std::stringstream line;
+    line.setf(std::ios::fixed, std::ios::floatfield);
+    line << std::setprecision(3);
+
+    switch (in_format)
+    {
+    case Format::CSV:
+        line << in_index << "," << s.m_timeUs / 1000000.0 << "," << s.m_frameNumber
+            << "," << s.m_numTilesRequested << "," << s.m_numTilesUploaded << "," << s.m_numTilesEvicted
+            << "," << s.m_compressedBytesRead << "," << s.m_uncompressedBytesRead
+            << "," << s.m_numTilesInFlight << "," << s.m_numUpdateListsBusy << "," << s.m_numUpdateLists
+            << "," << s.m_stagingBytesInFlight << "," << in_header.m_stagingBytesCapacity
+            << "," << s.m_numHeapTilesCommitted << "," << in_header.m_numHeapTiles << "," << s.m_numTilesResident
+            << "," << s.m_bandwidthMBps << "," << s.m_uploadsPerSecond
+            << "," << s.m_tileLatencyP50Ms << "," << s.m_tileLatencyP90Ms << "," << s.m_tileLatencyP99Ms
+            << "," << s.m_frameTimeP50Ms << "," << s.m_frameTimeP99Ms << "," << s.m_frameTimeMaxMs;
+        break;
+
+    case Format::JSON:
+        line << "{\"sample\": " << in_index << ", \"time_s\": " << s.m_timeUs / 1000000.0 << ", \"frame\": " << s.m_frameNumber
+            << ", \"tilesRequested\": " << s.m_numTilesRequested << ", \"tilesUploaded\": " << s.m_numTilesUploaded
+            << ", \"tilesEvicted\": " << s.m_numTilesEvicted
+            << ", \"compressedBytesRead\": " << s.m_compressedBytesRead << ", \"uncompressedBytesRead\": " << s.m_uncompressedBytesRead
+            << ", \"tilesInFlight\": " << s.m_numTilesInFlight << ", \"updateListsBusy\": " << s.m_numUpdateListsBusy
+            << ", \"updateLists\": " << s.m_numUpdateLists
+            << ", \"stagingBytesInFlight\": " << s.m_stagingBytesInFlight << ", \"stagingBytesCapacity\": " << in_header.m_stagingBytesCapacity
+            << ", \"heapTilesCommitted\": " << s.m_numHeapTilesCommitted << ", \"heapTiles\": " << in_header.m_numHeapTiles
+            << ", \"tilesResident\": " << s.m_numTilesResident
+            << ", \"bandwidthMBps\": " << s.m_bandwidthMBps << ", \"uploadsPerSecond\": " << s.m_uploadsPerSecond
+            << ", \"tileLatencyMs\": {\"p50\": " << s.m_tileLatencyP50Ms << ", \"p90\": " << s.m_tileLatencyP90Ms << ", \"p99\": " << s.m_tileLatencyP99Ms << "}"
+            << ", \"frameTimeMs\": {\"p50\": " << s.m_frameTimeP50Ms << ", \"p99\": " << s.m_frameTimeP99Ms << ", \"max\": " << s.m_frameTimeMaxMs << "}}";
+        break;
+
+    default:
+    {
+        float heapPercent = in_header.m_numHeapTiles ? 100.f * float(s.m_numHeapTilesCommitted) / float(in_header.m_numHeapTiles) : 0;
+        line << "frame " << s.m_frameNumber
+            << " | " << std::setw(8) << s.m_bandwidthMBps << " MB/s " << std::setw(8) << s.m_uploadsPerSecond << " tiles/s"
+            << " | backlog " << s.m_numTilesInFlight << " tiles " << s.m_numUpdateListsBusy << "/" << s.m_numUpdateLists << " lists"
+            << " | heap " << std::setprecision(1) << heapPercent << "%"
+            << " | latency ms p50 " << std::setprecision(3) << s.m_tileLatencyP50Ms << " p99 " << s.m_tileLatencyP99Ms
+            << " | frame ms p50 " << s.m_frameTimeP50Ms << " max " << s.m_frameTimeMaxMs;
+    }
+    }
+    std::cout << line.str() << std::endl;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+int main()
+{
+    std::wstring name;
+    UINT pollMs{ 50 };
+    UINT numSamples{ 0 };
+    bool csv{ false };
+    bool json{ false };
+    bool all{ false };
+
+    //---------------------------
+    // parse command line
+    //---------------------------
+    {
+        ArgParser argParser;
+        argParser.AddArg(L"-name", name, L"<Required> shared memory name given to expanse with -liveMetrics");
+        argParser.AddArg(L"-poll", pollMs, L"ms between checks for new samples");
+        argParser.AddArg(L"-count", numSamples, L"exit after this many samples, 0 = until the writer exits");
+        argParser.AddArg(L"-csv", csv, L"comma-separated values, one line per sample");
+        argParser.AddArg(L"-json", json, L"one JSON object per line");
+        argParser.AddArg(L"-all", all, L"start with the oldest samples still in the ring instead of the latest");
+        argParser.Parse();
+
+        if (0 == name.size())
+        {
+            ErrorMessage("shared memory name not provided (-name name)");
+        }
+    }
+    const Format format = json ? Format::JSON : (csv ? Format::CSV : Format::TEXT);
+
+    MetricsReader reader(name);
+    const auto& header = reader.GetHeader();
+
+    // the writer's process handle tells us when to stop
+    HANDLE writerProcess = OpenProcess(SYNCHRONIZE, FALSE, header.m_processId);
+
+    if (Format::CSV == format) { WriteCsvHeader(); }
+    else if (Format::TEXT == format)
+    {
+        std::cout << "process " << header.m_processId << ", sample every " << header.m_intervalMs << " ms, "
+            << header.m_numHeapTiles << " heap tiles, " << header.m_stagingBytesCapacity / (1024 * 1024) << " MB staging" << std::endl;
+    }
+
+    UINT64 next = reader.GetNumWritten();
+    if (all) { next -= std::min(next, UINT64(header.m_numSamples)); }
+    else if (next) { next--; }
+
+    UINT numRead = 0;
+    UINT64 numDropped = 0;
+    while (true)
+    {
+        const UINT64 numWritten = reader.GetNumWritten();
+        for (; next < numWritten; next++)
+        {
+            LiveMetrics::Sample sample;
+            if (reader.Read(next, sample))
+            {
+                WriteSample(format, next, header, sample);
+                numRead++;
+                if (numSamples && (numRead >= numSamples)) { return 0; }
+            }
+            else
+            {
+                // overwritten before we read it. skip to the oldest sample still in the ring
+                const UINT64 latest = reader.GetNumWritten();
+                const UINT64 oldest = latest - std::min(latest, UINT64(header.m_numSamples));
+                if (oldest > next)
+                {
+                    numDropped += oldest - next;
+                    next = oldest;
+                    std::cerr << "fell behind, " << numDropped << " samples dropped" << std::endl;
+                }
+                break;
+            }
+        }
+
+        if (writerProcess && (WAIT_OBJECT_0 == WaitForSingleObject(writerProcess, pollMs)))
+        {
+            // read the final samples, then stop
+            if (next >= reader.GetNumWritten()) { break; }
+        }
+        else if (nullptr == writerProcess)
+        {
+            Sleep(pollMs);
+        }
+    }
+
+    if (writerProcess) { CloseHandle(writerProcess); }
+    return 0;
+}
@@ -0,0 +1,937 @@
+//*********************************************************
+//
+// Copyright 2020 Intel Corporation 
+//
+// Permission is hereby granted, free of charge, to any 
+// person obtaining a copy of this software and associated 
+// documentation files(the "Software"), to deal in the Software 
+// without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to 
+// whom the Software is furnished to do so, subject to the 
+// following conditions :
+// The above copyright notice and this permission notice shall 
+// be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+// DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+
+// microbenchmarks for the data structures on the streaming hot paths
+// uses the library's own headers, so a regression in TileUpdateManager shows up here first
+//
+// Windows: build microbench.vcxproj
+// Linux, from the repository root:
+//     g++ -std=c++20 -O2 -pthread -Iinclude -ITileUpdateManager microbench/microbench.cpp -o microbench
+//
+// microbench [-filter substring] [-minTime seconds] [-repetitions n] [-json file] [-config file] [-xet file]
+// prints a table, and with -json writes the results for tools
+// then checks the scheduling of stale resources by priority, and (Windows) of feedback. the exit code is the number of failed checks
+// threads yield when they can't make progress, so the contended benchmarks are meaningful on few cores
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <d3d12.h>
+#else
+//-----------------------------------------------------------------------------
+// the subset of Win32/D3D12 types used by the headers under test
+//-----------------------------------------------------------------------------
+#include <cstdint>
+using UINT = uint32_t;
+using UINT8 = uint8_t;
+using UINT16 = uint16_t;
+using UINT32 = uint32_t;
+using UINT64 = uint64_t;
+using INT64 = int64_t;
+using BYTE = uint8_t;
+struct D3D12_TILED_RESOURCE_COORDINATE { UINT X; UINT Y; UINT Z; UINT Subresource; };
+struct D3D12_SUBRESOURCE_TILING { UINT WidthInTiles; UINT16 HeightInTiles; UINT16 DepthInTiles; UINT StartTileIndexInOverallResource; };
+#endif
+
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <random>
+#include <atomic>
+#include <cmath>
+
+#include "DebugHelper.h"
+#include "BitVector.h"
+#include "SimpleAllocator.h"
+#include "SynchronizationFlag.h"
+#include "TileMappingState.h"
+#include "PriorityScheduler.h"
+#include "ConfigurationParser.h"
+
+#ifdef _WIN32
+#include "XeTexture.h"
+#include "FeedbackScheduler.h"
+#pragma comment(lib, "TileUpdateManager.lib")
+#endif
+
+//-----------------------------------------------------------------------------
+// results are summed here so the compiler can't discard the work
+//-----------------------------------------------------------------------------
+static volatile UINT64 g_sink = 0;
+
+//=============================================================================
+// runs each benchmark long enough to be stable, several times, and reports the median
+//=============================================================================
+class Harness
+{
+public:
+    // returns the number of operations performed, e.g. # tiles allocated. time is reported per operation
+    using Function = std::function<UINT64(UINT64 in_numIterations)>;
+
+    struct Result
+    {
+        std::string m_name;
+        UINT64 m_iterations{ 0 };  // per repetition
+        UINT64 m_operations{ 0 };  // per repetition
+        double m_nsPerOp{ 0 };     // median over repetitions
+        double m_nsPerOpMin{ 0 };
+        double m_nsPerOpMax{ 0 };
+    };
+
+    std::string m_filter;
+    double m_minTime{ 0.25 };  // seconds per repetition
+    UINT m_repetitions{ 5 };
+
+    void Run(const std::string& in_name, Function in_function)
+    {
+        if (m_filter.size() && (std::string::npos == in_name.find(m_filter))) { return; }
+
+        // grow the iteration count until a run takes long enough to time reliably, then scale to m_minTime
+        UINT64 numIterations = 1;
+        double seconds = 0;
+        while (true)
+        {
+            seconds = Time(in_function, numIterations).first;
+            if ((seconds >= m_minTime / 10) || (numIterations >= (UINT64(1) << 40))) { break; }
+            numIterations *= (seconds < m_minTime / 1000) ? 10 : 2;
+        }
+        numIterations = std::max(UINT64(1), UINT64(double(numIterations) * m_minTime / std::max(seconds, 1e-9)));
+
+        Result result;
+        result.m_name = in_name;
+        result.m_iterations = numIterations;
+
+        std::vector<double> nsPerOp;
+        for (UINT i = 0; i < m_repetitions; i++)
+        {
+            auto [s, numOps] = Time(in_function, numIterations);
+            result.m_operations = numOps;
+            nsPerOp.push_back(s * 1e9 / double(std::max(UINT64(1), numOps)));
+        }
+        std::sort(nsPerOp.begin(), nsPerOp.end());
+        result.m_nsPerOp = nsPerOp[nsPerOp.size() / 2];
+        result.m_nsPerOpMin = nsPerOp.front();
+        result.m_nsPerOpMax = nsPerOp.back();
+
+        std::cout << std::left << std::setw(48) << result.m_name << std::right
+            << std::fixed << std::setprecision(2)
+            << std::setw(14) << result.m_nsPerOp
+            << std::setw(14) << result.m_nsPerOpMin
+            << std::setw(14) << result.m_nsPerOpMax
+            << std::setw(16) << std::setprecision(0) << 1e9 / result.m_nsPerOp
+            << std::endl;
+
+        m_results.push_back(result);
+    }
+
+    static void WriteTableHeader()
+    {
+        std::cout << std::left << std::setw(48) << "benchmark" << std::right
+            << std::setw(14) << "ns/op" << std::setw(14) << "min" << std::setw(14) << "max"
+            << std::setw(16) << "ops/s" << std::endl;
+    }
+
+    bool WriteJson(const std::string& in_fileName) const
+    {
+        std::ofstream ofs(in_fileName);
+        if (!ofs.good()) { return false; }
+
+        ofs << "{\n  \"platform\": \"" <<
+#ifdef _WIN32
+            "windows"
+#else
+            "linux"
+#endif
+            << "\",\n  \"repetitions\": " << m_repetitions
+            << ",\n  \"minTime_s\": " << m_minTime
+            << ",\n  \"benchmarks\": [";
+        for (size_t i = 0; i < m_results.size(); i++)
+        {
+            const auto& r = m_results[i];
+            ofs << (i ? "," : "") << "\n    {\"name\": \"" << r.m_name << "\""
+                << ", \"iterations\": " << r.m_iterations
+                << ", \"operations\": " << r.m_operations
+                << ", \"ns_per_op\": " << r.m_nsPerOp
+                << ", \"ns_per_op_min\": " << r.m_nsPerOpMin
+                << ", \"ns_per_op_max\": " << r.m_nsPerOpMax
+                << ", \"ops_per_s\": " << 1e9 / r.m_nsPerOp
+                << "}";
+        }
+        ofs << "\n  ]\n}\n";
+        return true;
+    }
+private:
+    std::vector<Result> m_results;
+
+    static std::pair<double, UINT64> Time(Function& in_function, UINT64 in_numIterations)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const UINT64 numOps = in_function(in_numIterations);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return { elapsed.count(), numOps };
+    }
+};
+
+//-----------------------------------------------------------------------------
+// sizes that match the defaults of expanse and TileUpdateManagerDesc
+//-----------------------------------------------------------------------------
+namespace Sizes
+{
+    constexpr UINT HEAP_TILES = 24576;    // config.json heapSizeTiles
+    constexpr UINT UPDATE_LISTS = 128;    // TileUpdateManagerDesc::m_maxNumCopyBatches
+    constexpr UINT NUM_RESOURCES = 1000;  // a large scene
+    constexpr UINT REGIONS = 64;          // 16k x 16k BC7: 256x256 texel tiles, 64x64 regions in the min mip map
+    constexpr UINT NUM_MIPS = 7;          // standard mips of the above. the remaining mips are packed
+}
+
+//-----------------------------------------------------------------------------
+// allocators: heap tiles are allocated in batches, UpdateLists one at a time
+//-----------------------------------------------------------------------------
+void BenchAllocators(Harness& in_harness)
+{
+    for (UINT batch : { 1u, 16u, 256u })
+    {
+        in_harness.Run("SimpleAllocator/AllocateFree/" + std::to_string(batch), [batch](UINT64 in_n)
+            {
+                Streaming::SimpleAllocator allocator(Sizes::HEAP_TILES);
+                std::vector<UINT> indices(batch);
+                for (UINT64 i = 0; i < in_n; i++)
+                {
+                    allocator.Allocate(indices.data(), batch);
+                    g_sink = g_sink + indices[0];
+                    allocator.Free(indices.data(), batch);
+                }
+                return in_n * batch;
+            });
+    }
+
+    in_harness.Run("AllocatorMT/AllocateFree", [](UINT64 in_n)
+        {
+            Streaming::AllocatorMT allocator(Sizes::UPDATE_LISTS);
+            for (UINT64 i = 0; i < in_n; i++)
+            {
+                UINT index = allocator.Allocate();
+                g_sink = g_sink + index;
+                allocator.Free(index);
+            }
+            return in_n;
+        });
+
+    // the ProcessFeedback thread allocates UpdateLists, the fence monitor thread frees them
+    in_harness.Run("AllocatorMT/TwoThreads", [](UINT64 in_n)
+        {
+            Streaming::AllocatorMT allocator(Sizes::UPDATE_LISTS);
+            std::vector<UINT> handoff(Sizes::UPDATE_LISTS);
+            Streaming::RingBuffer queue(Sizes::UPDATE_LISTS);
+
+            std::thread consumer([&]
+                {
+                    for (UINT64 i = 0; i < in_n;)
+                    {
+                        if (queue.GetReadyToRead())
+                        {
+                            allocator.Free(handoff[queue.GetReadIndex()]);
+                            queue.Free();
+                            i++;
+                        }
+                        else { std::this_thread::yield(); }
+                    }
+                });
+            for (UINT64 i = 0; i < in_n;)
+            {
+                if (allocator.GetAvailable() && queue.GetAvailableToWrite())
+                {
+                    handoff[queue.GetWriteIndex()] = allocator.Allocate();
+                    queue.Allocate();
+                    i++;
+                }
+                else { std::this_thread::yield(); }
+            }
+            consumer.join();
+            return in_n;
+        });
+}
+
+//-----------------------------------------------------------------------------
+// single writer, single reader
+//-----------------------------------------------------------------------------
+void BenchRingBuffer(Harness& in_harness)
+{
+    in_harness.Run("RingBuffer/WriteRead", [](UINT64 in_n)
+        {
+            Streaming::RingBuffer ringBuffer(Sizes::UPDATE_LISTS);
+            for (UINT64 i = 0; i < in_n; i++)
+            {
+                g_sink = g_sink + ringBuffer.GetWriteIndex();
+                ringBuffer.Allocate();
+                g_sink = g_sink + ringBuffer.GetReadIndex();
+                ringBuffer.Free();
+            }
+            return in_n;
+        });
+
+    for (UINT size : { 16u, Sizes::UPDATE_LISTS, 1024u })
+    {
+        in_harness.Run("RingBuffer/TwoThreads/" + std::to_string(size), [size](UINT64 in_n)
+            {
+                Streaming::RingBuffer ringBuffer(size);
+                std::vector<UINT64> data(size);
+
+                std::thread reader([&]
+                    {
+                        UINT64 sum = 0;
+                        for (UINT64 i = 0; i < in_n;)
+                        {
+                            UINT numReady = ringBuffer.GetReadyToRead();
+                            for (UINT j = 0; j < numReady; j++)
+                            {
+                                sum += data[ringBuffer.GetReadIndex(j)];
+                            }
+                            if (numReady) { ringBuffer.Free(numReady); }
+                            else { std::this_thread::yield(); }
+                            i += numReady;
+                        }
+                        g_sink = g_sink + sum;
+                    });
+                for (UINT64 i = 0; i < in_n;)
+                {
+                    UINT numAvailable = (UINT)std::min(UINT64(ringBuffer.GetAvailableToWrite()), in_n - i);
+                    for (UINT j = 0; j < numAvailable; j++)
+                    {
+                        data[ringBuffer.GetWriteIndex(j)] = i + j;
+                    }
+                    if (numAvailable) { ringBuffer.Allocate(numAvailable); }
+                    else { std::this_thread::yield(); }
+                    i += numAvailable;
+                }
+                reader.join();
+                return in_n;
+            });
+    }
+}
+
+//-----------------------------------------------------------------------------
+// TileUpdateManager tracks stale resources with a BitVector<UINT32>
+//-----------------------------------------------------------------------------
+void BenchBitVector(Harness& in_harness)
+{
+    for (UINT size : { Sizes::NUM_RESOURCES, 65536u })
+    {
+        std::vector<UINT> order(4096);
+        std::mt19937 rng(size);
+        for (auto& i : order) { i = rng() % size; }
+
+        in_harness.Run("BitVector/SetGetClear/" + std::to_string(size), [size, order](UINT64 in_n)
+            {
+                BitVector<UINT32> bits(size);
+                UINT64 sum = 0;
+                for (UINT64 i = 0; i < in_n; i++)
+                {
+                    UINT index = order[i & (order.size() - 1)];
+                    bits.Set(index);
+                    sum += bits.Get(index);
+                    bits.Clear(index);
+                }
+                g_sink = g_sink + sum;
+                return in_n;
+            });
+    }
+}
+
+//-----------------------------------------------------------------------------
+// wakes the streaming threads. Set() is called every frame and for every completed UpdateList
+//-----------------------------------------------------------------------------
+void BenchSynchronizationFlag(Harness& in_harness)
+{
+    in_harness.Run("SynchronizationFlag/SetWait", [](UINT64 in_n)
+        {
+            Streaming::SynchronizationFlag flag;
+            for (UINT64 i = 0; i < in_n; i++)
+            {
+                flag.Set();
+                flag.Wait(); // already set: returns immediately
+            }
+            return in_n;
+        });
+
+    // one operation = a round trip between two threads
+    in_harness.Run("SynchronizationFlag/PingPong", [](UINT64 in_n)
+        {
+            Streaming::SynchronizationFlag ping;
+            Streaming::SynchronizationFlag pong;
+            std::thread other([&]
+                {
+                    for (UINT64 i = 0; i < in_n; i++)
+                    {
+                        ping.Wait();
+                        pong.Set();
+                    }
+                });
+            for (UINT64 i = 0; i < in_n; i++)
+            {
+                ping.Set();
+                pong.Wait();
+            }
+            other.join();
+            return in_n;
+        });
+}
+
+//=============================================================================
+// a 16k x 16k BC7 texture with feedback that changes every frame like a moving camera
+//=============================================================================
+class TileMappingFixture
+{
+public:
+    TileMappingFixture()
+    {
+        for (UINT s = 0; s < Sizes::NUM_MIPS; s++)
+        {
+            D3D12_SUBRESOURCE_TILING t{};
+            t.WidthInTiles = std::max(1u, Sizes::REGIONS >> s);
+            t.HeightInTiles = (UINT16)std::max(1u, Sizes::REGIONS >> s);
+            t.DepthInTiles = 1;
+            m_tiling.push_back(t);
+        }
+
+        // the camera looks at one corner: mip 0 there, coarser with distance. the other feedback is shifted
+        for (UINT f = 0; f < 2; f++)
+        {
+            auto& feedback = m_feedback[f];
+            feedback.resize(Sizes::REGIONS * Sizes::REGIONS);
+            const UINT offset = f * 8;
+            for (UINT y = 0; y < Sizes::REGIONS; y++)
+            {
+                for (UINT x = 0; x < Sizes::REGIONS; x++)
+                {
+                    const UINT distance = std::max(x + offset, y) / 8;
+                    feedback[y * Sizes::REGIONS + x] = (BYTE)std::min(distance, 0xffu);
+                }
+            }
+        }
+    }
+
+    void Init(Streaming::TileMappingState& out_state) const { out_state.Init(Sizes::NUM_MIPS, m_tiling.data()); }
+
+    // the loop in StreamingResourceBase::ProcessFeedback()
+    // returns true if any region changed
+    bool ApplyFeedback(Streaming::TileMappingState& in_state, std::vector<BYTE>& inout_references, UINT in_feedbackIndex)
+    {
+        m_loads.clear();
+        m_evictions.clear();
+        const BYTE* pFeedback = m_feedback[in_feedbackIndex].data();
+        const UINT8 maxMip = (UINT8)Sizes::NUM_MIPS;
+        bool changed = false;
+        for (UINT y = 0; y < Sizes::REGIONS; y++)
+        {
+            for (UINT x = 0; x < Sizes::REGIONS; x++)
+            {
+                BYTE& reference = inout_references[y * Sizes::REGIONS + x];
+                UINT8 desired = std::min(pFeedback[y * Sizes::REGIONS + x], maxMip);
+                if (desired != reference) { changed = true; }
+                in_state.SetMinMip(reference, x, y, desired,
+                    [&](UINT x, UINT y, UINT s) { m_loads.push_back(D3D12_TILED_RESOURCE_COORDINATE{ x, y, 0, s }); },
+                    [&](UINT x, UINT y, UINT s) { m_evictions.push_back(D3D12_TILED_RESOURCE_COORDINATE{ x, y, 0, s }); });
+                reference = desired;
+            }
+        }
+        return changed;
+    }
+
+    // make every referenced tile resident, as if all loads completed
+    void MakeResident(Streaming::TileMappingState& in_state)
+    {
+        for (const auto& c : m_loads) { in_state.SetResidency(c, Streaming::TileMappingState::Resident); }
+        for (const auto& c : m_evictions) { in_state.SetResidency(c, Streaming::TileMappingState::NotResident); }
+    }
+
+    UINT64 GetNumLoads() const { return m_loads.size(); }
+private:
+    std::vector<D3D12_SUBRESOURCE_TILING> m_tiling;
+    std::vector<BYTE> m_feedback[2];
+    std::vector<D3D12_TILED_RESOURCE_COORDINATE> m_loads;
+    std::vector<D3D12_TILED_RESOURCE_COORDINATE> m_evictions;
+};
+
+//-----------------------------------------------------------------------------
+// per-resource tile state, feedback processing, and min mip map generation
+//-----------------------------------------------------------------------------
+void BenchTileMapping(Harness& in_harness)
+{
+    const UINT numRegions = Sizes::REGIONS * Sizes::REGIONS;
+
+    in_harness.Run("TileMappingState/Init/16kBC7", [](UINT64 in_n)
+        {
+            TileMappingFixture fixture;
+            for (UINT64 i = 0; i < in_n; i++)
+            {
+                Streaming::TileMappingState state;
+                fixture.Init(state);
+                g_sink = g_sink + state.GetNumSubresources();
+            }
+            return in_n;
+        });
+
+    in_harness.Run("TileMappingState/GetAnyRefCount+GetMinResidentMip", [](UINT64 in_n)
+        {
+            TileMappingFixture fixture;
+            Streaming::TileMappingState state;
+            fixture.Init(state);
+            UINT64 sum = 0;
+            for (UINT64 i = 0; i < in_n; i++)
+            {
+                sum += state.GetAnyRefCount() + state.GetMinResidentMip();
+            }
+            g_sink = g_sink + sum;
+            return in_n;
+        });
+
+    // steady camera: feedback matches the references, nothing to load or evict
+    in_harness.Run("ProcessFeedback/Static/64x64", [numRegions](UINT64 in_n)
+        {
+            TileMappingFixture fixture;
+            Streaming::TileMappingState state;
+            fixture.Init(state);
+            std::vector<BYTE> references(numRegions, (BYTE)Sizes::NUM_MIPS);
+            fixture.ApplyFeedback(state, references, 0);
+            for (UINT64 i = 0; i < in_n; i++)
+            {
+                g_sink = g_sink + fixture.ApplyFeedback(state, references, 0);
+            }
+            return in_n * numRegions;
+        });
+
+    // moving camera: alternates between two views, every frame loads and evicts tiles
+    in_harness.Run("ProcessFeedback/Moving/64x64", [numRegions](UINT64 in_n)
+        {
+            TileMappingFixture fixture;
+            Streaming::TileMappingState state;
+            fixture.Init(state);
+            std::vector<BYTE> references(numRegions, (BYTE)Sizes::NUM_MIPS);
+            for (UINT64 i = 0; i < in_n; i++)
+            {
+                g_sink = g_sink + fixture.ApplyFeedback(state, references, UINT(i & 1));
+            }
+            return in_n * numRegions;
+        });
+
+    // min mip map after everything requested is resident.
+    // warm: seeded with the previous result, the common case. cold: every region searched from the packed mips
+    for (bool warm : { true, false })
+    {
+        in_harness.Run(std::string("UpdateMinMipMap/") + (warm ? "Warm" : "Cold") + "/64x64", [numRegions, warm](UINT64 in_n)
+            {
+                TileMappingFixture fixture;
+                Streaming::TileMappingState state;
+                fixture.Init(state);
+                std::vector<BYTE> references(numRegions, (BYTE)Sizes::NUM_MIPS);
+                fixture.ApplyFeedback(state, references, 0);
+                fixture.MakeResident(state);
+
+                std::vector<BYTE> minMipMap(numRegions, (BYTE)Sizes::NUM_MIPS);
+                for (UINT64 i = 0; i < in_n; i++)
+                {
+                    if (!warm) { std::fill(minMipMap.begin(), minMipMap.end(), (BYTE)Sizes::NUM_MIPS); }
+                    state.UpdateMinMipMap(minMipMap.data(), Sizes::REGIONS, Sizes::REGIONS);
+                    g_sink = g_sink + minMipMap[i % numRegions];
+                }
+                return in_n * numRegions;
+            });
+    }
+}
+
+//-----------------------------------------------------------------------------
+// the config file is parsed at startup, and scene descriptions can be large
+//-----------------------------------------------------------------------------
+void BenchConfigurationParser(Harness& in_harness, const std::string& in_configFileName)
+{
+    std::string text;
+    {
+        std::ifstream ifs(in_configFileName, std::ios::binary);
+        if (ifs.good())
+        {
+            text.assign((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+        }
+    }
+    // without a config file, parse something with the same shape
+    if (text.empty())
+    {
+        std::stringstream s;
+        s << "{\n";
+        for (UINT i = 0; i < 100; i++)
+        {
+            s << "  \"value" << i << "\": " << i * 1.5f << ", // a comment\n"
+                << "  \"name" << i << "\": \"text" << i << "\",\n"
+                << "  \"block" << i << "\": { \"enabled\": true, \"array\": [1, 2, 3, 4] },\n";
+        }
+        s << "  \"last\": 0\n}\n";
+        text = s.str();
+    }
+
+    in_harness.Run("ConfigurationParser/Parse/" + std::to_string(text.size()) + "B", [text](UINT64 in_n)
+        {
+            for (UINT64 i = 0; i < in_n; i++)
+            {
+                std::string copy = text;
+                ConfigurationParser parser;
+                parser.Parse(copy);
+                g_sink = g_sink + parser.GetRoot().size();
+            }
+            return in_n;
+        });
+}
+
+//-----------------------------------------------------------------------------
+// ordering of stale resources under contention, as ProcessFeedbackThread() does it:
+// each pass sorts the stale resources, then each takes 1 UpdateList while any are available
+// returns the pass on which each resource finished its work
+//-----------------------------------------------------------------------------
+std::vector<UINT> SimulateContention(const std::vector<float>& in_priorities, UINT in_numListsNeeded, UINT in_numListsPerPass)
+{
+    const UINT numResources = (UINT)in_priorities.size();
+    Streaming::PriorityScheduler scheduler;
+    scheduler.Resize(numResources);
+
+    std::vector<UINT> remaining(numResources, in_numListsNeeded);
+    std::vector<UINT> finished(numResources, 0);
+    std::vector<UINT32> staleResources;
+    for (UINT i = 0; i < numResources; i++) // oldest first
+    {
+        staleResources.push_back(i);
+        scheduler.Wake(i, in_priorities[i]);
+    }
+
+    for (UINT pass = 1; staleResources.size(); pass++)
+    {
+        scheduler.Sort(staleResources);
+        UINT numListsAvailable = in_numListsPerPass;
+        UINT newStaleSize = 0;
+        for (auto i : staleResources)
+        {
+            if (numListsAvailable)
+            {
+                numListsAvailable--;
+                remaining[i]--;
+                scheduler.Served(i);
+            }
+            if (remaining[i]) { staleResources[newStaleSize++] = i; }
+            else { finished[i] = pass; }
+        }
+        staleResources.resize(newStaleSize);
+    }
+    return finished;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+void Check(const char* in_name, bool in_passed, UINT& inout_numFailures)
+{
+    std::cout << "check " << in_name << (in_passed ? ": passed" : ": FAILED") << std::endl;
+    if (!in_passed) { inout_numFailures++; }
+}
+
+//-----------------------------------------------------------------------------
+// not timed: verifies that high-priority resources converge first under contention
+// returns the number of failures
+//-----------------------------------------------------------------------------
+UINT CheckPriorityScheduler()
+{
+    UINT numFailures = 0;
+    auto check = [&](const char* in_name, bool in_passed) { Check(in_name, in_passed, numFailures); };
+
+    // the low-priority resource became stale first, so would be served first without priorities
+    auto f = SimulateContention({ 1.f, 4.f }, 100, 1);
+    check("PriorityScheduler/HighPriorityFirst", f[1] < f[0]);
+    // weighted, not strict: the low-priority resource received about 1/5 of the UpdateLists meanwhile
+    check("PriorityScheduler/NoStarvation", f[0] == 200);
+    check("PriorityScheduler/Proportional", (f[1] >= 123) && (f[1] <= 127));
+
+    // equal priorities share equally, oldest first
+    f = SimulateContention({ 1.f, 1.f, 1.f }, 100, 1);
+    check("PriorityScheduler/EqualShare", (f[0] == 298) && (f[1] == 299) && (f[2] == 300));
+
+    // priority 0 waits for everything else
+    f = SimulateContention({ 0.f, 1.f, 2.f }, 100, 1);
+    check("PriorityScheduler/IdlePriorityLast", (f[2] < f[1]) && (f[1] == 200) && (f[0] == 300));
+
+    // no contention: everyone finishes together
+    f = SimulateContention({ 1.f, 4.f, 0.f }, 10, 3);
+    check("PriorityScheduler/Uncontended", (f[0] == 10) && (f[1] == 10) && (f[2] == 10));
+
+    return numFailures;
+}
+
+//-----------------------------------------------------------------------------
+// not timed: which resources get feedback each frame. FeedbackScheduler uses no GPU objects
+// returns the number of failures
+//-----------------------------------------------------------------------------
+#ifdef _WIN32
+UINT CheckFeedbackScheduler()
+{
+    UINT numFailures = 0;
+    auto check = [&](const char* in_name, bool in_passed) { Check(in_name, in_passed, numFailures); };
+
+    using Scheduler = Streaming::FeedbackScheduler;
+    auto nearlyEqual = [](float a, float b) { return std::abs(a - b) <= 1e-3f * std::max(1.f, std::abs(b)); };
+
+    // feedback of "stable" never changes the desired tiles, feedback of "changing" always does
+    // no measurements: up to Params::m_defaultNumResolves per frame, so the budget doesn't matter
+    {
+        Scheduler scheduler;
+        Scheduler::History stableHistory, changingHistory;
+        Scheduler::Candidate candidates[2];
+        candidates[0].m_pHistory = &stableHistory;
+        candidates[1].m_pHistory = &changingHistory;
+        for (auto& c : candidates) { c.m_numTexels = 4096; c.m_screenArea = 0.1f; }
+
+        bool growing = true;
+        UINT interval = 1;
+        UINT numStable = 0, numChanging = 0;
+        for (UINT frame = 0; frame < 256; frame++)
+        {
+            scheduler.Schedule(candidates, 2, 1.f);
+            if (frame >= 160)
+            {
+                numStable += candidates[0].m_scheduled;
+                numChanging += candidates[1].m_scheduled;
+            }
+            // the feedback of a scheduled resource is processed before the next frame
+            for (UINT i = 0; i < 2; i++)
+            {
+                if (!candidates[i].m_scheduled) { continue; }
+                candidates[i].m_numProcessed++;
+                candidates[i].m_numChanged += i;
+            }
+            scheduler.Update(candidates[0]);
+            UINT next = scheduler.GetInterval(stableHistory);
+            growing = growing && (next >= interval);
+            interval = next;
+        }
+        check("FeedbackScheduler/IntervalGrows", growing && (Scheduler::Params().m_maxInterval == interval));
+        check("FeedbackScheduler/StableInterval", (96 / interval) == numStable);
+        check("FeedbackScheduler/ChangingEveryFrame", (1 == scheduler.GetInterval(changingHistory)) && (96 == numChanging));
+
+        // a stable resource is due early if its screen area changes substantially
+        while (scheduler.IsDue(candidates[0])) { scheduler.Schedule(candidates, 2, 1.f); }
+        candidates[0].m_screenArea = 0.12f;
+        const bool smallChangeDue = scheduler.IsDue(candidates[0]);
+        candidates[0].m_screenArea = 0.3f;
+        scheduler.Schedule(candidates, 2, 1.f);
+        check("FeedbackScheduler/ScreenAreaHint", (!smallChangeDue) && candidates[0].m_scheduled);
+    }
+
+    // time = 0.1ms per resolve + 1ms per megatexel, measured exactly
+    Scheduler scheduler;
+    check("FeedbackScheduler/NoEstimateUnmeasured", scheduler.EstimateCost(1 << 20) < 0);
+    scheduler.AddMeasurement(0.1f * 1 + 1.0f, 1, 1000000);
+    scheduler.AddMeasurement(0.1f * 2 + 1.0f, 2, 1000000);
+    scheduler.AddMeasurement(0.1f * 1 + 3.0f, 1, 3000000);
+    scheduler.AddMeasurement(0.1f * 4 + 2.5f, 4, 2500000);
+    check("FeedbackScheduler/LeastSquaresFit", nearlyEqual(scheduler.EstimateCost(0), 0.1f) &&
+        nearlyEqual(scheduler.EstimateCost(2000000), 2.1f));
+
+    // largest area first. the second large resource doesn't fit, but the small one after it does
+    {
+        Scheduler::History histories[3];
+        Scheduler::Candidate candidates[3];
+        const UINT numTexels[] = { 4000000, 4000000, 100000 };
+        const float areas[] = { 0.5f, 0.4f, 0.1f };
+        for (UINT i = 0; i < 3; i++)
+        {
+            candidates[i].m_pHistory = &histories[i];
+            candidates[i].m_numTexels = numTexels[i];
+            candidates[i].m_screenArea = areas[i];
+        }
+        scheduler.Schedule(candidates, 3, 4.5f); // 4.1 + 0.2 fit, 4.1 + 4.1 does not
+        const auto& statistics = scheduler.GetStatistics();
+        check("FeedbackScheduler/BudgetDefersLarger", candidates[0].m_scheduled && (!candidates[1].m_scheduled) &&
+            candidates[2].m_scheduled && (1 == statistics.m_numDeferred) && nearlyEqual(statistics.m_estimatedMs, 4.3f));
+
+        // the most important due resource is scheduled even if it alone exceeds the budget
+        scheduler.Schedule(candidates + 1, 1, 1.f);
+        check("FeedbackScheduler/AtLeastOne", candidates[1].m_scheduled);
+    }
+
+    // every frame resolves resources of the same size: resolves and texels can't be separated
+    Scheduler degenerate;
+    const UINT numTexels = 699051;
+    degenerate.AddMeasurement(2.0f, 1, numTexels);
+    degenerate.AddMeasurement(4.3f, 3, 3 * numTexels);
+    degenerate.AddMeasurement(6.7f, 7, 7 * numTexels);
+    degenerate.AddMeasurement(3.1f, 2, 2 * numTexels);
+    check("FeedbackScheduler/SameSizeCostPerResolve", (degenerate.EstimateCost(numTexels) > 0) &&
+        nearlyEqual(degenerate.EstimateCost(numTexels), degenerate.EstimateCost(8 * numTexels)) &&
+        (0 == degenerate.GetStatistics().m_costPerMegaTexelMs));
+
+    return numFailures;
+}
+#endif
+
+//-----------------------------------------------------------------------------
+// cost of re-ordering the stale resources after UpdateLists are handed out
+//-----------------------------------------------------------------------------
+void BenchPriorityScheduler(Harness& in_harness)
+{
+    const UINT numResources = 1000;
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> dis(0.5f, 4.f);
+    std::vector<float> priorities(numResources);
+    for (auto& p : priorities) { p = dis(gen); }
+
+    in_harness.Run("PriorityScheduler/Sort/" + std::to_string(numResources), [priorities](UINT64 in_n)
+        {
+            Streaming::PriorityScheduler scheduler;
+            scheduler.Resize(priorities.size());
+            std::vector<UINT32> staleResources;
+            for (UINT i = 0; i < (UINT)priorities.size(); i++)
+            {
+                staleResources.push_back(i);
+                scheduler.Wake(i, priorities[i]);
+            }
+            for (UINT64 i = 0; i < in_n; i++)
+            {
+                scheduler.Sort(staleResources);
+                scheduler.Served(staleResources[0]); // one UpdateList per pass, heavy contention
+            }
+            g_sink = g_sink + staleResources[0];
+            return in_n;
+        });
+}
+
+//-----------------------------------------------------------------------------
+// file offset lookup for every tile load. needs a real .xet file
+//-----------------------------------------------------------------------------
+#ifdef _WIN32
+void BenchXeTexture(Harness& in_harness, const std::wstring& in_xetFileName)
+{
+    auto pTexture = std::make_shared<Streaming::XeTexture>(in_xetFileName);
+
+    // every standard tile, in the order they are typically requested: coarse to fine
+    std::vector<D3D12_TILED_RESOURCE_COORDINATE> coords;
+    UINT width = (pTexture->GetImageWidth() + 255) / 256;
+    UINT height = (pTexture->GetImageHeight() + 255) / 256;
+    for (UINT s = 0; (s < pTexture->GetMipCount()) && width && height; s++)
+    {
+        for (UINT y = 0; y < height; y++)
+        {
+            for (UINT x = 0; x < width; x++)
+            {
+                coords.push_back(D3D12_TILED_RESOURCE_COORDINATE{ x, y, 0, s });
+            }
+        }
+        if ((1 == width) && (1 == height)) { break; }
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+    }
+    std::reverse(coords.begin(), coords.end());
+
+    in_harness.Run("XeTexture/GetFileOffset", [pTexture, coords](UINT64 in_n)
+        {
+            UINT64 sum = 0;
+            for (UINT64 i = 0; i < in_n; i++)
+            {
+                sum += pTexture->GetFileOffset(coords[i % coords.size()]).offset;
+            }
+            g_sink = g_sink + sum;
+            return in_n;
+        });
+}
+#endif
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    Harness harness;
+    std::string jsonFileName;
+    std::string configFileName = "config/config.json";
+    std::string xetFileName;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        const bool haveValue = (i + 1) < argc;
+        if (("-filter" == arg) && haveValue) { harness.m_filter = argv[++i]; }
+        else if (("-minTime" == arg) && haveValue) { harness.m_minTime = std::max(0.001, std::atof(argv[++i])); }
+        else if (("-repetitions" == arg) && haveValue) { harness.m_repetitions = std::max(1, std::atoi(argv[++i])); }
+        else if (("-json" == arg) && haveValue) { jsonFileName = argv[++i]; }
+        else if (("-config" == arg) && haveValue) { configFileName = argv[++i]; }
+        else if (("-xet" == arg) && haveValue) { xetFileName = argv[++i]; }
+        else
+        {
+            std::cerr << "usage: microbench [-filter substring] [-minTime seconds] [-repetitions n] [-json file] [-config file] [-xet file]" << std::endl;
+            return -1;
+        }
+    }
+
+    Harness::WriteTableHeader();
+
+    BenchAllocators(harness);
+    BenchRingBuffer(harness);
+    BenchBitVector(harness);
+    BenchSynchronizationFlag(harness);
+    BenchTileMapping(harness);
+    BenchConfigurationParser(harness, configFileName);
+    BenchPriorityScheduler(harness);
+#ifdef _WIN32
+    if (xetFileName.size())
+    {
+        BenchXeTexture(harness, std::wstring(xetFileName.begin(), xetFileName.end()));
+    }
+#else
+    if (xetFileName.size())
+    {
+        std::cerr << "XeTexture/GetFileOffset: skipped, XeTexture requires Windows" << std::endl;
+    }
+#endif
+
+    if (jsonFileName.size() && !harness.WriteJson(jsonFileName))
+    {
+        std::cerr << "Failed to write " << jsonFileName << std::endl;
+        return -1;
+    }
+
+    // a failed check is an error, e.g. for benchmarkHarness
+    UINT numFailures = CheckPriorityScheduler();
+#ifdef _WIN32
+    numFailures += CheckFeedbackScheduler();
+#else
+    std::cerr << "FeedbackScheduler checks: skipped, FeedbackScheduler.cpp requires the Windows precompiled header" << std::endl;
+#endif
+    return (int)numFailures;
+}
@@ -17,8 +17,6 @@ for /R %%f in (*.dds) do (
 	%exedir%\DdsToXet.exe -in %%~nf.dds -out %outdir%\%%~nf.xet %*
 )
 
-for /R %%f in (*.xet) do (
-	echo %%~nf.xet
-	%exedir%\DdsToXet.exe -in %%~nf.xet -out %outdir%\%%~nf.xet %*
-)
+rem older xet files are migrated in parallel and validated
+%exedir%\DdsToXet.exe -migrate . -out %outdir% %*
 popd
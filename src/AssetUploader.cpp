@@ -44,108 +44,79 @@ void AssetUploader::Init(ID3D12Device* in_pDevice)
     queueDesc.Device = in_pDevice;
     ThrowIfFailed(factory->CreateQueue(&queueDesc, IID_PPV_ARGS(&m_memoryQueue)));
 
-    in_pDevice->CreateFence(m_fenceValue, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence));
+    in_pDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence));
     m_event = ::CreateEvent(nullptr, FALSE, FALSE, nullptr);
 }
 
 //-----------------------------------------------------------------------------
 // FIXME? only buffers supported.
+// the footprint of a buffer is its width, no need for GetCopyableFootprints()
 //-----------------------------------------------------------------------------
-AssetUploader::Request::Request(ID3D12Resource* in_pDstResource,
-    D3D12_RESOURCE_STATES in_before, D3D12_RESOURCE_STATES in_after) :
-    m_before(in_before), m_after(in_after)
+void AssetUploader::SubmitRequest(
+    ID3D12Resource* in_pResource,
+    const void* in_pData, const size_t in_dataSize,
+    D3D12_RESOURCE_STATES in_before, D3D12_RESOURCE_STATES in_after)
 {
-    m_pResource = in_pDstResource;
-
-    auto desc = in_pDstResource->GetDesc();
+    auto desc = in_pResource->GetDesc();
     ASSERT(D3D12_RESOURCE_DIMENSION_BUFFER == desc.Dimension);
 
-    UINT64 numBytes = 0;
-    ComPtr<ID3D12Device> device;
-    in_pDstResource->GetDevice(IID_PPV_ARGS(&device));
-    device->GetCopyableFootprints(&desc, 0, desc.MipLevels, 0, nullptr, nullptr, nullptr, &numBytes);
-    m_data.resize(numBytes);
+    m_batcher.Stage(in_pResource, in_pData, in_dataSize, (size_t)desc.Width);
+    m_barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(in_pResource, in_before, in_after));
 }
 
 //-----------------------------------------------------------------------------
+// UploadBatcher::Destination: memory -> buffer via DirectStorage
 //-----------------------------------------------------------------------------
-void AssetUploader::SubmitRequest(
-    ID3D12Resource* in_pResource,
-    const void* in_pData, const size_t in_dataSize,
-    D3D12_RESOURCE_STATES in_before, D3D12_RESOURCE_STATES in_after)
+void AssetUploader::Enqueue(void* in_pDestination, const BYTE* in_pStaged, UINT32 in_numBytes)
 {
-    ASSERT(D3D12_RESOURCE_DIMENSION_BUFFER == in_pResource->GetDesc().Dimension);
-
-    Request* pRequest = new Request(in_pResource, in_before, in_after);
-    auto numBytes = std::min(pRequest->GetBuffer().size(), in_dataSize);
-    memcpy(pRequest->GetBuffer().data(), in_pData, numBytes);
-
     DSTORAGE_REQUEST request = {};
-    request.UncompressedSize = (UINT32)pRequest->GetBuffer().size();
+    request.UncompressedSize = in_numBytes;
     request.Options.SourceType = DSTORAGE_REQUEST_SOURCE_MEMORY;
     request.Options.DestinationType = DSTORAGE_REQUEST_DESTINATION_BUFFER;
-    request.Source.Memory.Source = pRequest->GetBuffer().data();
-    request.Source.Memory.Size = request.UncompressedSize; // uncompressed upload
+    request.Source.Memory.Source = in_pStaged;
+    request.Source.Memory.Size = in_numBytes; // uncompressed upload
     request.Destination.Buffer.Offset = 0;
-    request.Destination.Buffer.Size = request.Source.Memory.Size;
-    request.Destination.Buffer.Resource = pRequest->GetResource();
+    request.Destination.Buffer.Size = in_numBytes;
+    request.Destination.Buffer.Resource = (ID3D12Resource*)in_pDestination;
 
     m_memoryQueue->EnqueueRequest(&request);
-    m_requests.push_back(pRequest);
 }
 
-//-----------------------------------------------------------------------------
-// wait for any in-flight uploads to complete, then free scratch data
-//-----------------------------------------------------------------------------
-void AssetUploader::WaitForInFlight()
+void AssetUploader::Signal(UINT64 in_batchId)
+{
+    m_memoryQueue->EnqueueSignal(m_fence.Get(), in_batchId);
+    m_memoryQueue->Submit();
+}
+
+UINT64 AssetUploader::GetCompletedBatch()
 {
-    if (m_inFlight.size())
+    return m_fence->GetCompletedValue();
+}
+
+void AssetUploader::WaitForBatch(UINT64 in_batchId)
+{
+    if (m_fence->GetCompletedValue() < in_batchId)
     {
-        // wait for previous command to complete before freeing that scratch memory
-        if (m_fence->GetCompletedValue() < m_fenceValue)
-        {
-            ThrowIfFailed(m_fence->SetEventOnCompletion(m_fenceValue, m_event));
-            WaitForSingleObject(m_event, INFINITE);
-        }
-
-        // free scratch space
-        for (auto p : m_inFlight)
-        {
-            delete p;
-        }
-        m_inFlight.clear();
+        ThrowIfFailed(m_fence->SetEventOnCompletion(in_batchId, m_event));
+        WaitForSingleObject(m_event, INFINITE);
     }
 }
 
 //-----------------------------------------------------------------------------
-// waits for previous call to complete
 // enqueues fence. submits DS work.
 // adds Wait() on fence to queue. adds transition barriers to command list.
 //-----------------------------------------------------------------------------
 void AssetUploader::WaitForUploads(ID3D12CommandQueue* in_pDependentQueue, ID3D12GraphicsCommandList* in_pCommandList)
 {
-    WaitForInFlight();
-
     // submit current work and set up cross-queue fence/wait
-    if (m_requests.size())
+    if (m_barriers.size())
     {
-        m_fenceValue++;
-        m_memoryQueue->EnqueueSignal(m_fence.Get(), m_fenceValue);
-        m_memoryQueue->Submit();
-
-        in_pDependentQueue->Wait(m_fence.Get(), m_fenceValue);
+        UINT64 batchId = m_batcher.Submit();
 
-        std::vector<D3D12_RESOURCE_BARRIER> barriers;
+        in_pDependentQueue->Wait(m_fence.Get(), batchId);
 
-        // free scratch space
-        for (auto p : m_requests)
-        {
-            barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(p->GetResource(), p->GetBefore(), p->GetAfter()));
-        }
-        in_pCommandList->ResourceBarrier((UINT)barriers.size(), barriers.data());
-
-        // don't delete in-flight scratch data until commands complete
-        m_inFlight.swap(m_requests);
+        in_pCommandList->ResourceBarrier((UINT)m_barriers.size(), m_barriers.data());
+        m_barriers.clear();
     }
 }
 
@@ -153,8 +124,7 @@ void AssetUploader::WaitForUploads(ID3D12CommandQueue* in_pDependentQueue, ID3D1
 //-----------------------------------------------------------------------------
 AssetUploader::~AssetUploader()
 {
-    WaitForInFlight();
-
-    ASSERT(0 == m_requests.size());
+    ASSERT(0 == m_barriers.size());
+    m_batcher.WaitForAll();
     CloseHandle(m_event);
 }
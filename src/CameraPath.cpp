@@ -0,0 +1,152 @@
+//*********************************************************
+//
+// Copyright 2020 Intel Corporation 
+//
+// Permission is hereby granted, free of charge, to any 
+// person obtaining a copy of this software and associated 
+// documentation files(the "Software"), to deal in the Software 
+// without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to 
+// whom the Software is furnished to do so, subject to the 
+// following conditions :
+// The above copyright notice and this permission notice shall 
+// be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+// DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+
+
+#include "pch.h"
+
+#include "CameraPath.h"
+
+#include <filesystem>
+
+using namespace DirectX;
+
+//-----------------------------------------------------------------------------
+// textures are stored by file name, so a path recorded from one media directory
+// can be replayed from another
+//-----------------------------------------------------------------------------
+void CameraPath::RecordObject(const std::wstring& in_textureFilename, const XMMATRIX& in_model, FXMVECTOR in_axis)
+{
+    Object object;
+    XMStoreFloat4x3(&object.m_model, in_model);
+    XMStoreFloat3(&object.m_axis, in_axis);
+
+    if (in_textureFilename.size())
+    {
+        std::wstring name = std::filesystem::path(in_textureFilename).filename().wstring();
+        auto i = std::find(m_textures.begin(), m_textures.end(), name);
+        object.m_texture = (UINT32)(i - m_textures.begin());
+        if (m_textures.end() == i)
+        {
+            m_textures.push_back(name);
+        }
+    }
+
+    m_objects.push_back(object);
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+void CameraPath::RecordFrame(const XMMATRIX& in_view, float in_spin, UINT in_numObjects)
+{
+    Frame frame;
+    XMStoreFloat4x3(&frame.m_view, in_view);
+    frame.m_spin = in_spin;
+    frame.m_numObjects = in_numObjects;
+    m_frames.push_back(frame);
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+bool CameraPath::Write(const std::wstring& in_filename) const
+{
+    std::ofstream outFile(std::filesystem::path(in_filename), std::ios::out | std::ios::binary);
+    if (!outFile.is_open())
+    {
+        return false;
+    }
+
+    Header header{ MAGIC, VERSION, (UINT32)m_textures.size(), (UINT32)m_objects.size(), (UINT32)m_frames.size() };
+    outFile.write((const char*)&header, sizeof(header));
+
+    for (const auto& t : m_textures)
+    {
+        UINT32 length = (UINT32)t.size();
+        outFile.write((const char*)&length, sizeof(length));
+        outFile.write((const char*)t.data(), length * sizeof(wchar_t));
+    }
+
+    outFile.write((const char*)m_objects.data(), m_objects.size() * sizeof(Object));
+    outFile.write((const char*)m_frames.data(), m_frames.size() * sizeof(Frame));
+
+    return outFile.good();
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+bool CameraPath::Read(const std::wstring& in_filename)
+{
+    m_textures.clear();
+    m_objects.clear();
+    m_frames.clear();
+
+    std::ifstream inFile(std::filesystem::path(in_filename), std::ios::in | std::ios::binary);
+    if (!inFile.is_open())
+    {
+        return false;
+    }
+
+    Header header{};
+    inFile.read((char*)&header, sizeof(header));
+    if ((!inFile.good()) || (MAGIC != header.m_magic) || (VERSION != header.m_version))
+    {
+        return false;
+    }
+
+    m_textures.resize(header.m_numTextures);
+    for (auto& t : m_textures)
+    {
+        UINT32 length = 0;
+        inFile.read((char*)&length, sizeof(length));
+        if ((!inFile.good()) || (length > MAX_PATH))
+        {
+            return false;
+        }
+        t.resize(length);
+        inFile.read((char*)t.data(), length * sizeof(wchar_t));
+    }
+
+    m_objects.resize(header.m_numObjects);
+    inFile.read((char*)m_objects.data(), m_objects.size() * sizeof(Object));
+
+    m_frames.resize(header.m_numFrames);
+    inFile.read((char*)m_frames.data(), m_frames.size() * sizeof(Frame));
+
+    if (!inFile.good())
+    {
+        m_frames.clear();
+        return false;
+    }
+
+    for (const auto& o : m_objects)
+    {
+        if ((NO_TEXTURE != o.m_texture) && (o.m_texture >= m_textures.size()))
+        {
+            m_frames.clear();
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,104 @@
+//*********************************************************
+//
+// Copyright 2020 Intel Corporation 
+//
+// Permission is hereby granted, free of charge, to any 
+// person obtaining a copy of this software and associated 
+// documentation files(the "Software"), to deal in the Software 
+// without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to 
+// whom the Software is furnished to do so, subject to the 
+// following conditions :
+// The above copyright notice and this permission notice shall 
+// be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+// DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+
+
+/*-----------------------------------------------------------------------------
+CameraPath
+
+Per-frame record of what was drawn, for replaying a session frame-exactly.
+
+Each frame stores the view matrix, the object spin for that frame, and the number of
+objects in the scene. Each object stores its transform and spin axis at creation and
+the file name of its texture. Replaying sets these instead of computing them, so the
+result does not depend on the camera animation, random placement, or object loading
+order, timing, or build.
+
+File: Header, texture names, objects, frames. Matrices are stored as 4x3 (affine).
+-----------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+#include <string>
+
+class CameraPath
+{
+public:
+    static constexpr UINT32 NO_TEXTURE = UINT32_MAX; // sky and terrain choose their own textures
+
+    struct Frame
+    {
+        DirectX::XMFLOAT4X3 m_view;
+        float m_spin{ 0 };        // radians each object rotated this frame
+        UINT32 m_numObjects{ 0 }; // including sky and terrain
+    };
+
+    struct Object
+    {
+        DirectX::XMFLOAT4X3 m_model; // when added to the scene
+        DirectX::XMFLOAT3 m_axis;    // spin axis
+        UINT32 m_texture{ NO_TEXTURE }; // index into GetTextures()
+    };
+
+    //-------------------------------------------
+    // recording
+    //-------------------------------------------
+    void RecordObject(const std::wstring& in_textureFilename, const DirectX::XMMATRIX& in_model, DirectX::FXMVECTOR in_axis);
+    void RecordFrame(const DirectX::XMMATRIX& in_view, float in_spin, UINT in_numObjects);
+
+    // returns false if the file could not be written
+    bool Write(const std::wstring& in_filename) const;
+
+    //-------------------------------------------
+    // replay
+    //-------------------------------------------
+    // returns false if the file could not be read or is not a camera path
+    bool Read(const std::wstring& in_filename);
+
+    UINT GetNumFrames() const { return (UINT)m_frames.size(); }
+    UINT GetNumObjects() const { return (UINT)m_objects.size(); }
+    const Frame& GetFrame(UINT in_index) const { return m_frames[in_index]; }
+    const Object& GetObject(UINT in_index) const { return m_objects[in_index]; }
+
+    // texture file names without path
+    const std::vector<std::wstring>& GetTextures() const { return m_textures; }
+private:
+    struct Header
+    {
+        UINT32 m_magic;
+        UINT32 m_version;
+        UINT32 m_numTextures;
+        UINT32 m_numObjects;
+        UINT32 m_numFrames;
+    };
+    static constexpr UINT32 MAGIC = 0x48545043; // "CPTH"
+    static constexpr UINT32 VERSION = 1;
+
+    std::vector<std::wstring> m_textures;
+    std::vector<Object> m_objects;
+    std::vector<Frame> m_frames;
+};
@@ -71,13 +71,23 @@ struct CommandLineArgs
     UINT m_maxNumObjects{ 1000 };     // number of descriptors to allocate for scene
     int m_numSpheres{ 0 };
     UINT m_anisotropy{ 16 };          // sampler anisotropy
+    UINT m_cullingGridThreshold{ 4096 }; // frustum culling uses a spatial grid with at least this many objects. 0 = never
+    float m_objectCreationBudgetMs{ 2.0f }; // per-frame time for adding objects prepared on worker threads. 0 = create all on the render thread
     bool m_lightFromView{ false };    // light direction is look direction, useful for demos
 
     float m_maxGpuFeedbackTimeMs{ 10.0f };
+    UINT m_softwareFeedback{ 0 }; // 0: sampler feedback on the GPU. N: feedback computed on the CPU, 1 sample per NxN pixels
     bool m_addAliasingBarriers{ false }; // adds a barrier for each streaming resource: alias(nullptr, pResource)
     UINT m_streamingHeapSize{ 16384 }; // in # of tiles, not bytes
     UINT m_numHeaps{ 1 };
 
+    // objects that are not visible keep their tiles for a grace period: # frames or milliseconds, whichever expires first. 0 = no limit
+    // if both are 0, objects are evicted as soon as they are not visible
+    UINT m_evictionGraceFrames{ 60 };
+    float m_evictionGraceMs{ 0 };
+    float m_evictionHeapPressure{ 0.9f }; // above this fraction of heap capacity, objects are evicted before their grace period expires
+    float m_terrainPriority{ 1.f }; // StreamingQoS::m_priority of the terrain relative to other objects (1)
+
     // e.g. -timingStart 5 -timingEnd 25 writes a CSV showing the time to run 20 frames between those 2 times
     // ignored if end frame == 0
     // -timingStart 3 -timingEnd 3 will time no frames
@@ -86,7 +96,21 @@ struct CommandLineArgs
     UINT m_timingStopFrame{ 0 };
     std::wstring m_timingFrameFileName; // where to write per-frame statistics
     std::wstring m_exitImageFileName;   // write an image on exit
+    std::wstring m_recordCameraPathFileName; // write the view, object spin, and object set of every frame on exit
+    std::wstring m_saveResidencyFileName;    // write the resident tiles of every streaming resource on exit
+    UINT m_saveResidencyFrame{ 0 };          // ... or at this frame, e.g. once the starting view has converged
+    std::wstring m_restoreResidencyFileName; // warm start: load the tiles saved by m_saveResidencyFileName on the first frame
+    std::wstring m_replayCameraPathFileName; // replay a recorded camera path frame-exactly, then exit
+    std::wstring m_eventTraceFileName; // record streaming thread events, write a Chrome trace on exit
+    std::wstring m_liveMetricsName;    // publish streaming statistics to shared memory with this name, for metricsReader
+    UINT m_liveMetricsIntervalMs{ 100 }; // time between live metrics samples
     bool m_waitForAssetLoad{ false };   // wait for assets to load before progressing frame #
+    std::wstring m_cullingBenchmarkFileName; // time frustum culling of 1k/10k/100k objects, write results, and exit
+    std::wstring m_terrainBenchmarkFileName; // time terrain generation, write results, and exit
+    std::wstring m_meshBenchmarkFileName; // time sphere mesh generation and caching, write results, and exit
+    std::wstring m_placementBenchmarkFileName; // time planet placement for 1k to 50k planets, write results, and exit
+    std::wstring m_uploadBenchmarkFileName; // time staging of 10k small buffer uploads, write results, and exit
+    std::wstring m_meshCacheDir; // generated meshes are saved here and loaded by later runs. empty = memory only
 
     //-------------------------------------------------------
     // state that is not settable from command line:
@@ -112,6 +136,7 @@ struct CommandLineArgs
     bool m_cameraUpLock{ true };       // navigation locks "up" to be y=1
     UINT m_numStreamingBatches{ 128 }; // number of in-flight batches of updates (UpdateLists)
     UINT m_minNumUploadRequests{ 2000 }; // milliseconds. heuristic to reduce frequency of Submit() calls
+    UINT m_lowTierThreshold{ 0 }; // # in-flight batches at which to stream low quality tiers (DdsToXet -lowtier). 0 disables
 
     // planet parameters
     UINT m_sphereLong{ 128 }; // # steps vertically. must be even
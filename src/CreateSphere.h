@@ -60,7 +60,13 @@ namespace SphereGen
         // when UVs are mirrored or using the "top-bottom" mirror mode, the edge vertices don't have to be duplicated
         bool repeatEdge = !in_props.m_mirrorU;
 
-        std::vector<Vertex> vertices;
+        // reserve the final sizes: latitude rows plus pole vertices, and 2 triangles per quad plus 1 per pole
+        {
+            UINT numVertices = (in_props.m_numLat - 2) * (in_props.m_numLong + (repeatEdge ? 1 : 0));
+            numVertices += in_props.m_topBottom ? 2 : (2 * in_props.m_numLong);
+            out_vertices.reserve(out_vertices.size() + numVertices);
+            out_indices.reserve(out_indices.size() + (in_props.m_numLat - 2) * in_props.m_numLong * 6);
+        }
         // compute sphere vertices
         // skip top and bottom rows (will just use single points)
         {
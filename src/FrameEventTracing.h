@@ -31,9 +31,13 @@
 
 #include "CommandLineArgs.h"
 
+#include <array>
+
 enum class RenderEvents
 {
     FrameBegin,
+    CullBegin,
+    CullEnd,                 // time for frustum culling
     TumEndFrameBegin,
     TumEndFrame,             // time for TileUpdateManager to perform EndFrame()
     WaitOnFencesBegin,       // how long between ExecuteCommandLists and next frame end?
@@ -68,20 +72,62 @@ public:
         UINT in_numUploads, UINT in_numEvictions,
         float in_cpuProcessFeedbackTime,
         float in_gpuProcessFeedbackTime,
-        UINT in_numFeedbackResolves, UINT in_numSubmits)
+        UINT in_numFeedbackResolves, UINT in_numSubmits,
+        float in_fractionResident, float in_mipDeficit)
     {
         m_events.push_back({
             in_renderList.GetLatest(),
             in_updateList.GetLatest(),
             in_numUploads, in_numEvictions,
             in_cpuProcessFeedbackTime, in_gpuProcessFeedbackTime,
-            in_numFeedbackResolves, in_numSubmits });
+            in_numFeedbackResolves, in_numSubmits,
+            in_fractionResident, in_mipDeficit });
+
+        auto columns = GetColumns(m_events.back());
+        for (UINT i = 0; i < (UINT)Column::Num; i++)
+        {
+            m_histograms[i].Add(columns[i]);
+        }
     }
 
+    // per-frame table, then p50/p90/p99/max of each column
+    // also writes the percentiles and histograms to a .json file with the same name
     void WriteEvents(HWND in_hWnd, const CommandLineArgs& in_args);
+
+    // whole-interval results (bandwidth, latency, ...) written to the .json "summary" object
+    // call before WriteEvents(). compared across runs by benchmarkHarness
+    void AddSummary(const char* in_name, double in_value) { m_summary.push_back({ in_name, in_value }); }
 private:
     Timer m_timer;
 
+    std::vector<std::pair<std::string, double>> m_summary;
+
+    // per-frame values, in CSV column order. times are in ms
+    enum class Column
+    {
+        CpuDraw,
+        EndFrame,
+        ExecuteCommandLists,
+        WaitPresent,
+        FrameTime,
+        Evictions,
+        Uploads,
+        CpuFeedback,
+        GpuFeedback,
+        NumResolves,
+        NumSubmits,
+        Cull,
+        Resident,    // % of tiles requested by feedback that are resident
+        MipDeficit,  // texel-weighted mean # mips between requested and resident
+        Num
+    };
+    using Columns = std::array<float, (UINT)Column::Num>;
+    static const char* GetColumnName(UINT in_column);
+
+    std::array<Histogram, (UINT)Column::Num> m_histograms;
+
+    void WriteJson(double in_totalTime);
+
     struct FrameEvents
     {
         TimeTracing<RenderEvents>::Accessor m_renderTimes;
@@ -92,10 +138,14 @@ private:
         float m_gpuFeedbackTime;
         UINT m_numGpuFeedbackResolves;
         UINT m_numSubmits;
+        float m_fractionResident;
+        float m_mipDeficit;
     };
 
     std::vector<FrameEvents> m_events;
 
+    static Columns GetColumns(const FrameEvents& in_events);
+
     const std::wstring m_adapterDescription;
 };
 
@@ -112,6 +162,53 @@ inline FrameEventTracing::FrameEventTracing(
     m_timer.Start();
 }
 
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+inline const char* FrameEventTracing::GetColumnName(UINT in_column)
+{
+    static const char* names[] = {
+        "cpu_draw", "TUM::EndFrame", "exec_cmd_list", "wait_present", "total_frame_time",
+        "evictions_completed", "copies_completed", "cpu_feedback", "feedback_resolve",
+        "num_resolves", "num_submits", "cull", "resident_pct", "mip_deficit" };
+    static_assert(_countof(names) == (UINT)Column::Num, "one name per column");
+    return names[in_column];
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+inline FrameEventTracing::Columns FrameEventTracing::GetColumns(const FrameEvents& in_events)
+{
+    auto& e = in_events;
+    float frameBegin = e.m_renderTimes.Get(RenderEvents::FrameBegin);
+    float cullBegin = e.m_renderTimes.Get(RenderEvents::CullBegin);
+    float cullEnd = e.m_renderTimes.Get(RenderEvents::CullEnd);
+    float tumEndFrameBegin = e.m_renderTimes.Get(RenderEvents::TumEndFrameBegin);
+    float tumEndFrame = e.m_renderTimes.Get(RenderEvents::TumEndFrame);
+    float waitOnFencesBegin = e.m_renderTimes.Get(RenderEvents::WaitOnFencesBegin);
+    float frameEnd = e.m_renderTimes.Get(RenderEvents::FrameEnd);
+
+    Columns columns{};
+    columns[(UINT)Column::CpuDraw] = (tumEndFrameBegin - frameBegin) * 1000;               // render thread drawing via DrawIndexInstanced(), etc.
+    columns[(UINT)Column::EndFrame] = (tumEndFrame - tumEndFrameBegin) * 1000;             // TUM::EndFrame()
+    columns[(UINT)Column::ExecuteCommandLists] = (waitOnFencesBegin - tumEndFrame) * 1000; // ExecuteCommandLists()
+    columns[(UINT)Column::WaitPresent] = (frameEnd - waitOnFencesBegin) * 1000;            // WaitForSingleObject()
+    columns[(UINT)Column::FrameTime] = (frameEnd - frameBegin) * 1000;                     // frame time
+
+    columns[(UINT)Column::Evictions] = (float)e.m_numTilesEvicted;  // tile virtual->physical removed
+    columns[(UINT)Column::Uploads] = (float)e.m_numTileCopiesQueued; // copies queued
+
+    columns[(UINT)Column::CpuFeedback] = e.m_cpuFeedbackTime * 1000;
+    columns[(UINT)Column::GpuFeedback] = e.m_gpuFeedbackTime * 1000;
+    columns[(UINT)Column::NumResolves] = (float)e.m_numGpuFeedbackResolves;
+    columns[(UINT)Column::NumSubmits] = (float)e.m_numSubmits;
+    columns[(UINT)Column::Cull] = (cullEnd - cullBegin) * 1000;
+    columns[(UINT)Column::Resident] = e.m_fractionResident * 100;
+    columns[(UINT)Column::MipDeficit] = e.m_mipDeficit;
+    return columns;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
 inline void FrameEventTracing::WriteEvents(HWND in_hWnd, const CommandLineArgs& in_args)
 {
     double totalTime = m_timer.Stop();
@@ -132,35 +229,82 @@ inline void FrameEventTracing::WriteEvents(HWND in_hWnd, const CommandLineArgs&
         << "media dir: " << in_args.m_mediaDir << "\n";
 
     *this << "\nTimers (ms)\n"
-        << "-----------------------------------------------------------------------------------------------------------\n"
-        << "cpu_draw TUM::EndFrame exec_cmd_list wait_present total_frame_time evictions_completed copies_completed cpu_feedback feedback_resolve num_resolves num_submits\n"
         << "-----------------------------------------------------------------------------------------------------------\n";
+    for (UINT i = 0; i < (UINT)Column::Num; i++)
+    {
+        *this << (i ? " " : "") << GetColumnName(i);
+    }
+    *this << "\n-----------------------------------------------------------------------------------------------------------\n";
 
     for (auto& e : m_events)
     {
-        float frameBegin = e.m_renderTimes.Get(RenderEvents::FrameBegin);
-        float tumEndFrameBegin = e.m_renderTimes.Get(RenderEvents::TumEndFrameBegin);
-        float tumEndFrame = e.m_renderTimes.Get(RenderEvents::TumEndFrame);
-        float waitOnFencesBegin = e.m_renderTimes.Get(RenderEvents::WaitOnFencesBegin);
-        float frameEnd = e.m_renderTimes.Get(RenderEvents::FrameEnd);
-
-        *this
-            << (tumEndFrameBegin - frameBegin) * 1000                // render thread drawing via DrawIndexInstanced(), etc.
-            << " " << (tumEndFrame - tumEndFrameBegin) * 1000        // TUM::EndFrame()
-            << " " << (waitOnFencesBegin - tumEndFrame) * 1000       // ExecuteCommandLists()
-            << " " << (frameEnd - waitOnFencesBegin) * 1000          // WaitForSingleObject()
-            << " " << (frameEnd - frameBegin) * 1000                 // frame time
-
-            << " " << e.m_numTilesEvicted // copies queued
-            << " " << e.m_numTileCopiesQueued  // tile virtual->physical removed
-
-            << " " << e.m_cpuFeedbackTime * 1000
-            << " " << e.m_gpuFeedbackTime * 1000
-            << " " << e.m_numGpuFeedbackResolves
-            << " " << e.m_numSubmits
-
-            << std::endl;
+        auto columns = GetColumns(e);
+        for (UINT i = 0; i < (UINT)Column::Num; i++)
+        {
+            *this << (i ? " " : "") << columns[i];
+        }
+        *this << std::endl;
     }
 
     *this << "Total Time (s): " << totalTime << std::endl;
+
+    // spikes are hidden in averages
+    *this << "\nPer-frame percentiles (ms, count, % or mips)\n"
+        << "metric mean p50 p90 p99 max\n";
+    for (UINT i = 0; i < (UINT)Column::Num; i++)
+    {
+        const auto& h = m_histograms[i];
+        *this << GetColumnName(i)
+            << " " << h.GetMean()
+            << " " << h.GetPercentile(0.50)
+            << " " << h.GetPercentile(0.90)
+            << " " << h.GetPercentile(0.99)
+            << " " << h.GetMax()
+            << "\n";
+    }
+    *this << std::endl;
+
+    WriteJson(totalTime);
+}
+
+//-----------------------------------------------------------------------------
+// for comparing runs without parsing the CSV
+//-----------------------------------------------------------------------------
+inline void FrameEventTracing::WriteJson(double in_totalTime)
+{
+    std::ofstream json(GetFileNameNoExt() + L".json");
+    if (!json.is_open()) { return; }
+
+    json << "{\n  \"numFrames\": " << m_events.size()
+        << ",\n  \"totalTime_s\": " << in_totalTime
+        << ",\n  \"metrics\": {";
+
+    for (UINT i = 0; i < (UINT)Column::Num; i++)
+    {
+        const auto& h = m_histograms[i];
+        json << (i ? "," : "") << "\n    \"" << GetColumnName(i) << "\": {"
+            << "\"count\": " << h.GetCount()
+            << ", \"mean\": " << h.GetMean()
+            << ", \"min\": " << h.GetMin()
+            << ", \"p50\": " << h.GetPercentile(0.50)
+            << ", \"p90\": " << h.GetPercentile(0.90)
+            << ", \"p99\": " << h.GetPercentile(0.99)
+            << ", \"max\": " << h.GetMax()
+            << ", \"histogram\": [";
+
+        // [bucket lower bound, count] for non-empty buckets
+        const char* pSeparator = "";
+        h.ForEachBucket([&](double in_value, UINT64 in_count)
+            {
+                json << pSeparator << "[" << in_value << ", " << in_count << "]";
+                pSeparator = ", ";
+            });
+        json << "]}";
+    }
+    json << "\n  },\n  \"summary\": {";
+    for (size_t i = 0; i < m_summary.size(); i++)
+    {
+        json << (i ? "," : "") << "\n    \"" << m_summary[i].first << "\": " << m_summary[i].second;
+    }
+    json << "\n  }\n}\n";
 }
@@ -0,0 +1,409 @@
+//*********************************************************
+//
+// Copyright 2020 Intel Corporation 
+//
+// Permission is hereby granted, free of charge, to any 
+// person obtaining a copy of this software and associated 
+// documentation files(the "Software"), to deal in the Software 
+// without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to 
+// whom the Software is furnished to do so, subject to the 
+// following conditions :
+// The above copyright notice and this permission notice shall 
+// be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+// DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+
+
+#include "pch.h"
+
+#include "FrustumCulling.h"
+
+#include <random>
+#include <cmath>
+#include <cfloat>
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+void FrustumCulling::SetNumObjects(UINT in_numObjects)
+{
+    if (in_numObjects == m_numObjects)
+    {
+        return;
+    }
+
+    UINT oldNumObjects = m_numObjects;
+    m_numObjects = in_numObjects;
+
+    // pad so the SIMD loop never needs a remainder
+    UINT paddedSize = (in_numObjects + 3) & ~3;
+    m_centerX.resize(paddedSize, 0);
+    m_centerY.resize(paddedSize, 0);
+    m_centerZ.resize(paddedSize, 0);
+    m_radius.resize(paddedSize, 0);
+    m_alwaysVisible.resize(paddedSize, 0);
+    m_visible.resize(paddedSize, 0);
+
+    // new objects and padding are invisible until set
+    for (UINT i = std::min(oldNumObjects, in_numObjects); i < paddedSize; i++)
+    {
+        m_centerX[i] = 0;
+        m_centerY[i] = 0;
+        m_centerZ[i] = 0;
+        m_radius[i] = -FLT_MAX;
+        m_alwaysVisible[i] = 0;
+        m_visible[i] = 0;
+    }
+
+    m_gridDirty = true;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+void FrustumCulling::SetSphere(UINT in_index, DirectX::FXMVECTOR in_center, float in_radius, bool in_alwaysVisible)
+{
+    m_centerX[in_index] = DirectX::XMVectorGetX(in_center);
+    m_centerY[in_index] = DirectX::XMVectorGetY(in_center);
+    m_centerZ[in_index] = DirectX::XMVectorGetZ(in_center);
+    m_radius[in_index] = in_radius;
+    m_alwaysVisible[in_index] = in_alwaysVisible;
+
+    m_gridDirty = true;
+}
+
+void FrustumCulling::SetObject(UINT in_index, const DirectX::XMMATRIX& in_modelMatrix, bool in_alwaysVisible)
+{
+    float radius = DirectX::XMVectorGetX(DirectX::XMVector3Length(in_modelMatrix.r[0]));
+    SetSphere(in_index, in_modelMatrix.r[3], radius, in_alwaysVisible);
+}
+
+//-----------------------------------------------------------------------------
+// planes from the columns of the (row-vector) view-projection matrix:
+// -w <= x <= w, -w <= y <= w, 0 <= z <= w
+//-----------------------------------------------------------------------------
+void FrustumCulling::ExtractPlanes(Planes& out_planes, const DirectX::XMMATRIX& in_viewProjection)
+{
+    const DirectX::XMMATRIX m = DirectX::XMMatrixTranspose(in_viewProjection);
+
+    const DirectX::XMVECTOR planes[6] = {
+        DirectX::XMVectorAdd(m.r[3], m.r[0]),      // left
+        DirectX::XMVectorSubtract(m.r[3], m.r[0]), // right
+        DirectX::XMVectorAdd(m.r[3], m.r[1]),      // bottom
+        DirectX::XMVectorSubtract(m.r[3], m.r[1]), // top
+        m.r[2],                                    // near
+        DirectX::XMVectorSubtract(m.r[3], m.r[2])  // far
+    };
+
+    for (UINT i = 0; i < 6; i++)
+    {
+        DirectX::XMFLOAT4 p;
+        DirectX::XMStoreFloat4(&p, DirectX::XMPlaneNormalize(planes[i]));
+        out_planes.m_x[i] = p.x;
+        out_planes.m_y[i] = p.y;
+        out_planes.m_z[i] = p.z;
+        out_planes.m_w[i] = p.w;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// a sphere is visible if it is not entirely behind any plane: dot(plane, center) >= -radius
+//-----------------------------------------------------------------------------
+void FrustumCulling::CullRange(const Planes& in_planes,
+    const float* in_pX, const float* in_pY, const float* in_pZ, const float* in_pRadius,
+    UINT in_count, const UINT* in_pIndices, BYTE* out_pVisible)
+{
+    using namespace DirectX;
+
+    XMVECTOR px[6], py[6], pz[6], pw[6];
+    for (UINT p = 0; p < 6; p++)
+    {
+        px[p] = XMVectorReplicate(in_planes.m_x[p]);
+        py[p] = XMVectorReplicate(in_planes.m_y[p]);
+        pz[p] = XMVectorReplicate(in_planes.m_z[p]);
+        pw[p] = XMVectorReplicate(in_planes.m_w[p]);
+    }
+
+    UINT i = 0;
+    for (; (i + 4) <= in_count; i += 4)
+    {
+        XMVECTOR x = XMLoadFloat4((const XMFLOAT4*)&in_pX[i]);
+        XMVECTOR y = XMLoadFloat4((const XMFLOAT4*)&in_pY[i]);
+        XMVECTOR z = XMLoadFloat4((const XMFLOAT4*)&in_pZ[i]);
+        XMVECTOR negRadius = XMVectorNegate(XMLoadFloat4((const XMFLOAT4*)&in_pRadius[i]));
+
+        XMVECTOR visible = XMVectorTrueInt();
+        for (UINT p = 0; p < 6; p++)
+        {
+            XMVECTOR d = XMVectorMultiplyAdd(x, px[p], pw[p]);
+            d = XMVectorMultiplyAdd(y, py[p], d);
+            d = XMVectorMultiplyAdd(z, pz[p], d);
+            visible = XMVectorAndInt(visible, XMVectorGreaterOrEqual(d, negRadius));
+        }
+
+        XMUINT4 mask;
+        XMStoreUInt4(&mask, visible);
+        if (in_pIndices)
+        {
+            out_pVisible[in_pIndices[i + 0]] = BYTE(mask.x & 1);
+            out_pVisible[in_pIndices[i + 1]] = BYTE(mask.y & 1);
+            out_pVisible[in_pIndices[i + 2]] = BYTE(mask.z & 1);
+            out_pVisible[in_pIndices[i + 3]] = BYTE(mask.w & 1);
+        }
+        else
+        {
+            out_pVisible[i + 0] = BYTE(mask.x & 1);
+            out_pVisible[i + 1] = BYTE(mask.y & 1);
+            out_pVisible[i + 2] = BYTE(mask.z & 1);
+            out_pVisible[i + 3] = BYTE(mask.w & 1);
+        }
+    }
+
+    // remainder (grid cells are not padded)
+    for (; i < in_count; i++)
+    {
+        bool visible = true;
+        for (UINT p = 0; p < 6; p++)
+        {
+            float d = in_pX[i] * in_planes.m_x[p] + in_pY[i] * in_planes.m_y[p] + in_pZ[i] * in_planes.m_z[p] + in_planes.m_w[p];
+            visible = visible && (d >= -in_pRadius[i]);
+        }
+        out_pVisible[in_pIndices ? in_pIndices[i] : i] = visible;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// bucket objects into a uniform grid of about 64 objects per cell
+//-----------------------------------------------------------------------------
+void FrustumCulling::BuildGrid()
+{
+    m_gridDirty = false;
+
+    float minX = FLT_MAX, minY = FLT_MAX, minZ = FLT_MAX;
+    float maxX = -FLT_MAX, maxY = -FLT_MAX, maxZ = -FLT_MAX;
+    for (UINT i = 0; i < m_numObjects; i++)
+    {
+        minX = std::min(minX, m_centerX[i]); maxX = std::max(maxX, m_centerX[i]);
+        minY = std::min(minY, m_centerY[i]); maxY = std::max(maxY, m_centerY[i]);
+        minZ = std::min(minZ, m_centerZ[i]); maxZ = std::max(maxZ, m_centerZ[i]);
+    }
+
+    const UINT objectsPerCell = 64;
+    UINT dim = (UINT)std::cbrt(float(m_numObjects) / objectsPerCell);
+    dim = std::max(1U, std::min(dim, 64U));
+
+    float scaleX = dim / std::max(maxX - minX, 1e-3f);
+    float scaleY = dim / std::max(maxY - minY, 1e-3f);
+    float scaleZ = dim / std::max(maxZ - minZ, 1e-3f);
+
+    auto GetCellIndex = [&](UINT i)
+    {
+        UINT x = std::min(dim - 1, UINT((m_centerX[i] - minX) * scaleX));
+        UINT y = std::min(dim - 1, UINT((m_centerY[i] - minY) * scaleY));
+        UINT z = std::min(dim - 1, UINT((m_centerZ[i] - minZ) * scaleZ));
+        return x + (y * dim) + (z * dim * dim);
+    };
+
+    // counting sort of objects by cell
+    m_cells.assign(dim * dim * dim, Cell{});
+    std::vector<UINT> cellIndices(m_numObjects);
+    for (UINT i = 0; i < m_numObjects; i++)
+    {
+        cellIndices[i] = GetCellIndex(i);
+        m_cells[cellIndices[i]].m_count++;
+    }
+    UINT first = 0;
+    for (auto& c : m_cells)
+    {
+        c.m_first = first;
+        first += c.m_count;
+        c.m_count = 0;
+    }
+
+    m_cellObjects.resize(m_numObjects);
+    m_cellX.resize(m_numObjects);
+    m_cellY.resize(m_numObjects);
+    m_cellZ.resize(m_numObjects);
+    m_cellRadius.resize(m_numObjects);
+    for (UINT i = 0; i < m_numObjects; i++)
+    {
+        auto& c = m_cells[cellIndices[i]];
+        UINT dst = c.m_first + c.m_count;
+        c.m_count++;
+
+        m_cellObjects[dst] = i;
+        m_cellX[dst] = m_centerX[i];
+        m_cellY[dst] = m_centerY[i];
+        m_cellZ[dst] = m_centerZ[i];
+        m_cellRadius[dst] = m_radius[i];
+    }
+
+    // bounding sphere of each cell: center of the bounds of its spheres, radius reaches the farthest sphere
+    for (auto& c : m_cells)
+    {
+        float cMinX = FLT_MAX, cMinY = FLT_MAX, cMinZ = FLT_MAX;
+        float cMaxX = -FLT_MAX, cMaxY = -FLT_MAX, cMaxZ = -FLT_MAX;
+        for (UINT j = c.m_first; j < (c.m_first + c.m_count); j++)
+        {
+            float r = std::max(0.f, m_cellRadius[j]);
+            cMinX = std::min(cMinX, m_cellX[j] - r); cMaxX = std::max(cMaxX, m_cellX[j] + r);
+            cMinY = std::min(cMinY, m_cellY[j] - r); cMaxY = std::max(cMaxY, m_cellY[j] + r);
+            cMinZ = std::min(cMinZ, m_cellZ[j] - r); cMaxZ = std::max(cMaxZ, m_cellZ[j] + r);
+        }
+        c.m_center = DirectX::XMFLOAT3((cMinX + cMaxX) * 0.5f, (cMinY + cMaxY) * 0.5f, (cMinZ + cMaxZ) * 0.5f);
+        c.m_radius = 0;
+        for (UINT j = c.m_first; j < (c.m_first + c.m_count); j++)
+        {
+            float dx = m_cellX[j] - c.m_center.x;
+            float dy = m_cellY[j] - c.m_center.y;
+            float dz = m_cellZ[j] - c.m_center.z;
+            float r = std::sqrtf(dx * dx + dy * dy + dz * dz) + std::max(0.f, m_cellRadius[j]);
+            c.m_radius = std::max(c.m_radius, r);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+void FrustumCulling::CullGrid(const Planes& in_planes)
+{
+    for (const auto& c : m_cells)
+    {
+        if (0 == c.m_count)
+        {
+            continue;
+        }
+
+        bool outside = false;
+        bool inside = true;
+        for (UINT p = 0; p < 6; p++)
+        {
+            float d = c.m_center.x * in_planes.m_x[p] + c.m_center.y * in_planes.m_y[p] + c.m_center.z * in_planes.m_z[p] + in_planes.m_w[p];
+            if (d < -c.m_radius)
+            {
+                outside = true;
+                break;
+            }
+            inside = inside && (d >= c.m_radius);
+        }
+
+        if (outside || inside)
+        {
+            for (UINT j = c.m_first; j < (c.m_first + c.m_count); j++)
+            {
+                m_visible[m_cellObjects[j]] = inside;
+            }
+        }
+        else
+        {
+            CullRange(in_planes, &m_cellX[c.m_first], &m_cellY[c.m_first], &m_cellZ[c.m_first], &m_cellRadius[c.m_first],
+                c.m_count, &m_cellObjects[c.m_first], m_visible.data());
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+UINT FrustumCulling::Cull(const DirectX::XMMATRIX& in_viewProjection)
+{
+    if (0 == m_numObjects)
+    {
+        return 0;
+    }
+
+    Planes planes;
+    ExtractPlanes(planes, in_viewProjection);
+
+    if (m_gridThreshold && (m_numObjects >= m_gridThreshold))
+    {
+        if (m_gridDirty)
+        {
+            BuildGrid();
+        }
+        CullGrid(planes);
+    }
+    else
+    {
+        CullRange(planes, m_centerX.data(), m_centerY.data(), m_centerZ.data(), m_radius.data(),
+            (UINT)m_radius.size(), nullptr, m_visible.data());
+    }
+
+    UINT numVisible = 0;
+    for (UINT i = 0; i < m_numObjects; i++)
+    {
+        m_visible[i] |= m_alwaysVisible[i];
+        numVisible += m_visible[i];
+    }
+    return numVisible;
+}
+
+//-----------------------------------------------------------------------------
+// random spheres in a cube around a rotating camera. also reports how many
+// objects the previous "in front of the camera" (w > 0) test would have kept
+//-----------------------------------------------------------------------------
+void FrustumCulling::Benchmark(std::wostream& out_stream)
+{
+    using namespace DirectX;
+
+    const float worldSize = 1000.f;
+    const XMMATRIX projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.f / 9.f, 1.f, worldSize * 4);
+
+    out_stream << "objects grid visible in_front_of_camera ms_per_cull\n";
+
+    for (UINT numObjects : { 1000U, 10000U, 100000U })
+    {
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<float> pos(-worldSize, worldSize);
+        std::uniform_real_distribution<float> radius(1.f, 20.f);
+
+        FrustumCulling culling;
+        culling.SetNumObjects(numObjects);
+        for (UINT i = 0; i < numObjects; i++)
+        {
+            culling.SetSphere(i, XMVectorSet(pos(gen), pos(gen), pos(gen), 1), radius(gen));
+        }
+
+        const UINT numIterations = std::max(20U, 2000000U / numObjects);
+
+        for (UINT grid = 0; grid < 2; grid++)
+        {
+            culling.SetGridThreshold(grid ? 1 : 0);
+
+            UINT totalVisible = 0;
+            UINT totalInFront = 0;
+            Timer timer;
+            double cullTime = 0;
+            for (UINT n = 0; n < numIterations; n++)
+            {
+                float yaw = XM_2PI * n / numIterations;
+                XMMATRIX view = XMMatrixLookToLH(XMVectorZero(), XMVectorSet(std::sinf(yaw), 0.25f, std::cosf(yaw), 0), XMVectorSet(0, 1, 0, 0));
+                XMMATRIX viewProjection = view * projection;
+
+                timer.Start();
+                totalVisible += culling.Cull(viewProjection);
+                cullTime += timer.GetTime();
+
+                // what the w > 0 test accepts (not timed)
+                for (UINT i = 0; i < numObjects; i++)
+                {
+                    XMVECTOR c = XMVectorSet(culling.m_centerX[i], culling.m_centerY[i], culling.m_centerZ[i], 1);
+                    totalInFront += (XMVectorGetW(XMVector4Transform(c, viewProjection)) > 0);
+                }
+            }
+
+            out_stream << numObjects << " " << grid
+                << " " << totalVisible / numIterations
+                << " " << totalInFront / numIterations
+                << " " << 1000.0 * cullTime / numIterations << std::endl;
+        }
+    }
+}
@@ -0,0 +1,122 @@
+//*********************************************************
+//
+// Copyright 2020 Intel Corporation 
+//
+// Permission is hereby granted, free of charge, to any 
+// person obtaining a copy of this software and associated 
+// documentation files(the "Software"), to deal in the Software 
+// without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to 
+// whom the Software is furnished to do so, subject to the 
+// following conditions :
+// The above copyright notice and this permission notice shall 
+// be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+// DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+
+
+/*-----------------------------------------------------------------------------
+FrustumCulling
+
+Bounding sphere vs. view frustum, for many objects.
+
+Spheres are stored as structure-of-arrays (x[], y[], z[], radius[]) so each plane test
+processes 4 objects per SIMD instruction. For large scenes, objects are also bucketed
+into a uniform grid: a cell entirely outside the frustum skips all of its objects,
+a cell entirely inside marks all of its objects visible without testing them.
+
+Usage: SetNumObjects(), SetObject() when an object is created or moves,
+Cull() once per frame, then IsVisible()
+-----------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+#include <ostream>
+
+class FrustumCulling
+{
+public:
+    // in_gridThreshold: use the grid if there are at least this many objects. 0 = never
+    FrustumCulling(UINT in_gridThreshold = 4096) : m_gridThreshold(in_gridThreshold) {}
+
+    // new objects are invisible until SetObject()
+    void SetNumObjects(UINT in_numObjects);
+    UINT GetNumObjects() const { return m_numObjects; }
+
+    // bounding sphere from a model matrix: center = translation, radius = scale (sphere meshes have radius 1)
+    // in_alwaysVisible: never culled, e.g. the sky or the terrain
+    void SetObject(UINT in_index, const DirectX::XMMATRIX& in_modelMatrix, bool in_alwaysVisible = false);
+    void SetSphere(UINT in_index, DirectX::FXMVECTOR in_center, float in_radius, bool in_alwaysVisible = false);
+
+    void SetGridThreshold(UINT in_gridThreshold) { m_gridThreshold = in_gridThreshold; }
+
+    // in_viewProjection: view * projection (row vectors, D3D clip space z = [0..w])
+    // returns the number of visible objects
+    UINT Cull(const DirectX::XMMATRIX& in_viewProjection);
+
+    bool IsVisible(UINT in_index) const { return 0 != m_visible[in_index]; }
+
+    // time Cull() for 1k, 10k, and 100k random spheres with and without the grid
+    static void Benchmark(std::wostream& out_stream);
+private:
+    UINT m_numObjects{ 0 };
+    UINT m_gridThreshold{ 0 };
+
+    // structure of arrays, padded to a multiple of 4
+    std::vector<float> m_centerX;
+    std::vector<float> m_centerY;
+    std::vector<float> m_centerZ;
+    std::vector<float> m_radius;
+    std::vector<BYTE> m_alwaysVisible;
+
+    std::vector<BYTE> m_visible; // result of Cull(), 1 per object
+
+    // 6 normalized planes facing inward, as SoA for splatting
+    struct Planes
+    {
+        float m_x[6];
+        float m_y[6];
+        float m_z[6];
+        float m_w[6];
+    };
+    static void ExtractPlanes(Planes& out_planes, const DirectX::XMMATRIX& in_viewProjection);
+
+    // tests in_count spheres. writes visibility to out_pVisible[i], or out_pVisible[in_pIndices[i]] if in_pIndices
+    static void CullRange(const Planes& in_planes,
+        const float* in_pX, const float* in_pY, const float* in_pZ, const float* in_pRadius,
+        UINT in_count, const UINT* in_pIndices, BYTE* out_pVisible);
+
+    //-------------------------------------------
+    // uniform grid, rebuilt when objects change
+    //-------------------------------------------
+    struct Cell
+    {
+        DirectX::XMFLOAT3 m_center; // bounds all the spheres in the cell
+        float m_radius;
+        UINT m_first;               // range within m_cellObjects
+        UINT m_count;
+    };
+    bool m_gridDirty{ true };
+    std::vector<Cell> m_cells;
+    std::vector<UINT> m_cellObjects; // object indices sorted by cell
+    // copies of the spheres in m_cellObjects order, so each cell is contiguous
+    std::vector<float> m_cellX;
+    std::vector<float> m_cellY;
+    std::vector<float> m_cellZ;
+    std::vector<float> m_cellRadius;
+
+    void BuildGrid();
+    void CullGrid(const Planes& in_planes);
+};
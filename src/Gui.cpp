@@ -110,11 +110,9 @@ void Gui::DrawHeapOccupancyBar(UINT in_numTilesCommitted, UINT in_totalHeapSize,
 //-----------------------------------------------------------------------------
 // compute MB/s in a consistent way across UI
 //-----------------------------------------------------------------------------
-float Gui::ComputeBandwidth(UINT in_numTiles, float in_numSeconds)
+float Gui::ComputeBandwidth(UINT64 in_numBytes, float in_numSeconds)
 {
-    float tilesPerSecond = float(in_numTiles) / in_numSeconds;
-    float bytesPerTileDivMega = float(64 * 1024) / (1000.f * 1000.f);
-    return (tilesPerSecond * bytesPerTileDivMega);
+    return float(in_numBytes) / (in_numSeconds * 1000.f * 1000.f);
 }
 
 //-----------------------------------------------------------------------------
@@ -132,12 +130,12 @@ void Gui::DrawLineGraph(const std::vector<float>& in_ringBuffer, UINT in_head, c
     ImGui::PushStyleColor(ImGuiCol_Text, infoColor);
     ImGui::PushStyleColor(ImGuiCol_PlotLines, ImVec4(1.0f, 1.0f, 1.0f, 1.0f));
 
-    // # tiles / cpu time 
-    ASSERT(m_cpuTimes.GetNumEntries() == m_numUploads.GetNumEntries());
+    // # bytes / cpu time 
+    ASSERT(m_cpuTimes.GetNumEntries() == m_numBytesRead.GetNumEntries());
 
-    auto numTiles = m_numUploads.GetRange();
+    auto numBytes = m_numBytesRead.GetRange();
     float seconds = m_cpuTimer.GetSecondsFromDelta(m_cpuTimes.GetRange());
-    float mbps = ComputeBandwidth((UINT)numTiles, seconds);
+    float mbps = ComputeBandwidth(numBytes, seconds);
 
     float graphMin = 0.0f;
     float graphMax = 0.0f;
@@ -164,13 +162,13 @@ void Gui::DrawLineGraph(const std::vector<float>& in_ringBuffer, UINT in_head, c
 
 //-----------------------------------------------------------------------------
 // get time since last frame
-// use # uploads to compute average bandwidth
+// use # bytes read to compute average bandwidth
 // while here, update the average cpu time
 //-----------------------------------------------------------------------------
-void Gui::UpdateBandwidthHistory(UINT in_numTilesUploaded)
+void Gui::UpdateBandwidthHistory(UINT64 in_numBytesRead)
 {
     float seconds = m_cpuTimer.GetSecondsFromDelta(m_cpuTimes.GetMostRecentDelta());
-    m_bandwidthHistory[m_bandwidthHistoryIndex] = ComputeBandwidth(in_numTilesUploaded, seconds);
+    m_bandwidthHistory[m_bandwidthHistoryIndex] = ComputeBandwidth(in_numBytesRead, seconds);
     m_bandwidthHistoryIndex = (m_bandwidthHistoryIndex + 1) % m_bandwidthHistory.size();
 }
 
@@ -180,8 +178,8 @@ void Gui::UpdateBandwidthHistory(UINT in_numTilesUploaded)
 void Gui::DrawMini(ID3D12GraphicsCommandList* in_pCommandList, const DrawParams& in_drawParams)
 {
     m_cpuTimes.Update(m_cpuTimer.GetTime());
-    m_numUploads.AddDelta(in_drawParams.m_numTilesUploaded);
-    UpdateBandwidthHistory(in_drawParams.m_numTilesUploaded);
+    m_numBytesRead.AddDelta(in_drawParams.m_numBytesRead);
+    UpdateBandwidthHistory(in_drawParams.m_numBytesRead);
 
     ImGui_ImplDX12_NewFrame();
     ImGui_ImplWin32_NewFrame();
@@ -294,8 +292,8 @@ void Gui::Draw(ID3D12GraphicsCommandList* in_pCommandList,
     CommandLineArgs& in_args, const DrawParams& in_drawParams, ButtonChanges& out_buttonChanges)
 {
     m_cpuTimes.Update(m_cpuTimer.GetTime());
-    m_numUploads.AddDelta(in_drawParams.m_numTilesUploaded);
-    UpdateBandwidthHistory(in_drawParams.m_numTilesUploaded);
+    m_numBytesRead.AddDelta(in_drawParams.m_numBytesRead);
+    UpdateBandwidthHistory(in_drawParams.m_numBytesRead);
 
     ImGui_ImplDX12_NewFrame();
     ImGui_ImplWin32_NewFrame();
@@ -47,6 +47,7 @@ public:
         float m_cpuFeedbackTime;   // time cpu is working on feedback & related datastructures (update thread)
         int m_scrollMipDim;
         UINT m_numTilesUploaded;
+        UINT64 m_numBytesRead;     // bytes read from files for the uploaded tiles
         UINT m_numTilesEvicted;
         UINT m_numTilesCommitted;
         UINT m_numTilesVirtual;
@@ -84,13 +85,13 @@ private:
     std::string m_adapterDescription;
 
     TotalSince m_cpuTimes;
-    TotalSince m_numUploads;
+    TotalSince m_numBytesRead;
     RawCpuTimer m_cpuTimer;
 
     static constexpr int m_historySize = 128;
     std::vector<float> m_bandwidthHistory;
     UINT m_bandwidthHistoryIndex{ 0 };
-    void UpdateBandwidthHistory(UINT in_numTilesUploaded);
+    void UpdateBandwidthHistory(UINT64 in_numBytesRead);
 
     bool m_benchmarkMode{ false };
     void ToggleBenchmarkMode(CommandLineArgs& in_args);
@@ -98,7 +99,7 @@ private:
     bool m_demoMode{ false };
     void ToggleDemoMode(CommandLineArgs& in_args);
 
-    float ComputeBandwidth(UINT in_numTiles, float in_numSeconds);
+    float ComputeBandwidth(UINT64 in_numBytes, float in_numSeconds);
 
     void DrawLineGraph(const std::vector<float>& in_ringBuffer, UINT in_head, const ImVec2 in_windowDim);
 
@@ -0,0 +1,166 @@
+//*********************************************************
+//
+// Copyright 2020 Intel Corporation 
+//
+// Permission is hereby granted, free of charge, to any 
+// person obtaining a copy of this software and associated 
+// documentation files(the "Software"), to deal in the Software 
+// without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to 
+// whom the Software is furnished to do so, subject to the 
+// following conditions :
+// The above copyright notice and this permission notice shall 
+// be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+// DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+
+
+#include "pch.h"
+
+#include "LiveMetricsWriter.h"
+#include "DebugHelper.h"
+
+//-----------------------------------------------------------------------------
+// the mapping is backed by the paging file and lives until the last handle closes,
+// so a reader can still read the final samples after the application exits
+//-----------------------------------------------------------------------------
+LiveMetricsWriter::LiveMetricsWriter(const std::wstring& in_name, UINT in_intervalMs,
+    UINT in_numHeapTiles, UINT64 in_stagingBytesCapacity) :
+    m_intervalMs(std::max(1u, in_intervalMs))
+{
+    const std::wstring name = LiveMetrics::NAME_PREFIX + in_name;
+    const UINT64 mappingSize = LiveMetrics::GetMappingSize();
+
+    m_mapping = CreateFileMapping(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+        DWORD(mappingSize >> 32), DWORD(mappingSize), name.c_str());
+    if (nullptr == m_mapping) { return; }
+
+    // another writer would corrupt the ring
+    if (ERROR_ALREADY_EXISTS == GetLastError())
+    {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+        return;
+    }
+
+    BYTE* pView = (BYTE*)MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, mappingSize);
+    if (nullptr == pView)
+    {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+        return;
+    }
+
+    // new mappings are zero-filled, so every sequence starts at 0 (never written)
+    m_pHeader = (LiveMetrics::Header*)pView;
+    m_pSamples = (LiveMetrics::Sample*)(pView + sizeof(LiveMetrics::Header));
+
+    m_pHeader->m_headerSize = sizeof(LiveMetrics::Header);
+    m_pHeader->m_sampleSize = sizeof(LiveMetrics::Sample);
+    m_pHeader->m_numSamples = LiveMetrics::NUM_SAMPLES;
+    m_pHeader->m_processId = GetCurrentProcessId();
+    m_pHeader->m_intervalMs = m_intervalMs;
+    m_pHeader->m_numHeapTiles = in_numHeapTiles;
+    m_pHeader->m_stagingBytesCapacity = in_stagingBytesCapacity;
+    m_pHeader->m_version = LiveMetrics::VERSION;
+
+    // readers check the magic last
+    std::atomic_thread_fence(std::memory_order_release);
+    m_pHeader->m_magic = LiveMetrics::MAGIC;
+
+    m_timer.Start();
+}
+
+LiveMetricsWriter::~LiveMetricsWriter()
+{
+    if (m_pHeader)
+    {
+        UnmapViewOfFile(m_pHeader);
+    }
+    if (m_mapping)
+    {
+        CloseHandle(m_mapping);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// call once per frame
+//-----------------------------------------------------------------------------
+void LiveMetricsWriter::Update(UINT64 in_frameNumber, const TileUpdateManagerStatistics& in_statistics, UINT in_numHeapTilesCommitted)
+{
+    if (nullptr == m_pHeader) { return; }
+
+    double time = m_timer.GetTime();
+    m_frameTimes.Add((time - m_previousFrameTime) * 1000.0);
+    m_previousFrameTime = time;
+
+    if (((time - m_previousSampleTime) * 1000.0) >= m_intervalMs)
+    {
+        Publish(in_frameNumber, in_statistics, in_numHeapTilesCommitted, time);
+        m_previousSampleTime = time;
+        m_previousStatistics = in_statistics;
+        m_frameTimes = Histogram();
+    }
+}
+
+//-----------------------------------------------------------------------------
+// single writer: mark the slot odd, fill it, then publish the even sequence and the count
+//-----------------------------------------------------------------------------
+void LiveMetricsWriter::Publish(UINT64 in_frameNumber, const TileUpdateManagerStatistics& in_statistics, UINT in_numHeapTilesCommitted, double in_time)
+{
+    const UINT64 sampleIndex = m_pHeader->m_numWritten.load(std::memory_order_relaxed);
+    auto& sample = m_pSamples[sampleIndex % LiveMetrics::NUM_SAMPLES];
+
+    sample.m_sequence.store(2 * sampleIndex + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const auto& s = in_statistics;
+    const auto& p = m_previousStatistics;
+    const double seconds = std::max(in_time - m_previousSampleTime, 1e-6);
+
+    sample.m_timeUs = UINT64(in_time * 1000000.0);
+    sample.m_frameNumber = in_frameNumber;
+
+    sample.m_numTilesRequested = s.m_numTilesRequested;
+    sample.m_numTilesUploaded = s.m_numTilesUploaded;
+    sample.m_numTilesEvicted = s.m_numTilesEvicted;
+    sample.m_compressedBytesRead = s.m_compressedBytesRead;
+    sample.m_uncompressedBytesRead = s.m_uncompressedBytesRead;
+
+    sample.m_numTilesInFlight = s.m_numTilesInFlight;
+    sample.m_numUpdateListsBusy = s.m_numUpdateLists - s.m_numUpdateListsFree;
+    sample.m_numUpdateLists = s.m_numUpdateLists;
+    sample.m_stagingBytesInFlight = s.m_stagingBytesInFlight;
+
+    sample.m_numHeapTilesCommitted = in_numHeapTilesCommitted;
+    sample.m_numTilesResident = s.m_numTilesResident;
+
+    sample.m_bandwidthMBps = double(s.m_compressedBytesRead - p.m_compressedBytesRead) / (seconds * 1000.0 * 1000.0);
+    sample.m_uploadsPerSecond = double(s.m_numTilesUploaded - p.m_numTilesUploaded) / seconds;
+
+    UINT64 latencyCounts[TileUpdateManagerStatistics::NUM_LATENCY_BUCKETS]{};
+    for (UINT i = 0; i < TileUpdateManagerStatistics::NUM_LATENCY_BUCKETS; i++)
+    {
+        latencyCounts[i] = s.m_tileLatencyHistogram[i] - p.m_tileLatencyHistogram[i];
+    }
+    sample.m_tileLatencyP50Ms = TileUpdateManagerStatistics::GetLatencyPercentileUs(latencyCounts, 0.50) / 1000.0;
+    sample.m_tileLatencyP90Ms = TileUpdateManagerStatistics::GetLatencyPercentileUs(latencyCounts, 0.90) / 1000.0;
+    sample.m_tileLatencyP99Ms = TileUpdateManagerStatistics::GetLatencyPercentileUs(latencyCounts, 0.99) / 1000.0;
+
+    sample.m_frameTimeP50Ms = m_frameTimes.GetPercentile(0.50);
+    sample.m_frameTimeP99Ms = m_frameTimes.GetPercentile(0.99);
+    sample.m_frameTimeMaxMs = m_frameTimes.GetMax();
+
+    sample.m_sequence.store(2 * (sampleIndex + 1), std::memory_order_release);
+    m_pHeader->m_numWritten.store(sampleIndex + 1, std::memory_order_release);
+}
@@ -0,0 +1,77 @@
+//*********************************************************
+//
+// Copyright 2020 Intel Corporation 
+//
+// Permission is hereby granted, free of charge, to any 
+// person obtaining a copy of this software and associated 
+// documentation files(the "Software"), to deal in the Software 
+// without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to 
+// whom the Software is furnished to do so, subject to the 
+// following conditions :
+// The above copyright notice and this permission notice shall 
+// be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+// DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+
+
+
+/*-----------------------------------------------------------------------------
+LiveMetricsWriter
+
+Publishes streaming statistics to named shared memory for metricsReader and
+other external monitors. See LiveMetrics.h for the layout.
+
+Update() is called once per frame from the render thread. It only times the frame;
+every interval it also fills the next sample of the ring from the lock-free
+TileUpdateManager::GetStatistics() snapshot. The streaming threads are not touched.
+-----------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <string>
+
+#include "LiveMetrics.h"
+#include "TimeTracing.h"
+#include "SamplerFeedbackStreaming.h"
+
+class LiveMetricsWriter
+{
+public:
+    // in_name is the shared memory name without the "Local\" prefix
+    LiveMetricsWriter(const std::wstring& in_name, UINT in_intervalMs,
+        UINT in_numHeapTiles, UINT64 in_stagingBytesCapacity);
+    ~LiveMetricsWriter();
+
+    bool IsValid() const { return nullptr != m_pHeader; }
+
+    void Update(UINT64 in_frameNumber, const TileUpdateManagerStatistics& in_statistics, UINT in_numHeapTilesCommitted);
+private:
+    HANDLE m_mapping{ nullptr };
+    LiveMetrics::Header* m_pHeader{ nullptr };
+    LiveMetrics::Sample* m_pSamples{ nullptr };
+
+    const UINT m_intervalMs;
+
+    Timer m_timer;
+    double m_previousFrameTime{ 0 };
+    double m_previousSampleTime{ 0 };
+
+    // frame times since the previous sample
+    Histogram m_frameTimes;
+
+    // for interval rates and percentiles
+    TileUpdateManagerStatistics m_previousStatistics;
+
+    void Publish(UINT64 in_frameNumber, const TileUpdateManagerStatistics& in_statistics, UINT in_numHeapTilesCommitted, double in_time);
+};
@@ -0,0 +1,217 @@
+//*********************************************************
+//
+// Copyright 2020 Intel Corporation 
+//
+// Permission is hereby granted, free of charge, to any 
+// person obtaining a copy of this software and associated 
+// documentation files(the "Software"), to deal in the Software 
+// without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to 
+// whom the Software is furnished to do so, subject to the 
+// following conditions :
+// The above copyright notice and this permission notice shall 
+// be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+// DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+
+
+
+#include "pch.h"
+
+#include "MeshCache.h"
+
+#include <fstream>
+#include <filesystem>
+#include <sstream>
+#include <iomanip>
+
+//-----------------------------------------------------------------------------
+// file layout: FileHeader, key, vertices, then per lod: UINT32 count, indices
+//-----------------------------------------------------------------------------
+namespace
+{
+    struct FileHeader
+    {
+        UINT32 m_magic;
+        UINT32 m_version;
+        UINT32 m_keySize;
+        UINT32 m_vertexSize;
+        UINT64 m_verticesSize; // bytes
+        UINT32 m_numLods;
+        UINT32 m_reserved;
+    };
+    constexpr UINT32 MESH_MAGIC = 0x4853454d; // "MESH"
+    constexpr UINT32 MESH_VERSION = 1;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+MeshCache& MeshCache::Get()
+{
+    static MeshCache meshCache;
+    return meshCache;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+void MeshCache::SetDirectory(const std::wstring& in_directory)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_directory = in_directory;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+void MeshCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_meshes.clear();
+}
+
+//-----------------------------------------------------------------------------
+// the lock is held while generating so concurrent requests for the same mesh
+// wait for the first instead of generating it again
+//-----------------------------------------------------------------------------
+MeshCache::MeshPtr MeshCache::Find(const std::string& in_key, Generate in_generate)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto i = m_meshes.find(in_key);
+    if (m_meshes.end() != i)
+    {
+        return i->second;
+    }
+
+    auto pMesh = std::make_shared<Mesh>();
+    if (!Load(in_key, *pMesh))
+    {
+        in_generate(*pMesh);
+        Save(in_key, *pMesh);
+    }
+
+    m_meshes[in_key] = pMesh;
+    return pMesh;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+std::wstring MeshCache::GetFileName(const std::string& in_key) const
+{
+    std::wstringstream name;
+    name << std::hex << std::setw(16) << std::setfill(L'0') << (UINT64)std::hash<std::string>{}(in_key) << L".mesh";
+    return (std::filesystem::path(m_directory) / name.str()).wstring();
+}
+
+//-----------------------------------------------------------------------------
+// returns false if there is no directory, no file, or the file does not match
+//-----------------------------------------------------------------------------
+bool MeshCache::Load(const std::string& in_key, Mesh& out_mesh) const
+{
+    if (0 == m_directory.size())
+    {
+        return false;
+    }
+
+    std::ifstream inFile(std::filesystem::path(GetFileName(in_key)), std::ios::binary);
+    if (!inFile.good())
+    {
+        return false;
+    }
+
+    FileHeader header{};
+    inFile.read((char*)&header, sizeof(header));
+    if ((!inFile.good()) || (MESH_MAGIC != header.m_magic) || (MESH_VERSION != header.m_version)
+        || (in_key.size() != header.m_keySize) || (0 == header.m_vertexSize))
+    {
+        return false;
+    }
+
+    std::string key(header.m_keySize, '\0');
+    inFile.read(key.data(), key.size());
+    if (key != in_key)
+    {
+        return false;
+    }
+
+    out_mesh.m_vertexSize = header.m_vertexSize;
+    out_mesh.m_vertices.resize(header.m_verticesSize);
+    inFile.read((char*)out_mesh.m_vertices.data(), out_mesh.m_vertices.size());
+
+    out_mesh.m_lods.resize(header.m_numLods);
+    for (auto& indices : out_mesh.m_lods)
+    {
+        UINT32 numIndices = 0;
+        inFile.read((char*)&numIndices, sizeof(numIndices));
+        if (!inFile.good())
+        {
+            break;
+        }
+        indices.resize(numIndices);
+        inFile.read((char*)indices.data(), indices.size() * sizeof(UINT32));
+    }
+
+    if (!inFile.good())
+    {
+        out_mesh = Mesh{};
+        return false;
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// failure to write is not an error, the mesh will be generated next time
+//-----------------------------------------------------------------------------
+void MeshCache::Save(const std::string& in_key, const Mesh& in_mesh) const
+{
+    if (0 == m_directory.size())
+    {
+        return;
+    }
+
+    std::error_code errorCode;
+    std::filesystem::create_directories(m_directory, errorCode);
+
+    // write to a temporary file, then rename, so a partial file is never loaded
+    std::wstring fileName = GetFileName(in_key);
+    std::wstring tempFileName = fileName + L".tmp";
+    {
+        std::ofstream outFile(std::filesystem::path(tempFileName), std::ios::binary);
+        if (!outFile.good())
+        {
+            return;
+        }
+
+        FileHeader header{};
+        header.m_magic = MESH_MAGIC;
+        header.m_version = MESH_VERSION;
+        header.m_keySize = (UINT32)in_key.size();
+        header.m_vertexSize = in_mesh.m_vertexSize;
+        header.m_verticesSize = in_mesh.m_vertices.size();
+        header.m_numLods = (UINT32)in_mesh.m_lods.size();
+        outFile.write((const char*)&header, sizeof(header));
+        outFile.write(in_key.data(), in_key.size());
+        outFile.write((const char*)in_mesh.m_vertices.data(), in_mesh.m_vertices.size());
+        for (const auto& indices : in_mesh.m_lods)
+        {
+            UINT32 numIndices = (UINT32)indices.size();
+            outFile.write((const char*)&numIndices, sizeof(numIndices));
+            outFile.write((const char*)indices.data(), indices.size() * sizeof(UINT32));
+        }
+    }
+
+    std::filesystem::rename(tempFileName, fileName, errorCode);
+    if (errorCode)
+    {
+        std::filesystem::remove(tempFileName, errorCode);
+    }
+}
@@ -0,0 +1,96 @@
+//*********************************************************
+//
+// Copyright 2020 Intel Corporation 
+//
+// Permission is hereby granted, free of charge, to any 
+// person obtaining a copy of this software and associated 
+// documentation files(the "Software"), to deal in the Software 
+// without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to 
+// whom the Software is furnished to do so, subject to the 
+// following conditions :
+// The above copyright notice and this permission notice shall 
+// be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+// DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+
+
+
+/*-----------------------------------------------------------------------------
+MeshCache
+
+Process-wide cache of generated CPU geometry, keyed by a string describing the
+generation parameters. Objects created with identical parameters, including objects
+that are deleted and later re-created, share one copy instead of re-generating it.
+
+Optionally, meshes are also written to a directory and loaded from there by later
+runs. The file stores the key, so a hash collision or a stale file is re-generated.
+
+Usage: MeshCache::Get().Find(key, generator) returns the cached mesh, calling the
+generator only if the mesh is neither in memory nor on disk
+-----------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <map>
+#include <functional>
+
+class MeshCache
+{
+public:
+    struct Mesh
+    {
+        UINT m_vertexSize{ 0 };                 // bytes per vertex
+        std::vector<BYTE> m_vertices;
+        std::vector<std::vector<UINT32>> m_lods; // index buffer per level of detail, all share the vertices
+
+        UINT GetNumVertices() const { return m_vertexSize ? UINT(m_vertices.size() / m_vertexSize) : 0; }
+        template<typename T> const T* GetVertices() const { return (const T*)m_vertices.data(); }
+
+        template<typename T> void SetVertices(const std::vector<T>& in_vertices)
+        {
+            m_vertexSize = sizeof(T);
+            m_vertices.assign((const BYTE*)in_vertices.data(), (const BYTE*)(in_vertices.data() + in_vertices.size()));
+        }
+    };
+    using MeshPtr = std::shared_ptr<const Mesh>;
+    using Generate = std::function<void(Mesh& out_mesh)>;
+
+    static MeshCache& Get();
+
+    // returns the mesh for in_key. thread safe.
+    MeshPtr Find(const std::string& in_key, Generate in_generate);
+
+    // empty: memory only (default)
+    void SetDirectory(const std::wstring& in_directory);
+    const std::wstring& GetDirectory() const { return m_directory; }
+
+    // forget meshes held in memory. meshes in use remain valid.
+    void Clear();
+private:
+    MeshCache() {}
+    MeshCache(const MeshCache&) = delete;
+    MeshCache& operator=(const MeshCache&) = delete;
+
+    std::mutex m_mutex;
+    std::map<std::string, MeshPtr> m_meshes;
+    std::wstring m_directory;
+
+    std::wstring GetFileName(const std::string& in_key) const;
+    bool Load(const std::string& in_key, Mesh& out_mesh) const;
+    void Save(const std::string& in_key, const Mesh& in_mesh) const;
+};
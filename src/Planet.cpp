@@ -34,6 +34,7 @@
 #include "Scene.h"
 #include "AssetUploader.h"
 #include "Subdivision.h"
+#include "MeshCache.h"
 
 struct PlanetVertex
 {
@@ -68,10 +69,10 @@ static ID3D12Resource* CreatePlanetIndexBuffer(
 
 static ID3D12Resource* CreatePlanetVertexBuffer(
     ID3D12Device* in_pDevice, AssetUploader& in_assetUploader,
-    const std::vector<PlanetVertex>& in_verts)
+    const std::vector<BYTE>& in_verts)
 {
     ID3D12Resource* pResource = nullptr;
-    UINT vertexBufferSize = UINT(in_verts.size()) * sizeof(in_verts[0]);
+    UINT vertexBufferSize = UINT(in_verts.size());
 
     const auto heapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
     const auto resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(vertexBufferSize);
@@ -89,32 +90,26 @@ static ID3D12Resource* CreatePlanetVertexBuffer(
     return pResource;
 }
 
-//=========================================================================
-// planets have multiple LoDs
-// Texture Coordinates may optionally be mirrored in U
-//=========================================================================
-SceneObjects::Planet::Planet(const std::wstring& in_filename,
-    TileUpdateManager* in_pTileUpdateManager,
-    StreamingHeap* in_pStreamingHeap,
-    ID3D12Device* in_pDevice, AssetUploader& in_assetUploader,
-    UINT in_sampleCount,
-    D3D12_CPU_DESCRIPTOR_HANDLE in_srvBaseCPU) :
-    BaseObject(in_filename, in_pTileUpdateManager, in_pStreamingHeap,
-        in_pDevice, in_srvBaseCPU, nullptr)
+//-----------------------------------------------------------------------------
+// cpu version of ComputeUV() in planetPS.hlsl, for software feedback
+//-----------------------------------------------------------------------------
+static DirectX::XMFLOAT2 ComputePlanetUV(const DirectX::XMFLOAT3& in_pos)
 {
-    SetAxis(DirectX::XMVectorSet(0, 0, 1, 0));
+    float rSquared = 1.f - (in_pos.z * in_pos.z);
+    float rs = 1.f / std::max(std::fabsf(in_pos.x), std::fabsf(in_pos.y));
 
-    D3D12_RASTERIZER_DESC rasterizerDesc = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
-    D3D12_DEPTH_STENCIL_DESC depthStencilDesc = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
-    // Define the vertex input layout
-    std::vector< D3D12_INPUT_ELEMENT_DESC> inputElementDescs = {
-        { "POS",    0, DXGI_FORMAT_R32G32B32_FLOAT, 0,  0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-        { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-    };
+    const float distortion = std::sqrtf(2.0f) / 2.f;
+    float t = rSquared * (1 - std::fabsf(in_pos.z)) * (1 - std::fabsf(in_pos.z));
+    float s = distortion + (rs - distortion) * t;
 
-    CreatePipelineState(L"planetPS.cso", L"planetPS-FB.cso", L"planetVS.cso",
-        in_pDevice, in_sampleCount, rasterizerDesc, depthStencilDesc, inputElementDescs);
+    return DirectX::XMFLOAT2((1 + in_pos.x * s) * 0.5f, (1 + in_pos.y * s) * 0.5f);
+}
 
+//-----------------------------------------------------------------------------
+// subdivided octahedron. each level of detail has 4x the triangles of the previous
+//-----------------------------------------------------------------------------
+static void GeneratePlanetMesh(MeshCache::Mesh& out_mesh, UINT in_numLods)
+{
     std::vector<PlanetVertex> verts;
     verts.push_back({ { 1, 0, 0 }, {0, 0, 0} }); // 0
     verts.push_back({ { 0, 1, 0 }, { 0, 0, 0 } }); // 1
@@ -153,39 +148,94 @@ SceneObjects::Planet::Planet(const std::wstring& in_filename,
         v.normal = v.pos;
     }
 
-    Subdivision sub(
-        [&](uint32_t a, uint32_t b)
+    Subdivision sub((uint32_t)verts.size(),
+        [&](uint32_t in_numVertices) { verts.resize(in_numVertices); },
+        [&](uint32_t a, uint32_t b, uint32_t i)
         {
-            uint32_t i = (uint32_t)verts.size();
             float x = (verts[a].pos.x + verts[b].pos.x) * 0.5f;
             float y = (verts[a].pos.y + verts[b].pos.y) * 0.5f;
             float z = (verts[a].pos.z + verts[b].pos.z) * 0.5f;
 
             DirectX::XMFLOAT3 pos;
             DirectX::XMStoreFloat3(&pos, DirectX::XMVector3Normalize(DirectX::XMVectorSet(x, y, z, 0)));
-            verts.push_back({ pos, pos });
-
-            return i;
+            verts[i] = { pos, pos };
         },
         edges, tris);
 
+    out_mesh.m_lods.resize(in_numLods);
+    for (auto& indices : out_mesh.m_lods)
+    {
+        sub.Next();
+        sub.GetIndices(indices);
+    }
+
+    out_mesh.SetVertices(verts);
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+MeshCache::MeshPtr SceneObjects::GetPlanetMesh(UINT in_numLods)
+{
+    return MeshCache::Get().Find("planet lods=" + std::to_string(in_numLods),
+        [&](MeshCache::Mesh& out_mesh) { GeneratePlanetMesh(out_mesh, in_numLods); });
+}
+
+//=========================================================================
+// planets have multiple LoDs
+// Texture Coordinates may optionally be mirrored in U
+//=========================================================================
+SceneObjects::Planet::Planet(const std::wstring& in_filename,
+    TileUpdateManager* in_pTileUpdateManager,
+    StreamingHeap* in_pStreamingHeap,
+    ID3D12Device* in_pDevice, AssetUploader& in_assetUploader,
+    UINT in_sampleCount,
+    D3D12_CPU_DESCRIPTOR_HANDLE in_srvBaseCPU) :
+    BaseObject(in_filename, in_pTileUpdateManager, in_pStreamingHeap,
+        in_pDevice, in_srvBaseCPU, nullptr)
+{
+    SetAxis(DirectX::XMVectorSet(0, 0, 1, 0));
+
+    D3D12_RASTERIZER_DESC rasterizerDesc = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+    D3D12_DEPTH_STENCIL_DESC depthStencilDesc = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
+    // Define the vertex input layout
+    std::vector< D3D12_INPUT_ELEMENT_DESC> inputElementDescs = {
+        { "POS",    0, DXGI_FORMAT_R32G32B32_FLOAT, 0,  0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    };
+
+    CreatePipelineState(L"planetPS.cso", L"planetPS-FB.cso", L"planetVS.cso",
+        in_pDevice, in_sampleCount, rasterizerDesc, depthStencilDesc, inputElementDescs);
+
     constexpr UINT numLods = SharedConstants::NUM_SPHERE_LEVELS_OF_DETAIL;
 
-    std::vector<ID3D12Resource*> indexBuffers(numLods);
+    MeshCache::MeshPtr pMesh = GetPlanetMesh(numLods);
+    const PlanetVertex* pVerts = pMesh->GetVertices<PlanetVertex>();
+    const UINT numVertices = pMesh->GetNumVertices();
 
+    std::vector<ID3D12Resource*> indexBuffers(numLods);
     for (UINT lod = 0; lod < numLods; lod++)
     {
-        sub.Next();
-        std::vector<uint32_t> indices;
-        sub.GetIndices(indices);
-        indexBuffers[lod] = CreatePlanetIndexBuffer(in_pDevice, in_assetUploader, indices);
+        indexBuffers[lod] = CreatePlanetIndexBuffer(in_pDevice, in_assetUploader, pMesh->m_lods[lod]);
+    }
+
+    // cpu geometry for software feedback. the uvs are computed per-pixel on the gpu,
+    // per-vertex is close enough to find the sampled regions
+    std::vector<SoftwareFeedback::Mesh::Vertex> feedbackVertices(numVertices);
+    for (UINT i = 0; i < numVertices; i++)
+    {
+        feedbackVertices[i] = { pVerts[i].pos, ComputePlanetUV(pVerts[i].pos) };
     }
     
     // only 1 vertex buffer is required for all LoDs because subdivided triangles re-use vertices
-    ID3D12Resource* pVertexBuffer = CreatePlanetVertexBuffer(in_pDevice, in_assetUploader, verts);
+    ID3D12Resource* pVertexBuffer = CreatePlanetVertexBuffer(in_pDevice, in_assetUploader, pMesh->m_vertices);
 
     for (UINT lod = 0; lod < numLods; lod++)
     {
-        SetGeometry(pVertexBuffer, (UINT)sizeof(verts[0]), indexBuffers[lod], numLods - lod - 1);
+        SetGeometry(pVertexBuffer, pMesh->m_vertexSize, indexBuffers[lod], numLods - lod - 1);
+
+        auto pFeedbackMesh = std::make_shared<SoftwareFeedback::Mesh>();
+        pFeedbackMesh->m_vertices = feedbackVertices;
+        pFeedbackMesh->m_indices = pMesh->m_lods[lod];
+        SetFeedbackMesh(pFeedbackMesh, numLods - lod - 1);
     }
 }
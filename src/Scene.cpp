@@ -26,6 +26,8 @@
 
 #include "pch.h"
 
+#include <filesystem>
+
 #include "Scene.h"
 
 #include "D3D12GpuTimer.h"
@@ -143,6 +145,8 @@ Scene::Scene(const CommandLineArgs& in_args, HWND in_hwnd) :
     , m_updateFeedbackTimes(in_args.m_statisticsNumFrames)
 {
     m_gen.seed(42);
+    m_frustumCulling.SetGridThreshold(in_args.m_cullingGridThreshold);
+    m_evictionTimer.Start();
     m_windowInfo.cbSize = sizeof(WINDOWINFO);
 
     UINT factoryFlags = 0;
@@ -224,10 +228,19 @@ Scene::Scene(const CommandLineArgs& in_args, HWND in_hwnd) :
         m_csvFile = std::make_unique<FrameEventTracing>(m_args.m_timingFrameFileName, adapterDescription);
         m_csvFile->Reserve(m_args.m_timingStopFrame - m_args.m_timingStartFrame);
     }
+
+    LoadCameraPath();
 }
 
 Scene::~Scene()
 {
+    if (m_args.m_recordCameraPathFileName.size() && !m_cameraPath.Write(m_args.m_recordCameraPathFileName))
+    {
+        ErrorMessage("Failed to write camera path ", m_args.m_recordCameraPathFileName);
+    }
+
+    SaveResidency();
+
     WaitForGpu();
 
     if (GetSystemMetrics(SM_REMOTESESSION) == 0)
@@ -248,6 +261,8 @@ Scene::~Scene()
 
     delete m_pFrustumViewer;
 
+    CancelPendingObjects(0);
+
     for (auto o : m_objects)
     {
         delete o;
@@ -258,6 +273,11 @@ Scene::~Scene()
         h->Destroy();
     }
 
+    if (m_args.m_eventTraceFileName.size() && !m_pTileUpdateManager->WriteEventTrace(m_args.m_eventTraceFileName))
+    {
+        ErrorMessage("Failed to write event trace ", m_args.m_eventTraceFileName);
+    }
+
     m_pTileUpdateManager->Destroy();
 }
 
@@ -679,116 +699,177 @@ void Scene::StartStreamingLibrary()
     tumDesc.m_swapChainBufferCount = SharedConstants::SWAP_CHAIN_BUFFER_COUNT;
     tumDesc.m_addAliasingBarriers = m_args.m_addAliasingBarriers;
     tumDesc.m_minNumUploadRequests = m_args.m_minNumUploadRequests;
+    tumDesc.m_lowTierThreshold = m_args.m_lowTierThreshold;
     tumDesc.m_useDirectStorage = m_args.m_useDirectStorage;
     tumDesc.m_threadPriority = (TileUpdateManagerDesc::ThreadPriority)m_args.m_threadPriority;
 
     m_pTileUpdateManager = TileUpdateManager::Create(tumDesc);
+    m_pTileUpdateManager->SetEventTracing(m_args.m_eventTraceFileName.size() > 0);
+    if (CommandLineArgs::VisualizationMode::TEXTURE != m_args.m_dataVisualizationMode)
+    {
+        m_pTileUpdateManager->SetVisualizationMode((UINT)m_args.m_dataVisualizationMode);
+    }
 
     // create 1 or more heaps to contain our StreamingResources
     for (UINT i = 0; i < m_args.m_numHeaps; i++)
     {
         m_sharedHeaps.push_back(m_pTileUpdateManager->CreateStreamingHeap(m_args.m_streamingHeapSize));
     }
+
+    if (m_args.m_liveMetricsName.size())
+    {
+        m_pLiveMetrics = std::make_unique<LiveMetricsWriter>(m_args.m_liveMetricsName, m_args.m_liveMetricsIntervalMs,
+            m_args.m_streamingHeapSize * m_args.m_numHeaps, UINT64(m_args.m_stagingSizeMB) * 1024 * 1024);
+        if (!m_pLiveMetrics->IsValid())
+        {
+            ErrorMessage("Failed to create live metrics shared memory ", m_args.m_liveMetricsName, " (in use by another instance?)");
+        }
+    }
 }
 
 //-----------------------------------------------------------------------------
 // generate a random scale, position, and rotation
-// also space the spheres so they do not touch
+// also space the spheres so they do not touch (see SpherePlacement)
 //-----------------------------------------------------------------------------
 XMMATRIX Scene::SetSphereMatrix()
 {
-    static std::uniform_real_distribution<float> dis(-1, 1);
+    XMMATRIX matrix = XMMatrixIdentity();
+    if (!m_spherePlacement.Place(m_gen, matrix))
+    {
+        ErrorMessage("Failed to fit planet in universe. Universe too small?");
+    }
+    return matrix;
+}
 
-    constexpr float MIN_SPHERE_SIZE = SharedConstants::SPHERE_SCALE;
-    constexpr float MAX_SPHERE_SIZE = SharedConstants::MAX_SPHERE_SCALE * MIN_SPHERE_SIZE;
-    constexpr float SPHERE_SPACING = float(MIN_SPHERE_SIZE) * .75f;
-    static std::uniform_real_distribution<float> scaleDis(MIN_SPHERE_SIZE, MAX_SPHERE_SIZE);
+//-----------------------------------------------------------------------------
+// planets share the geometry and pipeline state of the first earth or planet
+//-----------------------------------------------------------------------------
+void Scene::SetPlanetTransform(SceneObjects::BaseObject* in_pObject, bool in_earth)
+{
+    if (m_replayingCameraPath && (m_cameraPathObject < m_cameraPath.GetNumObjects()))
+    {
+        const auto& recorded = m_cameraPath.GetObject(m_cameraPathObject);
+        in_pObject->SetAxis(XMLoadFloat3(&recorded.m_axis));
+        in_pObject->GetModelMatrix() = XMLoadFloat4x3(&recorded.m_model);
+        m_spherePlacement.Add(in_pObject->GetModelMatrix());
+        return;
+    }
 
-    bool tryAgain = true;
-    UINT maxTries = 1000;
+    if (in_earth)
+    {
+        in_pObject->SetAxis(XMVectorSet(0, 0, 1, 0));
+    }
+    else
+    {
+        static std::uniform_real_distribution<float> dis(-1.f, 1.f);
+        in_pObject->SetAxis(DirectX::XMVector3NormalizeEst(DirectX::XMVectorSet(dis(m_gen), dis(m_gen), dis(m_gen), 0)));
+    }
+    in_pObject->GetModelMatrix() = SetSphereMatrix();
+}
 
-    XMMATRIX matrix = XMMatrixIdentity();
+//-----------------------------------------------------------------------------
+// the object takes the next slot in m_objects and the descriptor heap
+//-----------------------------------------------------------------------------
+void Scene::AddObject(SceneObjects::BaseObject* in_pObject, const std::wstring& in_textureFilename)
+{
+    UINT objectIndex = (UINT)m_objects.size();
+    m_objects.push_back(in_pObject);
 
-    while (tryAgain)
+    if (m_replayingCameraPath)
     {
-        if (maxTries)
-        {
-            maxTries--;
-        }
-        else
-        {
-            ErrorMessage("Failed to fit planet in universe. Universe too small?");
-        }
+        m_cameraPathObject++;
+    }
+    else if (m_args.m_recordCameraPathFileName.size())
+    {
+        bool ownTexture = (in_pObject == m_pSky) || (in_pObject == m_pTerrainSceneObject);
+        m_cameraPath.RecordObject(ownTexture ? std::wstring() : in_textureFilename, in_pObject->GetModelMatrix(), in_pObject->GetAxis());
+    }
 
-        float sphereScale = scaleDis(m_gen);
+    // never cull the sky
+    // also never cull the terrain object, or will see incorrect behavior when inspecting closely
+    m_frustumCulling.SetNumObjects((UINT)m_objects.size());
+    m_culledObjects.resize(m_objects.size());
+    m_frustumCulling.SetObject(objectIndex, in_pObject->GetModelMatrix(), (in_pObject == m_pSky) || (in_pObject == m_pTerrainSceneObject));
+}
 
-        float x = SharedConstants::UNIVERSE_SIZE * std::abs(dis(m_gen));
+//-----------------------------------------------------------------------------
+// register prepared objects in order, until the per-frame budget is spent
+// at least 1 per frame, so loading always progresses
+//-----------------------------------------------------------------------------
+void Scene::AddPendingObjects()
+{
+    Timer timer;
+    timer.Start();
 
-        // position sphere far from terrain
-        constexpr float hollowCenter = 4 * 128; // 128 is texture dim
-        if (x < -hollowCenter) { x -= hollowCenter; }
-        else if (x < hollowCenter) { x += hollowCenter; }
-         
-        float rx = (XM_2PI) * dis(m_gen);
-        float ry = (XM_2PI) * dis(m_gen);
-        float rz = (XM_2PI) * dis(m_gen);
+    while (m_pendingObjects.size() && m_pendingObjects.front().m_task.is_done())
+    {
+        auto& pending = m_pendingObjects.front();
 
-        XMMATRIX rtate0 = XMMatrixRotationRollPitchYaw((XM_2PI)*dis(m_gen), (XM_2PI)*dis(m_gen), (XM_2PI)*dis(m_gen));
-        XMMATRIX xlate = XMMatrixTranslation(0, 0, x);
-        XMMATRIX rtate = XMMatrixRotationRollPitchYaw(rx, ry, rz);
-        XMMATRIX scale = XMMatrixScaling(sphereScale, sphereScale, sphereScale);
+        UINT objectIndex = (UINT)m_objects.size();
+        UINT descriptorOffset = (UINT)DescriptorHeapOffsets::NumEntries + objectIndex * (UINT)SceneObjects::Descriptors::NumEntries;
+        CD3DX12_CPU_DESCRIPTOR_HANDLE descCPU(m_srvHeap->GetCPUDescriptorHandleForHeapStart(), descriptorOffset, m_srvUavCbvDescriptorSize);
+        auto pHeap = m_sharedHeaps[objectIndex % m_sharedHeaps.size()];
 
-        matrix = rtate0 * scale * xlate * rtate;
-        matrix = scale * xlate * rtate;
+        auto o = new SceneObjects::Planet(pending.m_filename, pHeap, descCPU, pending.m_pSharedObject, pending.m_task.get());
+        SetPlanetTransform(o, pending.m_pSharedObject == m_pEarth);
+        AddObject(o, pending.m_filename);
 
-        tryAgain = false;
+        m_pendingObjects.pop_front();
 
-        // spread the spheres out
+        if ((timer.GetTime() * 1000.f) >= m_args.m_objectCreationBudgetMs)
         {
-            XMVECTOR p0 = matrix.r[3];
-            float s0 = sphereScale;
-            for (const auto o : m_objects)
-            {
-                if (o == m_pSky)
-                {
-                    continue;
-                }
-
-                XMVECTOR p1 = o->GetModelMatrix().r[3];
-                float dist = XMVectorGetX(XMVector3LengthEst(p1 - p0));
-                float s1 = XMVectorGetX(XMVector3LengthEst(o->GetModelMatrix().r[0]));
-
-                // leave a minimum spacing between planets
-                if (dist - (s0 + s1) < SPHERE_SPACING)
-                {
-                    tryAgain = true;
-                    break;
-                }
-            }
+            break;
         }
     }
+}
 
-    // pre-rotate to randomize axes
-    float rx = (1.5f * XM_PI) * dis(m_gen);
-    float ry = (2.5f * XM_PI) * dis(m_gen);
-    float rz = (2.0f * XM_PI) * dis(m_gen); // rotation around polar axis of sphere model
-    XMMATRIX rtate = XMMatrixRotationRollPitchYaw(rx, ry, rz);
-    matrix = rtate * matrix;
-
-    return matrix;
+//-----------------------------------------------------------------------------
+// objects that were requested, but are no longer wanted
+//-----------------------------------------------------------------------------
+void Scene::CancelPendingObjects(UINT in_numObjects)
+{
+    while (m_pendingObjects.size() && (m_objects.size() + m_pendingObjects.size() > in_numObjects))
+    {
+        m_pendingObjects.back().m_task.get()->Destroy();
+        m_pendingObjects.pop_back();
+    }
 }
 
 //-----------------------------------------------------------------------------
 // progressively over multiple frames, if there are many
+// copies of the first earth or planet are prepared on worker threads,
+// then added by AddPendingObjects() within m_objectCreationBudgetMs per frame
+// objects are added in the same order (and so with the same random placement)
+// as when all are created on the render thread
 //-----------------------------------------------------------------------------
 void Scene::LoadSpheres()
 {
-    if (m_objects.size() < (UINT)m_args.m_numSpheres)
+    // frame times while objects are being added
+    if (m_loadingObjects)
     {
-        // offset by all the objects that have been loaded so far
-        UINT descriptorOffset = (UINT)DescriptorHeapOffsets::NumEntries + UINT(m_objects.size()) * (UINT)SceneObjects::Descriptors::NumEntries;
-        CD3DX12_CPU_DESCRIPTOR_HANDLE descCPU = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_srvHeap->GetCPUDescriptorHandleForHeapStart(), descriptorOffset, m_srvUavCbvDescriptorSize);
+        m_objectLoadFrameTimes.push_back(float(m_objectLoadFrameTimer.GetTime() * 1000));
+    }
+    m_objectLoadFrameTimer.Start();
 
+    // replay the recorded object set. objects are created on the render thread, so exactly
+    // the recorded number is present at each frame
+    if (m_replayingCameraPath && (m_cameraPathFrame < m_cameraPath.GetNumFrames()))
+    {
+        m_args.m_numSpheres = (int)m_cameraPath.GetFrame(m_cameraPathFrame).m_numObjects;
+    }
+
+    CancelPendingObjects((UINT)m_args.m_numSpheres);
+    const UINT numObjects = (UINT)m_objects.size();
+    AddPendingObjects();
+
+    // start assigning textures from the beginning for each new batch of objects
+    if (!m_loadingObjects)
+    {
+        m_textureIndex = 0;
+    }
+
+    if (m_objects.size() + m_pendingObjects.size() < (UINT)m_args.m_numSpheres)
+    {
         // is there a sky?
         std::wstring skyTexture;
         if (m_args.m_skyTexture.size())
@@ -803,21 +884,65 @@ void Scene::LoadSpheres()
             }
         }
 
-        UINT textureIndex = 0;
-        while (m_objects.size() < (UINT)m_args.m_numSpheres)
+        const bool background = (m_args.m_objectCreationBudgetMs > 0);
+
+        while (m_objects.size() + m_pendingObjects.size() < (UINT)m_args.m_numSpheres)
         {
+            // grab the next texture, or the one the recorded object used
+            UINT fileIndex = m_textureIndex % m_args.m_textures.size();
+            if (m_replayingCameraPath && (m_cameraPathObject < m_cameraPath.GetNumObjects()))
+            {
+                UINT recordedTexture = m_cameraPath.GetObject(m_cameraPathObject).m_texture;
+                if (CameraPath::NO_TEXTURE != recordedTexture)
+                {
+                    fileIndex = m_cameraPathTextures[recordedTexture];
+                }
+            }
+            const auto& textureFilename = m_args.m_textures[fileIndex];
+
+            bool earth = m_args.m_earthTexture.size() && (std::wstring::npos != textureFilename.find(m_args.m_earthTexture));
+            bool skipTexture = (std::wstring::npos != textureFilename.find(m_args.m_terrainTexture)) && (m_args.m_textures.size() > 1);
+
+            // copies of an existing earth or planet can be prepared in the background
+            SceneObjects::Planet* pSharedObject = nullptr;
+            if (((nullptr != m_pSky) || (0 == skyTexture.size())) && (nullptr != m_pTerrainSceneObject))
+            {
+                if (earth) { pSharedObject = m_pEarth; }
+                else if (skipTexture)
+                {
+                    m_textureIndex++;
+                    continue;
+                }
+                else { pSharedObject = m_pFirstSphere; }
+            }
+            if (background && pSharedObject)
+            {
+                m_textureIndex++;
+                TileUpdateManager* pTileUpdateManager = m_pTileUpdateManager;
+                std::wstring filename = textureFilename;
+                m_pendingObjects.push_back({ filename, pSharedObject,
+                    concurrency::create_task([pTileUpdateManager, filename]() { return pTileUpdateManager->PrepareStreamingResource(filename); }) });
+                continue;
+            }
+
+            // objects created on the render thread must wait their turn
+            if (m_pendingObjects.size())
+            {
+                break;
+            }
+            m_textureIndex++;
+
             // this object's index-to-be
             UINT objectIndex = (UINT)m_objects.size();
 
+            // offset by all the objects that have been loaded so far
+            UINT descriptorOffset = (UINT)DescriptorHeapOffsets::NumEntries + objectIndex * (UINT)SceneObjects::Descriptors::NumEntries;
+            CD3DX12_CPU_DESCRIPTOR_HANDLE descCPU(m_srvHeap->GetCPUDescriptorHandleForHeapStart(), descriptorOffset, m_srvUavCbvDescriptorSize);
+
             // put this resource into one of our shared heaps
             UINT heapIndex = objectIndex % m_sharedHeaps.size();
             auto pHeap = m_sharedHeaps[heapIndex];
 
-            // grab the next texture
-            UINT fileIndex = textureIndex % m_args.m_textures.size();
-            textureIndex++;
-            const auto& textureFilename = m_args.m_textures[fileIndex];
-
             SceneObjects::BaseObject* o = nullptr;
 
             SphereGen::Properties sphereProperties;
@@ -841,9 +966,16 @@ void Scene::LoadSpheres()
                 m_pTerrainSceneObject = new SceneObjects::Terrain(m_args.m_terrainTexture, m_pTileUpdateManager, pHeap, m_device.Get(), m_args.m_sampleCount, descCPU, m_args, m_assetUploader);
                 m_terrainObjectIndex = objectIndex;
                 o = m_pTerrainSceneObject;
+                if (1.f != m_args.m_terrainPriority)
+                {
+                    StreamingQoS qos;
+                    qos.m_priority = m_args.m_terrainPriority;
+                    o->GetStreamingResource()->SetQoS(qos);
+                }
+                m_spherePlacement.Add(o->GetModelMatrix());
             }
             // earth
-            else if (m_args.m_earthTexture.size() && (std::wstring::npos != textureFilename.find(m_args.m_earthTexture)))
+            else if (earth)
             {
                 if (nullptr == m_pEarth)
                 {
@@ -856,12 +988,11 @@ void Scene::LoadSpheres()
                 {
                     o = new SceneObjects::Planet(textureFilename, pHeap, descCPU, m_pEarth);
                 }
-                o->SetAxis(XMVectorSet(0, 0, 1, 0));
-                o->GetModelMatrix() = SetSphereMatrix();
+                SetPlanetTransform(o, true);
             }
 
             // if there are textures other than the terrain texture, skip this one
-            else if ((std::wstring::npos != textureFilename.find(m_args.m_terrainTexture)) && (m_args.m_textures.size() > 1))
+            else if (skipTexture)
             {
                 continue;
             }
@@ -880,18 +1011,13 @@ void Scene::LoadSpheres()
                 {
                     o = new SceneObjects::Planet(textureFilename, pHeap, descCPU, m_pFirstSphere);
                 }
-                static std::uniform_real_distribution<float> dis(-1.f, 1.f);
-                o->SetAxis(DirectX::XMVector3NormalizeEst(DirectX::XMVectorSet(dis(m_gen), dis(m_gen), dis(m_gen), 0)));
-                o->GetModelMatrix() = SetSphereMatrix();
+                SetPlanetTransform(o, false);
             }
-            m_objects.push_back(o);
-
-            // offset to the next sphere
-            descCPU.Offset((UINT)SceneObjects::Descriptors::NumEntries, m_srvUavCbvDescriptorSize);
+            AddObject(o, textureFilename);
         }
     }
     // evict spheres?
-    else if (m_objects.size() > (UINT)m_args.m_numSpheres)
+    if (m_objects.size() > (UINT)m_args.m_numSpheres)
     {
         WaitForGpu();
         while (m_objects.size() > (UINT)m_args.m_numSpheres)
@@ -922,6 +1048,135 @@ void Scene::LoadSpheres()
             delete pObject;
             m_objects.resize(m_objects.size() - 1);
         }
+        m_frustumCulling.SetNumObjects((UINT)m_objects.size());
+        m_culledObjects.resize(m_objects.size());
+
+        // new planets must only avoid the remaining objects
+        m_spherePlacement.Clear();
+        for (auto o : m_objects)
+        {
+            if (o != m_pSky) { m_spherePlacement.Add(o->GetModelMatrix()); }
+        }
+    }
+
+    m_loadingObjects = m_pendingObjects.size() || (numObjects != m_objects.size()) || (m_objects.size() < (UINT)m_args.m_numSpheres);
+}
+
+//-----------------------------------------------------------------------------
+// track how long each object has not been visible
+// objects that become visible again before they are evicted keep their tiles
+//-----------------------------------------------------------------------------
+void Scene::UpdateCulledObject(UINT in_objectIndex, bool in_visible)
+{
+    auto& c = m_culledObjects[in_objectIndex];
+    if (in_visible)
+    {
+        if (c.m_culled && !c.m_evicted)
+        {
+            UINT numTiles = m_objects[in_objectIndex]->GetStreamingResource()->GetNumTilesResident();
+            m_reloadBytesAvoided += UINT64(numTiles) * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES;
+        }
+        c = CulledObject{};
+    }
+    else if (!c.m_culled)
+    {
+        c.m_culled = true;
+        c.m_frame = m_frameNumber;
+        c.m_time = m_evictionTimer.GetTime();
+    }
+}
+
+//-----------------------------------------------------------------------------
+// evict objects that have not been visible for longer than the grace period
+// under heap pressure, also evict objects within their grace period, longest-invisible first
+//-----------------------------------------------------------------------------
+void Scene::EvictCulledObjects()
+{
+    const bool graceEnabled = m_args.m_evictionGraceFrames || (m_args.m_evictionGraceMs > 0);
+    const double graceSeconds = m_args.m_evictionGraceMs / 1000.;
+    const double time = m_evictionTimer.GetTime();
+
+    // tiles that will be freed by objects that have already been evicted
+    UINT numTilesEvicting = 0;
+
+    m_evictionCandidates.clear();
+    for (UINT i = 0; i < (UINT)m_culledObjects.size(); i++)
+    {
+        auto& c = m_culledObjects[i];
+        if (!c.m_culled)
+        {
+            continue;
+        }
+
+        auto pResource = m_objects[i]->GetStreamingResource();
+
+        if (!c.m_evicted)
+        {
+            bool expired = (!graceEnabled) ||
+                (m_args.m_evictionGraceFrames && ((m_frameNumber - c.m_frame) >= m_args.m_evictionGraceFrames)) ||
+                ((graceSeconds > 0) && ((time - c.m_time) >= graceSeconds));
+            if (expired)
+            {
+                c.m_evicted = true;
+                if (graceEnabled) { m_numGraceEvictions++; }
+            }
+            else
+            {
+                c.m_priority = pResource->GetQoS().m_priority;
+                m_evictionCandidates.push_back(i);
+            }
+        }
+
+        // keep asking: feedback in flight when the object was culled could otherwise re-reference tiles
+        if (c.m_evicted)
+        {
+            pResource->QueueEviction();
+            numTilesEvicting += pResource->GetNumTilesResident();
+        }
+    }
+
+    if (0 == m_evictionCandidates.size())
+    {
+        return;
+    }
+
+    UINT numTilesAllocated = 0;
+    for (auto h : m_sharedHeaps)
+    {
+        numTilesAllocated += h->GetNumTilesAllocated();
+    }
+    numTilesAllocated -= std::min(numTilesAllocated, numTilesEvicting);
+
+    const UINT heapCapacity = m_args.m_streamingHeapSize * (UINT)m_sharedHeaps.size();
+    const UINT pressureLimit = UINT(heapCapacity * m_args.m_evictionHeapPressure);
+    if (numTilesAllocated <= pressureLimit)
+    {
+        return;
+    }
+
+    // lowest priority first, then longest-invisible
+    std::sort(m_evictionCandidates.begin(), m_evictionCandidates.end(),
+        [&](UINT a, UINT b)
+        {
+            const auto& ca = m_culledObjects[a];
+            const auto& cb = m_culledObjects[b];
+            if (ca.m_priority != cb.m_priority) { return ca.m_priority < cb.m_priority; }
+            return ca.m_frame < cb.m_frame;
+        });
+
+    UINT numTilesToFree = numTilesAllocated - pressureLimit;
+    for (UINT i : m_evictionCandidates)
+    {
+        auto pResource = m_objects[i]->GetStreamingResource();
+        pResource->QueueEviction();
+        m_culledObjects[i].m_evicted = true;
+        m_numPressureEvictions++;
+
+        numTilesToFree -= std::min(numTilesToFree, pResource->GetNumTilesResident());
+        if (0 == numTilesToFree)
+        {
+            break;
+        }
     }
 }
 
@@ -1083,38 +1338,61 @@ void Scene::SetSampler()
 
 //----------------------------------------------------------
 // time-limit the number of feedback resolves on the GPU
-// by keeping a running average of the time to resolve feedback
-// and only calling QueueFeedback() for a subset of the StreamingResources
+// TileUpdateManager ranks the visible objects by projected area and feedback history,
+// and learns the cost per resolve from the measured gpu time
 //----------------------------------------------------------
-UINT Scene::DetermineMaxNumFeedbackResolves()
+void Scene::ScheduleFeedback()
 {
-    UINT maxNumFeedbackResolves = 0;
+    m_feedbackScheduled.assign(m_objects.size(), 0);
 
     if (m_args.m_updateEveryObjectEveryFrame)
     {
-        maxNumFeedbackResolves = (UINT)m_objects.size();
+        std::fill(m_feedbackScheduled.begin(), m_feedbackScheduled.end(), 1);
+        return;
     }
-    else if (m_args.m_enableTileUpdates)
+
+    if (!m_args.m_enableTileUpdates)
     {
-        maxNumFeedbackResolves = 10;
+        return;
+    }
 
-        // how long did it take
-        const float feedbackTime = 1000.f * m_gpuProcessFeedbackTime;
+    const XMVECTOR eyePos = m_viewMatrixInverse.r[3];
+    const float tanHalfFov = std::tan(m_fieldOfView / 2.f);
 
-        if (feedbackTime > 0)
+    m_feedbackHints.clear();
+    m_feedbackHintObjects.clear();
+    for (UINT i = 0; i < (UINT)m_objects.size(); i++)
+    {
+        if (!m_frustumCulling.IsVisible(i))
         {
-            // keep a running average of feedback time
-            static AverageOver feedbackTimes;
-
-            float avgTimePerObject = feedbackTime / std::max(UINT(1), m_prevNumFeedbackObjects[m_frameIndex]);
-            feedbackTimes.Update(avgTimePerObject);
+            continue;
+        }
 
-            // # objects to meet target time
-            maxNumFeedbackResolves = std::max(UINT(1), UINT(m_args.m_maxGpuFeedbackTimeMs / feedbackTimes.Get()));
+        // fraction of the screen covered by the bounding sphere, approximately
+        const auto& modelMatrix = m_objects[i]->GetModelMatrix();
+        float radius = XMVectorGetX(XMVector3Length(modelMatrix.r[0]));
+        float distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(modelMatrix.r[3], eyePos)));
+        float screenArea = 1.f;
+        if (distance > radius)
+        {
+            float projectedRadius = radius / (distance * tanHalfFov);
+            screenArea = std::min(1.f, XM_PI * projectedRadius * projectedRadius / (4.f * m_aspectRatio));
         }
+
+        FeedbackHint hint;
+        hint.m_pResource = m_objects[i]->GetStreamingResource();
+        hint.m_screenArea = screenArea;
+        hint.m_distance = distance;
+        m_feedbackHints.push_back(hint);
+        m_feedbackHintObjects.push_back(i);
     }
 
-    return maxNumFeedbackResolves;
+    m_pTileUpdateManager->ScheduleFeedback(m_feedbackHints.data(), (UINT)m_feedbackHints.size(), m_args.m_maxGpuFeedbackTimeMs);
+
+    for (UINT i = 0; i < (UINT)m_feedbackHints.size(); i++)
+    {
+        m_feedbackScheduled[m_feedbackHintObjects[i]] = m_feedbackHints[i].m_scheduled;
+    }
 }
 
 //----------------------------------------------------------
@@ -1187,51 +1465,68 @@ void Scene::DrawObjects()
     // objects without feedback enabled will not call WriteSamplerFeedback()
     //------------------------------------------------------------------------------------
     {
-        UINT maxNumFeedbackResolves = DetermineMaxNumFeedbackResolves();
+        // objects only spin in place, so their bounding spheres were set when they were created
+        m_renderThreadTimes.Set(RenderEvents::CullBegin);
+        m_frustumCulling.Cull(m_viewMatrix * m_projection);
+        m_renderThreadTimes.Set(RenderEvents::CullEnd);
 
-        // clamp in case # objects changed
-        m_queueFeedbackIndex = m_queueFeedbackIndex % m_objects.size();
+        ScheduleFeedback();
+
+        const bool softwareFeedback = (0 != m_args.m_softwareFeedback);
+        if (softwareFeedback)
+        {
+            m_softwareFeedback.BeginFrame(m_windowWidth, m_windowHeight, m_args.m_softwareFeedback,
+                m_args.m_lodBias, m_args.m_anisotropy);
+        }
 
-        // loop over n objects starting with the range that we want to get sampler feedback from, then wrap around.
-        UINT numObjects = m_queueFeedbackIndex + (UINT)m_objects.size();
         UINT numFeedbackObjects = 0;
-        for (UINT i = m_queueFeedbackIndex; i < numObjects; i++)
+        for (UINT objectIndex = 0; objectIndex < (UINT)m_objects.size(); objectIndex++)
         {
-            UINT objectIndex = i % (UINT)m_objects.size();
             auto o = m_objects[objectIndex];
 
-            // FIXME: want proper frustum culling here
-            float w = XMVectorGetW(o->GetCombinedMatrix().r[3]);
-            // never cull the sky
-            // also never cull the terrain object, or will see incorrect behavior when inspecting closely
-            bool visible = (w > 0) || (o == m_pSky) || (o == m_pTerrainSceneObject);
+            bool visible = m_frustumCulling.IsVisible(objectIndex);
 
             // get sampler feedback for this object?
             bool queueFeedback = false;
 
             if (visible)
             {
-                if (numFeedbackObjects < maxNumFeedbackResolves)
+                if (m_feedbackScheduled[objectIndex])
                 {
                     queueFeedback = true;
                     numFeedbackObjects++;
                 }
 
-                o->SetFeedbackEnabled(queueFeedback);
+                // with software feedback, every visible object is rasterized so it can occlude others,
+                // but the gpu never writes feedback
+                if (softwareFeedback)
+                {
+                    o->DrawSoftwareFeedback(m_softwareFeedback, drawParams, queueFeedback);
+                    o->SetFeedbackEnabled(false);
+                }
+                else
+                {
+                    o->SetFeedbackEnabled(queueFeedback);
+                }
 
                 // only draw visible objects
                 // group objects by material (PSO)
                 m_frameObjectSets[o->GetPipelineState()].push_back({ o, objectIndex });
             }
-            else // evict tiles of objects that are not visible
-            {
-                o->GetStreamingResource()->QueueEviction();
-            }
+
+            // objects that are not visible are evicted after a grace period, see EvictCulledObjects()
+            UpdateCulledObject(objectIndex, visible);
         }
 
-        // next time, start feedback where we left off this time.
-        // note m_queueFeedbackIndex will be adjusted to # of objects next time, above
-        m_queueFeedbackIndex += numFeedbackObjects;
+        EvictCulledObjects();
+
+        if (softwareFeedback)
+        {
+            m_softwareFeedback.Resolve([&](const void* in_pKey, const BYTE* in_pMinMips)
+                {
+                    m_pTileUpdateManager->QueueCpuFeedback((StreamingResource*)in_pKey, in_pMinMips);
+                });
+        }
 
         // remember how many resolves were queued for the running average
         m_prevNumFeedbackObjects[m_frameIndex] = numFeedbackObjects;
@@ -1276,21 +1571,130 @@ void Scene::ScreenShot(std::wstring& in_fileName) const
     WindowCapture::CaptureRenderTarget(m_renderTargets[m_frameIndex].Get(), m_commandQueue.Get(), filename);
 }
 
+//-------------------------------------------------------------------------
+// the event trace keeps only the most recent events of each thread (a flight recorder)
+// each call writes a new file next to the one written on exit: name_1.json, name_2.json, ...
+//-------------------------------------------------------------------------
+void Scene::WriteEventTrace()
+{
+    if (0 == m_args.m_eventTraceFileName.size())
+    {
+        return;
+    }
+
+    const std::filesystem::path path(m_args.m_eventTraceFileName);
+    std::filesystem::path filename;
+    UINT index = 0;
+    do
+    {
+        filename = path.parent_path() / (path.stem().wstring() + L"_" + std::to_wstring(++index) + path.extension().wstring());
+    } while (std::filesystem::exists(filename));
+
+    if (m_pTileUpdateManager->WriteEventTrace(filename.wstring()))
+    {
+        DebugPrint(L"Wrote event trace ", filename.c_str(), L"\n");
+    }
+}
+
+//-------------------------------------------------------------------------
+// called every frame. the first frame drawn is the start: with -waitForAssetLoad, all objects and packed mips are ready
+// a warm start restores a residency snapshot, then feedback takes over once the restored tiles are resident
+//-------------------------------------------------------------------------
+void Scene::UpdateStartup(const TileUpdateManagerStatistics& in_statistics)
+{
+    if (!m_startupBegan)
+    {
+        m_startupBegan = true;
+        m_startupTimer.Start();
+
+        if (m_args.m_restoreResidencyFileName.size())
+        {
+            // as important as anything on screen. give up on tiles that don't fit in the heap after a while
+            PrefetchOptions options;
+            options.m_priority = 1.f;
+            options.m_expirySeconds = 30.f;
+            m_restoreHandle = m_pTileUpdateManager->RestoreResidencySnapshot(m_args.m_restoreResidencyFileName, options);
+            if (0 == m_restoreHandle)
+            {
+                ErrorMessage("Failed to read residency snapshot ", m_args.m_restoreResidencyFileName);
+            }
+        }
+    }
+
+    if (m_restoreHandle)
+    {
+        const auto status = m_pTileUpdateManager->GetPrefetchStatus(m_restoreHandle);
+        if (PrefetchStatus::Pending != status)
+        {
+            if (PrefetchStatus::Complete == status)
+            {
+                m_restoreSeconds = (float)m_startupTimer.GetTime();
+            }
+            m_pTileUpdateManager->ReleasePrefetch(m_restoreHandle);
+            m_restoreHandle = 0;
+        }
+    }
+
+    if ((0 == m_startupSecondsToQuality) && in_statistics.m_quality.m_numTilesWanted &&
+        (in_statistics.m_quality.GetFractionResident() >= 0.99f))
+    {
+        m_startupSecondsToQuality = (float)m_startupTimer.GetTime();
+    }
+
+    if (m_args.m_saveResidencyFrame && (m_frameNumber == m_args.m_saveResidencyFrame))
+    {
+        SaveResidency();
+    }
+}
+
+//-------------------------------------------------------------------------
+// once, at m_saveResidencyFrame or on exit
+//-------------------------------------------------------------------------
+void Scene::SaveResidency()
+{
+    if (m_residencySaved || (0 == m_args.m_saveResidencyFileName.size())) { return; }
+    m_residencySaved = true;
+
+    if (!m_pTileUpdateManager->WriteResidencySnapshot(m_args.m_saveResidencyFileName))
+    {
+        ErrorMessage("Failed to write residency snapshot ", m_args.m_saveResidencyFileName);
+    }
+}
+
 //-------------------------------------------------------------------------
 //-------------------------------------------------------------------------
 void Scene::GatherStatistics()
 {
     // NOTE: streaming isn't aware of frame time.
     // these numbers are approximately a measure of the number of operations during the last frame
-    const UINT numEvictions = m_pTileUpdateManager->GetTotalNumEvictions();
-    const UINT numUploads = m_pTileUpdateManager->GetTotalNumUploads();
+    const auto statistics = m_pTileUpdateManager->GetStatistics();
+    UpdateStartup(statistics);
+
+    const UINT numEvictions = (UINT)statistics.m_numTilesEvicted;
+    const UINT numUploads = (UINT)statistics.m_numTilesUploaded;
     static UINT numSubmits = 0;
 
     m_numEvictionsPreviousFrame = numEvictions - m_numTotalEvictions;
     m_numUploadsPreviousFrame = numUploads - m_numTotalUploads;
+    // visualization modes don't read files, so fall back to the uncompressed tile size
+    const bool readingFiles = (CommandLineArgs::VisualizationMode::TEXTURE == m_args.m_dataVisualizationMode);
+    auto GetBytesRead = [&](const TileUpdateManagerStatistics& s) { return readingFiles ? s.m_compressedBytesRead : s.m_uncompressedBytesRead; };
+    const UINT64 bytesRead = GetBytesRead(statistics);
+    m_numBytesReadPreviousFrame = bytesRead - m_numTotalBytesRead;
 
     m_numTotalEvictions = numEvictions;
     m_numTotalUploads = numUploads;
+    m_numTotalBytesRead = bytesRead;
+
+    if (m_pLiveMetrics)
+    {
+        UINT numHeapTilesCommitted = 0;
+        for (auto h : m_sharedHeaps)
+        {
+            numHeapTilesCommitted += h->GetNumTilesAllocated();
+        }
+        m_pLiveMetrics->Update(m_frameNumber, statistics, numHeapTilesCommitted);
+    }
 
     // statistics gathering
     if (m_args.m_timingFrameFileName.size() &&
@@ -1306,20 +1710,54 @@ void Scene::GatherStatistics()
             // Note: these may be off by 1 frame, but probably good enough
             m_pTileUpdateManager->GetCpuProcessFeedbackTime(),
             m_gpuProcessFeedbackTime, m_prevNumFeedbackObjects[m_frameIndex],
-            numSubmitsLastFrame);
+            numSubmitsLastFrame,
+            statistics.m_quality.GetFractionResident(), statistics.m_quality.m_mipDeficit);
 
         if (m_frameNumber == m_args.m_timingStopFrame)
         {
             float measuredTime = (float)m_cpuTimer.Stop();
             UINT measuredNumUploads = numUploads - m_startUploadCount;
-            float tilesPerSecond = float(measuredNumUploads) / measuredTime;
-            float bytesPerTileDivMega = float(64 * 1024) / (1000.f * 1000.f);
-            float mbps = tilesPerSecond * bytesPerTileDivMega;
+            // bytes actually read from disk. compressed tiles are usually much smaller than 64KB
+            float mbps = float(bytesRead - GetBytesRead(m_startStatistics)) / (measuredTime * 1000.f * 1000.f);
             m_totalTileLatency = m_pTileUpdateManager->GetTotalTileCopyLatency() - m_totalTileLatency;
             float approximatePerTileLatency = 1000.f * (m_totalTileLatency / measuredNumUploads);
 
             DebugPrint(L"Gathering final statistics before exiting\n");
 
+            // the same interval as the summary lines below, in machine-readable form for benchmarkHarness
+            {
+                UINT64 latencyHistogram[TileUpdateManagerStatistics::NUM_LATENCY_BUCKETS]{};
+                for (UINT i = 0; i < TileUpdateManagerStatistics::NUM_LATENCY_BUCKETS; i++)
+                {
+                    latencyHistogram[i] = statistics.m_tileLatencyHistogram[i] - m_startStatistics.m_tileLatencyHistogram[i];
+                }
+
+                const UINT64 numConverged = statistics.m_numCameraCutsConverged - m_startStatistics.m_numCameraCutsConverged;
+                const float timeToFullQuality = statistics.m_totalTimeToFullQuality - m_startStatistics.m_totalTimeToFullQuality;
+
+                m_csvFile->AddSummary("bandwidth_MBps", mbps);
+                m_csvFile->AddSummary("uploads", measuredNumUploads);
+                m_csvFile->AddSummary("uploads_per_s", measuredNumUploads / measuredTime);
+                m_csvFile->AddSummary("seconds", measuredTime);
+                m_csvFile->AddSummary("latency_ms", approximatePerTileLatency);
+                m_csvFile->AddSummary("latency_p50_us", double(TileUpdateManagerStatistics::GetLatencyPercentileUs(latencyHistogram, 0.50)));
+                m_csvFile->AddSummary("latency_p99_us", double(TileUpdateManagerStatistics::GetLatencyPercentileUs(latencyHistogram, 0.99)));
+                m_csvFile->AddSummary("submits", double(m_pTileUpdateManager->GetTotalNumSubmits() - m_startSubmitCount));
+                m_csvFile->AddSummary("tiles_requested", double(statistics.m_numTilesRequested - m_startStatistics.m_numTilesRequested));
+                m_csvFile->AddSummary("compressed_MB", (statistics.m_compressedBytesRead - m_startStatistics.m_compressedBytesRead) / (1000. * 1000.));
+                m_csvFile->AddSummary("heap_tiles_resident", statistics.m_numTilesResident);
+                m_csvFile->AddSummary("cpu_process_feedback_s", statistics.m_totalCpuProcessFeedbackTime - m_startStatistics.m_totalCpuProcessFeedbackTime);
+                m_csvFile->AddSummary("resident_pct", 100.f * statistics.m_quality.GetFractionResident());
+                m_csvFile->AddSummary("camera_cuts_converged", double(numConverged));
+                // no fallback value: if no cut converged, a benchmark comparing this should fail, not improve
+                if (numConverged)
+                {
+                    m_csvFile->AddSummary("mean_s_to_full_quality", timeToFullQuality / numConverged);
+                }
+                m_csvFile->AddSummary("startup_s_to_quality", GetStartupSecondsToQuality());
+                m_csvFile->AddSummary("restore_s", m_restoreSeconds);
+            }
+
             m_csvFile->WriteEvents(m_hwnd, m_args);
             *m_csvFile
                 << "bandwidth_MB/s #uploads seconds latency_ms #submits\n"
@@ -1329,6 +1767,84 @@ void Scene::GatherStatistics()
                 << " " << approximatePerTileLatency
                 << " " << m_pTileUpdateManager->GetTotalNumSubmits() - m_startSubmitCount
                 << "\n";
+
+            // where requested tiles went: rejected were already loading or resident when dequeued
+            *m_csvFile
+                << "requested cancelled rejected queued compressed_MB uncompressed_MB\n"
+                << statistics.m_numTilesRequested - m_startStatistics.m_numTilesRequested
+                << " " << statistics.m_numTilesCancelled - m_startStatistics.m_numTilesCancelled
+                << " " << statistics.m_numTilesRejected - m_startStatistics.m_numTilesRejected
+                << " " << statistics.m_numTilesQueued - m_startStatistics.m_numTilesQueued
+                << " " << (statistics.m_compressedBytesRead - m_startStatistics.m_compressedBytesRead) / (1000.f * 1000.f)
+                << " " << (statistics.m_uncompressedBytesRead - m_startStatistics.m_uncompressedBytesRead) / (1000.f * 1000.f)
+                << "\n";
+
+            // how long it took after a camera cut until everything feedback requested was resident
+            {
+                const UINT64 numCuts = statistics.m_numCameraCuts - m_startStatistics.m_numCameraCuts;
+                const UINT64 numConverged = statistics.m_numCameraCutsConverged - m_startStatistics.m_numCameraCutsConverged;
+                const float totalTime = statistics.m_totalTimeToFullQuality - m_startStatistics.m_totalTimeToFullQuality;
+                *m_csvFile
+                    << "camera_cuts converged mean_s_to_full_quality\n"
+                    << numCuts
+                    << " " << numConverged
+                    << " " << (numConverged ? totalTime / numConverged : 0.f)
+                    << "\n";
+            }
+
+            // compare a warm start (-restoreResidency) to a cold start
+            *m_csvFile
+                << "startup_s_to_99pct_resident restore_s\n"
+                << GetStartupSecondsToQuality()
+                << " " << m_restoreSeconds
+                << "\n";
+
+            // heap usage is identical for both tiers, the savings are in bytes read while under backlog
+            if (m_args.m_lowTierThreshold)
+            {
+                *m_csvFile
+                    << "lowtier_uploads upgrades lowtier_MB_saved upgrade_MB\n"
+                    << m_pTileUpdateManager->GetTotalNumLowTierUploads()
+                    << " " << m_pTileUpdateManager->GetTotalNumUpgrades()
+                    << " " << m_pTileUpdateManager->GetTotalLowTierBytesSaved() / (1000.f * 1000.f)
+                    << " " << m_pTileUpdateManager->GetTotalUpgradeBytes() / (1000.f * 1000.f)
+                    << "\n";
+            }
+
+            // objects that came back into view within their grace period kept these tiles
+            *m_csvFile
+                << "grace_evictions pressure_evictions reload_MB_avoided\n"
+                << m_numGraceEvictions - m_startNumGraceEvictions
+                << " " << m_numPressureEvictions - m_startNumPressureEvictions
+                << " " << (m_reloadBytesAvoided - m_startReloadBytesAvoided) / (1000.f * 1000.f)
+                << "\n";
+
+            // feedback resolves scheduled, skipped because feedback was stable, skipped over budget. learned cost
+            auto feedbackStatistics = m_pTileUpdateManager->GetFeedbackSchedulerStatistics();
+            *m_csvFile
+                << "feedback_scheduled feedback_stable feedback_deferred ms_per_resolve ms_per_megatexel\n"
+                << feedbackStatistics.m_totalScheduled - m_startFeedbackStatistics.m_totalScheduled
+                << " " << feedbackStatistics.m_totalStable - m_startFeedbackStatistics.m_totalStable
+                << " " << feedbackStatistics.m_totalDeferred - m_startFeedbackStatistics.m_totalDeferred
+                << " " << feedbackStatistics.m_costPerResolveMs
+                << " " << feedbackStatistics.m_costPerMegaTexelMs
+                << "\n";
+
+            // frames while objects were being added, e.g. increasing numSpheres during the stress path
+            if (m_objectLoadFrameTimes.size())
+            {
+                std::vector<float> frameTimes = m_objectLoadFrameTimes;
+                std::sort(frameTimes.begin(), frameTimes.end());
+                auto percentile = [&](float p) { return frameTimes[std::min(frameTimes.size() - 1, size_t(p * frameTimes.size()))]; };
+                *m_csvFile
+                    << "object_load_frames p50_ms p95_ms p99_ms max_ms\n"
+                    << frameTimes.size()
+                    << " " << percentile(0.5f)
+                    << " " << percentile(0.95f)
+                    << " " << percentile(0.99f)
+                    << " " << frameTimes.back()
+                    << "\n";
+            }
             m_csvFile->close();
             m_csvFile = nullptr;
         }
@@ -1340,6 +1856,12 @@ void Scene::GatherStatistics()
         PostQuitMessage(0);
     }
 
+    // also exit at the end of a replayed camera path
+    if (m_replayingCameraPath && (m_cameraPathFrame >= m_cameraPath.GetNumFrames()))
+    {
+        PostQuitMessage(0);
+    }
+
     if (m_frameNumber == m_args.m_timingStartFrame)
     {
         m_pTileUpdateManager->CaptureTraceFile(m_args.m_captureTrace);
@@ -1351,6 +1873,11 @@ void Scene::GatherStatistics()
             m_startUploadCount = m_pTileUpdateManager->GetTotalNumUploads();
             m_startSubmitCount = m_pTileUpdateManager->GetTotalNumSubmits();
             m_totalTileLatency = m_pTileUpdateManager->GetTotalTileCopyLatency();
+            m_startNumGraceEvictions = m_numGraceEvictions;
+            m_startNumPressureEvictions = m_numPressureEvictions;
+            m_startReloadBytesAvoided = m_reloadBytesAvoided;
+            m_startFeedbackStatistics = m_pTileUpdateManager->GetFeedbackSchedulerStatistics();
+            m_startStatistics = m_pTileUpdateManager->GetStatistics();
             m_cpuTimer.Start();
         }
     }
@@ -1364,14 +1891,33 @@ void Scene::GatherStatistics()
 //-------------------------------------------------------------------------
 void Scene::Animate()
 {
+    // spin objects
+    float rotation = m_args.m_animationRate * 0.01f;
+
+    // replay camera and spin
+    if (m_replayingCameraPath)
+    {
+        if (m_cameraPathFrame < m_cameraPath.GetNumFrames())
+        {
+            const auto& frame = m_cameraPath.GetFrame(m_cameraPathFrame);
+            SetViewMatrix(XMLoadFloat4x3(&frame.m_view));
+            rotation = frame.m_spin;
+            m_cameraPathFrame++;
+        }
+    }
     // animate camera
-    if (m_args.m_cameraAnimationRate)
+    else if (m_args.m_cameraAnimationRate)
     {
         m_args.m_cameraUpLock = false;
 
         if (m_args.m_cameraPaintMixer)
         {
-            m_args.m_cameraRollerCoaster = (0x04 & m_frameNumber);
+            const bool rollerCoaster = (0x04 & m_frameNumber);
+            if (rollerCoaster != m_args.m_cameraRollerCoaster)
+            {
+                m_pTileUpdateManager->NotifyCameraCut();
+            }
+            m_args.m_cameraRollerCoaster = rollerCoaster;
         }
 
         static float theta = -XM_PIDIV2;
@@ -1409,8 +1955,10 @@ void Scene::Animate()
         }
     }
 
-    // spin objects
-    float rotation = m_args.m_animationRate * 0.01f;
+    if (m_args.m_recordCameraPathFileName.size() && !m_replayingCameraPath)
+    {
+        m_cameraPath.RecordFrame(m_viewMatrix, rotation, (UINT)m_objects.size());
+    }
 
     for (auto o : m_objects)
     {
@@ -1423,6 +1971,45 @@ void Scene::Animate()
     }
 }
 
+//-------------------------------------------------------------------------
+// replay a recorded camera path
+// recorded textures are matched by file name with the textures in the media directory
+// objects are created on the render thread so each frame has the recorded object set
+//-------------------------------------------------------------------------
+void Scene::LoadCameraPath()
+{
+    if (0 == m_args.m_replayCameraPathFileName.size())
+    {
+        return;
+    }
+
+    if (!m_cameraPath.Read(m_args.m_replayCameraPathFileName))
+    {
+        ErrorMessage("Failed to read camera path ", m_args.m_replayCameraPathFileName);
+    }
+
+    for (const auto& recorded : m_cameraPath.GetTextures())
+    {
+        UINT textureIndex = 0;
+        for (; textureIndex < m_args.m_textures.size(); textureIndex++)
+        {
+            if (std::filesystem::path(m_args.m_textures[textureIndex]).filename() == recorded)
+            {
+                break;
+            }
+        }
+        if (m_args.m_textures.size() == textureIndex)
+        {
+            ErrorMessage("Camera path texture not found: ", recorded);
+        }
+        m_cameraPathTextures.push_back(textureIndex);
+    }
+
+    m_replayingCameraPath = true;
+    m_args.m_objectCreationBudgetMs = 0;
+    m_args.m_cameraAnimationRate = 0;
+}
+
 //-------------------------------------------------------------------------
 // create various windows to inspect terrain object resources
 //-------------------------------------------------------------------------
@@ -1620,6 +2207,7 @@ void Scene::DrawUI()
             guiDrawParams.m_scrollMipDim = m_pTerrainSceneObject->GetStreamingResource()->GetTiledResource()->GetDesc().MipLevels;
         }
         guiDrawParams.m_numTilesUploaded = m_numUploadsPreviousFrame;
+        guiDrawParams.m_numBytesRead = m_numBytesReadPreviousFrame;
         guiDrawParams.m_numTilesEvicted = m_numEvictionsPreviousFrame;
         guiDrawParams.m_numTilesCommitted = numTilesCommitted;
         guiDrawParams.m_numTilesVirtual = numTilesVirtual;
@@ -1683,6 +2271,9 @@ void Scene::SwapCameraForDemo(bool in_capture)
     {
         SetViewMatrix(previousView);
     }
+
+    // either way the view jumps: measure how long streaming takes to catch up
+    m_pTileUpdateManager->NotifyCameraCut();
 }
 
 //-------------------------------------------------------------------------
@@ -1728,23 +2319,26 @@ void Scene::HandleUIchanges()
 //-------------------------------------------------------------------------
 bool Scene::WaitForAssetLoad()
 {
+    // also wait for objects still being prepared on worker threads
+    bool waiting = (0 != m_pendingObjects.size());
     for (const auto o : m_objects)
     {
-        if (!o->GetPackedMipsPresent())
-        {
-            // must give TileUpdateManager a chance to process packed mip requests
-            D3D12_CPU_DESCRIPTOR_HANDLE minmipmapDescriptor = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_srvHeap->GetCPUDescriptorHandleForHeapStart(), (UINT)DescriptorHeapOffsets::SHARED_MIN_MIP_MAP, m_srvUavCbvDescriptorSize);
-            m_pTileUpdateManager->BeginFrame(m_srvHeap.Get(), minmipmapDescriptor);
-            auto commandLists = m_pTileUpdateManager->EndFrame();
-            ID3D12CommandList* pCommandLists[] = { commandLists.m_beforeDrawCommands, commandLists.m_afterDrawCommands };
-            m_commandQueue->ExecuteCommandLists(_countof(pCommandLists), pCommandLists);
+        if (waiting) { break; }
+        waiting = !o->GetPackedMipsPresent();
+    }
 
-            MoveToNextFrame();
+    if (waiting)
+    {
+        // must give TileUpdateManager a chance to process packed mip requests
+        D3D12_CPU_DESCRIPTOR_HANDLE minmipmapDescriptor = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_srvHeap->GetCPUDescriptorHandleForHeapStart(), (UINT)DescriptorHeapOffsets::SHARED_MIN_MIP_MAP, m_srvUavCbvDescriptorSize);
+        m_pTileUpdateManager->BeginFrame(m_srvHeap.Get(), minmipmapDescriptor);
+        auto commandLists = m_pTileUpdateManager->EndFrame();
+        ID3D12CommandList* pCommandLists[] = { commandLists.m_beforeDrawCommands, commandLists.m_afterDrawCommands };
+        m_commandQueue->ExecuteCommandLists(_countof(pCommandLists), pCommandLists);
 
-            return true;
-        }
+        MoveToNextFrame();
     }
-    return false;
+    return waiting;
 }
 
 //-------------------------------------------------------------------------
@@ -27,11 +27,17 @@
 #pragma once
 
 #include <random>
+#include <deque>
+#include <ppltasks.h>
 
 #include "CommandLineArgs.h"
 #include "SharedConstants.h"
 #include "SceneObject.h"
+#include "FrustumCulling.h"
+#include "SpherePlacement.h"
+#include "CameraPath.h"
 #include "FrameEventTracing.h"
+#include "LiveMetricsWriter.h"
 #include "AssetUploader.h"
 #include "Gui.h"
 
@@ -80,6 +86,9 @@ public:
 
     void ScreenShot(std::wstring& in_fileName) const;
 
+    // write the recent events of the streaming threads now, e.g. right after a hitch
+    void WriteEventTrace();
+
 private:
     Scene(const Scene&) = delete;
     Scene(Scene&&) = delete;
@@ -216,7 +225,7 @@ private:
 
     struct TileUpdateManager* m_pTileUpdateManager{ nullptr };
 
-    UINT DetermineMaxNumFeedbackResolves();
+    void ScheduleFeedback(); // after culling, choose the visible objects that get feedback this frame
     void DrawObjects();   // draw all the objects
 
     void CreateTerrainViewers();
@@ -236,11 +245,64 @@ private:
     SceneObjects::BaseObject* m_pSky{ nullptr }; // lifetime owned by m_objects
 
     DirectX::XMMATRIX SetSphereMatrix();
+    SpherePlacement m_spherePlacement; // bounding spheres of m_objects except the sky, for the overlap test
     void LoadSpheres(); // progressively over multiple frames
+    void SetPlanetTransform(SceneObjects::BaseObject* in_pObject, bool in_earth);
+    void AddObject(SceneObjects::BaseObject* in_pObject, const std::wstring& in_textureFilename);
 
-    // each frame, update objects until timeout reached
-    UINT m_queueFeedbackIndex{ 0 }; // index based on number of gpu feedback resolves per frame
+    // copies of the first earth or planet: file parsing, packed mip reads, and resource creation
+    // run on worker threads, then the objects are added in order within a per-frame budget
+    struct PendingObject
+    {
+        std::wstring m_filename;
+        SceneObjects::Planet* m_pSharedObject;
+        concurrency::task<PreparedStreamingResource*> m_task;
+    };
+    std::deque<PendingObject> m_pendingObjects;
+    UINT m_textureIndex{ 0 }; // next texture to assign, persists while a batch of objects is loading
+    bool m_loadingObjects{ false };
+    void AddPendingObjects();
+    void CancelPendingObjects(UINT in_numObjects); // drop pending objects beyond this total
+
+    // frame times while objects are being added, summarized in the timing file
+    std::vector<float> m_objectLoadFrameTimes;
+    Timer m_objectLoadFrameTimer;
+
+    // record or replay the view, object spin, and object set of every frame
+    CameraPath m_cameraPath;
+    bool m_replayingCameraPath{ false };
+    UINT m_cameraPathFrame{ 0 };  // next frame to replay
+    UINT m_cameraPathObject{ 0 }; // next object to replay
+    std::vector<UINT> m_cameraPathTextures; // recorded texture -> index into m_args.m_textures
+    void LoadCameraPath();
+
+    // each frame, TileUpdateManager::ScheduleFeedback() picks objects to update within the feedback time budget
+    std::vector<FeedbackHint> m_feedbackHints;
+    std::vector<UINT> m_feedbackHintObjects; // object index of each hint
+    std::vector<BYTE> m_feedbackScheduled;   // per object
     std::vector<UINT> m_prevNumFeedbackObjects; // to correlate # objects with feedback time
+    FrustumCulling m_frustumCulling; // bounding spheres of m_objects, same indices
+    SoftwareFeedback m_softwareFeedback; // used instead of gpu sampler feedback if m_args.m_softwareFeedback
+
+    //-----------------------------------
+    // grace period before evicting objects that are not visible
+    //-----------------------------------
+    struct CulledObject
+    {
+        bool m_culled{ false };  // not visible since m_frame
+        bool m_evicted{ false }; // QueueEviction() has been called
+        UINT m_frame{ 0 };
+        double m_time{ 0 };
+        float m_priority{ 1.f }; // StreamingQoS::m_priority, sampled when an eviction candidate
+    };
+    std::vector<CulledObject> m_culledObjects; // same indices as m_objects
+    std::vector<UINT> m_evictionCandidates;   // scratch: culled objects within their grace period
+    Timer m_evictionTimer;
+    UINT m_numGraceEvictions{ 0 };
+    UINT m_numPressureEvictions{ 0 };
+    UINT64 m_reloadBytesAvoided{ 0 };         // tiles still resident when a culled object became visible again
+    void UpdateCulledObject(UINT in_objectIndex, bool in_visible);
+    void EvictCulledObjects();
 
     //-----------------------------------
     // statistics gathering
@@ -249,6 +311,7 @@ private:
     FrameEventTracing::UpdateEventList m_updateFeedbackTimes;
     class D3D12GpuTimer* m_pGpuTimer { nullptr };
     std::unique_ptr<FrameEventTracing> m_csvFile{ nullptr };
+    std::unique_ptr<LiveMetricsWriter> m_pLiveMetrics{ nullptr };
     float m_gpuProcessFeedbackTime{ 0 };
 
     // render thread can request other threads to stop processing e.g. on time budget exceeded
@@ -261,15 +324,36 @@ private:
     UINT m_numEvictionsPreviousFrame{ 0 };
     UINT m_numUploadsPreviousFrame{ 0 };
 
+    // compressed bytes read from files, for bandwidth
+    UINT64 m_numTotalBytesRead{ 0 };
+    UINT64 m_numBytesReadPreviousFrame{ 0 };
+
     void StartStreamingLibrary();
     std::vector<StreamingHeap*> m_sharedHeaps;
 
     void GatherStatistics();
     UINT m_startUploadCount{ 0 };
     UINT m_startSubmitCount{ 0 };
+    UINT m_startNumGraceEvictions{ 0 };
+    UINT m_startNumPressureEvictions{ 0 };
+    UINT64 m_startReloadBytesAvoided{ 0 };
+    FeedbackSchedulerStatistics m_startFeedbackStatistics;
+    TileUpdateManagerStatistics m_startStatistics;
     float m_totalTileLatency{ 0 }; // per-tile upload latency. NOT the same as per-UpdateList
     Timer m_cpuTimer;
 
+    // warm start from a residency snapshot (-restoreResidency), and time to quality after startup, warm or cold
+    void UpdateStartup(const TileUpdateManagerStatistics& in_statistics);
+    void SaveResidency();
+    bool m_residencySaved{ false };
+    Timer m_startupTimer;
+    bool m_startupBegan{ false };
+    float m_startupSecondsToQuality{ 0 }; // until 99% of the tiles feedback wants are resident. 0 until then
+    PrefetchHandle m_restoreHandle{ 0 };
+    float m_restoreSeconds{ 0 };          // until the restored tiles were resident. 0 if not restored
+    // not reached yet? the time so far, which still compares as slower than any start that did converge
+    float GetStartupSecondsToQuality() const { return m_startupSecondsToQuality ? m_startupSecondsToQuality : (float)m_startupTimer.GetTime(); }
+
     void HandleUIchanges();
     bool WaitForAssetLoad();
     void StartScene();
@@ -41,6 +41,8 @@
 #include "Scene.h"
 #include "TerrainGenerator.h"
 #include "AssetUploader.h"
+#include "MeshCache.h"
+#include "Timer.h"
 
 //-------------------------------------------------------------------------
 // constructor
@@ -51,7 +53,8 @@ SceneObjects::BaseObject::BaseObject(
     StreamingHeap* in_pStreamingHeap,
     ID3D12Device* in_pDevice,
     D3D12_CPU_DESCRIPTOR_HANDLE in_srvBaseCPU,
-    BaseObject* in_pSharedObject) : m_pTileUpdateManager(in_pTileUpdateManager)
+    BaseObject* in_pSharedObject,
+    PreparedStreamingResource* in_pPreparedResource) : m_pTileUpdateManager(in_pTileUpdateManager)
 {
     //---------------------------------------
     // create root signature
@@ -159,7 +162,15 @@ SceneObjects::BaseObject::BaseObject(
 
         // The tile update manager queries the streaming texture for its tile dimensions
         // The feedback resource will be allocated with a mip region size matching the tile size
-        m_pStreamingResource = in_pTileUpdateManager->CreateStreamingResource(in_filename, in_pStreamingHeap);
+        // the file may have been parsed and the resources created ahead of time on another thread
+        if (in_pPreparedResource)
+        {
+            m_pStreamingResource = in_pTileUpdateManager->CreateStreamingResource(in_pPreparedResource, in_pStreamingHeap);
+        }
+        else
+        {
+            m_pStreamingResource = in_pTileUpdateManager->CreateStreamingResource(in_filename, in_pStreamingHeap);
+        }
 
         // sampler feedback view
         CD3DX12_CPU_DESCRIPTOR_HANDLE feedbackHandle(in_srvBaseCPU, (UINT)Descriptors::HeapOffsetFeedback, m_srvUavCbvDescriptorSize);
@@ -270,6 +281,19 @@ void SceneObjects::BaseObject::CopyGeometry(const BaseObject* in_pObjectForShare
         m_lods[i].m_indexBufferView = in_pObjectForSharedHeap->m_lods[i].m_indexBufferView;
         m_lods[i].m_vertexBufferView = in_pObjectForSharedHeap->m_lods[i].m_vertexBufferView;
     }
+    m_feedbackMeshes = in_pObjectForSharedHeap->m_feedbackMeshes;
+    m_insideOut = in_pObjectForSharedHeap->m_insideOut;
+}
+
+//-------------------------------------------------------------------------
+//-------------------------------------------------------------------------
+void SceneObjects::BaseObject::SetFeedbackMesh(FeedbackMesh in_mesh, UINT in_lod)
+{
+    if (in_lod >= m_feedbackMeshes.size())
+    {
+        m_feedbackMeshes.resize(in_lod + 1);
+    }
+    m_feedbackMeshes[in_lod] = in_mesh;
 }
 
 //-------------------------------------------------------------------------
@@ -392,21 +416,100 @@ void SceneObjects::BaseObject::Draw(ID3D12GraphicsCommandList1* in_pCommandList,
     }
 }
 
+//-------------------------------------------------------------------------
+// same lod and transform as Draw(), but into the cpu feedback buffer
+//-------------------------------------------------------------------------
+void SceneObjects::BaseObject::DrawSoftwareFeedback(SoftwareFeedback& in_softwareFeedback,
+    const SceneObjects::DrawParams& in_drawParams, bool in_writeFeedback)
+{
+    if ((0 == m_feedbackMeshes.size()) || (!m_pStreamingResource->GetPackedMipsResident()))
+    {
+        return;
+    }
+
+    UINT lod = 0;
+    if (m_lods.size() > 1)
+    {
+        DirectX::XMVECTOR eye = in_drawParams.m_viewInverse.r[3];
+        DirectX::XMVECTOR pos = m_matrix.r[3];
+        DirectX::XMVECTOR direction = DirectX::XMVectorSubtract(pos, eye);
+        float distance = DirectX::XMVectorGetX(DirectX::XMVector3LengthEst(direction));
+
+        lod = ComputeLod(distance, in_drawParams);
+    }
+    lod = std::min(lod, UINT(m_feedbackMeshes.size() - 1));
+    const auto& mesh = m_feedbackMeshes[lod];
+    if (nullptr == mesh)
+    {
+        return;
+    }
+
+    ModelConstantData modelConstantData{};
+    SetModelConstants(modelConstantData, in_drawParams.m_projection, in_drawParams.m_view);
+
+    const auto desc = m_pStreamingResource->GetTiledResource()->GetDesc();
+    in_softwareFeedback.Draw(m_pStreamingResource, *mesh, modelConstantData.g_combinedTransform,
+        (UINT)desc.Width, desc.Height,
+        m_pStreamingResource->GetMinMipMapWidth(), m_pStreamingResource->GetMinMipMapHeight(),
+        m_insideOut, in_writeFeedback);
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+SceneObjects::BaseObject::FeedbackMesh SceneObjects::CreateFeedbackMesh(
+    const TerrainGenerator::Vertex* in_pVertices, UINT in_numVertices,
+    const UINT32* in_pIndices, UINT in_numIndices)
+{
+    auto pMesh = std::make_shared<SoftwareFeedback::Mesh>();
+    pMesh->m_vertices.resize(in_numVertices);
+    for (UINT i = 0; i < in_numVertices; i++)
+    {
+        pMesh->m_vertices[i] = { in_pVertices[i].pos, in_pVertices[i].tex };
+    }
+    pMesh->m_indices.assign(in_pIndices, in_pIndices + in_numIndices);
+    return pMesh;
+}
+
+//-----------------------------------------------------------------------------
+// the key contains every property that affects the generated geometry
+//-----------------------------------------------------------------------------
+MeshCache::MeshPtr SceneObjects::GetSphereMesh(const SphereGen::Properties& in_sphereProperties)
+{
+    std::string key = "sphere"
+        " long=" + std::to_string(in_sphereProperties.m_numLong) +
+        " lat=" + std::to_string(in_sphereProperties.m_numLat) +
+        " exponent=" + std::to_string(in_sphereProperties.m_exponent) +
+        " mirrorU=" + std::to_string(in_sphereProperties.m_mirrorU) +
+        " topBottom=" + std::to_string(in_sphereProperties.m_topBottom);
+
+    return MeshCache::Get().Find(key, [&](MeshCache::Mesh& out_mesh)
+        {
+            std::vector<SphereGen::Vertex> sphereVerts;
+            out_mesh.m_lods.resize(1);
+            SphereGen::Create(sphereVerts, out_mesh.m_lods[0], in_sphereProperties);
+            out_mesh.SetVertices(sphereVerts);
+        });
+}
+
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 void SceneObjects::CreateSphereResources(
     ID3D12Resource** out_ppVertexBuffer, ID3D12Resource** out_ppIndexBuffer,
     ID3D12Device* in_pDevice, const SphereGen::Properties& in_sphereProperties,
-    AssetUploader& in_assetUploader)
+    AssetUploader& in_assetUploader, BaseObject::FeedbackMesh* out_pFeedbackMesh)
 {
-    std::vector<SphereGen::Vertex> sphereVerts;
-    std::vector<UINT32> sphereIndices;
+    MeshCache::MeshPtr pMesh = GetSphereMesh(in_sphereProperties);
+    const std::vector<UINT32>& sphereIndices = pMesh->m_lods[0];
 
-    SphereGen::Create(sphereVerts, sphereIndices, in_sphereProperties);
+    if (out_pFeedbackMesh)
+    {
+        *out_pFeedbackMesh = CreateFeedbackMesh(pMesh->GetVertices<SphereGen::Vertex>(), pMesh->GetNumVertices(),
+            sphereIndices.data(), (UINT)sphereIndices.size());
+    }
 
     // build vertex buffer
     {
-        UINT vertexBufferSize = UINT(sphereVerts.size()) * sizeof(sphereVerts[0]);
+        UINT vertexBufferSize = UINT(pMesh->m_vertices.size());
 
         const auto heapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
         const auto resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(vertexBufferSize);
@@ -418,7 +521,7 @@ void SceneObjects::CreateSphereResources(
             nullptr,
             IID_PPV_ARGS(out_ppVertexBuffer)));
 
-        in_assetUploader.SubmitRequest(*out_ppVertexBuffer, sphereVerts.data(), vertexBufferSize,
+        in_assetUploader.SubmitRequest(*out_ppVertexBuffer, pMesh->m_vertices.data(), vertexBufferSize,
             D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
     }
 
@@ -442,30 +545,120 @@ void SceneObjects::CreateSphereResources(
 }
 
 //-----------------------------------------------------------------------------
+// each lod reduces the # of latitude and longitude steps
 //-----------------------------------------------------------------------------
-void SceneObjects::CreateSphere(SceneObjects::BaseObject* out_pObject,
-    ID3D12Device* in_pDevice, AssetUploader& in_assetUploader,
-    const SphereGen::Properties& in_sphereProperties,
-    UINT in_numLods)
+static SphereGen::Properties GetSphereLodProperties(
+    const SphereGen::Properties& in_sphereProperties, UINT in_numLods, UINT in_lod)
 {
     const float lodStepFactor = 1.0f / in_numLods;
     float lodScaleFactor = 1.0f;
+    for (UINT lod = 0; lod < in_lod; lod++)
+    {
+        lodScaleFactor -= lodStepFactor;
+    }
 
     SphereGen::Properties sphereProperties = in_sphereProperties;
+    sphereProperties.m_numLat = UINT(in_sphereProperties.m_numLat * lodScaleFactor);
+    sphereProperties.m_numLong = UINT(in_sphereProperties.m_numLong * lodScaleFactor);
+    return sphereProperties;
+}
 
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+void SceneObjects::CreateSphere(SceneObjects::BaseObject* out_pObject,
+    ID3D12Device* in_pDevice, AssetUploader& in_assetUploader,
+    const SphereGen::Properties& in_sphereProperties,
+    UINT in_numLods)
+{
     for (UINT lod = 0; lod < in_numLods; lod++)
     {
-        sphereProperties.m_numLat = UINT(in_sphereProperties.m_numLat * lodScaleFactor);
-        sphereProperties.m_numLong = UINT(in_sphereProperties.m_numLong * lodScaleFactor);
-        lodScaleFactor -= lodStepFactor;
+        SphereGen::Properties sphereProperties = GetSphereLodProperties(in_sphereProperties, in_numLods, lod);
 
         ID3D12Resource* pVertexBuffer{ nullptr };
         ID3D12Resource* pIndexBuffer{ nullptr };
-        CreateSphereResources(&pVertexBuffer, &pIndexBuffer, in_pDevice, sphereProperties, in_assetUploader);
+        BaseObject::FeedbackMesh feedbackMesh;
+        CreateSphereResources(&pVertexBuffer, &pIndexBuffer, in_pDevice, sphereProperties, in_assetUploader, &feedbackMesh);
         out_pObject->SetGeometry(pVertexBuffer, (UINT)sizeof(SphereGen::Vertex), pIndexBuffer, lod);
+        out_pObject->SetFeedbackMesh(feedbackMesh, lod);
     }
 }
 
+//-----------------------------------------------------------------------------
+// generation is timed with the memory cache cleared and the disk cache disabled
+// the disk cache (if configured) is timed by clearing memory after the mesh was written
+//-----------------------------------------------------------------------------
+void SceneObjects::BenchmarkMeshes(std::wostream& out_stream,
+    const SphereGen::Properties& in_sphereProperties, UINT in_numLods)
+{
+    MeshCache& meshCache = MeshCache::Get();
+    const std::wstring directory = meshCache.GetDirectory();
+
+    // each test creates all the lods of one object, as at startup
+    struct Test
+    {
+        std::wstring m_name;
+        std::function<UINT()> m_create; // returns # vertices
+    };
+    std::vector<Test> tests;
+
+    tests.push_back({ L"planet", [&]()
+        {
+            return GetPlanetMesh(SharedConstants::NUM_SPHERE_LEVELS_OF_DETAIL)->GetNumVertices();
+        } });
+    tests.push_back({ L"earth", [&]()
+        {
+            SphereGen::Properties sphereProperties = in_sphereProperties;
+            sphereProperties.m_mirrorU = false;
+            sphereProperties.m_topBottom = false;
+            UINT numVertices = 0;
+            for (UINT lod = 0; lod < in_numLods; lod++)
+            {
+                numVertices += GetSphereMesh(GetSphereLodProperties(sphereProperties, in_numLods, lod))->GetNumVertices();
+            }
+            return numVertices;
+        } });
+
+    out_stream << "mesh lods vertices generate_ms memory_cache_ms disk_cache_ms\n";
+
+    for (const auto& test : tests)
+    {
+        Timer timer;
+
+        meshCache.SetDirectory(L"");
+        meshCache.Clear();
+        timer.Start();
+        UINT numVertices = test.m_create();
+        double generateTime = timer.GetTime();
+
+        timer.Start();
+        test.m_create();
+        double memoryTime = timer.GetTime();
+
+        double diskTime = 0;
+        if (directory.size())
+        {
+            meshCache.SetDirectory(directory);
+            meshCache.Clear();
+            test.m_create(); // write the files, if not already there
+
+            meshCache.Clear();
+            timer.Start();
+            test.m_create();
+            diskTime = timer.GetTime();
+        }
+
+        out_stream << test.m_name
+            << " " << ((L"planet" == test.m_name) ? SharedConstants::NUM_SPHERE_LEVELS_OF_DETAIL : in_numLods)
+            << " " << numVertices
+            << " " << generateTime * 1000
+            << " " << memoryTime * 1000
+            << " " << diskTime * 1000 << std::endl;
+    }
+
+    meshCache.SetDirectory(directory);
+    meshCache.Clear();
+}
+
 //=========================================================================
 //=========================================================================
 SceneObjects::Terrain::Terrain(const std::wstring& in_filename,
@@ -527,6 +720,8 @@ SceneObjects::Terrain::Terrain(const std::wstring& in_filename,
         
         in_assetUploader.SubmitRequest(pIndexBuffer, indices.data(), indices.size(),
             D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_INDEX_BUFFER);
+
+        SetFeedbackMesh(CreateFeedbackMesh(mesh.GetVertices().data(), (UINT)mesh.GetVertices().size(), (const UINT32*)indices.data(), UINT(indices.size() / sizeof(UINT32))));
     }
 
     SetGeometry(pVertexBuffer, (UINT)sizeof(TerrainGenerator::Vertex), pIndexBuffer);
@@ -576,9 +771,10 @@ SceneObjects::Planet::Planet(const std::wstring& in_filename,
 SceneObjects::Planet::Planet(const std::wstring& in_filename,
     StreamingHeap* in_pStreamingHeap,
     D3D12_CPU_DESCRIPTOR_HANDLE in_srvBaseCPU,
-    Planet* in_pSharedObject) :
+    Planet* in_pSharedObject,
+    PreparedStreamingResource* in_pPreparedResource) :
     BaseObject(in_filename, in_pSharedObject->m_pTileUpdateManager, in_pStreamingHeap,
-        in_pSharedObject->GetDevice(), in_srvBaseCPU, in_pSharedObject)
+        in_pSharedObject->GetDevice(), in_srvBaseCPU, in_pSharedObject, in_pPreparedResource)
 {
     CopyGeometry(in_pSharedObject);
 }
@@ -602,6 +798,7 @@ SceneObjects::Sky::Sky(const std::wstring& in_filename,
     rasterizerDesc.CullMode = D3D12_CULL_MODE_FRONT;
     D3D12_DEPTH_STENCIL_DESC depthStencilDesc = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
     depthStencilDesc.DepthEnable = false;
+    m_insideOut = true;
 
     CreatePipelineState(L"skyPS.cso", L"skyPS-FB.cso", L"skyVS.cso", in_pDevice, in_sampleCount, rasterizerDesc, depthStencilDesc);
 
@@ -30,6 +30,8 @@
 #include "CommandLineArgs.h"
 #include "SamplerFeedbackStreaming.h"
 #include "CreateSphere.h"
+#include "SoftwareFeedback.h"
+#include "MeshCache.h"
 
 class AssetUploader;
 
@@ -90,6 +92,10 @@ namespace SceneObjects
         }
 
         virtual void Draw(ID3D12GraphicsCommandList1* in_pCommandList, const DrawParams& in_drawParams);
+
+        // rasterize the cpu copy of the geometry into the software feedback buffer
+        // in_writeFeedback: false to only occlude other objects
+        void DrawSoftwareFeedback(SoftwareFeedback& in_softwareFeedback, const DrawParams& in_drawParams, bool in_writeFeedback);
         UINT ComputeLod(const float in_distance, const SceneObjects::DrawParams& in_drawParams);
 
         DirectX::XMMATRIX& GetModelMatrix() { return m_matrix; }
@@ -112,9 +118,14 @@ namespace SceneObjects
         void SetGeometry(ID3D12Resource* in_pVertexBuffer, UINT in_vertexSize,
             ID3D12Resource* in_pIndexBuffer, UINT in_lod = 0);
 
+        // cpu copy of the geometry for software feedback
+        typedef std::shared_ptr<const SoftwareFeedback::Mesh> FeedbackMesh;
+        void SetFeedbackMesh(FeedbackMesh in_mesh, UINT in_lod = 0);
+
         void SetFeedbackEnabled(bool in_value) { m_feedbackEnabled = in_value; }
 
         void SetAxis(DirectX::XMVECTOR in_vector) { m_axis.v = in_vector; }
+        DirectX::XMVECTOR GetAxis() const { return m_axis; }
     protected:
         // pass in a location in a descriptor heap where this can write 3 descriptors
         BaseObject(
@@ -123,11 +134,13 @@ namespace SceneObjects
             StreamingHeap* in_pStreamingHeap,
             ID3D12Device* in_pDevice,
             D3D12_CPU_DESCRIPTOR_HANDLE in_srvBaseCPU,
-            BaseObject* in_pSharedObject);  // to share root sig, etc.
+            BaseObject* in_pSharedObject,  // to share root sig, etc.
+            PreparedStreamingResource* in_pPreparedResource = nullptr);
 
         template<typename T> using ComPtr = Microsoft::WRL::ComPtr<T>;
 
         bool m_feedbackEnabled{ true };
+        bool m_insideOut{ false }; // viewed from inside (front faces culled, never occludes)
         TileUpdateManager* m_pTileUpdateManager{ nullptr };
 
         DirectX::XMMATRIX m_matrix{ DirectX::XMMatrixIdentity() };
@@ -184,6 +197,7 @@ namespace SceneObjects
         };
 
         std::vector<Geometry> m_lods;
+        std::vector<FeedbackMesh> m_feedbackMeshes; // 1 per lod
 
         ComPtr<ID3D12RootSignature> m_rootSignature;
         ComPtr<ID3D12PipelineState> m_pipelineState;
@@ -206,7 +220,17 @@ namespace SceneObjects
 
     void CreateSphereResources(ID3D12Resource** out_ppVertexBuffer, ID3D12Resource** out_ppIndexBuffer,
         ID3D12Device* in_pDevice, const SphereGen::Properties& in_sphereProperties,
-        AssetUploader& in_assetUploader);
+        AssetUploader& in_assetUploader, BaseObject::FeedbackMesh* out_pFeedbackMesh = nullptr);
+
+    BaseObject::FeedbackMesh CreateFeedbackMesh(const TerrainGenerator::Vertex* in_pVertices, UINT in_numVertices,
+        const UINT32* in_pIndices, UINT in_numIndices);
+
+    // cpu geometry, generated once per set of properties (see MeshCache)
+    MeshCache::MeshPtr GetSphereMesh(const SphereGen::Properties& in_sphereProperties);
+    MeshCache::MeshPtr GetPlanetMesh(UINT in_numLods); // subdivided octahedron, 1 index buffer per lod
+
+    // time mesh generation and the memory and disk caches for the sphere types created at startup, write results
+    void BenchmarkMeshes(std::wostream& out_stream, const SphereGen::Properties& in_sphereProperties, UINT in_numLods);
 
     class Terrain : public BaseObject
     {
@@ -232,10 +256,12 @@ namespace SceneObjects
             D3D12_CPU_DESCRIPTOR_HANDLE in_srvBaseCPU,
             const SphereGen::Properties& in_properties);
 
+        // in_pPreparedResource: optional, from TileUpdateManager::PrepareStreamingResource(). this object takes ownership
         Planet(const std::wstring& in_filename,
             StreamingHeap* in_pStreamingHeap,
             D3D12_CPU_DESCRIPTOR_HANDLE in_srvBaseCPU,
-            Planet* in_pSharedObject);
+            Planet* in_pSharedObject,
+            PreparedStreamingResource* in_pPreparedResource = nullptr);
 
         Planet(const std::wstring& in_filename,
             TileUpdateManager* in_pTileUpdateManager,
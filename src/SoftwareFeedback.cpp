@@ -0,0 +1,248 @@
+//*********************************************************
+//
+// Copyright 2020 Intel Corporation 
+//
+// Permission is hereby granted, free of charge, to any 
+// person obtaining a copy of this software and associated 
+// documentation files(the "Software"), to deal in the Software 
+// without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to 
+// whom the Software is furnished to do so, subject to the 
+// following conditions :
+// The above copyright notice and this permission notice shall 
+// be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+// DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+
+
+#include "pch.h"
+#include "SoftwareFeedback.h"
+
+using namespace DirectX;
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+void SoftwareFeedback::BeginFrame(UINT in_windowWidth, UINT in_windowHeight, UINT in_downsample,
+    float in_lodBias, UINT in_maxAnisotropy)
+{
+    UINT downsample = std::max<UINT>(1, in_downsample);
+    m_downsample = (float)downsample;
+    m_width = std::max<UINT>(1, in_windowWidth / downsample);
+    m_height = std::max<UINT>(1, in_windowHeight / downsample);
+    m_lodBias = in_lodBias;
+    m_maxAnisotropy = (float)std::max<UINT>(1, in_maxAnisotropy);
+
+    m_samples.assign(m_width * m_height, Sample{ 0, 0, 0, 0 });
+    m_objects.clear();
+}
+
+//-----------------------------------------------------------------------------
+// transform vertices, clip triangles to the near plane, rasterize
+//-----------------------------------------------------------------------------
+void SoftwareFeedback::Draw(const void* in_pKey, const Mesh& in_mesh, const XMMATRIX& in_combinedTransform,
+    UINT in_textureWidth, UINT in_textureHeight, UINT in_feedbackWidth, UINT in_feedbackHeight,
+    bool in_insideOut, bool in_writeFeedback)
+{
+    UINT objectIndex = (UINT)m_objects.size();
+    m_objects.push_back({ in_pKey, in_textureWidth, in_textureHeight, in_feedbackWidth, in_feedbackHeight, in_writeFeedback });
+
+    // same convention as the vertex shaders: mul(g_combinedTransform, pos) with a row-major matrix
+    m_clipVertices.resize(in_mesh.m_vertices.size());
+    for (size_t i = 0; i < in_mesh.m_vertices.size(); i++)
+    {
+        const auto& v = in_mesh.m_vertices[i];
+        XMVECTOR pos = XMVector4Transform(XMVectorSet(v.m_pos.x, v.m_pos.y, v.m_pos.z, 1.0f), in_combinedTransform);
+        XMStoreFloat4(&m_clipVertices[i].m_pos, pos);
+        m_clipVertices[i].m_uv = v.m_uv;
+    }
+
+    for (size_t i = 0; (i + 2) < in_mesh.m_indices.size(); i += 3)
+    {
+        ClipVertex triangle[3] = {
+            m_clipVertices[in_mesh.m_indices[i]],
+            m_clipVertices[in_mesh.m_indices[i + 1]],
+            m_clipVertices[in_mesh.m_indices[i + 2]] };
+
+        // near plane is z = 0 in D3D clip space
+        UINT numBehind = 0;
+        for (const auto& v : triangle) { if (v.m_pos.z < 0) { numBehind++; } }
+
+        if (0 == numBehind)
+        {
+            DrawTriangle(triangle, objectIndex, in_insideOut);
+        }
+        else if (numBehind < 3)
+        {
+            // clip to the near plane, resulting in a triangle or a quad
+            ClipVertex polygon[4];
+            UINT numVerts = 0;
+            for (UINT j = 0; j < 3; j++)
+            {
+                const auto& a = triangle[j];
+                const auto& b = triangle[(j + 1) % 3];
+                if (a.m_pos.z >= 0) { polygon[numVerts++] = a; }
+                if ((a.m_pos.z >= 0) != (b.m_pos.z >= 0))
+                {
+                    float t = a.m_pos.z / (a.m_pos.z - b.m_pos.z);
+                    ClipVertex& c = polygon[numVerts++];
+                    XMStoreFloat4(&c.m_pos, XMVectorLerp(XMLoadFloat4(&a.m_pos), XMLoadFloat4(&b.m_pos), t));
+                    XMStoreFloat2(&c.m_uv, XMVectorLerp(XMLoadFloat2(&a.m_uv), XMLoadFloat2(&b.m_uv), t));
+                }
+            }
+            for (UINT j = 2; j < numVerts; j++)
+            {
+                ClipVertex fan[3] = { polygon[0], polygon[j - 1], polygon[j] };
+                DrawTriangle(fan, objectIndex, in_insideOut);
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// visit each sample center covered by the triangle
+// 1/w, u/w, and v/w are linear in screen space, so their gradients are constant per triangle
+//-----------------------------------------------------------------------------
+void SoftwareFeedback::DrawTriangle(const ClipVertex* in_pVerts, UINT in_objectIndex, bool in_insideOut)
+{
+    const auto& object = m_objects[in_objectIndex];
+
+    // screen position in samples, y down
+    float x[3], y[3], q[3], uq[3], vq[3];
+    for (UINT i = 0; i < 3; i++)
+    {
+        const auto& v = in_pVerts[i];
+        q[i] = 1.0f / v.m_pos.w;
+        x[i] = ((v.m_pos.x * q[i] * 0.5f) + 0.5f) * m_width;
+        y[i] = (0.5f - (v.m_pos.y * q[i] * 0.5f)) * m_height;
+        uq[i] = v.m_uv.x * q[i];
+        vq[i] = v.m_uv.y * q[i];
+    }
+
+    // clockwise triangles are front-facing (D3D12 default), which have positive area with y down
+    float area = ((x[1] - x[0]) * (y[2] - y[0])) - ((x[2] - x[0]) * (y[1] - y[0]));
+    if (in_insideOut ? (area >= 0) : (area <= 0))
+    {
+        return;
+    }
+
+    int minX = std::max<int>(0, (int)std::ceil(std::min({ x[0], x[1], x[2] }) - 0.5f));
+    int maxX = std::min<int>((int)m_width - 1, (int)std::floor(std::max({ x[0], x[1], x[2] }) - 0.5f));
+    int minY = std::max<int>(0, (int)std::ceil(std::min({ y[0], y[1], y[2] }) - 0.5f));
+    int maxY = std::min<int>((int)m_height - 1, (int)std::floor(std::max({ y[0], y[1], y[2] }) - 0.5f));
+    if ((minX > maxX) || (minY > maxY))
+    {
+        return;
+    }
+
+    const float invArea = 1.0f / area;
+    auto GradientX = [&](const float* a) { return (((a[1] - a[0]) * (y[2] - y[0])) - ((a[2] - a[0]) * (y[1] - y[0]))) * invArea; };
+    auto GradientY = [&](const float* a) { return (((a[2] - a[0]) * (x[1] - x[0])) - ((a[1] - a[0]) * (x[2] - x[0]))) * invArea; };
+    const float dqdx = GradientX(q), dqdy = GradientY(q);
+    const float duqdx = GradientX(uq), duqdy = GradientY(uq);
+    const float dvqdx = GradientX(vq), dvqdy = GradientY(vq);
+
+    // edge functions have the sign of the area inside the triangle
+    auto Edge = [&](UINT a, UINT b, float px, float py) { return ((x[b] - x[a]) * (py - y[a])) - ((y[b] - y[a]) * (px - x[a])); };
+
+    // gradients are per sample. the sampler sees per-pixel derivatives
+    const float pixelScale = 1.0f / m_downsample;
+    const float textureWidth = (float)object.m_textureWidth;
+    const float textureHeight = (float)object.m_textureHeight;
+
+    for (int sy = minY; sy <= maxY; sy++)
+    {
+        float py = sy + 0.5f;
+        for (int sx = minX; sx <= maxX; sx++)
+        {
+            float px = sx + 0.5f;
+            if (((Edge(0, 1, px, py) * area) < 0) || ((Edge(1, 2, px, py) * area) < 0) || ((Edge(2, 0, px, py) * area) < 0))
+            {
+                continue;
+            }
+
+            float dx = px - x[0];
+            float dy = py - y[0];
+            float qs = q[0] + (dqdx * dx) + (dqdy * dy);
+
+            // nearest wins. inside-out objects (the sky) are behind everything
+            float depth = in_insideOut ? FLT_MIN : qs;
+            Sample& sample = m_samples[(sy * m_width) + sx];
+            if ((qs <= 0) || (depth <= sample.m_depth))
+            {
+                continue;
+            }
+
+            // perspective-correct uv and its derivatives
+            float u = (uq[0] + (duqdx * dx) + (duqdy * dy)) / qs;
+            float v = (vq[0] + (dvqdx * dx) + (dvqdy * dy)) / qs;
+            float dudx = ((duqdx - (u * dqdx)) / qs) * pixelScale * textureWidth;
+            float dudy = ((duqdy - (u * dqdy)) / qs) * pixelScale * textureWidth;
+            float dvdx = ((dvqdx - (v * dqdx)) / qs) * pixelScale * textureHeight;
+            float dvdy = ((dvqdy - (v * dqdy)) / qs) * pixelScale * textureHeight;
+
+            // lod as selected by the sampler: anisotropic filtering reduces the lod by the clamped anisotropy ratio
+            float lengthX = std::sqrt((dudx * dudx) + (dvdx * dvdx));
+            float lengthY = std::sqrt((dudy * dudy) + (dvdy * dvdy));
+            float major = std::max(lengthX, lengthY);
+            float minor = std::max(std::min(lengthX, lengthY), FLT_MIN);
+            float anisotropy = std::min(major / minor, m_maxAnisotropy);
+            float lod = std::log2(std::max(major / anisotropy, FLT_MIN)) + m_lodBias;
+
+            // trilinear filtering reads the finer of the 2 mips
+            BYTE mip = (lod <= 0) ? 0 : (BYTE)std::min(lod, 254.0f);
+
+            // clamp addressing
+            u = std::clamp(u, 0.0f, 1.0f);
+            v = std::clamp(v, 0.0f, 1.0f);
+            UINT rx = std::min(object.m_feedbackWidth - 1, (UINT)(u * object.m_feedbackWidth));
+            UINT ry = std::min(object.m_feedbackHeight - 1, (UINT)(v * object.m_feedbackHeight));
+
+            sample = { depth, in_objectIndex, (ry * object.m_feedbackWidth) + rx, mip };
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// min-reduce the visible samples of each object into its feedback regions
+//-----------------------------------------------------------------------------
+void SoftwareFeedback::Resolve(FeedbackFunction in_function)
+{
+    std::vector<UINT> offsets(m_objects.size(), 0);
+    UINT numBytes = 0;
+    for (UINT i = 0; i < (UINT)m_objects.size(); i++)
+    {
+        if (m_objects[i].m_writeFeedback)
+        {
+            offsets[i] = numBytes;
+            numBytes += m_objects[i].m_feedbackWidth * m_objects[i].m_feedbackHeight;
+        }
+    }
+    m_feedback.assign(numBytes, 0xff);
+
+    for (const auto& s : m_samples)
+    {
+        if ((s.m_depth > 0) && m_objects[s.m_object].m_writeFeedback)
+        {
+            BYTE& minMip = m_feedback[offsets[s.m_object] + s.m_region];
+            minMip = std::min(minMip, s.m_mip);
+        }
+    }
+
+    for (UINT i = 0; i < (UINT)m_objects.size(); i++)
+    {
+        if (m_objects[i].m_writeFeedback)
+        {
+            in_function(m_objects[i].m_pKey, &m_feedback[offsets[i]]);
+        }
+    }
+}
@@ -0,0 +1,119 @@
+//*********************************************************
+//
+// Copyright 2020 Intel Corporation 
+//
+// Permission is hereby granted, free of charge, to any 
+// person obtaining a copy of this software and associated 
+// documentation files(the "Software"), to deal in the Software 
+// without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to 
+// whom the Software is furnished to do so, subject to the 
+// following conditions :
+// The above copyright notice and this permission notice shall 
+// be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+// DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+
+
+/*-----------------------------------------------------------------------------
+SoftwareFeedback
+
+CPU substitute for WriteSamplerFeedback() + ResolveSubresource(), for runs that must be
+reproducible frame-to-frame independent of GPU timing, or that can't rely on the GPU for feedback.
+
+Objects are rasterized into a coarse visibility buffer (1 sample per NxN pixels).
+The nearest object at each sample wins, as with depth testing.
+At each sample, the mip the sampler would select is computed from perspective-correct
+uv derivatives (with lod bias and anisotropy), then min-reduced into the feedback region
+containing the uv. The result has the layout of resolved min mip feedback:
+1 byte per region (a 64KB tile of mip 0), 0xff where the texture was not sampled.
+
+Usage per frame: BeginFrame(), Draw() each visible object, Resolve()
+-----------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+#include <functional>
+
+class SoftwareFeedback
+{
+public:
+    // cpu copy of geometry. positions in model space
+    struct Mesh
+    {
+        struct Vertex
+        {
+            DirectX::XMFLOAT3 m_pos;
+            DirectX::XMFLOAT2 m_uv;
+        };
+        std::vector<Vertex> m_vertices;
+        std::vector<UINT32> m_indices;
+    };
+
+    // in_downsample: 1 sample per in_downsample x in_downsample pixels
+    void BeginFrame(UINT in_windowWidth, UINT in_windowHeight, UINT in_downsample,
+        float in_lodBias, UINT in_maxAnisotropy);
+
+    // in_pKey identifies the feedback in Resolve()
+    // in_feedbackWidth/Height: # regions, in_textureWidth/Height: mip 0 texels
+    // in_insideOut: front faces are culled, and the object never occludes others (e.g. the sky)
+    // in_writeFeedback: false to only occlude other objects
+    void Draw(const void* in_pKey, const Mesh& in_mesh, const DirectX::XMMATRIX& in_combinedTransform,
+        UINT in_textureWidth, UINT in_textureHeight, UINT in_feedbackWidth, UINT in_feedbackHeight,
+        bool in_insideOut, bool in_writeFeedback);
+
+    // min-mip feedback for every object drawn with in_writeFeedback since BeginFrame()
+    typedef std::function<void(const void* in_pKey, const BYTE* in_pMinMips)> FeedbackFunction;
+    void Resolve(FeedbackFunction in_function);
+
+    UINT GetNumSamples() const { return (UINT)m_samples.size(); }
+private:
+    struct Sample
+    {
+        float m_depth;  // 1/w, larger is nearer. 0 = empty
+        UINT m_object;  // index into m_objects
+        UINT m_region;  // index into the object's feedback
+        BYTE m_mip;
+    };
+    std::vector<Sample> m_samples;
+    UINT m_width{ 0 };
+    UINT m_height{ 0 };
+    float m_downsample{ 1 };
+    float m_lodBias{ 0 };
+    float m_maxAnisotropy{ 1 };
+
+    struct Object
+    {
+        const void* m_pKey;
+        UINT m_textureWidth;
+        UINT m_textureHeight;
+        UINT m_feedbackWidth;
+        UINT m_feedbackHeight;
+        bool m_writeFeedback;
+    };
+    std::vector<Object> m_objects;
+
+    std::vector<BYTE> m_feedback; // scratch for Resolve()
+
+    // transformed vertex
+    struct ClipVertex
+    {
+        DirectX::XMFLOAT4 m_pos;
+        DirectX::XMFLOAT2 m_uv;
+    };
+    std::vector<ClipVertex> m_clipVertices; // scratch for Draw()
+
+    void DrawTriangle(const ClipVertex* in_pVerts, UINT in_objectIndex, bool in_insideOut);
+};
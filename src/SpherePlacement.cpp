@@ -0,0 +1,245 @@
+//*********************************************************
+//
+// Copyright 2020 Intel Corporation 
+//
+// Permission is hereby granted, free of charge, to any 
+// person obtaining a copy of this software and associated 
+// documentation files(the "Software"), to deal in the Software 
+// without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to 
+// whom the Software is furnished to do so, subject to the 
+// following conditions :
+// The above copyright notice and this permission notice shall 
+// be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+// DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+
+
+
+#include "pch.h"
+
+#include "SpherePlacement.h"
+#include "Timer.h"
+
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+
+//-----------------------------------------------------------------------------
+// a cell is as wide as the largest possible pair of touching spheres
+// so typical queries touch only the neighboring cells
+//-----------------------------------------------------------------------------
+SpherePlacement::SpherePlacement(const Params& in_params, bool in_bruteForce) :
+    m_params(in_params), m_bruteForce(in_bruteForce),
+    m_cellSize(2 * in_params.m_maxSphereSize + in_params.m_spacing)
+{
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+void SpherePlacement::Clear()
+{
+    m_spheres.clear();
+    m_cells.clear();
+    m_maxRadius = 0;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+int SpherePlacement::GetCell(float in_coord) const
+{
+    return (int)std::floor(in_coord / m_cellSize);
+}
+
+UINT64 SpherePlacement::GetKey(int in_x, int in_y, int in_z)
+{
+    constexpr UINT64 mask = (1 << 21) - 1;
+    return (UINT64(in_x) & mask) | ((UINT64(in_y) & mask) << 21) | ((UINT64(in_z) & mask) << 42);
+}
+
+//-----------------------------------------------------------------------------
+// radius is computed the same way as by the original overlap test
+//-----------------------------------------------------------------------------
+void SpherePlacement::Add(const XMMATRIX& in_modelMatrix)
+{
+    XMFLOAT4 sphere;
+    XMStoreFloat4(&sphere, in_modelMatrix.r[3]);
+    sphere.w = XMVectorGetX(XMVector3LengthEst(in_modelMatrix.r[0]));
+
+    UINT index = (UINT)m_spheres.size();
+    m_spheres.push_back(sphere);
+    m_maxRadius = std::max(m_maxRadius, sphere.w);
+
+    m_cells[GetKey(GetCell(sphere.x), GetCell(sphere.y), GetCell(sphere.z))].push_back(index);
+}
+
+//-----------------------------------------------------------------------------
+// leave a minimum spacing between planets
+//-----------------------------------------------------------------------------
+bool SpherePlacement::Overlaps(FXMVECTOR in_center, float in_radius, UINT in_sphereIndex) const
+{
+    const XMFLOAT4& sphere = m_spheres[in_sphereIndex];
+    XMVECTOR p1 = XMVectorSet(sphere.x, sphere.y, sphere.z, 0);
+    float dist = XMVectorGetX(XMVector3LengthEst(p1 - in_center));
+    return (dist - (in_radius + sphere.w) < m_params.m_spacing);
+}
+
+//-----------------------------------------------------------------------------
+// search every cell that could hold the center of an overlapping sphere
+// the range is padded because the distances are estimates
+//-----------------------------------------------------------------------------
+bool SpherePlacement::Overlaps(FXMVECTOR in_center, float in_radius) const
+{
+    if (m_bruteForce)
+    {
+        for (UINT i = 0; i < (UINT)m_spheres.size(); i++)
+        {
+            if (Overlaps(in_center, in_radius, i)) { return true; }
+        }
+        return false;
+    }
+
+    XMFLOAT3 center;
+    XMStoreFloat3(&center, in_center);
+    const float reach = 1.01f * (in_radius + m_maxRadius + m_params.m_spacing);
+
+    const int x0 = GetCell(center.x - reach), x1 = GetCell(center.x + reach);
+    const int y0 = GetCell(center.y - reach), y1 = GetCell(center.y + reach);
+    const int z0 = GetCell(center.z - reach), z1 = GetCell(center.z + reach);
+
+    for (int z = z0; z <= z1; z++)
+    {
+        for (int y = y0; y <= y1; y++)
+        {
+            for (int x = x0; x <= x1; x++)
+            {
+                auto i = m_cells.find(GetKey(x, y, z));
+                if (m_cells.end() == i) { continue; }
+
+                for (UINT sphereIndex : i->second)
+                {
+                    if (Overlaps(in_center, in_radius, sphereIndex)) { return true; }
+                }
+            }
+        }
+    }
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+// the random draws, including the unused ones, match the original placement
+// so the same seed yields the same universe
+//-----------------------------------------------------------------------------
+bool SpherePlacement::Place(std::default_random_engine& inout_gen, XMMATRIX& out_matrix)
+{
+    static std::uniform_real_distribution<float> dis(-1, 1);
+    std::uniform_real_distribution<float> scaleDis(m_params.m_minSphereSize, m_params.m_maxSphereSize);
+
+    XMMATRIX matrix = XMMatrixIdentity();
+
+    bool placed = false;
+    for (UINT tries = 0; (!placed) && (tries < m_params.m_maxTries); tries++)
+    {
+        float sphereScale = scaleDis(inout_gen);
+
+        float x = m_params.m_universeSize * std::abs(dis(inout_gen));
+
+        // position sphere far from terrain
+        const float hollowCenter = m_params.m_hollowCenter;
+        if (x < -hollowCenter) { x -= hollowCenter; }
+        else if (x < hollowCenter) { x += hollowCenter; }
+
+        float rx = (XM_2PI)*dis(inout_gen);
+        float ry = (XM_2PI)*dis(inout_gen);
+        float rz = (XM_2PI)*dis(inout_gen);
+
+        XMMATRIX rtate0 = XMMatrixRotationRollPitchYaw((XM_2PI)*dis(inout_gen), (XM_2PI)*dis(inout_gen), (XM_2PI)*dis(inout_gen));
+        XMMATRIX xlate = XMMatrixTranslation(0, 0, x);
+        XMMATRIX rtate = XMMatrixRotationRollPitchYaw(rx, ry, rz);
+        XMMATRIX scale = XMMatrixScaling(sphereScale, sphereScale, sphereScale);
+
+        matrix = rtate0 * scale * xlate * rtate;
+        matrix = scale * xlate * rtate;
+
+        // spread the spheres out
+        placed = !Overlaps(matrix.r[3], sphereScale);
+    }
+
+    if (!placed)
+    {
+        return false;
+    }
+
+    // pre-rotate to randomize axes
+    float rx = (1.5f * XM_PI) * dis(inout_gen);
+    float ry = (2.5f * XM_PI) * dis(inout_gen);
+    float rz = (2.0f * XM_PI) * dis(inout_gen); // rotation around polar axis of sphere model
+    XMMATRIX rtate = XMMatrixRotationRollPitchYaw(rx, ry, rz);
+    out_matrix = rtate * matrix;
+
+    Add(out_matrix);
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// the universe grows with the # of planets so the density, and so the # of retries,
+// stays close to that of a 1k planet universe
+//-----------------------------------------------------------------------------
+void SpherePlacement::Benchmark(std::wostream& out_stream)
+{
+    out_stream << "num_planets universe_size brute_force_ms grid_ms identical\n";
+
+    for (UINT numPlanets : { 1000U, 5000U, 10000U, 20000U, 50000U })
+    {
+        Params params;
+        params.m_universeSize *= std::cbrt(numPlanets / 1000.f);
+
+        std::vector<XMMATRIX> matrices[2];
+        double times[2]{};
+
+        for (UINT i = 0; i < 2; i++)
+        {
+            bool bruteForce = (0 == i);
+            SpherePlacement placement(params, bruteForce);
+            placement.Add(XMMatrixIdentity()); // terrain
+
+            std::default_random_engine gen;
+            gen.seed(42);
+
+            matrices[i].resize(numPlanets);
+
+            Timer timer;
+            timer.Start();
+            for (auto& m : matrices[i])
+            {
+                if (!placement.Place(gen, m))
+                {
+                    matrices[i].resize(placement.GetNumSpheres() - 1);
+                    break;
+                }
+            }
+            times[i] = timer.GetTime();
+        }
+
+        bool identical = (matrices[0].size() == matrices[1].size()) &&
+            (0 == std::memcmp(matrices[0].data(), matrices[1].data(), matrices[0].size() * sizeof(XMMATRIX)));
+
+        out_stream << matrices[1].size()
+            << " " << params.m_universeSize
+            << " " << times[0] * 1000
+            << " " << times[1] * 1000
+            << " " << identical << std::endl;
+    }
+}
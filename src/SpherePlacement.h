@@ -0,0 +1,99 @@
+//*********************************************************
+//
+// Copyright 2020 Intel Corporation 
+//
+// Permission is hereby granted, free of charge, to any 
+// person obtaining a copy of this software and associated 
+// documentation files(the "Software"), to deal in the Software 
+// without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to 
+// whom the Software is furnished to do so, subject to the 
+// following conditions :
+// The above copyright notice and this permission notice shall 
+// be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+// DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+
+
+
+/*-----------------------------------------------------------------------------
+SpherePlacement
+
+Random, non-overlapping placement of planets.
+
+Each candidate transform is drawn from the random engine exactly as before; only the
+overlap test changed. Instead of comparing the candidate with every object, placed
+spheres are bucketed by center into a uniform grid (stored as a hash of cell coordinates)
+and only the cells within reach of the candidate are searched. The same seed produces
+the same sequence of transforms.
+
+Usage: Add() objects that are not placed randomly (e.g. the terrain), Place() each planet,
+Clear() and Add() the remaining objects after removing some
+-----------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+#include <unordered_map>
+#include <random>
+#include <ostream>
+
+#include "SharedConstants.h"
+
+class SpherePlacement
+{
+public:
+    struct Params
+    {
+        float m_universeSize{ float(SharedConstants::UNIVERSE_SIZE) };
+        float m_minSphereSize{ float(SharedConstants::SPHERE_SCALE) };
+        float m_maxSphereSize{ float(SharedConstants::MAX_SPHERE_SCALE * SharedConstants::SPHERE_SCALE) };
+        float m_spacing{ float(SharedConstants::SPHERE_SCALE) * .75f }; // minimum distance between sphere surfaces
+        float m_hollowCenter{ 4 * 128 }; // keep planets away from the terrain. 128 is texture dim
+        UINT m_maxTries{ 1000 };
+    };
+
+    // in_bruteForce: test every sphere, as the original placement did. for comparison.
+    SpherePlacement(const Params& in_params, bool in_bruteForce = false);
+
+    void Clear();
+
+    // add an existing object. center = translation, radius = scale
+    void Add(const DirectX::XMMATRIX& in_modelMatrix);
+
+    // random transform that does not overlap any added sphere, which is then added
+    // returns false if nothing fit in m_maxTries attempts
+    bool Place(std::default_random_engine& inout_gen, DirectX::XMMATRIX& out_matrix);
+
+    UINT GetNumSpheres() const { return (UINT)m_spheres.size(); }
+
+    // time placement of 1k to 50k planets with and without the grid
+    static void Benchmark(std::wostream& out_stream);
+private:
+    const Params m_params;
+    const bool m_bruteForce{ false };
+    const float m_cellSize{ 0 };
+
+    std::vector<DirectX::XMFLOAT4> m_spheres; // center, radius
+    float m_maxRadius{ 0 };
+
+    // sphere indices by cell of the sphere center
+    std::unordered_map<UINT64, std::vector<UINT>> m_cells;
+
+    int GetCell(float in_coord) const;
+    static UINT64 GetKey(int in_x, int in_y, int in_z);
+
+    bool Overlaps(DirectX::FXMVECTOR in_center, float in_radius) const;
+    bool Overlaps(DirectX::FXMVECTOR in_center, float in_radius, UINT in_sphereIndex) const;
+};
@@ -11,15 +11,19 @@
 #include <cstdint>
 #include <vector>
 #include <array>
+#include <functional>
+#include <ppl.h>
 
 class Subdivision
 {
 public:
-    // we need a function that creates a vertex from 2 parent vertex indices,
-    // adds it to a storage object, then returns the index of the new vertex.
+    // each subdivision adds a vertex between the 2 vertices of every edge.
+    // the caller grows its vertex storage in ResizeVertices(), then SetVertex() creates the vertex
+    // at in_index from its 2 parent vertex indices. SetVertex() is called from multiple threads.
     // we don't care about the vertex format or the storage object
     // std::function lets the caller capture that into the function
-    using AddVertex = std::function<uint32_t(uint32_t, uint32_t)>;
+    using ResizeVertices = std::function<void(uint32_t in_numVertices)>;
+    using SetVertex = std::function<void(uint32_t in_a, uint32_t in_b, uint32_t in_index)>;
     using Edge = std::array<uint32_t, 2>; // e.g. edge{0,1} is the edge from vert 0 to vert 1
     struct EdgeIndex
     {
@@ -32,68 +36,83 @@ public:
     };
 
     // initial object to subdivide
-    Subdivision(AddVertex in_addVert,
+    Subdivision(uint32_t in_numVertices,
+        ResizeVertices in_resizeVertices, SetVertex in_setVertex,
         const std::vector<Edge>& in_edges,
-        const std::vector<Triangle>& in_triangles)
-        //: m_addVert(in_addVert), m_edges(in_edges), m_triangles(in_triangles)
+        const std::vector<Triangle>& in_triangles) :
+        m_numVertices(in_numVertices), m_resizeVertices(in_resizeVertices), m_setVertex(in_setVertex),
+        m_edges(in_edges), m_triangles(in_triangles)
     {
-        m_addVert = in_addVert;
-        m_edges = in_edges;
-        m_triangles = in_triangles;
     }
 
     // subdivision appends to the vertex buffer
     // the internal edge list is replaced each iteration
+    // every edge and triangle writes to a fixed position, so the work is split across threads
+    // and the result does not depend on thread timing
     void Next()
     {
+        const uint32_t numEdges = (uint32_t)m_edges.size();
+        const uint32_t numTriangles = (uint32_t)m_triangles.size();
+
+        // one new vertex per edge. edges are shared by adjacent triangles, so midpoints are not duplicated
+        const uint32_t firstVertex = m_numVertices;
+        m_numVertices += numEdges;
+        m_resizeVertices(m_numVertices);
+
+        // children of m_edges[i] will be edges[i*2] and edges[i*2+1]
+        // followed by 3 new edges per triangle
+        std::vector<Edge> edges(size_t(numEdges) * 2 + size_t(numTriangles) * 3);
+        std::vector<Triangle> triangles(size_t(numTriangles) * 4);
+
         // subdivide edges (adds a vertex per edge)
-        std::vector<Edge> edges;
-        edges.reserve(m_edges.size() * 2);
-        for (const auto& e : m_edges)
-        {
-            uint32_t v = m_addVert(e[0], e[1]);
-            // children of m_edges[i] will be edges[i*2] and edges[i*2+1]
-            edges.push_back({ e[0], v });
-            edges.push_back({ v, e[1] });
-        }
+        concurrency::parallel_for(0U, numEdges, [&](uint32_t i)
+            {
+                const auto& e = m_edges[i];
+                uint32_t v = firstVertex + i;
+                m_setVertex(e[0], e[1], v);
+                edges[i * 2] = { e[0], v };
+                edges[i * 2 + 1] = { v, e[1] };
+            });
 
         // generate triangles (adds 3 more edges)
-        std::vector<Triangle> triangles;
-        for (const auto& t : m_triangles)
-        {
-            EdgeIndex e0 = t.m_edgeIndices[0];
-            uint32_t e00 = e0.index * 2;
-            uint32_t e01 = e00 + 1;
-            
-            EdgeIndex e1 = t.m_edgeIndices[1];
-            uint32_t e10 = e1.index * 2;
-            uint32_t e11 = e10 + 1;
-
-            EdgeIndex e2 = t.m_edgeIndices[2];
-            uint32_t e20 = e2.index * 2;
-            uint32_t e21 = e20 + 1;
-
-            // regardless of the direction of edges 0, 1, 2
-            // the generated edges will always have direction 0
-            uint32_t m0 = edges[e00][1];
-            uint32_t m1 = edges[e10][1];
-            uint32_t m2 = edges[e20][1];
-
-            // new center triangle
-            uint32_t baseIndex = (uint32_t)edges.size();
-            edges.push_back({ m0, m1 });
-            edges.push_back({ m1, m2 });
-            edges.push_back({ m2, m0 });
-            struct EdgeIndex x0 { 0, baseIndex };
-            triangles.push_back({ { {0,baseIndex + 0}, {0,baseIndex + 1}, {0,baseIndex + 2} } });
-
-            if (e0.direction) { std::swap(e00, e01); }
-            if (e1.direction) { std::swap(e10, e11); }
-            if (e2.direction) { std::swap(e20, e21); }
-            triangles.push_back({ { {e0.direction, e00}, {1,baseIndex + 2}, {e2.direction, e21} } });
-            triangles.push_back({ { {e0.direction, e01}, {e1.direction, e10}, {1, baseIndex + 0} } });
-            triangles.push_back({ { {1, baseIndex + 1}, {e1.direction, e11}, {e2.direction, e20} } });
-        }
+        concurrency::parallel_for(0U, numTriangles, [&](uint32_t t)
+            {
+                const auto& tri = m_triangles[t];
+
+                EdgeIndex e0 = tri.m_edgeIndices[0];
+                uint32_t e00 = e0.index * 2;
+                uint32_t e01 = e00 + 1;
+
+                EdgeIndex e1 = tri.m_edgeIndices[1];
+                uint32_t e10 = e1.index * 2;
+                uint32_t e11 = e10 + 1;
+
+                EdgeIndex e2 = tri.m_edgeIndices[2];
+                uint32_t e20 = e2.index * 2;
+                uint32_t e21 = e20 + 1;
+
+                // regardless of the direction of edges 0, 1, 2
+                // the generated edges will always have direction 0
+                uint32_t m0 = edges[e00][1];
+                uint32_t m1 = edges[e10][1];
+                uint32_t m2 = edges[e20][1];
+
+                // new center triangle
+                uint32_t baseIndex = (numEdges * 2) + (t * 3);
+                edges[baseIndex + 0] = { m0, m1 };
+                edges[baseIndex + 1] = { m1, m2 };
+                edges[baseIndex + 2] = { m2, m0 };
+
+                Triangle* pTriangles = &triangles[size_t(t) * 4];
+                pTriangles[0] = { { {0,baseIndex + 0}, {0,baseIndex + 1}, {0,baseIndex + 2} } };
+
+                if (e0.direction) { std::swap(e00, e01); }
+                if (e1.direction) { std::swap(e10, e11); }
+                if (e2.direction) { std::swap(e20, e21); }
+                pTriangles[1] = { { {e0.direction, e00}, {1,baseIndex + 2}, {e2.direction, e21} } };
+                pTriangles[2] = { { {e0.direction, e01}, {e1.direction, e10}, {1, baseIndex + 0} } };
+                pTriangles[3] = { { {1, baseIndex + 1}, {e1.direction, e11}, {e2.direction, e20} } };
+            });
 
         m_edges.swap(edges);
         m_triangles.swap(triangles);
@@ -126,9 +145,11 @@ public:
         }
     }
 private:
+    uint32_t m_numVertices{ 0 };
+    ResizeVertices m_resizeVertices;
+    SetVertex m_setVertex;
     std::vector<Edge> m_edges;
     std::vector<Triangle> m_triangles;
-    AddVertex m_addVert;
 
     Subdivision(Subdivision&) = delete;
 };
@@ -27,6 +27,7 @@
 #include "pch.h"
 
 #include <random>
+#include <ppl.h>
 #include "TerrainGenerator.h"
 
 using namespace DirectX;
@@ -34,7 +35,7 @@ using namespace DirectX;
 //-----------------------------------------------------------------------------
 // Setup random lattice
 //-----------------------------------------------------------------------------
-TerrainGenerator::TerrainGenerator(const TerrainGenerator::Params& in_args) :
+TerrainGenerator::TerrainGenerator(const TerrainGenerator::Params& in_args, bool in_reference) :
     m_args(in_args)
 {
     std::mt19937 gen(42);
@@ -50,7 +51,14 @@ TerrainGenerator::TerrainGenerator(const TerrainGenerator::Params& in_args) :
     }
 
     m_vertices.resize(gridSize);
-    GenerateVertices();
+    if (in_reference)
+    {
+        GenerateVerticesReference();
+    }
+    else
+    {
+        GenerateVertices();
+    }
 
     UINT numQuads = (in_args.m_terrainSideSize - 1) * (in_args.m_terrainSideSize - 1);
     m_numIndices = numQuads * 6;
@@ -120,6 +128,66 @@ float TerrainGenerator::Noise(XMFLOAT2 scaledLocation)
     return noise;
 }
 
+//-----------------------------------------------------------------------------
+// vectorized across 4 sample locations
+// to be bit-identical with Noise(), each step is the same IEEE operation in the same order
+// (note: no fused multiply-add, which would round differently)
+//-----------------------------------------------------------------------------
+XMVECTOR TerrainGenerator::Noise4(FXMVECTOR in_x, FXMVECTOR in_y)
+{
+    const XMVECTOR one = XMVectorSplatOne();
+
+    XMVECTOR floorX = XMVectorFloor(in_x);
+    XMVECTOR floorY = XMVectorFloor(in_y);
+
+    // vectors from the 4 corners to the sample point
+    XMVECTOR x0 = in_x - floorX;
+    XMVECTOR x1 = in_x - (floorX + one);
+    XMVECTOR y0 = in_y - floorY;
+    XMVECTOR y1 = in_y - (floorY + one);
+
+    // gather the random vectors
+    XMFLOAT4A locationX, locationY;
+    XMStoreFloat4A(&locationX, floorX);
+    XMStoreFloat4A(&locationY, floorY);
+
+    XMFLOAT4A grad00x, grad00y, grad01x, grad01y, grad10x, grad10y, grad11x, grad11y;
+    float* pLocationX = &locationX.x;
+    float* pLocationY = &locationY.x;
+    for (UINT i = 0; i < 4; i++)
+    {
+        int2 location00 = int2(static_cast<int>(pLocationX[i]), static_cast<int>(pLocationY[i]));
+
+        XMFLOAT2 grad00 = ReadLattice(location00 + int2(0, 0));
+        XMFLOAT2 grad01 = ReadLattice(location00 + int2(0, 1));
+        XMFLOAT2 grad10 = ReadLattice(location00 + int2(1, 0));
+        XMFLOAT2 grad11 = ReadLattice(location00 + int2(1, 1));
+
+        (&grad00x.x)[i] = grad00.x; (&grad00y.x)[i] = grad00.y;
+        (&grad01x.x)[i] = grad01.x; (&grad01y.x)[i] = grad01.y;
+        (&grad10x.x)[i] = grad10.x; (&grad10y.x)[i] = grad10.y;
+        (&grad11x.x)[i] = grad11.x; (&grad11y.x)[i] = grad11.y;
+    }
+
+    // dot products
+    XMVECTOR g00 = (XMLoadFloat4A(&grad00x) * x0) + (XMLoadFloat4A(&grad00y) * y0);
+    XMVECTOR g01 = (XMLoadFloat4A(&grad01x) * x0) + (XMLoadFloat4A(&grad01y) * y1);
+    XMVECTOR g10 = (XMLoadFloat4A(&grad10x) * x1) + (XMLoadFloat4A(&grad10y) * y0);
+    XMVECTOR g11 = (XMLoadFloat4A(&grad11x) * x1) + (XMLoadFloat4A(&grad11y) * y1);
+
+    // bilinear interpolation with spline weights: 3t^2 - 2t^3
+    auto Bilinear4 = [](FXMVECTOR lo, FXMVECTOR hi, FXMVECTOR t)
+    {
+        XMVECTOR weight = (XMVectorReplicate(3.f) * (t * t)) - (((XMVectorReplicate(2.f) * t) * t) * t);
+        return lo + (weight * (hi - lo));
+    };
+
+    XMVECTOR a = Bilinear4(g00, g10, x0);
+    XMVECTOR b = Bilinear4(g01, g11, x0);
+
+    return Bilinear4(a, b, y0);
+}
+
 void TerrainGenerator::Add(DirectX::XMFLOAT3& out_a, DirectX::XMVECTOR in_b)
 {
     DirectX::XMVECTOR n = DirectX::XMLoadFloat3(&out_a);
@@ -132,12 +200,123 @@ void TerrainGenerator::Normalize(DirectX::XMFLOAT3& out_v)
     DirectX::XMStoreFloat3(&out_v, n);
 }
 
+//-----------------------------------------------------------------------------
+// positions and texture coordinates for one row of vertices, same as GenerateVerticesReference()
+// the last group of 4 may extend past the end of the row. those results are discarded.
+//-----------------------------------------------------------------------------
+void TerrainGenerator::GenerateRow(UINT in_y)
+{
+    const float minDimension = -100.0f;
+    const float maxDimension = 100.0f;
+
+    const float length = maxDimension - minDimension;
+    const float frac = 1.0f / static_cast<float>(m_args.m_terrainSideSize - 1);
+
+    const float texY = in_y * frac;
+    const XMVECTOR posZ = XMVectorReplicate(minDimension + (length * texY));
+    const XMVECTOR lanes = XMVectorSet(0, 1, 2, 3);
+
+    for (UINT x = 0; x < m_args.m_terrainSideSize; x += 4)
+    {
+        XMVECTOR texX = (XMVectorReplicate(float(x)) + lanes) * XMVectorReplicate(frac);
+        XMVECTOR posX = XMVectorReplicate(minDimension) + (XMVectorReplicate(length) * texX);
+
+        XMVECTOR height = XMVectorZero();
+
+        for (UINT i = 0; i < m_args.m_numOctaves; i++)
+        {
+            float coordModulate = float(1 << i);
+            float heightModulate = 1.0f / (coordModulate * coordModulate);
+
+            XMVECTOR noiseX = (posX * XMVectorReplicate(coordModulate)) / XMVectorReplicate(m_args.m_noiseScale);
+            XMVECTOR noiseY = (posZ * XMVectorReplicate(coordModulate)) / XMVectorReplicate(m_args.m_noiseScale);
+
+            height = height + (Noise4(noiseX, noiseY) * XMVectorReplicate(heightModulate));
+        }
+
+        XMVECTOR distanceFromCenter = XMVectorSqrt((posX * posX) + (posZ * posZ));
+
+        XMFLOAT4A texXs, posXs, heights, distances;
+        XMStoreFloat4A(&texXs, texX);
+        XMStoreFloat4A(&posXs, posX);
+        XMStoreFloat4A(&heights, height);
+        XMStoreFloat4A(&distances, distanceFromCenter);
+
+        const UINT numLanes = std::min(4U, m_args.m_terrainSideSize - x);
+        for (UINT i = 0; i < numLanes; i++)
+        {
+            Vertex& vtx = m_vertices[in_y * m_args.m_terrainSideSize + x + i];
+
+            vtx.pos.x = (&posXs.x)[i];
+            vtx.pos.z = XMVectorGetX(posZ);
+
+            // Gaussian() is not vectorized: exp() has no bit-exact SIMD equivalent
+            vtx.pos.y = m_args.m_heightScale * (&heights.x)[i] * Gaussian((&distances.x)[i], m_args.m_mountainSize);
+
+            // FIXME? the terrain is shown upside down!
+            vtx.tex.x = 1.f - (&texXs.x)[i];
+            vtx.tex.y = texY;
+        }
+    }
+}
+
 //-----------------------------------------------------------------------------
 // Compute vertex buffer for terrain that is a 2D grid.
 // The computed terrain spans [0,1] in texture coordinates (inclusive on edges).
-// The array pointed to by pResult is assumed to have m_numVertices elements, which are filled in by valid data by this function.
+// Rows are generated in parallel, 4 vertices at a time. Produces exactly the same vertices as
+// GenerateVerticesReference(): normals are gathered per vertex in the order the reference accumulates them.
 //-----------------------------------------------------------------------------
 void TerrainGenerator::GenerateVertices()
+{
+    const UINT sideSize = m_args.m_terrainSideSize;
+    const UINT numQuads = sideSize - 1; // per row
+
+    concurrency::parallel_for(0U, sideSize, [&](UINT y) { GenerateRow(y); });
+
+    // 2 face normals per quad (upper, lower)
+    std::vector<XMFLOAT3> faceNormals(numQuads * numQuads * 2);
+    concurrency::parallel_for(0U, numQuads, [&](UINT y)
+        {
+            for (UINT x = 0; x < numQuads; x++)
+            {
+                UINT vtx0 = (y * sideSize) + x;
+                UINT quad = 2 * ((y * numQuads) + x);
+                XMStoreFloat3(&faceNormals[quad + 0], ComputeNormal(vtx0, vtx0 + 1, vtx0 + 1 + sideSize));
+                XMStoreFloat3(&faceNormals[quad + 1], ComputeNormal(vtx0, vtx0 + 1 + sideSize, vtx0 + sideSize));
+            }
+        });
+
+    // each vertex sums the faces that touch it, in the order the reference loops over quads
+    concurrency::parallel_for(0U, sideSize, [&](UINT y)
+        {
+            for (UINT x = 0; x < sideSize; x++)
+            {
+                XMVECTOR n = XMVectorZero();
+                auto AddFace = [&](UINT qx, UINT qy, UINT tri)
+                {
+                    n = n + XMLoadFloat3(&faceNormals[2 * ((qy * numQuads) + qx) + tri]);
+                };
+
+                if (y > 0)
+                {
+                    if (x > 0) { AddFace(x - 1, y - 1, 0); AddFace(x - 1, y - 1, 1); }
+                    if (x < numQuads) { AddFace(x, y - 1, 1); }
+                }
+                if (y < numQuads)
+                {
+                    if (x > 0) { AddFace(x - 1, y, 0); }
+                    if (x < numQuads) { AddFace(x, y, 0); AddFace(x, y, 1); }
+                }
+
+                XMStoreFloat3(&m_vertices[(y * sideSize) + x].normal, XMVector3Normalize(n));
+            }
+        });
+}
+
+//-----------------------------------------------------------------------------
+// original single-threaded scalar generator
+//-----------------------------------------------------------------------------
+void TerrainGenerator::GenerateVerticesReference()
 {
     float minDimension = -100.0f;
     float maxDimension = 100.0f;
@@ -265,3 +444,40 @@ XMVECTOR TerrainGenerator::ComputeNormal(UINT vtx0, UINT vtx1, UINT vtx2) const
     XMVECTOR v20 = XMVectorSubtract(pos2, pos0);
     return XMVector3Normalize(XMVector3Cross(v20, v10));
 }
+
+//-----------------------------------------------------------------------------
+// includes the (serial) random lattice setup, which both generators share
+//-----------------------------------------------------------------------------
+void TerrainGenerator::Benchmark(std::wostream& out_stream, const Params& in_params)
+{
+    std::vector<UINT> sizes{ in_params.m_terrainSideSize };
+    for (UINT s : { 512U, 1024U, 2048U })
+    {
+        if (s > in_params.m_terrainSideSize) { sizes.push_back(s); }
+    }
+
+    out_stream << "side_size octaves reference_ms parallel_ms identical\n";
+
+    for (UINT s : sizes)
+    {
+        Params params = in_params;
+        params.m_terrainSideSize = s;
+
+        Timer timer;
+        timer.Start();
+        TerrainGenerator reference(params, true);
+        double referenceTime = timer.GetTime();
+
+        timer.Start();
+        TerrainGenerator terrain(params);
+        double parallelTime = timer.GetTime();
+
+        bool identical = (0 == std::memcmp(reference.m_vertices.data(), terrain.m_vertices.data(),
+            terrain.m_vertices.size() * sizeof(Vertex)));
+
+        out_stream << s << " " << params.m_numOctaves
+            << " " << referenceTime * 1000
+            << " " << parallelTime * 1000
+            << " " << identical << std::endl;
+    }
+}
@@ -39,7 +39,12 @@ public:
         float m_mountainSize{ 4000 };
     };
 
-    TerrainGenerator(const Params& in_args);
+    // in_reference: use the original single-threaded scalar generator, for validation
+    TerrainGenerator(const Params& in_args, bool in_reference = false);
+
+    // time the reference and parallel generators at the configured and a few larger sizes,
+    // and check that their vertices are bit-identical
+    static void Benchmark(std::wostream& out_stream, const Params& in_params);
 
     struct Vertex
     {
@@ -70,6 +75,8 @@ private:
         }
     };
     float Noise(DirectX::XMFLOAT2 scaledLocation);
+    // 4 samples at a time. same operations, in the same order, as Noise()
+    DirectX::XMVECTOR Noise4(DirectX::FXMVECTOR in_x, DirectX::FXMVECTOR in_y);
     DirectX::XMFLOAT2 ReadLattice(int2 location);
 
     template <typename T> T Lerp(T lo, T hi, float w) { return (lo + ((hi - lo) * w)); }
@@ -88,4 +95,6 @@ private:
     void Normalize(DirectX::XMFLOAT3& out_v);
 
     void GenerateVertices();
+    void GenerateVerticesReference();
+    void GenerateRow(UINT in_y); // positions and texture coordinates of 1 row, 4 vertices at a time
 };
@@ -28,6 +28,7 @@
 #include <algorithm>
 #include <time.h>
 #include <iomanip>
+#include <cmath>
 
 //=============================================================================
 //=============================================================================
@@ -108,6 +109,96 @@ private:
     float m_total; // keep a running total of the last n begin/end
 };
 
+//=============================================================================
+// streaming histogram: fixed memory, values added one at a time
+// buckets are log-linear (32 per power of 2), so percentiles are within ~3% below the true value
+// integers up to 32 are exact. count, sum, min, and max are exact
+//=============================================================================
+class Histogram
+{
+public:
+    Histogram() : m_buckets(NUM_BUCKETS, 0) {}
+
+    void Add(double in_value)
+    {
+        m_buckets[GetBucket(in_value)]++;
+        if (0 == m_count)
+        {
+            m_min = in_value;
+            m_max = in_value;
+        }
+        m_min = std::min(m_min, in_value);
+        m_max = std::max(m_max, in_value);
+        m_sum += in_value;
+        m_count++;
+    }
+
+    UINT64 GetCount() const { return m_count; }
+    double GetMin() const { return m_min; }
+    double GetMax() const { return m_max; }
+    double GetMean() const { return m_count ? m_sum / m_count : 0; }
+
+    // e.g. 0.99 for p99. returns the lower bound of the bucket containing the percentile, clamped to [min, max]
+    double GetPercentile(double in_percentile) const
+    {
+        if (0 == m_count) { return 0; }
+
+        // rank of the sample, 1-based
+        UINT64 rank = std::max(UINT64(1), UINT64(std::ceil(in_percentile * m_count)));
+        UINT64 total = 0;
+        for (UINT i = 0; i < NUM_BUCKETS; i++)
+        {
+            total += m_buckets[i];
+            if (total >= rank)
+            {
+                return std::min(m_max, std::max(m_min, GetBucketValue(i)));
+            }
+        }
+        return m_max;
+    }
+
+    // call with (lower bound, count) for each non-empty bucket
+    template<typename F> void ForEachBucket(F&& in_function) const
+    {
+        for (UINT i = 0; i < NUM_BUCKETS; i++)
+        {
+            if (m_buckets[i]) { in_function(GetBucketValue(i), m_buckets[i]); }
+        }
+    }
+private:
+    static constexpr int SUB_BUCKET_BITS = 5;
+    static constexpr int NUM_SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr int MIN_EXPONENT = -10; // values below 2^-10 share bucket 0, e.g. times in ms below 1us
+    static constexpr int MAX_EXPONENT = 40;  // values above 2^40 share the last bucket
+    static constexpr UINT NUM_BUCKETS = 1 + (MAX_EXPONENT - MIN_EXPONENT) * NUM_SUB_BUCKETS;
+
+    std::vector<UINT64> m_buckets;
+    UINT64 m_count{ 0 };
+    double m_sum{ 0 };
+    double m_min{ 0 };
+    double m_max{ 0 };
+
+    static UINT GetBucket(double in_value)
+    {
+        if (!(in_value >= std::ldexp(1.0, MIN_EXPONENT))) { return 0; } // also catches NaN
+        int exponent = 0;
+        double mantissa = std::frexp(in_value, &exponent); // [0.5, 1)
+        exponent -= 1; // value = (2 * mantissa) * 2^exponent, 2 * mantissa in [1, 2)
+        if (exponent >= MAX_EXPONENT) { return NUM_BUCKETS - 1; }
+        UINT subBucket = UINT((2 * mantissa - 1) * NUM_SUB_BUCKETS);
+        return 1 + UINT(exponent - MIN_EXPONENT) * NUM_SUB_BUCKETS + subBucket;
+    }
+
+    static double GetBucketValue(UINT in_bucket)
+    {
+        if (0 == in_bucket) { return 0; }
+        in_bucket--;
+        int exponent = int(in_bucket / NUM_SUB_BUCKETS) + MIN_EXPONENT;
+        double mantissa = 1 + double(in_bucket % NUM_SUB_BUCKETS) / NUM_SUB_BUCKETS;
+        return std::ldexp(mantissa, exponent);
+    }
+};
+
 //=============================================================================
 // CSV output
 //=============================================================================
@@ -0,0 +1,389 @@
+//*********************************************************
+//
+// Copyright 2020 Intel Corporation 
+//
+// Permission is hereby granted, free of charge, to any 
+// person obtaining a copy of this software and associated 
+// documentation files(the "Software"), to deal in the Software 
+// without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to 
+// whom the Software is furnished to do so, subject to the 
+// following conditions :
+// The above copyright notice and this permission notice shall 
+// be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+// DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+
+
+#include "pch.h"
+
+#include "UploadBatcher.h"
+#include "DebugHelper.h"
+#include "Timer.h"
+
+#include <cstring>
+
+//-----------------------------------------------------------------------------
+// staged uploads start on 16-byte boundaries
+// arenas beyond this count are released rather than kept for reuse
+//-----------------------------------------------------------------------------
+namespace
+{
+    constexpr size_t STAGING_ALIGNMENT = 16;
+    constexpr size_t MAX_FREE_ARENAS = 8;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+UploadBatcher::UploadBatcher(Destination& in_destination, size_t in_arenaSize) :
+    m_destination(in_destination), m_arenaSize(in_arenaSize)
+{
+}
+
+UploadBatcher::~UploadBatcher()
+{
+    ASSERT(!m_staged);
+    WaitForAll();
+}
+
+//-----------------------------------------------------------------------------
+// return arenas of completed batches to the free list
+//-----------------------------------------------------------------------------
+void UploadBatcher::Recycle(UINT64 in_completedBatch)
+{
+    while (m_inFlight.size() && (m_inFlight.front().m_id <= in_completedBatch))
+    {
+        for (auto& arena : m_inFlight.front().m_arenas)
+        {
+            // dedicated blocks for large uploads are not reused
+            if ((m_arenaSize == arena.m_size) && (m_free.size() < MAX_FREE_ARENAS))
+            {
+                arena.m_used = 0;
+                m_free.push_back(std::move(arena));
+            }
+        }
+        m_inFlight.pop_front();
+    }
+}
+
+//-----------------------------------------------------------------------------
+// sub-allocate from the open arena. starts a new arena (recycled if possible) when full
+//-----------------------------------------------------------------------------
+BYTE* UploadBatcher::Allocate(size_t in_numBytes)
+{
+    size_t alignedSize = (in_numBytes + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+
+    // too large for an arena: dedicated block. keep the open arena last
+    if (alignedSize > m_arenaSize)
+    {
+        Arena arena;
+        arena.m_data.reset(new BYTE[in_numBytes]);
+        arena.m_size = in_numBytes;
+        arena.m_used = in_numBytes;
+        m_numArenas++;
+
+        BYTE* pData = arena.m_data.get();
+        m_current.insert(m_current.begin(), std::move(arena));
+        return pData;
+    }
+
+    if (m_current.empty() || (m_current.back().m_used + alignedSize > m_current.back().m_size))
+    {
+        Recycle(m_destination.GetCompletedBatch());
+
+        Arena arena;
+        if (m_free.size())
+        {
+            arena = std::move(m_free.back());
+            m_free.pop_back();
+            m_numRecycled++;
+        }
+        else
+        {
+            arena.m_data.reset(new BYTE[m_arenaSize]);
+            arena.m_size = m_arenaSize;
+            m_numArenas++;
+        }
+        m_current.push_back(std::move(arena));
+    }
+
+    auto& arena = m_current.back();
+    BYTE* pData = arena.m_data.get() + arena.m_used;
+    arena.m_used += alignedSize;
+    return pData;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+void UploadBatcher::Stage(void* in_pDestination, const void* in_pData, size_t in_dataSize, size_t in_uploadSize)
+{
+    ASSERT(in_uploadSize <= UINT32_MAX);
+    if (0 == in_uploadSize)
+    {
+        return;
+    }
+
+    size_t numBytes = std::min(in_dataSize, in_uploadSize);
+
+    BYTE* pStaged = Allocate(in_uploadSize);
+    memcpy(pStaged, in_pData, numBytes);
+    if (in_uploadSize > numBytes)
+    {
+        memset(pStaged + numBytes, 0, in_uploadSize - numBytes);
+    }
+
+    m_destination.Enqueue(in_pDestination, pStaged, (UINT32)in_uploadSize);
+    m_staged = true;
+}
+
+//-----------------------------------------------------------------------------
+// one completion for everything staged since the previous Submit()
+//-----------------------------------------------------------------------------
+UINT64 UploadBatcher::Submit()
+{
+    if (m_staged)
+    {
+        m_batchId++;
+        m_destination.Signal(m_batchId);
+
+        // staging memory must outlive the batch
+        Batch batch;
+        batch.m_id = m_batchId;
+        batch.m_arenas.swap(m_current);
+        m_inFlight.push_back(std::move(batch));
+
+        m_staged = false;
+
+        Recycle(m_destination.GetCompletedBatch());
+    }
+    return m_batchId;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+void UploadBatcher::WaitForAll()
+{
+    if (m_inFlight.size())
+    {
+        m_destination.WaitForBatch(m_batchId);
+        Recycle(m_batchId);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// in-memory destination for Benchmark()
+// copies are deferred until a batch completes, which is in_latency batches after
+// it was signaled, so staging memory released early would be detected
+//-----------------------------------------------------------------------------
+namespace
+{
+    class MemoryDestination : public UploadBatcher::Destination
+    {
+    public:
+        MemoryDestination(UINT in_latency) : m_latency(in_latency) {}
+
+        virtual void Enqueue(void* in_pDestination, const BYTE* in_pStaged, UINT32 in_numBytes) override
+        {
+            m_pending.push_back({ in_pDestination, in_pStaged, in_numBytes });
+        }
+
+        virtual void Signal(UINT64 in_batchId) override
+        {
+            m_batches.push_back({ in_batchId, std::move(m_pending) });
+            m_pending.clear();
+            while (m_batches.size() > m_latency)
+            {
+                Complete();
+            }
+        }
+
+        virtual UINT64 GetCompletedBatch() override { return m_completed; }
+
+        virtual void WaitForBatch(UINT64 in_batchId) override
+        {
+            while (m_completed < in_batchId)
+            {
+                Complete();
+            }
+        }
+    private:
+        struct Copy
+        {
+            void* m_pDestination;
+            const BYTE* m_pSource;
+            UINT32 m_numBytes;
+        };
+        const UINT m_latency;
+        std::vector<Copy> m_pending;
+        std::deque<std::pair<UINT64, std::vector<Copy>>> m_batches;
+        UINT64 m_completed{ 0 };
+
+        void Complete()
+        {
+            for (const auto& c : m_batches.front().second)
+            {
+                memcpy(c.m_pDestination, c.m_pSource, c.m_numBytes);
+            }
+            m_completed = m_batches.front().first;
+            m_batches.pop_front();
+        }
+    };
+}
+
+//-----------------------------------------------------------------------------
+// upload 10k small buffers (64B to 16KB, zero-padded to 256B like constant buffers)
+// in batches of various sizes to memory.
+// per_request: a separately allocated staging copy per buffer, freed when its batch completes
+//              (how AssetUploader staged data before arenas)
+// arena: UploadBatcher. the upload set is repeated to show arenas being reused
+//-----------------------------------------------------------------------------
+void UploadBatcher::Benchmark(std::wostream& out_stream)
+{
+    const UINT numBuffers = 10000;
+    const UINT numRepeats = 4;
+    const UINT latency = 2;
+
+    std::default_random_engine gen;
+    gen.seed(42);
+    std::uniform_int_distribution<UINT> sizeDis(64, 16 * 1024);
+    std::uniform_int_distribution<UINT> byteDis(0, 255);
+
+    std::vector<std::vector<BYTE>> sources(numBuffers);
+    std::vector<size_t> uploadSizes(numBuffers);
+    size_t totalBytes = 0;
+    for (UINT i = 0; i < numBuffers; i++)
+    {
+        sources[i].resize(sizeDis(gen));
+        for (auto& b : sources[i]) { b = (BYTE)byteDis(gen); }
+        uploadSizes[i] = (sources[i].size() + 255) & ~size_t(255);
+        totalBytes += uploadSizes[i];
+    }
+
+    // destinations are compared with the source data and the zero padding after it
+    auto Verify = [&](const std::vector<std::vector<BYTE>>& in_destinations)
+    {
+        for (UINT i = 0; i < numBuffers; i++)
+        {
+            const auto& d = in_destinations[i];
+            if (0 != std::memcmp(d.data(), sources[i].data(), sources[i].size())) { return false; }
+            for (size_t j = sources[i].size(); j < d.size(); j++)
+            {
+                if (d[j]) { return false; }
+            }
+        }
+        return true;
+    };
+
+    auto ResetDestinations = [&](std::vector<std::vector<BYTE>>& out_destinations)
+    {
+        out_destinations.resize(numBuffers);
+        for (UINT i = 0; i < numBuffers; i++)
+        {
+            out_destinations[i].assign(uploadSizes[i], 0xcd);
+        }
+    };
+
+    out_stream << "num_buffers total_mb batch_size per_request_ms arena_ms arenas recycled identical\n";
+
+    for (UINT batchSize : { 10000U, 1000U, 100U })
+    {
+        std::vector<std::vector<BYTE>> destinations;
+        double times[2]{};
+        bool identical = true;
+        UINT numArenas = 0;
+        UINT numRecycled = 0;
+
+        // per-request staging
+        {
+            MemoryDestination destination(latency);
+            std::deque<std::pair<UINT64, std::vector<std::vector<BYTE>*>>> inFlight;
+            std::vector<std::vector<BYTE>*> staged;
+            UINT64 batchId = 0;
+
+            auto Release = [&]()
+            {
+                while (inFlight.size() && (inFlight.front().first <= destination.GetCompletedBatch()))
+                {
+                    for (auto p : inFlight.front().second) { delete p; }
+                    inFlight.pop_front();
+                }
+            };
+
+            for (UINT r = 0; r < numRepeats; r++)
+            {
+                ResetDestinations(destinations);
+
+                Timer timer;
+                timer.Start();
+                for (UINT i = 0; i < numBuffers; i++)
+                {
+                    auto pStaged = new std::vector<BYTE>(uploadSizes[i]);
+                    memcpy(pStaged->data(), sources[i].data(), sources[i].size());
+                    destination.Enqueue(destinations[i].data(), pStaged->data(), (UINT32)pStaged->size());
+                    staged.push_back(pStaged);
+
+                    if ((0 == ((i + 1) % batchSize)) || ((i + 1) == numBuffers))
+                    {
+                        destination.Signal(++batchId);
+                        inFlight.push_back({ batchId, std::move(staged) });
+                        staged.clear();
+                        Release();
+                    }
+                }
+                destination.WaitForBatch(batchId);
+                Release();
+                times[0] += timer.GetTime();
+
+                identical = identical && Verify(destinations);
+            }
+        }
+
+        // arenas
+        {
+            MemoryDestination destination(latency);
+            UploadBatcher batcher(destination);
+
+            for (UINT r = 0; r < numRepeats; r++)
+            {
+                ResetDestinations(destinations);
+
+                Timer timer;
+                timer.Start();
+                for (UINT i = 0; i < numBuffers; i++)
+                {
+                    batcher.Stage(destinations[i].data(), sources[i].data(), sources[i].size(), uploadSizes[i]);
+                    if ((0 == ((i + 1) % batchSize)) || ((i + 1) == numBuffers))
+                    {
+                        batcher.Submit();
+                    }
+                }
+                batcher.WaitForAll();
+                times[1] += timer.GetTime();
+
+                identical = identical && Verify(destinations);
+            }
+            numArenas = batcher.GetNumArenas();
+            numRecycled = batcher.GetNumRecycled();
+        }
+
+        out_stream << numBuffers
+            << " " << double(totalBytes) / (1024. * 1024.)
+            << " " << batchSize
+            << " " << times[0] * 1000. / numRepeats
+            << " " << times[1] * 1000. / numRepeats
+            << " " << numArenas
+            << " " << numRecycled
+            << " " << (identical ? 1 : 0)
+            << std::endl;
+    }
+}
@@ -0,0 +1,118 @@
+//*********************************************************
+//
+// Copyright 2020 Intel Corporation 
+//
+// Permission is hereby granted, free of charge, to any 
+// person obtaining a copy of this software and associated 
+// documentation files(the "Software"), to deal in the Software 
+// without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, 
+// and/or sell copies of the Software, and to permit persons to 
+// whom the Software is furnished to do so, subject to the 
+// following conditions :
+// The above copyright notice and this permission notice shall 
+// be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+// DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+
+
+/*-----------------------------------------------------------------------------
+UploadBatcher
+
+Packs many small uploads into large contiguous staging blocks ("arenas").
+
+Stage() copies data into the current arena and forwards the staged copy to a Destination.
+Submit() closes the batch: the destination signals a single completion value for every
+upload in the batch. Arenas are not freed when a batch completes, they return to a free
+list and are reused by later batches. An upload larger than an arena gets a block of its
+own, which is released rather than recycled.
+
+The Destination is an interface so the batching can run without a device: AssetUploader
+implements it with a DirectStorage memory queue, Benchmark() with a plain memory copy.
+-----------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <ostream>
+
+class UploadBatcher
+{
+public:
+    class Destination
+    {
+    public:
+        virtual ~Destination() {}
+
+        // copy in_numBytes from staging memory to the destination. in_pStaged remains valid until the batch completes
+        virtual void Enqueue(void* in_pDestination, const BYTE* in_pStaged, UINT32 in_numBytes) = 0;
+
+        // start all enqueued uploads. the batch is complete when GetCompletedBatch() >= in_batchId
+        virtual void Signal(UINT64 in_batchId) = 0;
+        virtual UINT64 GetCompletedBatch() = 0;
+        virtual void WaitForBatch(UINT64 in_batchId) = 0;
+    };
+
+    static constexpr size_t DEFAULT_ARENA_SIZE = 4 * 1024 * 1024;
+
+    UploadBatcher(Destination& in_destination, size_t in_arenaSize = DEFAULT_ARENA_SIZE);
+    ~UploadBatcher();
+
+    // copy in_dataSize bytes to staging memory and enqueue them to in_pDestination
+    // the upload is in_uploadSize bytes. if larger than the data, the rest is zero
+    void Stage(void* in_pDestination, const void* in_pData, size_t in_dataSize, size_t in_uploadSize);
+
+    // signal the uploads staged since the last Submit(). returns the batch id, or the previous id if nothing was staged
+    UINT64 Submit();
+
+    UINT64 GetLastBatch() const { return m_batchId; }
+
+    // blocks until every submitted batch completes
+    void WaitForAll();
+
+    UINT GetNumArenas() const { return m_numArenas; } // arenas ever allocated
+    UINT GetNumRecycled() const { return m_numRecycled; } // arenas reused from the free list
+
+    // stage 10k small buffers into memory, per-upload allocation vs. arenas
+    static void Benchmark(std::wostream& out_stream);
+private:
+    struct Arena
+    {
+        std::unique_ptr<BYTE[]> m_data;
+        size_t m_size{ 0 };
+        size_t m_used{ 0 };
+    };
+
+    struct Batch
+    {
+        UINT64 m_id{ 0 };
+        std::vector<Arena> m_arenas;
+    };
+
+    Destination& m_destination;
+    const size_t m_arenaSize{ 0 };
+
+    std::vector<Arena> m_current; // arenas of the batch being staged. the last one is open
+    std::deque<Batch> m_inFlight;
+    std::vector<Arena> m_free;
+
+    UINT64 m_batchId{ 0 };
+    bool m_staged{ false }; // something was staged since the last Submit()
+
+    UINT m_numArenas{ 0 };
+    UINT m_numRecycled{ 0 };
+
+    BYTE* Allocate(size_t in_numBytes);
+    void Recycle(UINT64 in_completedBatch);
+};
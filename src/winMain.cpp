@@ -46,6 +46,10 @@ END: toggle all UI
 #include "CommandLineArgs.h"
 #include "ArgParser.h"
 #include "ConfigurationParser.h"
+#include "FrustumCulling.h"
+#include "MeshCache.h"
+#include "SpherePlacement.h"
+#include "UploadBatcher.h"
 
 Scene* g_pScene = nullptr;
 
@@ -131,6 +135,12 @@ void AdjustArguments(CommandLineArgs& out_args)
         {
             for (const auto& filename : std::filesystem::directory_iterator(out_args.m_mediaDir))
             {
+                // skip DdsToXet sidecar files (e.g. .hash) and anything else that isn't a texture
+                if (0 != _wcsicmp(filename.path().extension().c_str(), L".xet"))
+                {
+                    continue;
+                }
+
                 std::wstring f = std::filesystem::absolute(filename.path());
                 out_args.m_textures.push_back(f);
 
@@ -188,8 +198,13 @@ void ParseCommandLine(CommandLineArgs& out_args)
 
     argParser.AddArg(L"-heapSizeTiles", out_args.m_streamingHeapSize);
     argParser.AddArg(L"-numHeaps", out_args.m_numHeaps);
+    argParser.AddArg(L"-evictionGraceFrames", out_args.m_evictionGraceFrames, L"# frames an object that is not visible keeps its tiles");
+    argParser.AddArg(L"-evictionGraceMs", out_args.m_evictionGraceMs, L"milliseconds an object that is not visible keeps its tiles");
+    argParser.AddArg(L"-evictionHeapPressure", out_args.m_evictionHeapPressure, L"heap occupancy (0..1) above which objects are evicted before their grace period");
+    argParser.AddArg(L"-terrainPriority", out_args.m_terrainPriority, L"streaming priority of the terrain, other objects are 1");
 
     argParser.AddArg(L"-maxFeedbackTime", out_args.m_maxGpuFeedbackTimeMs);
+    argParser.AddArg(L"-softwareFeedback", out_args.m_softwareFeedback, L"compute feedback on the CPU with 1 sample per NxN pixels, 0 = GPU sampler feedback");
 
     argParser.AddArg(L"-maxNumObjects", out_args.m_maxNumObjects);
     argParser.AddArg(L"-numSpheres", out_args.m_numSpheres);
@@ -205,6 +220,7 @@ void ParseCommandLine(CommandLineArgs& out_args)
     argParser.AddArg(L"-paintMixer", out_args.m_cameraPaintMixer);
 
     argParser.AddArg(L"-visualizeMinMip", [&]() { out_args.m_visualizeMinMip = true; }, out_args.m_visualizeMinMip);
+    argParser.AddArg(L"-dataVisualization", out_args.m_dataVisualizationMode, L"texture (0), mip level colors (1), random colors (2). 1 & 2 generate tiles without reading files");
     argParser.AddArg(L"-hideFeedback", [&]() { out_args.m_showFeedbackMaps = false; }, false, L"start with no feedback viewer");
     argParser.AddArg(L"-hideUI", [&]() { out_args.m_showUI = false; }, false, L"start with no visible UI");
     argParser.AddArg(L"-miniUI", [&]() { out_args.m_uiModeMini = true; }, false, L"start with mini UI");
@@ -215,6 +231,23 @@ void ParseCommandLine(CommandLineArgs& out_args)
     argParser.AddArg(L"-timingStop", out_args.m_timingStopFrame);
     argParser.AddArg(L"-timingFileFrames", out_args.m_timingFrameFileName);
     argParser.AddArg(L"-exitImageFile", out_args.m_exitImageFileName);
+    argParser.AddArg(L"-recordCameraPath", out_args.m_recordCameraPathFileName, L"record the camera, object spin, and objects of every frame to this file");
+    argParser.AddArg(L"-replayCameraPath", out_args.m_replayCameraPathFileName, L"replay a recorded camera path, then exit");
+    argParser.AddArg(L"-saveResidency", out_args.m_saveResidencyFileName, L"write the resident tiles of every texture to this file on exit");
+    argParser.AddArg(L"-saveResidencyFrame", out_args.m_saveResidencyFrame, L"write the -saveResidency file at this frame instead of on exit");
+    argParser.AddArg(L"-restoreResidency", out_args.m_restoreResidencyFileName, L"warm start: load the tiles saved with -saveResidency. use with -waitForAssetLoad");
+    argParser.AddArg(L"-eventTrace", out_args.m_eventTraceFileName, L"record streaming thread events, write a Chrome trace to this file on exit. 'T' writes one immediately");
+    argParser.AddArg(L"-liveMetrics", out_args.m_liveMetricsName, L"publish streaming statistics to shared memory with this name. read with metricsReader");
+    argParser.AddArg(L"-liveMetricsInterval", out_args.m_liveMetricsIntervalMs, L"ms between live metrics samples");
+
+    argParser.AddArg(L"-objectCreationBudget", out_args.m_objectCreationBudgetMs, L"ms per frame to add objects prepared on worker threads, 0 = create all objects on the render thread");
+    argParser.AddArg(L"-cullingGridThreshold", out_args.m_cullingGridThreshold, L"# objects at which frustum culling uses a spatial grid, 0 = never");
+    argParser.AddArg(L"-cullingBenchmark", out_args.m_cullingBenchmarkFileName, L"time frustum culling of 1k, 10k, and 100k objects, write to this file, and exit");
+    argParser.AddArg(L"-terrainBenchmark", out_args.m_terrainBenchmarkFileName, L"time terrain generation at the configured size and larger, write to this file, and exit");
+    argParser.AddArg(L"-meshBenchmark", out_args.m_meshBenchmarkFileName, L"time sphere mesh generation and the mesh caches, write to this file, and exit");
+    argParser.AddArg(L"-placementBenchmark", out_args.m_placementBenchmarkFileName, L"time placement of 1k to 50k planets with and without the spatial grid, write to this file, and exit");
+    argParser.AddArg(L"-uploadBenchmark", out_args.m_uploadBenchmarkFileName, L"time staging of 10k small buffer uploads with and without arenas, write to this file, and exit");
+    argParser.AddArg(L"-meshCacheDir", out_args.m_meshCacheDir, L"save generated meshes to this directory and load them on later runs");
 
     argParser.AddArg(L"-waitForAssetLoad", out_args.m_waitForAssetLoad, L"stall animation & statistics until assets have minimally loaded");
 
@@ -224,6 +257,7 @@ void ParseCommandLine(CommandLineArgs& out_args)
     argParser.AddArg(L"-directStorage", [&]() { out_args.m_useDirectStorage = true; }, L"force enable DirectStorage");
     argParser.AddArg(L"-directStorageOff", [&]() { out_args.m_useDirectStorage = false; }, L"force disable DirectStorage");
     argParser.AddArg(L"-stagingSizeMB", out_args.m_stagingSizeMB, L"DirectStorage staging buffer size");
+    argParser.AddArg(L"-lowTierThreshold", out_args.m_lowTierThreshold, L"# in-flight batches at which to stream low quality tiers, 0 = off");
 
     argParser.AddArg(L"-captureTrace", [&]() { out_args.m_captureTrace = true; }, false, L"capture a trace of tile requests and submits (DS only)");
 
@@ -369,6 +403,10 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
             g_pScene->SetVisualizationMode(CommandLineArgs::VisualizationMode::RANDOM);
             break;
 
+        case 'T':
+            g_pScene->WriteEventTrace();
+            break;
+
         case VK_UP:
             g_keyState.key.rotxl = 1;
             break;
@@ -498,10 +536,18 @@ void LoadConfigFile(std::wstring& in_configFileName, CommandLineArgs& out_args)
             if (root.isMember("maxTileUpdatesPerApiCall")) out_args.m_maxTileUpdatesPerApiCall = root["maxTileUpdatesPerApiCall"].asUInt();
             if (root.isMember("numStreamingBatches")) out_args.m_numStreamingBatches = root["numStreamingBatches"].asUInt();
             if (root.isMember("minNumUploadRequests")) out_args.m_minNumUploadRequests = root["minNumUploadRequests"].asUInt();
+            if (root.isMember("lowTierThreshold")) out_args.m_lowTierThreshold = root["lowTierThreshold"].asUInt();
+
+            if (root.isMember("evictionGraceFrames")) out_args.m_evictionGraceFrames = root["evictionGraceFrames"].asUInt();
+            if (root.isMember("evictionGraceMs")) out_args.m_evictionGraceMs = root["evictionGraceMs"].asFloat();
+            if (root.isMember("evictionHeapPressure")) out_args.m_evictionHeapPressure = root["evictionHeapPressure"].asFloat();
+            if (root.isMember("terrainPriority")) out_args.m_terrainPriority = root["terrainPriority"].asFloat();
 
             if (root.isMember("maxFeedbackTime")) out_args.m_maxGpuFeedbackTimeMs = root["maxFeedbackTime"].asFloat();
+            if (root.isMember("softwareFeedback")) out_args.m_softwareFeedback = root["softwareFeedback"].asUInt();
 
             if (root.isMember("visualizeMinMip")) out_args.m_visualizeMinMip = root["visualizeMinMip"].asBool();
+            if (root.isMember("dataVisualization")) out_args.m_dataVisualizationMode = root["dataVisualization"].asInt();
             if (root.isMember("hideFeedback")) out_args.m_showFeedbackMaps = !root["hideFeedback"].asBool();
 
             if (root.isMember("hideUI")) out_args.m_showUI = !root["hideUI"].asBool();
@@ -514,6 +560,18 @@ void LoadConfigFile(std::wstring& in_configFileName, CommandLineArgs& out_args)
             if (root.isMember("timingStop")) out_args.m_timingStopFrame = root["timingStop"].asUInt();
             if (root.isMember("timingFileFrames")) out_args.m_timingFrameFileName = StrToWstr(root["timingFileFrames"].asString());
             if (root.isMember("exitImageFile")) out_args.m_exitImageFileName = StrToWstr(root["exitImage"].asString());
+            if (root.isMember("recordCameraPath")) out_args.m_recordCameraPathFileName = StrToWstr(root["recordCameraPath"].asString());
+            if (root.isMember("replayCameraPath")) out_args.m_replayCameraPathFileName = StrToWstr(root["replayCameraPath"].asString());
+            if (root.isMember("saveResidency")) out_args.m_saveResidencyFileName = StrToWstr(root["saveResidency"].asString());
+            if (root.isMember("saveResidencyFrame")) out_args.m_saveResidencyFrame = root["saveResidencyFrame"].asUInt();
+            if (root.isMember("restoreResidency")) out_args.m_restoreResidencyFileName = StrToWstr(root["restoreResidency"].asString());
+            if (root.isMember("eventTrace")) out_args.m_eventTraceFileName = StrToWstr(root["eventTrace"].asString());
+            if (root.isMember("liveMetrics")) out_args.m_liveMetricsName = StrToWstr(root["liveMetrics"].asString());
+            if (root.isMember("liveMetricsInterval")) out_args.m_liveMetricsIntervalMs = root["liveMetricsInterval"].asUInt();
+
+            if (root.isMember("cullingGridThreshold")) out_args.m_cullingGridThreshold = root["cullingGridThreshold"].asUInt();
+            if (root.isMember("objectCreationBudget")) out_args.m_objectCreationBudgetMs = root["objectCreationBudget"].asFloat();
+            if (root.isMember("meshCacheDir")) out_args.m_meshCacheDir = StrToWstr(root["meshCacheDir"].asString());
 
             if (root.isMember("waitForAssetLoad")) out_args.m_waitForAssetLoad = root["waitForAssetLoad"].asBool();
             if (root.isMember("adapter")) out_args.m_adapterDescription = StrToWstr(root["adapter"].asString());
@@ -562,6 +620,44 @@ int WINAPI WinMain(
     // apply limits and other constraints
     AdjustArguments(args);
 
+    MeshCache::Get().SetDirectory(args.m_meshCacheDir);
+
+    // stand-alone benchmarks, no window or device required
+    if (args.m_cullingBenchmarkFileName.size())
+    {
+        WriteCSV csv(args.m_cullingBenchmarkFileName);
+        FrustumCulling::Benchmark(csv);
+        return 0;
+    }
+    if (args.m_terrainBenchmarkFileName.size())
+    {
+        WriteCSV csv(args.m_terrainBenchmarkFileName);
+        TerrainGenerator::Benchmark(csv, args.m_terrainParams);
+        return 0;
+    }
+    if (args.m_meshBenchmarkFileName.size())
+    {
+        SphereGen::Properties sphereProperties;
+        sphereProperties.m_numLat = args.m_sphereLat;
+        sphereProperties.m_numLong = args.m_sphereLong;
+
+        WriteCSV csv(args.m_meshBenchmarkFileName);
+        SceneObjects::BenchmarkMeshes(csv, sphereProperties, SharedConstants::NUM_SPHERE_LEVELS_OF_DETAIL);
+        return 0;
+    }
+    if (args.m_placementBenchmarkFileName.size())
+    {
+        WriteCSV csv(args.m_placementBenchmarkFileName);
+        SpherePlacement::Benchmark(csv);
+        return 0;
+    }
+    if (args.m_uploadBenchmarkFileName.size())
+    {
+        WriteCSV csv(args.m_uploadBenchmarkFileName);
+        UploadBatcher::Benchmark(csv);
+        return 0;
+    }
+
     WNDCLASSEX wcex = {};
     wcex.cbSize = sizeof(WNDCLASSEX);
     wcex.style = CS_HREDRAW | CS_VREDRAW;